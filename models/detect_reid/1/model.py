@@ -0,0 +1,171 @@
+"""
+Detect -> crop -> ReID pipeline (Triton Python BLS)
+===================================================
+
+Runs the detector on the request's images, decodes and clusters its output
+with the DeepStream parser (libyolov7_server_step.so, loaded with ctypes),
+cuts the boxes of the ReID classes out of the detector input and sends them
+to the embedder in batches of up to reid_max_batch crops, across every image
+of the request. The client gets boxes and embeddings back from one call and
+never sees the crops.
+
+NumPy arrays go to the library as pointers, so decode and crop copy nothing
+beyond their outputs.
+"""
+
+import ctypes
+import json
+import os
+
+import numpy as np
+import triton_python_backend_utils as pb_utils
+
+
+class ServerStepParams(ctypes.Structure):
+    """Mirrors Yolov7ServerStepParams in server_step.h."""
+
+    _fields_ = [
+        ("netWidth", ctypes.c_uint),
+        ("netHeight", ctypes.c_uint),
+        ("numClasses", ctypes.c_uint),
+        ("confidenceThreshold", ctypes.c_float),
+        ("nmsIou", ctypes.c_float),
+        ("topK", ctypes.c_uint),
+    ]
+
+
+def _float_ptr(array):
+    return array.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+
+
+class ServerStep:
+    """ctypes binding of server_step.h."""
+
+    def __init__(self, path):
+        self.lib = ctypes.CDLL(path)
+        float_p = ctypes.POINTER(ctypes.c_float)
+        self.lib.Yolov7ServerStepDecode.argtypes = [
+            float_p, ctypes.c_uint, ctypes.c_uint, ctypes.POINTER(ServerStepParams), float_p, ctypes.c_uint]
+        self.lib.Yolov7ServerStepDecode.restype = ctypes.c_int
+        self.lib.Yolov7ServerStepCrop.argtypes = [
+            float_p, ctypes.c_uint, ctypes.c_uint, float_p, ctypes.c_uint, ctypes.c_uint,
+            ctypes.c_uint, ctypes.c_uint, float_p, float_p, float_p]
+        self.lib.Yolov7ServerStepCrop.restype = None
+
+    def decode(self, output, params, max_boxes):
+        """One image's detector output -> [n, 6] x1,y1,x2,y2,conf,class."""
+        output = np.ascontiguousarray(output, dtype=np.float32)
+        boxes = np.empty((max_boxes, 6), dtype=np.float32)
+        n = self.lib.Yolov7ServerStepDecode(
+            _float_ptr(output), output.shape[0], output.shape[1], ctypes.byref(params),
+            _float_ptr(boxes), max_boxes)
+        if n < 0:
+            raise RuntimeError("parser rejected a %dx%d output" % output.shape)
+        return boxes[:n]
+
+    def crop(self, image, boxes, out, mean, std):
+        """Fills out [n, 3, h, w] from the boxes' regions of image [3, H, W]."""
+        boxes = np.ascontiguousarray(boxes, dtype=np.float32)
+        self.lib.Yolov7ServerStepCrop(
+            _float_ptr(image), image.shape[2], image.shape[1], _float_ptr(boxes), boxes.shape[0],
+            boxes.shape[1], out.shape[3], out.shape[2], _float_ptr(mean), _float_ptr(std), _float_ptr(out))
+
+
+def _split(value, cast):
+    return [cast(v) for v in value.split(";") if v]
+
+
+class TritonPythonModel:
+    def initialize(self, args):
+        config = json.loads(args["model_config"])
+        params = {k: v["string_value"] for k, v in config.get("parameters", {}).items()}
+        self.detector_model = params.get("detector_model", "yolov7_fp16")
+        self.reid_model = params.get("reid_model", "reid_resnet50")
+
+        library = params.get("server_step_library", "libyolov7_server_step.so")
+        if not os.path.isabs(library):
+            library = os.path.join(args["model_repository"], args["model_version"], library)
+        self.step = ServerStep(library)
+
+        self.num_classes = int(params.get("num_classes", "80"))
+        self.confidence_threshold = float(params.get("confidence_threshold", "0.25"))
+        self.nms_iou = float(params.get("nms_iou", "0.45"))
+        self.max_detections = int(params.get("max_detections", "100"))
+        self.reid_class_ids = np.array(_split(params.get("reid_class_ids", "0"), int), dtype=np.float32)
+        self.reid_max_batch = max(1, int(params.get("reid_max_batch", "16")))
+        self.reid_height, self.reid_width = _split(params.get("reid_input_size", "256;128"), int)
+        self.reid_mean = np.array(_split(params.get("reid_mean", "0.485;0.456;0.406"), float), dtype=np.float32)
+        self.reid_std = np.array(_split(params.get("reid_std", "0.229;0.224;0.225"), float), dtype=np.float32)
+
+        embeddings = pb_utils.get_output_config_by_name(config, "embeddings")
+        self.embedding_size = int(embeddings["dims"][-1])
+
+    def _embed(self, crops):
+        """[n, 3, h, w] crops -> [n, embedding_size], reid_max_batch at a time."""
+        out = np.empty((crops.shape[0], self.embedding_size), dtype=np.float32)
+        for start in range(0, crops.shape[0], self.reid_max_batch):
+            batch = crops[start:start + self.reid_max_batch]
+            sub = pb_utils.InferenceRequest(
+                model_name=self.reid_model,
+                requested_output_names=["output"],
+                inputs=[pb_utils.Tensor("input", batch)])
+            response = sub.exec()
+            if response.has_error():
+                raise pb_utils.TritonModelException(response.error().message())
+            out[start:start + batch.shape[0]] = pb_utils.get_output_tensor_by_name(response, "output").as_numpy()
+        return out
+
+    def _run(self, images):
+        sub = pb_utils.InferenceRequest(
+            model_name=self.detector_model,
+            requested_output_names=["output"],
+            inputs=[pb_utils.Tensor("input", images)])
+        response = sub.exec()
+        if response.has_error():
+            raise pb_utils.TritonModelException(response.error().message())
+        dets = pb_utils.get_output_tensor_by_name(response, "output").as_numpy()
+
+        step_params = ServerStepParams(
+            images.shape[3], images.shape[2], self.num_classes, self.confidence_threshold, self.nms_iou,
+            self.max_detections)
+        boxes = [self.step.decode(dets[i], step_params, self.max_detections) for i in range(images.shape[0])]
+
+        # Crops of every image in one array, so ReID batches span images
+        selected = [np.nonzero(np.isin(b[:, 5], self.reid_class_ids))[0] for b in boxes]
+        total = sum(len(s) for s in selected)
+        crops = np.empty((total, 3, self.reid_height, self.reid_width), dtype=np.float32)
+        offset = 0
+        for i, sel in enumerate(selected):
+            if len(sel):
+                self.step.crop(images[i], boxes[i][sel], crops[offset:offset + len(sel)], self.reid_mean,
+                               self.reid_std)
+                offset += len(sel)
+        embeddings = self._embed(crops) if total else None
+
+        rows = max([len(b) for b in boxes] + [0])
+        out_boxes = np.zeros((images.shape[0], rows, 6), dtype=np.float32)
+        out_embeddings = np.zeros((images.shape[0], rows, self.embedding_size), dtype=np.float32)
+        count = np.zeros((images.shape[0], 1), dtype=np.int32)
+        offset = 0
+        for i, sel in enumerate(selected):
+            out_boxes[i, :len(boxes[i])] = boxes[i]
+            out_embeddings[i, sel] = embeddings[offset:offset + len(sel)] if len(sel) else 0.0
+            count[i, 0] = len(boxes[i])
+            offset += len(sel)
+        return out_boxes, out_embeddings, count
+
+    def execute(self, requests):
+        responses = []
+        for request in requests:
+            images = np.ascontiguousarray(
+                pb_utils.get_input_tensor_by_name(request, "input").as_numpy(), dtype=np.float32)
+            try:
+                boxes, embeddings, count = self._run(images)
+            except Exception as e:
+                responses.append(pb_utils.InferenceResponse(output_tensors=[], error=pb_utils.TritonError(str(e))))
+                continue
+            responses.append(pb_utils.InferenceResponse(output_tensors=[
+                pb_utils.Tensor("boxes", boxes),
+                pb_utils.Tensor("embeddings", embeddings),
+                pb_utils.Tensor("count", count)]))
+        return responses
@@ -0,0 +1,79 @@
+"""
+Tiered YOLOv7 dispatcher (Triton Python BLS)
+============================================
+
+Splits each request by its per-element "tier" input and forwards every
+group to that tier's detector model, then reassembles the batch in order.
+Processed [N, 6] outputs pass through; raw [N, 85] outputs are reduced to
+[x1, y1, x2, y2, confidence, class_id] here so the DeepStream parser sees
+one layout for every tier. Per-tier score scales bring a cheaper model's
+confidences in line with the full model so tracker thresholds keep working
+across a switch.
+"""
+
+import json
+
+import numpy as np
+import triton_python_backend_utils as pb_utils
+
+
+def reduce_raw_output(raw, score_scale):
+    """[N, 85] cx,cy,w,h,obj,cls... -> [N, 6] x1,y1,x2,y2,conf,class."""
+    cls = np.argmax(raw[:, 5:], axis=1)
+    conf = raw[:, 4] * raw[np.arange(raw.shape[0]), 5 + cls] * score_scale
+    half_w = raw[:, 2] * 0.5
+    half_h = raw[:, 3] * 0.5
+    out = np.empty((raw.shape[0], 6), dtype=np.float32)
+    out[:, 0] = raw[:, 0] - half_w
+    out[:, 1] = raw[:, 1] - half_h
+    out[:, 2] = raw[:, 0] + half_w
+    out[:, 3] = raw[:, 1] + half_h
+    out[:, 4] = np.minimum(conf, 1.0)
+    out[:, 5] = cls
+    return out
+
+
+class TritonPythonModel:
+    def initialize(self, args):
+        params = json.loads(args["model_config"]).get("parameters", {})
+        self.tier_models = params["tier_models"]["string_value"].split(";")
+        scales = params.get("score_scales", {}).get("string_value", "")
+        self.score_scales = [float(s) for s in scales.split(";") if s]
+        self.score_scales += [1.0] * (len(self.tier_models) - len(self.score_scales))
+
+    def execute(self, requests):
+        responses = []
+        for request in requests:
+            images = pb_utils.get_input_tensor_by_name(request, "input").as_numpy()
+            tiers = pb_utils.get_input_tensor_by_name(request, "tier").as_numpy().reshape(-1)
+            tiers = np.clip(tiers, 0, len(self.tier_models) - 1)
+
+            output = None
+            error = None
+            for tier in np.unique(tiers):
+                idx = np.nonzero(tiers == tier)[0]
+                sub = pb_utils.InferenceRequest(
+                    model_name=self.tier_models[tier],
+                    requested_output_names=["output"],
+                    inputs=[pb_utils.Tensor("input", np.ascontiguousarray(images[idx]))])
+                sub_response = sub.exec()
+                if sub_response.has_error():
+                    error = sub_response.error()
+                    break
+
+                dets = pb_utils.get_output_tensor_by_name(sub_response, "output").as_numpy()
+                if output is None:
+                    output = np.zeros((images.shape[0], dets.shape[1], 6), dtype=np.float32)
+                for j, i in enumerate(idx):
+                    if dets.shape[2] == 6:
+                        output[i] = dets[j]
+                        output[i, :, 4] = np.minimum(dets[j, :, 4] * self.score_scales[tier], 1.0)
+                    else:
+                        output[i] = reduce_raw_output(dets[j], self.score_scales[tier])
+
+            if error is not None:
+                responses.append(pb_utils.InferenceResponse(output_tensors=[], error=error))
+            else:
+                responses.append(pb_utils.InferenceResponse(
+                    output_tensors=[pb_utils.Tensor("output", output)]))
+        return responses
@@ -0,0 +1,133 @@
+/*
+ * Smart-record backed ClipRecorder and ClipTrigger pad probe
+ */
+
+#include "clip_recorder_smartrecord.h"
+
+#include "gstnvdsmeta.h"
+
+#include <iostream>
+#include <vector>
+
+static gpointer onRecordingDone(NvDsSRRecordingInfo* info, gpointer userData)
+{
+    (void)userData;
+    std::cout << "Event clip written: " << info->dirpath << "/" << info->filename << " ("
+              << info->duration << " ms)" << std::endl;
+    return nullptr;
+}
+
+SmartRecordClipRecorder::~SmartRecordClipRecorder()
+{
+    for (auto& kv : m_Sources) {
+        if (kv.second.recording) {
+            NvDsSRStop(kv.second.ctx, kv.second.session);
+        }
+        if (kv.second.owned) {
+            NvDsSRDestroy(kv.second.ctx);
+        }
+    }
+}
+
+GstElement* SmartRecordClipRecorder::addSource(uint32_t sourceId, const std::string& dirPath,
+                                               const std::string& filePrefix, uint32_t cacheSec)
+{
+    std::vector<gchar> dir(dirPath.begin(), dirPath.end());
+    dir.push_back('\0');
+    std::vector<gchar> prefix(filePrefix.begin(), filePrefix.end());
+    prefix.push_back('\0');
+
+    NvDsSRInitParams params = {};
+    params.containerType = NVDSSR_CONTAINER_MP4;
+    params.cacheSize = cacheSec;
+    params.defaultDuration = cacheSec;
+    params.callback = onRecordingDone;
+    params.fileNamePrefix = prefix.data();
+    params.dirpath = dir.data();
+
+    NvDsSRContext* ctx = nullptr;
+    if (NvDsSRCreate(&ctx, &params) != NVDSSR_STATUS_OK || !ctx) {
+        std::cerr << "ERROR: Could not create smart record context for source " << sourceId << std::endl;
+        return nullptr;
+    }
+
+    m_Sources[sourceId] = Source{ctx, true, false, 0};
+    return ctx->recordbin;
+}
+
+void SmartRecordClipRecorder::attachSource(uint32_t sourceId, NvDsSRContext* ctx)
+{
+    m_Sources[sourceId] = Source{ctx, false, false, 0};
+}
+
+bool SmartRecordClipRecorder::startClip(uint32_t sourceId, uint32_t preRollSec, uint32_t maxDurationSec)
+{
+    auto it = m_Sources.find(sourceId);
+    if (it == m_Sources.end()) {
+        return false;
+    }
+    Source& src = it->second;
+    if (src.recording) {
+        return true;
+    }
+
+    // startTime is how far back into the packet cache the clip begins
+    if (NvDsSRStart(src.ctx, &src.session, preRollSec, maxDurationSec, nullptr) != NVDSSR_STATUS_OK) {
+        std::cerr << "WARNING: Smart record start failed on source " << sourceId << std::endl;
+        return false;
+    }
+    src.recording = true;
+    return true;
+}
+
+void SmartRecordClipRecorder::stopClip(uint32_t sourceId)
+{
+    auto it = m_Sources.find(sourceId);
+    if (it == m_Sources.end() || !it->second.recording) {
+        return;
+    }
+    NvDsSRStop(it->second.ctx, it->second.session);
+    it->second.recording = false;
+}
+
+extern "C" GstPadProbeReturn clipTriggerPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData)
+{
+    (void)pad;
+    ClipTrigger* trigger = (ClipTrigger*)userData;
+    GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    NvDsBatchMeta* batchMeta = buf ? gst_buffer_get_nvds_batch_meta(buf) : nullptr;
+    if (!trigger || !batchMeta) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    // Reused across calls; probes on one pad are never concurrent
+    static thread_local std::vector<ClipTrackObject> objects;
+
+    for (NvDsMetaList* l_frame = batchMeta->frame_meta_list; l_frame != nullptr; l_frame = l_frame->next) {
+        NvDsFrameMeta* frameMeta = (NvDsFrameMeta*)(l_frame->data);
+
+        objects.clear();
+        for (NvDsMetaList* l_obj = frameMeta->obj_meta_list; l_obj != nullptr; l_obj = l_obj->next) {
+            NvDsObjectMeta* objMeta = (NvDsObjectMeta*)(l_obj->data);
+            if (objMeta->object_id == UNTRACKED_OBJECT_ID) {
+                continue;
+            }
+            ClipTrackObject o;
+            o.trackId = objMeta->object_id;
+            o.globalId = 0;
+            o.classId = (uint32_t)objMeta->class_id;
+            o.left = objMeta->rect_params.left;
+            o.top = objMeta->rect_params.top;
+            o.width = objMeta->rect_params.width;
+            o.height = objMeta->rect_params.height;
+            objects.push_back(o);
+        }
+
+        // Prefer the NTP/system timestamp so all sources share one clock
+        const uint64_t tsNs = frameMeta->ntp_timestamp ? frameMeta->ntp_timestamp : frameMeta->buf_pts;
+        trigger->onFrame(frameMeta->source_id, tsNs / 1000, frameMeta->pipeline_width,
+                         frameMeta->pipeline_height, objects.data(), objects.size());
+    }
+
+    return GST_PAD_PROBE_OK;
+}
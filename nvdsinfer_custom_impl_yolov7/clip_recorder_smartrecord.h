@@ -0,0 +1,66 @@
+/*
+ * Smart-record backed ClipRecorder and the tracker-output probe that
+ * drives ClipTrigger
+ *
+ * Each source gets an NvDsSRContext whose record bin sits on the encoded
+ * (pre-decode) branch of the source and keeps a rolling cache of encoded
+ * packets. Starting a clip writes the cached pre-roll plus live packets
+ * straight to MP4 without re-encoding, so idle streams cost only the cache.
+ *
+ * Nothing in this tree builds the pipeline around it: the embedding
+ * application creates the recorder, links each source's record bin (or
+ * attaches its own smart-record contexts), loads a ClipTrigger from
+ * configs/event_record.txt and adds clipTriggerPadProbe on the tracker's
+ * src pad. Stock deepstream-app offers no hook for the probe, so its
+ * configs keep continuous sinks.
+ */
+
+#ifndef __CLIP_RECORDER_SMARTRECORD_H__
+#define __CLIP_RECORDER_SMARTRECORD_H__
+
+#include "clip_trigger.h"
+
+#include <gst/gst.h>
+#include "gst-nvdssr.h"
+
+#include <map>
+#include <string>
+
+class SmartRecordClipRecorder : public ClipRecorder
+{
+public:
+    ~SmartRecordClipRecorder() override;
+
+    // Creates a context whose cache holds cacheSec seconds of encoded
+    // packets. The caller links the returned record bin after the source's
+    // parser (e.g. h264parse) through a tee. Returns nullptr on failure.
+    GstElement* addSource(uint32_t sourceId, const std::string& dirPath, const std::string& filePrefix,
+                          uint32_t cacheSec);
+
+    // Uses a context created elsewhere (e.g. deepstream-app's smart-record
+    // source bins). The recorder does not take ownership.
+    void attachSource(uint32_t sourceId, NvDsSRContext* ctx);
+
+    bool startClip(uint32_t sourceId, uint32_t preRollSec, uint32_t maxDurationSec) override;
+    void stopClip(uint32_t sourceId) override;
+
+private:
+    struct Source
+    {
+        NvDsSRContext* ctx;
+        bool owned;
+        bool recording;
+        NvDsSRSessionId session;
+    };
+
+    std::map<uint32_t, Source> m_Sources;
+};
+
+// Attach after the tracker with user_data pointing at a ClipTrigger. The
+// object meta carries no cross-camera id, so objects go in with globalId 0
+// and only zone entries fire; an application that associates in-process
+// calls ClipTrigger::onFrame() with its own ids instead (as
+// tools/bench_pipeline_scaling does). Always returns GST_PAD_PROBE_OK.
+extern "C" GstPadProbeReturn clipTriggerPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData);
+
+#endif
@@ -0,0 +1,246 @@
+/*
+ * Event-triggered pre/post-roll clip recording
+ */
+
+#include "clip_trigger.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const uint32_t kMaxZonesPerSource = 32;  // zone membership is a 32-bit mask
+
+static inline uint64_t secToUs(const double sec)
+{
+    return (uint64_t)std::llround(std::max(0.0, sec) * 1e6);
+}
+
+static inline uint64_t trackKey(const uint32_t sourceId, const uint64_t trackId)
+{
+    return ((uint64_t)sourceId << 40) ^ trackId;
+}
+
+// Even-odd rule over normalised polygon vertices
+static bool pointInPolygon(const float x, const float y, const std::vector<float>& poly)
+{
+    bool inside = false;
+    const size_t n = poly.size() / 2;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        const float xi = poly[2 * i], yi = poly[2 * i + 1];
+        const float xj = poly[2 * j], yj = poly[2 * j + 1];
+        if (((yi > y) != (yj > y)) && (x < (xj - xi) * (y - yi) / (yj - yi) + xi)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+bool ClipTriggerConfig::load(const std::string& path, ClipTriggerConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    if (!kf.hasGroup("event-record")) {
+        std::cerr << "ERROR: " << path << " has no [event-record] group" << std::endl;
+        return false;
+    }
+
+    const std::string g = "event-record";
+    config.preRollSec = kf.getDouble(g, "pre-roll-sec", config.preRollSec);
+    config.postRollSec = kf.getDouble(g, "post-roll-sec", config.postRollSec);
+    config.maxClipSec = kf.getDouble(g, "max-clip-sec", config.maxClipSec);
+    config.cooldownSec = kf.getDouble(g, "cooldown-sec", config.cooldownSec);
+    config.triggerZoneEntry = kf.getBool(g, "trigger-zone-entry", config.triggerZoneEntry);
+    config.triggerNewGlobalId = kf.getBool(g, "trigger-new-global-id", config.triggerNewGlobalId);
+    config.classIds = kf.getIntList(g, "class-ids");
+    config.trackExpirySec = kf.getDouble(g, "track-expiry-sec", config.trackExpirySec);
+    config.globalIdMemorySec = kf.getDouble(g, "global-id-memory-sec", config.globalIdMemorySec);
+
+    config.zones.clear();
+    for (const std::string& group : kf.groups()) {
+        if (group.compare(0, 5, "zone-") != 0) {
+            continue;
+        }
+        ClipZone zone;
+        zone.name = group.substr(5);
+        zone.sourceId = (uint32_t)kf.getInt(group, "source-id", 0);
+        for (double v : kf.getDoubleList(group, "polygon")) {
+            zone.polygon.push_back((float)v);
+        }
+        if (zone.polygon.size() < 6 || zone.polygon.size() % 2 != 0) {
+            std::cerr << "ERROR: [" << group << "] polygon needs at least 3 x;y pairs" << std::endl;
+            return false;
+        }
+        config.zones.push_back(zone);
+    }
+
+    if (config.maxClipSec < config.preRollSec + config.postRollSec) {
+        std::cerr << "WARNING: max-clip-sec shorter than pre-roll + post-roll, raising it" << std::endl;
+        config.maxClipSec = config.preRollSec + config.postRollSec;
+    }
+    return true;
+}
+
+ClipTrigger::ClipTrigger(const ClipTriggerConfig& config, ClipRecorder* recorder)
+    : m_Config(config), m_Recorder(recorder), m_LastExpiryUs(0), m_Stats()
+{
+    for (size_t i = 0; i < m_Config.zones.size(); ++i) {
+        SourceState& src = source(m_Config.zones[i].sourceId);
+        if (src.zones.size() == kMaxZonesPerSource) {
+            std::cerr << "WARNING: Ignoring zone " << m_Config.zones[i].name << ", source "
+                      << m_Config.zones[i].sourceId << " already has " << kMaxZonesPerSource << " zones"
+                      << std::endl;
+            continue;
+        }
+        src.zones.push_back((int)i);
+    }
+}
+
+ClipTrigger::SourceState& ClipTrigger::source(uint32_t sourceId)
+{
+    return m_Sources[sourceId];
+}
+
+void ClipTrigger::onFrame(uint32_t sourceId, uint64_t timestampUs, uint32_t frameWidth, uint32_t frameHeight,
+                          const ClipTrackObject* objects, size_t numObjects)
+{
+    SourceState& src = source(sourceId);
+    src.lastFrameUs = timestampUs;
+
+    const float invW = frameWidth ? 1.0f / (float)frameWidth : 0.0f;
+    const float invH = frameHeight ? 1.0f / (float)frameHeight : 0.0f;
+
+    for (size_t i = 0; i < numObjects; ++i) {
+        const ClipTrackObject& obj = objects[i];
+        if (!m_Config.classIds.empty() &&
+            std::find(m_Config.classIds.begin(), m_Config.classIds.end(), (int)obj.classId) ==
+                m_Config.classIds.end()) {
+            continue;
+        }
+
+        if (m_Config.triggerNewGlobalId && obj.globalId != 0) {
+            auto it = m_GlobalIds.find(obj.globalId);
+            if (it == m_GlobalIds.end()) {
+                m_GlobalIds.emplace(obj.globalId, timestampUs);
+                fire(ClipEvent{CLIP_EVENT_NEW_GLOBAL_ID, sourceId, timestampUs, obj.trackId, obj.globalId, -1});
+            } else {
+                it->second = std::max(it->second, timestampUs);
+            }
+        }
+
+        if (!m_Config.triggerZoneEntry || src.zones.empty()) {
+            continue;
+        }
+
+        // Foot point: bottom centre of the box
+        const float fx = (obj.left + 0.5f * obj.width) * invW;
+        const float fy = (obj.top + obj.height) * invH;
+        uint32_t mask = 0;
+        for (size_t z = 0; z < src.zones.size(); ++z) {
+            if (pointInPolygon(fx, fy, m_Config.zones[src.zones[z]].polygon)) {
+                mask |= 1u << z;
+            }
+        }
+
+        TrackState& ts = m_Tracks[trackKey(sourceId, obj.trackId)];
+        const uint32_t entered = mask & ~ts.zoneMask;
+        ts.zoneMask = mask;
+        ts.lastSeenUs = timestampUs;
+
+        for (size_t z = 0; entered && z < src.zones.size(); ++z) {
+            if (entered & (1u << z)) {
+                fire(ClipEvent{CLIP_EVENT_ZONE_ENTRY, sourceId, timestampUs, obj.trackId, obj.globalId,
+                               src.zones[z]});
+            }
+        }
+    }
+
+    closeIfDue(sourceId, src, timestampUs);
+
+    // Bound the per-track and per-global-id state once a second
+    if (timestampUs >= m_LastExpiryUs + 1000000) {
+        expire(timestampUs);
+        m_LastExpiryUs = timestampUs;
+    }
+}
+
+void ClipTrigger::fire(const ClipEvent& ev)
+{
+    m_Stats.events++;
+    if (m_OnEvent) {
+        m_OnEvent(ev);
+    }
+
+    SourceState& src = source(ev.sourceId);
+    const uint64_t t = ev.timestampUs;
+    const uint64_t preUs = secToUs(m_Config.preRollSec);
+    const uint64_t postUs = secToUs(m_Config.postRollSec);
+    const uint64_t maxUs = secToUs(m_Config.maxClipSec);
+
+    if (src.recording) {
+        const uint64_t end = std::min(std::max(src.clipEndUs, t + postUs), src.clipStartUs + maxUs);
+        if (end > src.clipEndUs) {
+            src.clipEndUs = end;
+            m_Stats.clipsExtended++;
+        }
+        return;
+    }
+
+    if (t < src.cooldownUntilUs) {
+        m_Stats.eventsInCooldown++;
+        return;
+    }
+
+    const uint32_t preSec = (uint32_t)std::ceil(m_Config.preRollSec);
+    const uint32_t maxSec = (uint32_t)std::ceil(m_Config.maxClipSec);
+    if (!m_Recorder || !m_Recorder->startClip(ev.sourceId, preSec, maxSec)) {
+        m_Stats.startFailures++;
+        return;
+    }
+
+    src.recording = true;
+    src.clipStartUs = t > preUs ? t - preUs : 0;
+    src.clipEndUs = t + postUs;
+    m_Stats.clipsStarted++;
+}
+
+void ClipTrigger::closeIfDue(uint32_t sourceId, SourceState& src, uint64_t nowUs)
+{
+    if (!src.recording || nowUs < src.clipEndUs) {
+        return;
+    }
+    m_Recorder->stopClip(sourceId);
+    src.recording = false;
+    src.cooldownUntilUs = nowUs + secToUs(m_Config.cooldownSec);
+    m_Stats.recordedSec += (double)(nowUs - src.clipStartUs) / 1e6;
+}
+
+void ClipTrigger::tick(uint64_t nowUs)
+{
+    for (auto& kv : m_Sources) {
+        closeIfDue(kv.first, kv.second, nowUs);
+    }
+}
+
+void ClipTrigger::expire(uint64_t nowUs)
+{
+    const uint64_t trackTtl = secToUs(m_Config.trackExpirySec);
+    for (auto it = m_Tracks.begin(); it != m_Tracks.end();) {
+        if (nowUs > it->second.lastSeenUs + trackTtl) {
+            it = m_Tracks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    const uint64_t idTtl = secToUs(m_Config.globalIdMemorySec);
+    for (auto it = m_GlobalIds.begin(); it != m_GlobalIds.end();) {
+        if (nowUs > it->second + idTtl) {
+            it = m_GlobalIds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
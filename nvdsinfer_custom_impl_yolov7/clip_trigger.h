@@ -0,0 +1,164 @@
+/*
+ * Event-triggered pre/post-roll clip recording
+ *
+ * ClipTrigger turns per-frame track observations into recording decisions:
+ * when a configured event fires (a tracked object's foot point enters a
+ * zone, or a global id is seen for the first time) it asks a ClipRecorder
+ * to start a clip that begins pre-roll seconds in the past, and stops it
+ * once post-roll seconds have passed without another event. Events that
+ * arrive while a clip is open extend it up to max-clip-sec instead of
+ * opening a second clip.
+ *
+ * The recorder owns the per-source cache of encoded packets that makes the
+ * pre-roll possible (see clip_recorder_smartrecord.h); this module only
+ * decides when to record and has no DeepStream dependency.
+ *
+ * Config file (key file format, see configs/event_record.txt):
+ *
+ *   [event-record]
+ *   pre-roll-sec=5
+ *   post-roll-sec=10
+ *   max-clip-sec=60
+ *   cooldown-sec=2
+ *   trigger-zone-entry=1
+ *   trigger-new-global-id=1
+ *   class-ids=0                 # optional filter, ';'-separated
+ *
+ *   [zone-<name>]
+ *   source-id=0
+ *   polygon=0.1;0.5;0.4;0.5;0.4;1.0;0.1;1.0   # normalised x;y pairs
+ */
+
+#ifndef __CLIP_TRIGGER_H__
+#define __CLIP_TRIGGER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ClipZone
+{
+    std::string name;
+    uint32_t sourceId;
+    std::vector<float> polygon;  // normalised x,y pairs, at least 3 points
+};
+
+struct ClipTriggerConfig
+{
+    double preRollSec = 5.0;
+    double postRollSec = 10.0;
+    double maxClipSec = 60.0;
+    double cooldownSec = 2.0;
+    bool triggerZoneEntry = true;
+    bool triggerNewGlobalId = true;
+    std::vector<int> classIds;  // empty = every class
+    std::vector<ClipZone> zones;
+    // Per-track zone state is forgotten after this long without a sighting
+    double trackExpirySec = 10.0;
+    // A global id is "new" if it has not been seen for this long
+    double globalIdMemorySec = 300.0;
+
+    static bool load(const std::string& path, ClipTriggerConfig& config);
+};
+
+struct ClipTrackObject
+{
+    uint64_t trackId;
+    uint32_t globalId;  // 0 when not associated
+    uint32_t classId;
+    float left, top, width, height;  // pixels in frameWidth x frameHeight space
+};
+
+enum ClipEventType
+{
+    CLIP_EVENT_ZONE_ENTRY = 0,
+    CLIP_EVENT_NEW_GLOBAL_ID = 1
+};
+
+struct ClipEvent
+{
+    ClipEventType type;
+    uint32_t sourceId;
+    uint64_t timestampUs;
+    uint64_t trackId;
+    uint32_t globalId;
+    int zoneIndex;  // index into ClipTriggerConfig::zones, -1 for global-id events
+};
+
+class ClipRecorder
+{
+public:
+    virtual ~ClipRecorder() {}
+
+    // Start a clip on `sourceId` that includes the last preRollSec seconds
+    // and runs for at most maxDurationSec unless stopClip() comes first.
+    virtual bool startClip(uint32_t sourceId, uint32_t preRollSec, uint32_t maxDurationSec) = 0;
+    virtual void stopClip(uint32_t sourceId) = 0;
+};
+
+struct ClipTriggerStats
+{
+    uint64_t events;
+    uint64_t clipsStarted;
+    uint64_t clipsExtended;
+    uint64_t eventsInCooldown;
+    uint64_t startFailures;
+    double recordedSec;  // closed clips only, including pre-roll
+};
+
+class ClipTrigger
+{
+public:
+    ClipTrigger(const ClipTriggerConfig& config, ClipRecorder* recorder);
+
+    // Feed one frame of tracker output. Boxes are in a frameWidth x
+    // frameHeight pixel space (the streammux resolution).
+    void onFrame(uint32_t sourceId, uint64_t timestampUs, uint32_t frameWidth, uint32_t frameHeight,
+                 const ClipTrackObject* objects, size_t numObjects);
+
+    // Close clips whose post-roll has elapsed. onFrame() does this for the
+    // source it is called with; call tick() for sources that went quiet.
+    void tick(uint64_t nowUs);
+
+    // Optional observer, e.g. for logging or publishing events
+    void setEventCallback(std::function<void(const ClipEvent&)> cb) { m_OnEvent = cb; }
+
+    ClipTriggerStats stats() const { return m_Stats; }
+
+private:
+    struct TrackState
+    {
+        uint32_t zoneMask;
+        uint64_t lastSeenUs;
+    };
+
+    struct SourceState
+    {
+        bool recording = false;
+        uint64_t clipStartUs = 0;     // includes pre-roll
+        uint64_t clipEndUs = 0;       // current stop deadline
+        uint64_t cooldownUntilUs = 0;
+        uint64_t lastFrameUs = 0;
+        std::vector<int> zones;       // indices into m_Config.zones
+    };
+
+    void fire(const ClipEvent& ev);
+    void closeIfDue(uint32_t sourceId, SourceState& src, uint64_t nowUs);
+    void expire(uint64_t nowUs);
+    SourceState& source(uint32_t sourceId);
+
+    ClipTriggerConfig m_Config;
+    ClipRecorder* m_Recorder;
+    std::function<void(const ClipEvent&)> m_OnEvent;
+
+    std::unordered_map<uint32_t, SourceState> m_Sources;
+    std::unordered_map<uint64_t, TrackState> m_Tracks;   // (source, trackId) -> state
+    std::unordered_map<uint32_t, uint64_t> m_GlobalIds;  // globalId -> last seen
+    uint64_t m_LastExpiryUs;
+    ClipTriggerStats m_Stats;
+};
+
+#endif
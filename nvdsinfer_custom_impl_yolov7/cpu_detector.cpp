@@ -0,0 +1,481 @@
+/*
+ * CPU detector: YOLOv7(-tiny) on ONNX Runtime, decoded by the same parser
+ */
+
+#include "cpu_detector.h"
+#include "key_file.h"
+#include "object_nms.h"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+extern "C" bool NvDsInferParseYolov7(std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+                                     NvDsInferNetworkInfo const& networkInfo,
+                                     NvDsInferParseDetectionParams const& detectionParams,
+                                     std::vector<NvDsInferParseObjectInfo>& objectList);
+
+typedef std::chrono::steady_clock Clock;
+
+// YOLOv7's letterbox border
+static const float kPadValue = 114.0f / 255.0f;
+
+static uint64_t elapsedUs(Clock::time_point since)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count();
+}
+
+bool CpuDetectorConfig::load(const std::string& path, CpuDetectorConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "cpu-detector";
+    CpuDetectorConfig c;
+    c.model = kf.getString(g, "model", c.model);
+    c.inputName = kf.getString(g, "input-name", c.inputName);
+    c.outputName = kf.getString(g, "output-name", c.outputName);
+    c.width = (uint32_t)kf.getInt(g, "width", (int)c.width);
+    c.height = (uint32_t)kf.getInt(g, "height", (int)c.height);
+    c.maxBatch = (uint32_t)kf.getInt(g, "max-batch", (int)c.maxBatch);
+    c.lanes = (uint32_t)kf.getInt(g, "lanes", (int)c.lanes);
+    c.intraOpThreads = (uint32_t)kf.getInt(g, "intra-op-threads", (int)c.intraOpThreads);
+    c.maxStreams = (uint32_t)kf.getInt(g, "max-streams", (int)c.maxStreams);
+    c.queueFrames = (uint32_t)kf.getInt(g, "queue-frames", (int)c.queueFrames);
+    c.numClasses = (uint32_t)kf.getInt(g, "num-classes", (int)c.numClasses);
+    c.confidenceThreshold = (float)kf.getDouble(g, "confidence-threshold", c.confidenceThreshold);
+    c.nmsIou = (float)kf.getDouble(g, "nms-iou", c.nmsIou);
+    c.topK = (uint32_t)kf.getInt(g, "top-k", (int)c.topK);
+    c.optimization = kf.getString(g, "optimization", c.optimization);
+    if (c.model.empty() || c.width == 0 || c.height == 0 || c.maxBatch == 0 || c.intraOpThreads == 0 ||
+        c.maxStreams == 0 || c.queueFrames == 0 || c.numClasses == 0) {
+        std::cerr << "ERROR: " << path
+                  << ": need a model and positive width, height, max-batch, intra-op-threads, max-streams, "
+                     "queue-frames and num-classes"
+                  << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+struct CpuDetector::Runtime
+{
+    Ort::Env env{ORT_LOGGING_LEVEL_WARNING, "cpu-detector"};
+    Ort::Session session{nullptr};
+    Ort::RunOptions run;
+};
+
+struct CpuDetector::LaneRuntime
+{
+    // Views of the lane's tensors and their binding, index = batch size - 1
+    std::vector<Ort::Value> inputs;
+    std::vector<Ort::Value> outputs;
+    std::vector<Ort::IoBinding> bindings;
+};
+
+CpuDetector::CpuDetector(const CpuDetectorConfig& config, WorkStealingScheduler& scheduler,
+                         ResultCallback callback)
+    : m_Config(config), m_Scheduler(scheduler), m_Callback(std::move(callback)),
+      m_StreamPending(new std::atomic<uint32_t>[config.maxStreams])
+{
+    for (uint32_t s = 0; s < config.maxStreams; ++s) {
+        m_StreamPending[s].store(0);
+    }
+}
+
+CpuDetector::~CpuDetector()
+{
+    flush();
+}
+
+std::unique_ptr<CpuDetector> CpuDetector::create(const CpuDetectorConfig& config, WorkStealingScheduler& scheduler,
+                                                 ResultCallback callback)
+{
+    std::unique_ptr<CpuDetector> detector(new CpuDetector(config, scheduler, std::move(callback)));
+    if (!detector->init()) {
+        return nullptr;
+    }
+    return detector;
+}
+
+static bool parseOptimization(const std::string& name, GraphOptimizationLevel& level)
+{
+    if (name == "none") {
+        level = ORT_DISABLE_ALL;
+    } else if (name == "basic") {
+        level = ORT_ENABLE_BASIC;
+    } else if (name == "extended") {
+        level = ORT_ENABLE_EXTENDED;
+    } else if (name == "all") {
+        level = ORT_ENABLE_ALL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Shape of the named FP32 input or output, empty when there is none
+static std::vector<int64_t> tensorShape(Ort::Session& session, const std::string& name, bool input)
+{
+    Ort::AllocatorWithDefaultOptions allocator;
+    const size_t count = input ? session.GetInputCount() : session.GetOutputCount();
+    for (size_t i = 0; i < count; ++i) {
+        Ort::AllocatedStringPtr n =
+            input ? session.GetInputNameAllocated(i, allocator) : session.GetOutputNameAllocated(i, allocator);
+        if (name != n.get()) {
+            continue;
+        }
+        Ort::TypeInfo type = input ? session.GetInputTypeInfo(i) : session.GetOutputTypeInfo(i);
+        auto tensor = type.GetTensorTypeAndShapeInfo();
+        if (tensor.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+            return {};
+        }
+        return tensor.GetShape();
+    }
+    return {};
+}
+
+bool CpuDetector::init()
+{
+    const CpuDetectorConfig& c = m_Config;
+    GraphOptimizationLevel level;
+    if (!parseOptimization(c.optimization, level)) {
+        std::cerr << "ERROR: Unknown CPU detector optimization level " << c.optimization << std::endl;
+        return false;
+    }
+    uint32_t lanes = c.lanes;
+    if (lanes == 0) {
+        lanes = std::max(1u, m_Scheduler.workers() / c.intraOpThreads);
+    }
+    if ((uint64_t)lanes * c.intraOpThreads > m_Scheduler.workers()) {
+        std::cerr << "WARNING: CPU detector runs " << lanes << " lanes x " << c.intraOpThreads
+                  << " intra-op threads on " << m_Scheduler.workers() << " scheduler workers" << std::endl;
+    }
+
+    try {
+        m_Runtime.reset(new Runtime());
+        Ort::SessionOptions options;
+        options.SetExecutionMode(ORT_SEQUENTIAL);
+        options.SetGraphOptimizationLevel(level);
+        // 1 = run on the calling scheduler worker, no pool threads
+        options.SetIntraOpNumThreads((int)c.intraOpThreads);
+        options.SetInterOpNumThreads(1);
+        options.AddConfigEntry("session.intra_op.allow_spinning", "0");
+        options.AddConfigEntry("session.set_denormal_as_zero", "1");
+        m_Runtime->session = Ort::Session(m_Runtime->env, c.model.c_str(), options);
+
+        const std::vector<int64_t> in = tensorShape(m_Runtime->session, c.inputName, true);
+        const std::vector<int64_t> out = tensorShape(m_Runtime->session, c.outputName, false);
+        if (in.size() != 4 || in[1] != 3 || in[0] > 0 || out.size() != 3 || out[0] > 0 || out[1] <= 0 ||
+            (out[2] != 6 && out[2] != 85)) {
+            std::cerr << "ERROR: " << c.model << ": need FP32 input " << c.inputName << " [N,3,H,W] and output "
+                      << c.outputName << " [N,rows,6|85] with a dynamic batch" << std::endl;
+            return false;
+        }
+        m_Height = in[2] > 0 ? (uint32_t)in[2] : c.height;
+        m_Width = in[3] > 0 ? (uint32_t)in[3] : c.width;
+        m_Rows = (uint32_t)out[1];
+        m_Channels = (uint32_t)out[2];
+
+        m_NetworkInfo.width = m_Width;
+        m_NetworkInfo.height = m_Height;
+        m_NetworkInfo.channels = 3;
+        m_Params.numClassesConfigured = c.numClasses;
+        m_Params.perClassPreclusterThreshold.assign(c.numClasses, c.confidenceThreshold);
+        m_Params.perClassPostclusterThreshold.assign(c.numClasses, c.confidenceThreshold);
+
+        const size_t inSize = (size_t)3 * m_Height * m_Width;
+        const size_t outSize = (size_t)m_Rows * m_Channels;
+        const uint32_t ringSize = ((c.maxStreams + lanes - 1) / lanes) * c.queueFrames;
+        Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        for (uint32_t l = 0; l < lanes; ++l) {
+            std::unique_ptr<Lane> lane(new Lane());
+            lane->detector = this;
+            lane->ring.resize(ringSize);
+            lane->job.run = &CpuDetector::runLane;
+            lane->job.lane = lane.get();
+            lane->batch.reserve(c.maxBatch);
+            lane->placements.resize(c.maxBatch);
+            lane->input.assign(inSize * c.maxBatch, 0.0f);
+            lane->output.assign(outSize * c.maxBatch, 0.0f);
+            lane->layers.resize(1);
+            NvDsInferLayerInfo& layer = lane->layers[0];
+            memset(&layer, 0, sizeof(layer));
+            layer.dataType = FLOAT;
+            layer.inferDims.numDims = 2;
+            layer.inferDims.d[0] = m_Rows;
+            layer.inferDims.d[1] = m_Channels;
+            layer.inferDims.numElements = m_Rows * m_Channels;
+            layer.layerName = "output";
+            layer.isInput = 0;
+            lane->parsed.reserve(c.topK * 4);
+            lane->objects.reserve(c.topK);
+            lane->x0.resize(m_Width);
+            lane->x1.resize(m_Width);
+            lane->fx.resize(m_Width);
+
+            lane->runtime.reset(new LaneRuntime());
+            LaneRuntime& rt = *lane->runtime;
+            for (uint32_t n = 1; n <= c.maxBatch; ++n) {
+                const int64_t inShape[4] = {(int64_t)n, 3, (int64_t)m_Height, (int64_t)m_Width};
+                const int64_t outShape[3] = {(int64_t)n, (int64_t)m_Rows, (int64_t)m_Channels};
+                rt.inputs.push_back(Ort::Value::CreateTensor<float>(memory, lane->input.data(), inSize * n, inShape, 4));
+                rt.outputs.push_back(
+                    Ort::Value::CreateTensor<float>(memory, lane->output.data(), outSize * n, outShape, 3));
+                Ort::IoBinding binding(m_Runtime->session);
+                binding.BindInput(c.inputName.c_str(), rt.inputs.back());
+                binding.BindOutput(c.outputName.c_str(), rt.outputs.back());
+                rt.bindings.push_back(std::move(binding));
+            }
+            m_Lanes.push_back(std::move(lane));
+        }
+
+        // ONNX Runtime plans its allocations on the first run per shape
+        for (uint32_t n : {1u, c.maxBatch}) {
+            m_Runtime->session.Run(m_Runtime->run, m_Lanes[0]->runtime->bindings[n - 1]);
+        }
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ERROR: Cannot load CPU detector model " << c.model << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CpuDetector::submit(const CpuFrame& frame)
+{
+    if (frame.stream >= m_Config.maxStreams) {
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::atomic<uint32_t>& pending = m_StreamPending[frame.stream];
+    if (pending.fetch_add(1, std::memory_order_acq_rel) >= m_Config.queueFrames) {
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_InFlight.fetch_add(1, std::memory_order_acq_rel);
+
+    // Every stream of the lane stays within queue-frames, so the ring has room
+    Lane& lane = *m_Lanes[frame.stream % m_Lanes.size()];
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        lane.ring[(lane.head + lane.count) % lane.ring.size()] = frame;
+        lane.count++;
+        if (!lane.scheduled) {
+            lane.scheduled = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        m_Scheduler.submit(&lane.job);
+    }
+    return true;
+}
+
+void CpuDetector::flush()
+{
+    std::unique_lock<std::mutex> lock(m_FlushMutex);
+    m_FlushCv.wait(lock, [this]() { return m_InFlight.load(std::memory_order_acquire) == 0; });
+}
+
+void CpuDetector::runLane(SchedulerJob* job)
+{
+    Lane* lane = static_cast<LaneJob*>(job)->lane;
+    lane->detector->drainLane(*lane);
+}
+
+void CpuDetector::drainLane(Lane& lane)
+{
+    lane.batch.clear();
+    {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        while (lane.count > 0 && lane.batch.size() < m_Config.maxBatch) {
+            lane.batch.push_back(lane.ring[lane.head]);
+            lane.head = (lane.head + 1) % (uint32_t)lane.ring.size();
+            lane.count--;
+        }
+        if (lane.batch.empty()) {
+            lane.scheduled = false;
+            return;
+        }
+    }
+
+    const uint32_t n = (uint32_t)lane.batch.size();
+    const size_t inSize = (size_t)3 * m_Height * m_Width;
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < n; ++i) {
+        letterbox(lane, lane.batch[i], &lane.input[i * inSize], lane.placements[i]);
+    }
+    m_PreprocessUs.fetch_add(elapsedUs(start), std::memory_order_relaxed);
+
+    start = Clock::now();
+    bool ok = true;
+    try {
+        m_Runtime->session.Run(m_Runtime->run, lane.runtime->bindings[n - 1]);
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ERROR: CPU detector inference failed: " << e.what() << std::endl;
+        ok = false;
+    }
+    m_InferenceUs.fetch_add(elapsedUs(start), std::memory_order_relaxed);
+    m_Batches.fetch_add(1, std::memory_order_relaxed);
+
+    start = Clock::now();
+    for (uint32_t i = 0; i < n; ++i) {
+        if (ok) {
+            lane.layers[0].buffer = &lane.output[(size_t)i * m_Rows * m_Channels];
+            finish(lane, lane.batch[i], lane.placements[i]);
+        } else {
+            // The frame is still delivered, with no objects, to keep order
+            lane.objects.clear();
+        }
+        const CpuDetectorResult result = {&lane.batch[i], lane.objects.data(), (uint32_t)lane.objects.size()};
+        if (m_Callback) {
+            m_Callback(result);
+        }
+        m_Frames.fetch_add(1, std::memory_order_relaxed);
+        m_Objects.fetch_add(lane.objects.size(), std::memory_order_relaxed);
+        m_StreamPending[lane.batch[i].stream].fetch_sub(1, std::memory_order_acq_rel);
+    }
+    m_ParseUs.fetch_add(elapsedUs(start), std::memory_order_relaxed);
+
+    bool requeue;
+    {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        requeue = lane.count > 0;
+        if (!requeue) {
+            lane.scheduled = false;
+        }
+    }
+    {
+        // Under the lock, so flush() cannot return (and the destructor run)
+        // between this decrement and the notify
+        std::lock_guard<std::mutex> lock(m_FlushMutex);
+        if (m_InFlight.fetch_sub(n, std::memory_order_acq_rel) == n) {
+            m_FlushCv.notify_all();
+        }
+    }
+    // Yield between batches so other lanes get their turn; from a worker the
+    // job goes to its own deque, ahead of work injected from outside
+    if (requeue) {
+        m_Scheduler.submit(&lane.job);
+    }
+}
+
+void CpuDetector::letterbox(Lane& lane, const CpuFrame& frame, float* dst, Placement& placement)
+{
+    const size_t plane = (size_t)m_Width * m_Height;
+    const float scale = std::min((float)m_Width / frame.width, (float)m_Height / frame.height);
+    const uint32_t w = std::min(m_Width, std::max(1u, (uint32_t)std::lround(frame.width * scale)));
+    const uint32_t h = std::min(m_Height, std::max(1u, (uint32_t)std::lround(frame.height * scale)));
+    const uint32_t padX = (m_Width - w) / 2;
+    const uint32_t padY = (m_Height - h) / 2;
+    placement.scale = scale;
+    placement.padX = (float)padX;
+    placement.padY = (float)padY;
+
+    const uint32_t bpp = (frame.format == kCpuPixelRgba || frame.format == kCpuPixelBgra) ? 4 : 3;
+    const bool bgr = frame.format == kCpuPixelBgr || frame.format == kCpuPixelBgra;
+    const uint32_t channel[3] = {bgr ? 2u : 0u, 1u, bgr ? 0u : 2u};  // byte offset of R, G, B
+    const float norm = 1.0f / 255.0f;
+
+    // Bilinear taps with pixel centres aligned
+    const float sx = (float)frame.width / w;
+    const float sy = (float)frame.height / h;
+    const int32_t maxX = (int32_t)frame.width - 1;
+    const int32_t maxY = (int32_t)frame.height - 1;
+    for (uint32_t x = 0; x < w; ++x) {
+        const float fx = std::max(0.0f, (x + 0.5f) * sx - 0.5f);
+        const int32_t x0 = std::min((int32_t)fx, maxX);
+        lane.x0[x] = x0 * (int32_t)bpp;
+        lane.x1[x] = std::min(x0 + 1, maxX) * (int32_t)bpp;
+        lane.fx[x] = fx - x0;
+    }
+
+    for (int ch = 0; ch < 3; ++ch) {
+        float* out = dst + ch * plane;
+        std::fill(out, out + (size_t)padY * m_Width, kPadValue);
+        std::fill(out + (size_t)(padY + h) * m_Width, out + plane, kPadValue);
+    }
+    for (uint32_t y = 0; y < h; ++y) {
+        const float fy = std::max(0.0f, (y + 0.5f) * sy - 0.5f);
+        const int32_t y0 = std::min((int32_t)fy, maxY);
+        const int32_t y1 = std::min(y0 + 1, maxY);
+        const float wy = fy - y0;
+        const uint8_t* row0 = frame.pixels + (size_t)y0 * frame.stride;
+        const uint8_t* row1 = frame.pixels + (size_t)y1 * frame.stride;
+        for (int ch = 0; ch < 3; ++ch) {
+            float* out = dst + ch * plane + (size_t)(padY + y) * m_Width;
+            std::fill(out, out + padX, kPadValue);
+            std::fill(out + padX + w, out + m_Width, kPadValue);
+            out += padX;
+            const uint32_t o = channel[ch];
+            for (uint32_t x = 0; x < w; ++x) {
+                const float wx = lane.fx[x];
+                const float a = row0[lane.x0[x] + o] + wx * (row0[lane.x1[x] + o] - row0[lane.x0[x] + o]);
+                const float b = row1[lane.x0[x] + o] + wx * (row1[lane.x1[x] + o] - row1[lane.x0[x] + o]);
+                out[x] = (a + wy * (b - a)) * norm;
+            }
+        }
+    }
+}
+
+void CpuDetector::finish(Lane& lane, const CpuFrame& frame, const Placement& placement)
+{
+    NvDsInferParseYolov7(lane.layers, m_NetworkInfo, m_Params, lane.parsed);
+    nmsPerClass(lane.parsed, m_Config.nmsIou, m_Config.topK, lane.objects);
+
+    // Network pixels -> frame pixels, undoing the letterbox
+    const float inv = 1.0f / placement.scale;
+    for (NvDsInferParseObjectInfo& o : lane.objects) {
+        const float left = std::max(0.0f, (o.left - placement.padX) * inv);
+        const float top = std::max(0.0f, (o.top - placement.padY) * inv);
+        const float right = std::min((float)frame.width, (o.left + o.width - placement.padX) * inv);
+        const float bottom = std::min((float)frame.height, (o.top + o.height - placement.padY) * inv);
+        o.left = left;
+        o.top = top;
+        o.width = std::max(0.0f, right - left);
+        o.height = std::max(0.0f, bottom - top);
+    }
+}
+
+CpuDetectorStats CpuDetector::stats() const
+{
+    CpuDetectorStats s;
+    s.frames = m_Frames.load(std::memory_order_relaxed);
+    s.dropped = m_Dropped.load(std::memory_order_relaxed);
+    s.batches = m_Batches.load(std::memory_order_relaxed);
+    s.objects = m_Objects.load(std::memory_order_relaxed);
+    s.preprocessUs = m_PreprocessUs.load(std::memory_order_relaxed);
+    s.inferenceUs = m_InferenceUs.load(std::memory_order_relaxed);
+    s.parseUs = m_ParseUs.load(std::memory_order_relaxed);
+    return s;
+}
+
+void CpuDetector::writePrometheus(std::string& out) const
+{
+    const CpuDetectorStats s = stats();
+    std::ostringstream os;
+    os << "# TYPE deepstream_cpu_detector_frames_total counter\n"
+       << "deepstream_cpu_detector_frames_total " << s.frames << "\n"
+       << "# TYPE deepstream_cpu_detector_dropped_frames_total counter\n"
+       << "deepstream_cpu_detector_dropped_frames_total " << s.dropped << "\n"
+       << "# TYPE deepstream_cpu_detector_batches_total counter\n"
+       << "deepstream_cpu_detector_batches_total " << s.batches << "\n"
+       << "# TYPE deepstream_cpu_detector_objects_total counter\n"
+       << "deepstream_cpu_detector_objects_total " << s.objects << "\n"
+       << "# TYPE deepstream_cpu_detector_preprocess_seconds_total counter\n"
+       << "deepstream_cpu_detector_preprocess_seconds_total " << s.preprocessUs / 1e6 << "\n"
+       << "# TYPE deepstream_cpu_detector_inference_seconds_total counter\n"
+       << "deepstream_cpu_detector_inference_seconds_total " << s.inferenceUs / 1e6 << "\n"
+       << "# TYPE deepstream_cpu_detector_parse_seconds_total counter\n"
+       << "deepstream_cpu_detector_parse_seconds_total " << s.parseUs / 1e6 << "\n";
+    out += os.str();
+}
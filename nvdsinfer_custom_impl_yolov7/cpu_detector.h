@@ -0,0 +1,226 @@
+/*
+ * CPU detector: YOLOv7(-tiny) on ONNX Runtime, decoded by the same parser
+ *
+ * For sites without a GPU, where Triton on CUDA is not an option. An ONNX
+ * export of YOLOv7 or YOLOv7-tiny (INT8 dynamically quantized with
+ * scripts/quantize_yolov7_int8.sh) runs in-process on ONNX Runtime's CPU
+ * execution provider. Its output tensor is handed to NvDsInferParseYolov7
+ * as an NvDsInferLayerInfo, exactly as nvinferserver would, followed by
+ * the same per-class NMS nvinfer clusters with. Boxes come back in frame
+ * pixels.
+ *
+ * Scheduling across streams goes through the WorkStealingScheduler (see
+ * work_stealing_scheduler.h) rather than ONNX Runtime's own pools:
+ *
+ *   - frames are spread over `lanes`, stream s on lane s % lanes, so a
+ *     stream's results are delivered in submission order
+ *   - a lane with pending frames is one scheduler job. It takes up to
+ *     max-batch frames from its streams (batching across streams),
+ *     letterboxes them into its input tensor, runs the session and parses.
+ *     It then yields and requeues itself while frames remain
+ *   - all lanes share one session (Run is thread-safe); each lane owns its
+ *     input/output tensors and an IoBinding per batch size, so a batch
+ *     allocates nothing
+ *   - with intra-op-threads=1 (the default) inference runs on the worker
+ *     itself and the process has no threads beyond the scheduler's. Then
+ *     lanes defaults to the scheduler's worker count. Larger intra-op pools
+ *     are extra threads; lanes then defaults to workers / intra-op-threads
+ *     so the two together do not oversubscribe the cores
+ *
+ * submit() never blocks: a stream with queue-frames frames pending drops
+ * the new one, as a leaky queue upstream would. The caller's pixels must
+ * stay valid until that frame's result callback has run.
+ *
+ * Config (key file format, see configs/cpu_detector.txt):
+ *
+ *   [cpu-detector]
+ *   model=/workspace/models/yolov7_tiny_int8/1/model.onnx
+ *   input-name=input
+ *   output-name=output
+ *   width=640                 # used only when the model's input is dynamic
+ *   height=640
+ *   max-batch=4
+ *   lanes=0                   # 0 = scheduler workers / intra-op-threads
+ *   intra-op-threads=1
+ *   max-streams=64
+ *   queue-frames=2            # per stream
+ *   num-classes=80
+ *   confidence-threshold=0.25
+ *   nms-iou=0.45
+ *   top-k=300
+ *   optimization=all          # none | basic | extended | all
+ */
+
+#ifndef __CPU_DETECTOR_H__
+#define __CPU_DETECTOR_H__
+
+#include "nvdsinfer_custom_impl.h"
+#include "work_stealing_scheduler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct CpuDetectorConfig
+{
+    std::string model = "/workspace/models/yolov7_tiny_int8/1/model.onnx";
+    std::string inputName = "input";
+    std::string outputName = "output";
+    uint32_t width = 640;
+    uint32_t height = 640;
+    uint32_t maxBatch = 4;
+    uint32_t lanes = 0;
+    uint32_t intraOpThreads = 1;
+    uint32_t maxStreams = 64;
+    uint32_t queueFrames = 2;
+    uint32_t numClasses = 80;
+    float confidenceThreshold = 0.25f;
+    float nmsIou = 0.45f;
+    uint32_t topK = 300;
+    std::string optimization = "all";
+
+    static bool load(const std::string& path, CpuDetectorConfig& config);
+};
+
+enum CpuPixelFormat : uint32_t
+{
+    kCpuPixelRgb = 0,
+    kCpuPixelBgr = 1,
+    kCpuPixelRgba = 2,
+    kCpuPixelBgra = 3,
+};
+
+struct CpuFrame
+{
+    uint32_t stream;
+    uint64_t timestampUs;
+    const uint8_t* pixels;  // packed 8-bit, top-left first
+    uint32_t width, height;
+    uint32_t stride;  // bytes per row
+    CpuPixelFormat format;
+    void* user;  // handed back with the result
+};
+
+struct CpuDetectorResult
+{
+    const CpuFrame* frame;
+    const NvDsInferParseObjectInfo* objects;  // frame pixels, after NMS
+    uint32_t count;
+};
+
+struct CpuDetectorStats
+{
+    uint64_t frames = 0;
+    uint64_t dropped = 0;
+    uint64_t batches = 0;
+    uint64_t objects = 0;
+    uint64_t preprocessUs = 0;
+    uint64_t inferenceUs = 0;
+    uint64_t parseUs = 0;  // parser and NMS
+};
+
+class CpuDetector
+{
+public:
+    // Called on a scheduler worker, in submission order per stream
+    typedef std::function<void(const CpuDetectorResult& result)> ResultCallback;
+
+    // Loads the model and checks its input/output; nullptr on failure
+    static std::unique_ptr<CpuDetector> create(const CpuDetectorConfig& config, WorkStealingScheduler& scheduler,
+                                               ResultCallback callback);
+    // Waits for frames still in flight
+    ~CpuDetector();
+
+    // Any thread, never blocks; false when the frame was dropped (stream
+    // queue full or stream >= max-streams)
+    bool submit(const CpuFrame& frame);
+    // Blocks until every submitted frame has been delivered
+    void flush();
+
+    uint32_t lanes() const { return (uint32_t)m_Lanes.size(); }
+    uint32_t inputWidth() const { return m_Width; }
+    uint32_t inputHeight() const { return m_Height; }
+    CpuDetectorStats stats() const;
+
+    void writePrometheus(std::string& out) const;
+
+private:
+    struct Runtime;      // ONNX Runtime session, kept out of this header
+    struct LaneRuntime;  // a lane's tensor views and bindings
+
+    // Letterbox geometry of one batch entry
+    struct Placement
+    {
+        float scale;
+        float padX, padY;
+    };
+
+    struct Lane;
+    struct LaneJob : SchedulerJob
+    {
+        Lane* lane;
+    };
+
+    struct Lane
+    {
+        CpuDetector* detector;
+        std::mutex mutex;
+        std::vector<CpuFrame> ring;  // pending frames
+        uint32_t head = 0;
+        uint32_t count = 0;
+        bool scheduled = false;
+        LaneJob job;
+
+        // Touched only by the lane's running job
+        std::vector<CpuFrame> batch;
+        std::vector<Placement> placements;
+        std::vector<float> input;   // maxBatch * 3 * height * width
+        std::vector<float> output;  // maxBatch * rows * channels
+        std::vector<NvDsInferLayerInfo> layers;
+        std::vector<NvDsInferParseObjectInfo> parsed;
+        std::vector<NvDsInferParseObjectInfo> objects;
+        std::vector<int32_t> x0, x1;  // bilinear taps per input column
+        std::vector<float> fx;
+        std::unique_ptr<LaneRuntime> runtime;
+    };
+
+    CpuDetector(const CpuDetectorConfig& config, WorkStealingScheduler& scheduler, ResultCallback callback);
+
+    bool init();
+    static void runLane(SchedulerJob* job);
+    void drainLane(Lane& lane);
+    void letterbox(Lane& lane, const CpuFrame& frame, float* dst, Placement& placement);
+    void finish(Lane& lane, const CpuFrame& frame, const Placement& placement);
+
+    CpuDetectorConfig m_Config;
+    WorkStealingScheduler& m_Scheduler;
+    ResultCallback m_Callback;
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+    uint32_t m_Rows = 0;
+    uint32_t m_Channels = 0;
+    NvDsInferNetworkInfo m_NetworkInfo;
+    NvDsInferParseDetectionParams m_Params;
+    std::unique_ptr<Runtime> m_Runtime;
+    std::vector<std::unique_ptr<Lane>> m_Lanes;
+
+    std::unique_ptr<std::atomic<uint32_t>[]> m_StreamPending;  // per stream
+    std::atomic<uint64_t> m_InFlight{0};
+    std::mutex m_FlushMutex;
+    std::condition_variable m_FlushCv;
+
+    std::atomic<uint64_t> m_Frames{0};
+    std::atomic<uint64_t> m_Dropped{0};
+    std::atomic<uint64_t> m_Batches{0};
+    std::atomic<uint64_t> m_Objects{0};
+    std::atomic<uint64_t> m_PreprocessUs{0};
+    std::atomic<uint64_t> m_InferenceUs{0};
+    std::atomic<uint64_t> m_ParseUs{0};
+};
+
+#endif
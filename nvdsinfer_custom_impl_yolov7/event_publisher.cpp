@@ -0,0 +1,342 @@
+/*
+ * Windowed, binary event publisher for detections and tracks
+ */
+
+#include "event_publisher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+static inline uint16_t toU16(const float v)
+{
+    return (uint16_t)std::min(65535.0f, std::max(0.0f, std::round(v)));
+}
+
+static inline uint64_t trackKey(const uint32_t sourceId, const uint64_t trackId)
+{
+    return ((uint64_t)sourceId << 32) | (uint32_t)trackId;
+}
+
+EventPublisher::EventPublisher(const EventPublisherConfig& config, std::unique_ptr<EventTransport> transport)
+    : m_Config(config),
+      m_Transport(std::move(transport)),
+      m_WindowStartUs(0),
+      m_WindowObservations(0),
+      m_Busy(false),
+      m_Stopping(false),
+      m_Observations(0),
+      m_RecordsOut(0),
+      m_Batches(0),
+      m_RawBytes(0),
+      m_PublishedBytes(0),
+      m_Dropped(0),
+      m_SendFailures(0)
+{
+#ifndef WITH_ZSTD
+    if (m_Config.compress) {
+        std::cerr << "WARNING: Event publisher built without zstd, publishing uncompressed" << std::endl;
+        m_Config.compress = false;
+    }
+#endif
+    if (m_Config.windowMs == 0) {
+        m_Config.windowMs = 1;
+    }
+    // offsetMs is 16 bits wide
+    m_Config.windowMs = std::min<uint32_t>(m_Config.windowMs, 65535);
+    m_Config.maxRecordsPerWindow = std::min<uint32_t>(m_Config.maxRecordsPerWindow, EVENT_BATCH_MAX_RECORDS);
+
+    m_Records.reserve(std::min<uint32_t>(m_Config.maxRecordsPerWindow, 4096));
+    m_Worker = std::thread(&EventPublisher::workerLoop, this);
+}
+
+EventPublisher::~EventPublisher()
+{
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        m_Stopping = true;
+    }
+    m_QueueCv.notify_one();
+    m_Worker.join();
+}
+
+void EventPublisher::publish(const EventObservation& obs)
+{
+    m_Observations.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_WindowMutex);
+
+    const uint64_t windowUs = (uint64_t)m_Config.windowMs * 1000;
+    if (m_WindowObservations == 0) {
+        m_WindowStartUs = obs.timestampUs;
+    } else if (obs.timestampUs >= m_WindowStartUs + windowUs) {
+        closeWindowLocked(obs.timestampUs);
+        m_WindowStartUs = obs.timestampUs;
+    }
+
+    // Late observations (clock skew between sources) are pinned to the start
+    const uint64_t offsetUs = obs.timestampUs > m_WindowStartUs ? obs.timestampUs - m_WindowStartUs : 0;
+
+    EventRecord rec;
+    rec.offsetMs = (uint16_t)(offsetUs / 1000);
+    rec.sourceId = (uint16_t)obs.sourceId;
+    rec.classId = (uint8_t)std::min<uint32_t>(obs.classId, 255);
+    rec.confidence = (uint8_t)std::lround(std::min(1.0f, std::max(0.0f, obs.confidence)) * 255.0f);
+    rec.flags = 0;
+    rec.hits = 1;
+    rec.trackId = (uint32_t)obs.trackId;
+    rec.globalId = obs.globalId;
+    rec.left = toU16(obs.left);
+    rec.top = toU16(obs.top);
+    rec.width = toU16(obs.width);
+    rec.height = toU16(obs.height);
+
+    const bool tracked = obs.trackId != ~(uint64_t)0;
+    if (!tracked) {
+        rec.flags |= EVENT_RECORD_FLAG_UNTRACKED;
+    }
+
+    m_WindowObservations++;
+
+    if (m_Config.latestPerTrack && tracked) {
+        auto it = m_TrackSlot.find(trackKey(obs.sourceId, obs.trackId));
+        if (it != m_TrackSlot.end()) {
+            EventRecord& prev = m_Records[it->second];
+            rec.flags |= prev.flags;
+            rec.hits = prev.hits == 255 ? 255 : prev.hits + 1;
+            // Keep the global id once one has been assigned in this window
+            if (rec.globalId == 0) {
+                rec.globalId = prev.globalId;
+            }
+            prev = rec;
+            return;
+        }
+        m_TrackSlot.emplace(trackKey(obs.sourceId, obs.trackId), (uint32_t)m_Records.size());
+    }
+
+    m_Records.push_back(rec);
+
+    if (m_Records.size() >= m_Config.maxRecordsPerWindow) {
+        closeWindowLocked(obs.timestampUs);
+    }
+}
+
+void EventPublisher::flush()
+{
+    std::lock_guard<std::mutex> lock(m_WindowMutex);
+    closeWindowLocked(m_WindowStartUs + (uint64_t)m_Config.windowMs * 1000);
+}
+
+void EventPublisher::drain()
+{
+    flush();
+    std::unique_lock<std::mutex> lock(m_QueueMutex);
+    m_IdleCv.wait(lock, [this] { return m_Queue.empty() && !m_Busy; });
+}
+
+void EventPublisher::closeWindowLocked(uint64_t windowEndUs)
+{
+    if (m_WindowObservations == 0) {
+        return;
+    }
+
+    PendingBatch batch;
+    batch.windowStartUs = m_WindowStartUs;
+    batch.windowLengthUs = (uint32_t)std::min<uint64_t>(windowEndUs - m_WindowStartUs, 0xffffffffu);
+    batch.observationCount = m_WindowObservations;
+    batch.records.swap(m_Records);
+
+    m_Records.reserve(batch.records.size());
+    m_TrackSlot.clear();
+    m_WindowObservations = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        if (m_Queue.size() >= m_Config.maxQueuedBatches) {
+            // Transport cannot keep up: drop the oldest window, keep the newest
+            m_Queue.pop_front();
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_Queue.push_back(std::move(batch));
+    }
+    m_QueueCv.notify_one();
+}
+
+void EventPublisher::workerLoop()
+{
+    std::vector<uint8_t> payload;
+    PendingBatch batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_QueueMutex);
+            if (m_Busy) {
+                m_Busy = false;
+                m_IdleCv.notify_all();
+            }
+            m_QueueCv.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+            if (m_Queue.empty()) {
+                return;
+            }
+            batch = std::move(m_Queue.front());
+            m_Queue.pop_front();
+            m_Busy = true;
+        }
+
+        sendWindow(batch, payload);
+    }
+}
+
+void EventPublisher::sendWindow(const PendingBatch& batch, std::vector<uint8_t>& payload)
+{
+    // Records per batch so that even uncompressed ones fit the transport;
+    // a compressed payload is only kept when it is smaller
+    const size_t total = batch.records.size();
+    const size_t limit = m_Transport ? m_Transport->maxPayloadBytes() : 0;
+    size_t perBatch = std::max<size_t>(total, 1);
+    if (limit > sizeof(EventBatchHeader) + sizeof(EventRecord)) {
+        perBatch = std::min(perBatch, (limit - sizeof(EventBatchHeader)) / sizeof(EventRecord));
+    }
+
+    size_t done = 0;
+    do {
+        const size_t count = std::min(perBatch, total - done);
+        const uint32_t observations = done == 0 ? batch.observationCount : 0;
+        const EventRecord* records = batch.records.data() + done;
+        done += count;
+
+        if (!encodeBatch(batch.windowStartUs, batch.windowLengthUs, observations, records, count,
+                         m_Config.compress, m_Config.compressionLevel, payload)) {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        m_RawBytes.fetch_add(sizeof(EventBatchHeader) + count * sizeof(EventRecord), std::memory_order_relaxed);
+
+        if (!m_Transport || !m_Transport->send(m_Config.topic, payload.data(), payload.size())) {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            // Report the first failure and then every 1000th to avoid log floods
+            if (m_SendFailures++ % 1000 == 0) {
+                std::cerr << "WARNING: Event transport " << (m_Transport ? m_Transport->name() : "(none)")
+                          << " dropped a " << payload.size() << " byte batch (" << m_SendFailures
+                          << " dropped so far)" << std::endl;
+            }
+            continue;
+        }
+
+        m_Batches.fetch_add(1, std::memory_order_relaxed);
+        m_RecordsOut.fetch_add(count, std::memory_order_relaxed);
+        m_PublishedBytes.fetch_add(payload.size(), std::memory_order_relaxed);
+    } while (done < total);
+}
+
+EventPublisherStats EventPublisher::stats() const
+{
+    EventPublisherStats s;
+    s.observations = m_Observations.load(std::memory_order_relaxed);
+    s.records = m_RecordsOut.load(std::memory_order_relaxed);
+    s.batches = m_Batches.load(std::memory_order_relaxed);
+    s.rawBytes = m_RawBytes.load(std::memory_order_relaxed);
+    s.publishedBytes = m_PublishedBytes.load(std::memory_order_relaxed);
+    s.droppedBatches = m_Dropped.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool EventPublisher::encodeBatch(uint64_t windowStartUs, uint32_t windowLengthUs, uint32_t observationCount,
+                                 const EventRecord* records, size_t count, bool compress, int level,
+                                 std::vector<uint8_t>& out)
+{
+    EventBatchHeader header;
+    header.magic = EVENT_BATCH_MAGIC;
+    header.version = EVENT_BATCH_VERSION;
+    header.flags = 0;
+    header.windowStartUs = windowStartUs;
+    header.windowLengthUs = windowLengthUs;
+    header.recordCount = (uint32_t)count;
+    header.observationCount = observationCount;
+
+    const size_t rawSize = count * sizeof(EventRecord);
+
+#ifdef WITH_ZSTD
+    if (compress && rawSize > 0) {
+        const size_t bound = ZSTD_compressBound(rawSize);
+        out.resize(sizeof(EventBatchHeader) + bound);
+        size_t written = ZSTD_compress(out.data() + sizeof(EventBatchHeader), bound, records, rawSize, level);
+        if (ZSTD_isError(written)) {
+            std::cerr << "ERROR: zstd compression failed: " << ZSTD_getErrorName(written) << std::endl;
+            return false;
+        }
+        // Only keep the compressed form when it actually saves bytes
+        if (written < rawSize) {
+            header.flags |= EVENT_BATCH_FLAG_ZSTD;
+            header.payloadBytes = (uint32_t)written;
+            out.resize(sizeof(EventBatchHeader) + written);
+            memcpy(out.data(), &header, sizeof(header));
+            return true;
+        }
+    }
+#else
+    (void)compress;
+    (void)level;
+#endif
+
+    header.payloadBytes = (uint32_t)rawSize;
+    out.resize(sizeof(EventBatchHeader) + rawSize);
+    memcpy(out.data(), &header, sizeof(header));
+    if (rawSize > 0) {
+        memcpy(out.data() + sizeof(EventBatchHeader), records, rawSize);
+    }
+    return true;
+}
+
+bool EventPublisher::decodeBatch(const uint8_t* data, size_t size, EventBatchHeader& header,
+                                 std::vector<EventRecord>& records)
+{
+    if (size < sizeof(EventBatchHeader)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != EVENT_BATCH_MAGIC || header.version != EVENT_BATCH_VERSION) {
+        return false;
+    }
+    if (size - sizeof(EventBatchHeader) < header.payloadBytes) {
+        return false;
+    }
+
+    // Check the record count against the payload before allocating for it
+    const uint8_t* payload = data + sizeof(EventBatchHeader);
+    const size_t rawSize = (size_t)header.recordCount * sizeof(EventRecord);
+    if (header.recordCount > EVENT_BATCH_MAX_RECORDS) {
+        return false;
+    }
+
+    if (header.flags & EVENT_BATCH_FLAG_ZSTD) {
+#ifdef WITH_ZSTD
+        // encodeBatch writes the content size into the frame header
+        if (ZSTD_getFrameContentSize(payload, header.payloadBytes) != rawSize) {
+            return false;
+        }
+        records.resize(header.recordCount);
+        size_t n = ZSTD_decompress(records.data(), rawSize, payload, header.payloadBytes);
+        return !ZSTD_isError(n) && n == rawSize;
+#else
+        std::cerr << "ERROR: Compressed event batch but built without zstd" << std::endl;
+        return false;
+#endif
+    }
+
+    if (header.payloadBytes != rawSize) {
+        return false;
+    }
+    records.resize(header.recordCount);
+    if (rawSize > 0) {
+        memcpy(records.data(), payload, rawSize);
+    }
+    return true;
+}
@@ -0,0 +1,190 @@
+/*
+ * Windowed, binary event publisher for detections and tracks
+ *
+ * Instead of one JSON message per object, observations are collected into
+ * fixed time windows and each window is published as a single compact
+ * binary payload (optionally zstd-compressed) through a pluggable
+ * EventTransport.
+ *
+ * Payload layout (all fields little-endian):
+ *
+ *   EventBatchHeader   (32 bytes)
+ *   EventRecord[count] (24 bytes each, uncompressed)
+ *
+ * When EVENT_BATCH_FLAG_ZSTD is set the records are zstd-compressed and
+ * header.payloadBytes holds the compressed size; header.recordCount still
+ * gives the number of records after decompression.
+ *
+ * A window too large for the transport (EventTransport::maxPayloadBytes(),
+ * e.g. a UNIX datagram) goes out as several batches with the same window
+ * start and length; the first carries observationCount, the others 0.
+ */
+
+#ifndef __EVENT_PUBLISHER_H__
+#define __EVENT_PUBLISHER_H__
+
+#include "event_transport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define EVENT_BATCH_MAGIC 0x56455344u  // "DSEV"
+#define EVENT_BATCH_VERSION 1
+
+#define EVENT_BATCH_FLAG_ZSTD 0x1
+// Decoders reject batches claiming more records than this
+#define EVENT_BATCH_MAX_RECORDS (1u << 20)
+
+#define EVENT_RECORD_FLAG_UNTRACKED 0x1
+
+#pragma pack(push, 1)
+struct EventBatchHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint64_t windowStartUs;
+    uint32_t windowLengthUs;
+    uint32_t recordCount;
+    uint32_t observationCount;  // observations folded into the records
+    uint32_t payloadBytes;      // bytes following this header
+};
+
+struct EventRecord
+{
+    uint16_t offsetMs;      // last observation, relative to windowStartUs
+    uint16_t sourceId;
+    uint8_t classId;
+    uint8_t confidence;     // detection confidence * 255
+    uint8_t flags;          // EVENT_RECORD_FLAG_*
+    uint8_t hits;           // observations folded into this record (saturating)
+    uint32_t trackId;       // tracker-local object id, truncated to 32 bits
+    uint32_t globalId;      // cross-camera id, 0 when not associated
+    uint16_t left, top, width, height;  // pixels in streammux resolution
+};
+#pragma pack(pop)
+
+static_assert(sizeof(EventBatchHeader) == 32, "EventBatchHeader layout changed");
+static_assert(sizeof(EventRecord) == 24, "EventRecord layout changed");
+
+// One observation as reported by a pipeline probe
+struct EventObservation
+{
+    uint32_t sourceId;
+    uint64_t timestampUs;
+    uint64_t trackId;       // UNTRACKED_OBJECT_ID (~0) for untracked detections
+    uint32_t globalId;
+    uint32_t classId;
+    float confidence;
+    float left, top, width, height;
+};
+
+struct EventPublisherConfig
+{
+    std::string topic = "deepstream-events";
+    uint32_t windowMs = 1000;
+    // Fold repeated observations of one track within a window into a single
+    // record holding the latest box. Untracked detections are never folded.
+    bool latestPerTrack = true;
+    bool compress = false;
+    int compressionLevel = 1;
+    // Records per window before an early flush (bounds payload size), at
+    // most EVENT_BATCH_MAX_RECORDS
+    uint32_t maxRecordsPerWindow = 65536;
+    // Closed windows waiting for the transport before the oldest is dropped
+    uint32_t maxQueuedBatches = 8;
+};
+
+struct EventPublisherStats
+{
+    uint64_t observations;
+    uint64_t records;
+    uint64_t batches;
+    uint64_t rawBytes;          // header + uncompressed records
+    uint64_t publishedBytes;    // bytes handed to the transport
+    uint64_t droppedBatches;    // queue overflow or transport failure (per datagram part)
+};
+
+class EventPublisher
+{
+public:
+    EventPublisher(const EventPublisherConfig& config, std::unique_ptr<EventTransport> transport);
+    ~EventPublisher();
+
+    // Called from pipeline probes; never blocks on the transport.
+    void publish(const EventObservation& obs);
+
+    // Closes the current window regardless of its age.
+    void flush();
+
+    // Flushes and waits until every closed window has reached the transport.
+    void drain();
+
+    EventPublisherStats stats() const;
+
+    // Serializes one window into a payload. Exposed for tests and tools.
+    static bool encodeBatch(uint64_t windowStartUs, uint32_t windowLengthUs, uint32_t observationCount,
+                            const std::vector<EventRecord>& records, bool compress, int level,
+                            std::vector<uint8_t>& out)
+    {
+        return encodeBatch(windowStartUs, windowLengthUs, observationCount, records.data(), records.size(),
+                           compress, level, out);
+    }
+    static bool encodeBatch(uint64_t windowStartUs, uint32_t windowLengthUs, uint32_t observationCount,
+                            const EventRecord* records, size_t count, bool compress, int level,
+                            std::vector<uint8_t>& out);
+
+    // Inverse of encodeBatch; returns false on malformed input.
+    static bool decodeBatch(const uint8_t* data, size_t size, EventBatchHeader& header,
+                            std::vector<EventRecord>& records);
+
+private:
+    struct PendingBatch
+    {
+        uint64_t windowStartUs;
+        uint32_t windowLengthUs;
+        uint32_t observationCount;
+        std::vector<EventRecord> records;
+    };
+
+    void closeWindowLocked(uint64_t windowEndUs);
+    void workerLoop();
+    void sendWindow(const PendingBatch& batch, std::vector<uint8_t>& payload);
+
+    EventPublisherConfig m_Config;
+    std::unique_ptr<EventTransport> m_Transport;
+
+    // Current window, guarded by m_WindowMutex
+    std::mutex m_WindowMutex;
+    uint64_t m_WindowStartUs;
+    uint32_t m_WindowObservations;
+    std::vector<EventRecord> m_Records;
+    std::unordered_map<uint64_t, uint32_t> m_TrackSlot;  // (source, trackId) -> record index
+
+    // Closed windows waiting for the worker, guarded by m_QueueMutex
+    std::mutex m_QueueMutex;
+    std::condition_variable m_QueueCv;
+    std::condition_variable m_IdleCv;
+    std::deque<PendingBatch> m_Queue;
+    bool m_Busy;
+    bool m_Stopping;
+    std::thread m_Worker;
+
+    std::atomic<uint64_t> m_Observations;
+    std::atomic<uint64_t> m_RecordsOut;
+    std::atomic<uint64_t> m_Batches;
+    std::atomic<uint64_t> m_RawBytes;
+    std::atomic<uint64_t> m_PublishedBytes;
+    std::atomic<uint64_t> m_Dropped;
+    uint64_t m_SendFailures;  // worker thread only
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * Local event transports (file, UNIX datagram socket) and URI factory
+ */
+
+#include "event_transport.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+FileEventTransport::FileEventTransport(const std::string& path)
+{
+    m_Fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_Fd < 0) {
+        std::cerr << "ERROR: Could not open event file " << path << ": " << strerror(errno) << std::endl;
+    }
+}
+
+FileEventTransport::~FileEventTransport()
+{
+    if (m_Fd >= 0) {
+        close(m_Fd);
+    }
+}
+
+bool FileEventTransport::send(const std::string& topic, const uint8_t* data, size_t size)
+{
+    if (m_Fd < 0) {
+        return false;
+    }
+
+    // One writev per frame so concurrent readers never observe a torn header
+    uint32_t topicLen = (uint32_t)topic.size();
+    uint32_t payloadLen = (uint32_t)size;
+    struct iovec iov[4];
+    iov[0].iov_base = &topicLen;
+    iov[0].iov_len = sizeof(topicLen);
+    iov[1].iov_base = (void*)topic.data();
+    iov[1].iov_len = topic.size();
+    iov[2].iov_base = &payloadLen;
+    iov[2].iov_len = sizeof(payloadLen);
+    iov[3].iov_base = (void*)data;
+    iov[3].iov_len = size;
+
+    ssize_t expected = (ssize_t)(2 * sizeof(uint32_t) + topic.size() + size);
+    return writev(m_Fd, iov, 4) == expected;
+}
+
+UnixSocketEventTransport::UnixSocketEventTransport(const std::string& path)
+    : m_Path(path), m_MaxPayload(0)
+{
+    m_Fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_Fd < 0) {
+        std::cerr << "ERROR: Could not create UNIX socket: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "ERROR: UNIX socket path too long: " << path << std::endl;
+        close(m_Fd);
+        m_Fd = -1;
+        return;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+
+    // Connecting a datagram socket only fixes the peer address; it succeeds
+    // once the reader has bound the path.
+    if (connect(m_Fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::cerr << "ERROR: Could not connect to UNIX socket " << path << ": " << strerror(errno) << std::endl;
+        close(m_Fd);
+        m_Fd = -1;
+        return;
+    }
+
+    // The kernel refuses datagrams within 32 bytes of SO_SNDBUF; the topic
+    // prefix takes up to 256 more
+    int sndbuf = 0;
+    socklen_t len = sizeof(sndbuf);
+    if (getsockopt(m_Fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, &len) == 0 && sndbuf > 32 + 256) {
+        m_MaxPayload = (size_t)sndbuf - 32 - 256;
+    }
+}
+
+UnixSocketEventTransport::~UnixSocketEventTransport()
+{
+    if (m_Fd >= 0) {
+        close(m_Fd);
+    }
+}
+
+bool UnixSocketEventTransport::send(const std::string& topic, const uint8_t* data, size_t size)
+{
+    if (m_Fd < 0) {
+        return false;
+    }
+
+    // The socket path already identifies the stream, so the topic travels
+    // only as a one-byte-length prefix to keep datagrams self-describing.
+    uint8_t topicLen = (uint8_t)std::min<size_t>(topic.size(), 255);
+    struct iovec iov[3];
+    iov[0].iov_base = &topicLen;
+    iov[0].iov_len = 1;
+    iov[1].iov_base = (void*)topic.data();
+    iov[1].iov_len = topicLen;
+    iov[2].iov_base = (void*)data;
+    iov[2].iov_len = size;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 3;
+
+    if (sendmsg(m_Fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+        return true;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+    }
+
+    // A window split into several datagrams fills the send buffer until the
+    // reader catches up; give it a moment before dropping
+    struct pollfd pfd;
+    pfd.fd = m_Fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, kSendWaitMs) <= 0) {
+        return false;
+    }
+    return sendmsg(m_Fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0;
+}
+
+#ifndef EVENT_TRANSPORT_NO_MSGBROKER
+// Splits "key=value&key=value" query strings
+static std::string queryParam(const std::string& query, const std::string& key)
+{
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t end = query.find('&', pos);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        std::string item = query.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        if (eq != std::string::npos && item.compare(0, eq, key) == 0) {
+            return item.substr(eq + 1);
+        }
+        pos = end + 1;
+    }
+    return std::string();
+}
+#endif
+
+std::unique_ptr<EventTransport> createEventTransport(const std::string& uri)
+{
+    size_t sep = uri.find("://");
+    if (sep == std::string::npos) {
+        std::cerr << "ERROR: Event transport URI needs a scheme: " << uri << std::endl;
+        return nullptr;
+    }
+
+    std::string scheme = uri.substr(0, sep);
+    std::string rest = uri.substr(sep + 3);
+
+    if (scheme == "file") {
+        std::unique_ptr<FileEventTransport> t(new FileEventTransport(rest));
+        if (!t->isOpen()) {
+            return nullptr;
+        }
+        return t;
+    }
+
+    if (scheme == "unix") {
+        std::unique_ptr<UnixSocketEventTransport> t(new UnixSocketEventTransport(rest));
+        if (!t->isOpen()) {
+            return nullptr;
+        }
+        return t;
+    }
+
+#ifndef EVENT_TRANSPORT_NO_MSGBROKER
+    if (scheme == "msgbroker") {
+        size_t q = rest.find('?');
+        std::string protoLib = rest.substr(0, q);
+        std::string query = (q == std::string::npos) ? std::string() : rest.substr(q + 1);
+        return createMsgBrokerEventTransport(protoLib, queryParam(query, "conn"), queryParam(query, "cfg"));
+    }
+#endif
+
+    std::cerr << "ERROR: Unsupported event transport scheme: " << scheme << std::endl;
+    return nullptr;
+}
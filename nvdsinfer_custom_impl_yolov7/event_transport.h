@@ -0,0 +1,90 @@
+/*
+ * Pluggable transports for the event publisher
+ *
+ * A transport moves one already-serialized payload to its destination.
+ * Implementations must not block the caller for long: the publisher calls
+ * send() from its own worker thread, but a stalled transport still backs up
+ * the publisher's queue and forces it to drop windows.
+ *
+ * Supported URIs (see createEventTransport):
+ *   file:///path/to/events.bin     length-prefixed frames appended to a file
+ *   unix:///path/to/socket         one SOCK_DGRAM datagram per payload
+ *   msgbroker://<proto-lib>?conn=<conn-str>[&cfg=<cfg-file>]
+ *                                  DeepStream nvmsgbroker (Kafka, MQTT, ...)
+ */
+
+#ifndef __EVENT_TRANSPORT_H__
+#define __EVENT_TRANSPORT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class EventTransport
+{
+public:
+    virtual ~EventTransport() {}
+
+    // Deliver one payload on the given topic. Returns false if the payload
+    // was dropped; the publisher counts the failure and carries on.
+    virtual bool send(const std::string& topic, const uint8_t* data, size_t size) = 0;
+
+    // Largest payload send() can deliver, 0 = no limit. The publisher
+    // splits windows that would not fit.
+    virtual size_t maxPayloadBytes() const { return 0; }
+
+    virtual const char* name() const = 0;
+};
+
+// Appends [u32 topic_len][topic][u32 payload_len][payload] frames to a file.
+// Intended for tests and offline replay.
+class FileEventTransport : public EventTransport
+{
+public:
+    explicit FileEventTransport(const std::string& path);
+    ~FileEventTransport() override;
+
+    bool isOpen() const { return m_Fd >= 0; }
+    bool send(const std::string& topic, const uint8_t* data, size_t size) override;
+    const char* name() const override { return "file"; }
+
+private:
+    int m_Fd;
+};
+
+// Sends each payload as a single datagram to a UNIX socket. The socket is
+// non-blocking: if the reader leaves no room for kSendWaitMs the datagram is
+// dropped, never queued.
+// A datagram must fit the socket's send buffer (SO_SNDBUF, 208 KiB by
+// default), which maxPayloadBytes() reports.
+class UnixSocketEventTransport : public EventTransport
+{
+public:
+    explicit UnixSocketEventTransport(const std::string& path);
+    ~UnixSocketEventTransport() override;
+
+    bool isOpen() const { return m_Fd >= 0; }
+    bool send(const std::string& topic, const uint8_t* data, size_t size) override;
+    size_t maxPayloadBytes() const override { return m_MaxPayload; }
+    const char* name() const override { return "unix"; }
+
+private:
+    static constexpr int kSendWaitMs = 20;
+
+    int m_Fd;
+    std::string m_Path;
+    size_t m_MaxPayload;
+};
+
+// Returns nullptr (and logs) for unknown schemes or unusable destinations.
+std::unique_ptr<EventTransport> createEventTransport(const std::string& uri);
+
+#ifndef EVENT_TRANSPORT_NO_MSGBROKER
+// Implemented in event_transport_msgbroker.cpp (needs libnvds_msgbroker).
+std::unique_ptr<EventTransport> createMsgBrokerEventTransport(const std::string& protoLib,
+                                                              const std::string& connStr,
+                                                              const std::string& cfgFile);
+#endif
+
+#endif
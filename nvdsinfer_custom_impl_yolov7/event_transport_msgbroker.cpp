@@ -0,0 +1,137 @@
+/*
+ * nvmsgbroker-backed event transport
+ *
+ * Uses the asynchronous send path so a slow broker never blocks the
+ * publisher's worker. The broker library copies the payload before
+ * nv_msgbroker_send_async returns, so the caller's buffer can be reused.
+ *
+ * Completion callbacks own a reference to the transport's shared state, so
+ * one that fires after the transport is destroyed is still safe. The
+ * destructor waits briefly for outstanding sends before disconnecting.
+ */
+
+#include "event_transport.h"
+
+#include "nvmsgbroker.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class MsgBrokerEventTransport : public EventTransport
+{
+public:
+    explicit MsgBrokerEventTransport(NvMsgBrokerClientHandle handle)
+        : m_Handle(handle), m_State(std::make_shared<SendState>())
+    {
+    }
+
+    ~MsgBrokerEventTransport() override
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_State->mutex);
+            SendState* state = m_State.get();
+            if (!state->drained.wait_for(lock, std::chrono::seconds(2), [state]() { return state->pending == 0; })) {
+                std::cerr << "WARNING: nvmsgbroker disconnecting with " << state->pending
+                          << " sends outstanding" << std::endl;
+            }
+        }
+        nv_msgbroker_disconnect(m_Handle);
+    }
+
+    bool send(const std::string& topic, const uint8_t* data, size_t size) override
+    {
+        std::vector<char> topicBuf(topic.begin(), topic.end());
+        topicBuf.push_back('\0');
+
+        NvMsgBrokerClientMsg msg;
+        msg.topic = topicBuf.data();
+        msg.payload = (void*)data;
+        msg.payload_len = size;
+
+        // Freed by onSendComplete, or here when the send is refused
+        std::shared_ptr<SendState>* ctx = new std::shared_ptr<SendState>(m_State);
+        {
+            std::lock_guard<std::mutex> lock(m_State->mutex);
+            m_State->pending++;
+        }
+        if (nv_msgbroker_send_async(m_Handle, msg, onSendComplete, ctx) != NV_MSGBROKER_API_OK) {
+            sendDone(*ctx);
+            delete ctx;
+            return false;
+        }
+        return true;
+    }
+
+    const char* name() const override { return "msgbroker"; }
+
+private:
+    struct SendState
+    {
+        std::mutex mutex;
+        std::condition_variable drained;
+        uint64_t pending = 0;
+        std::atomic<uint64_t> failures{0};
+    };
+
+    static void sendDone(const std::shared_ptr<SendState>& state)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (--state->pending == 0) {
+            state->drained.notify_all();
+        }
+    }
+
+    static void onSendComplete(void* user, NvMsgBrokerErrorType status)
+    {
+        std::shared_ptr<SendState>* ctx = (std::shared_ptr<SendState>*)user;
+        if (status != NV_MSGBROKER_API_OK) {
+            // Report the first failure and then every 1000th to avoid log floods
+            if ((*ctx)->failures.fetch_add(1) % 1000 == 0) {
+                std::cerr << "WARNING: nvmsgbroker send failed (status " << status << ")" << std::endl;
+            }
+        }
+        sendDone(*ctx);
+        delete ctx;
+    }
+
+    static void onConnect(NvMsgBrokerClientHandle, NvMsgBrokerErrorType status)
+    {
+        if (status != NV_MSGBROKER_API_OK) {
+            std::cerr << "WARNING: nvmsgbroker connection lost (status " << status << ")" << std::endl;
+        }
+    }
+
+    friend std::unique_ptr<EventTransport> createMsgBrokerEventTransport(const std::string&,
+                                                                         const std::string&,
+                                                                         const std::string&);
+
+    NvMsgBrokerClientHandle m_Handle;
+    std::shared_ptr<SendState> m_State;
+};
+
+std::unique_ptr<EventTransport> createMsgBrokerEventTransport(const std::string& protoLib,
+                                                              const std::string& connStr,
+                                                              const std::string& cfgFile)
+{
+    std::vector<char> conn(connStr.begin(), connStr.end());
+    conn.push_back('\0');
+    std::vector<char> lib(protoLib.begin(), protoLib.end());
+    lib.push_back('\0');
+    std::vector<char> cfg(cfgFile.begin(), cfgFile.end());
+    cfg.push_back('\0');
+
+    NvMsgBrokerClientHandle handle = nv_msgbroker_connect(conn.data(), lib.data(),
+                                                          MsgBrokerEventTransport::onConnect,
+                                                          cfgFile.empty() ? nullptr : cfg.data());
+    if (!handle) {
+        std::cerr << "ERROR: nvmsgbroker could not connect to " << connStr << " via " << protoLib << std::endl;
+        return nullptr;
+    }
+
+    return std::unique_ptr<EventTransport>(new MsgBrokerEventTransport(handle));
+}
@@ -0,0 +1,337 @@
+/*
+ * Shared-memory SPMC ring of per-frame detection metadata
+ */
+
+#include "frame_meta_ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct alignas(64) FrameRingConsumerSlot
+{
+    std::atomic<uint32_t> pid;  // 0 = free
+    std::atomic<uint64_t> cursor;
+    std::atomic<uint64_t> overruns;
+};
+
+struct FrameRingShmHeader
+{
+    std::atomic<uint32_t> magic;  // written last, once the header is valid
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    uint64_t slotStride;
+    alignas(64) std::atomic<uint64_t> writeSeq;  // records committed so far
+    FrameRingConsumerSlot consumers[FRAME_RING_MAX_CONSUMERS];
+};
+
+// Each slot is [seq word][FrameRecord], padded to a cache line multiple.
+// seq == 2*s+1 while record s is being written, 2*s+2 once it is complete.
+struct FrameRingSlot
+{
+    std::atomic<uint64_t> seq;
+    uint64_t pad[7];
+    FrameRecord record;
+};
+
+struct FrameRingMapping
+{
+    FrameRingShmHeader* header;
+    uint8_t* slots;
+    size_t bytes;
+    uint32_t mask;
+
+    FrameRingSlot* slot(uint64_t seq) const
+    {
+        return (FrameRingSlot*)(slots + (seq & mask) * header->slotStride);
+    }
+};
+
+static const size_t kHeaderBytes = (sizeof(FrameRingShmHeader) + 4095) & ~(size_t)4095;
+static const size_t kSlotStride = (sizeof(FrameRingSlot) + 63) & ~(size_t)63;
+
+static inline size_t usedBytes(const FrameRecord& r)
+{
+    const uint16_t n = std::min<uint16_t>(r.numObjects, FRAME_RING_MAX_OBJECTS);
+    return offsetof(FrameRecord, objects) + n * sizeof(FrameRecordObject);
+}
+
+static std::string shmName(const std::string& name)
+{
+    return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+
+static bool processAlive(uint32_t pid)
+{
+    return pid != 0 && (kill((pid_t)pid, 0) == 0 || errno != ESRCH);
+}
+
+std::unique_ptr<FrameRingProducer> FrameRingProducer::create(const std::string& name, uint32_t capacity)
+{
+    uint32_t cap = 1;
+    while (cap < capacity && cap < (1u << 30)) {
+        cap <<= 1;
+    }
+
+    const std::string path = shmName(name);
+    // Start from a fresh segment so stale consumers from a previous run
+    // cannot observe a half-initialised layout.
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "ERROR: shm_open(" << path << ") failed: " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    const size_t bytes = kHeaderBytes + (size_t)cap * kSlotStride;
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        std::cerr << "ERROR: Could not size frame ring " << path << ": " << strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(path.c_str());
+        return nullptr;
+    }
+
+    // MAP_POPULATE pre-faults the ring so the first frames do not page-fault
+    void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "ERROR: Could not map frame ring " << path << ": " << strerror(errno) << std::endl;
+        shm_unlink(path.c_str());
+        return nullptr;
+    }
+
+    FrameRingShmHeader* hdr = new (addr) FrameRingShmHeader();
+    hdr->version = FRAME_RING_VERSION;
+    hdr->capacity = cap;
+    hdr->recordSize = sizeof(FrameRecord);
+    hdr->slotStride = kSlotStride;
+    hdr->writeSeq.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < FRAME_RING_MAX_CONSUMERS; ++i) {
+        hdr->consumers[i].pid.store(0, std::memory_order_relaxed);
+        hdr->consumers[i].cursor.store(0, std::memory_order_relaxed);
+        hdr->consumers[i].overruns.store(0, std::memory_order_relaxed);
+    }
+
+    uint8_t* slots = (uint8_t*)addr + kHeaderBytes;
+    for (uint32_t i = 0; i < cap; ++i) {
+        FrameRingSlot* s = new (slots + (size_t)i * kSlotStride) FrameRingSlot;
+        s->seq.store(0, std::memory_order_relaxed);
+    }
+
+    hdr->magic.store(FRAME_RING_MAGIC, std::memory_order_release);
+
+    std::unique_ptr<FrameRingProducer> producer(new FrameRingProducer());
+    producer->m_Map = new FrameRingMapping{hdr, slots, bytes, cap - 1};
+    producer->m_Name = path;
+    producer->m_OpenSeq = ~(uint64_t)0;
+    return producer;
+}
+
+FrameRingProducer::~FrameRingProducer()
+{
+    munmap(m_Map->header, m_Map->bytes);
+    // Attached consumers keep their mapping; new ones can no longer attach
+    shm_unlink(m_Name.c_str());
+    delete m_Map;
+}
+
+FrameRecord* FrameRingProducer::beginWrite()
+{
+    const uint64_t s = m_Map->header->writeSeq.load(std::memory_order_relaxed);
+    FrameRingSlot* slot = m_Map->slot(s);
+
+    slot->seq.store(2 * s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_OpenSeq = s;
+    slot->record.sequence = s;
+    return &slot->record;
+}
+
+void FrameRingProducer::commit()
+{
+    if (m_OpenSeq == ~(uint64_t)0) {
+        return;
+    }
+    const uint64_t s = m_OpenSeq;
+    FrameRingSlot* slot = m_Map->slot(s);
+    if (slot->record.numObjects > FRAME_RING_MAX_OBJECTS) {
+        slot->record.numObjects = FRAME_RING_MAX_OBJECTS;
+        slot->record.flags |= FRAME_RECORD_FLAG_TRUNCATED;
+    }
+
+    slot->seq.store(2 * s + 2, std::memory_order_release);
+    m_Map->header->writeSeq.store(s + 1, std::memory_order_release);
+    m_OpenSeq = ~(uint64_t)0;
+}
+
+void FrameRingProducer::publish(const FrameRecord& record)
+{
+    FrameRecord* dst = beginWrite();
+    const uint64_t seq = dst->sequence;
+    memcpy(dst, &record, usedBytes(record));
+    dst->sequence = seq;
+    commit();
+}
+
+uint64_t FrameRingProducer::published() const
+{
+    return m_Map->header->writeSeq.load(std::memory_order_relaxed);
+}
+
+uint32_t FrameRingProducer::capacity() const
+{
+    return m_Map->header->capacity;
+}
+
+uint32_t FrameRingProducer::consumers(FrameRingConsumerInfo* out, uint32_t maxOut) const
+{
+    const uint64_t w = published();
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < FRAME_RING_MAX_CONSUMERS && n < maxOut; ++i) {
+        const FrameRingConsumerSlot& c = m_Map->header->consumers[i];
+        const uint32_t pid = c.pid.load(std::memory_order_relaxed);
+        if (pid == 0) {
+            continue;
+        }
+        out[n].pid = pid;
+        out[n].cursor = c.cursor.load(std::memory_order_relaxed);
+        out[n].lag = w > out[n].cursor ? w - out[n].cursor : 0;
+        out[n].overruns = c.overruns.load(std::memory_order_relaxed);
+        n++;
+    }
+    return n;
+}
+
+std::unique_ptr<FrameRingConsumer> FrameRingConsumer::open(const std::string& name, bool fromOldest)
+{
+    const std::string path = shmName(name);
+    int fd = shm_open(path.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "ERROR: Frame ring " << path << " not found: " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < kHeaderBytes) {
+        std::cerr << "ERROR: Frame ring " << path << " is not initialised" << std::endl;
+        close(fd);
+        return nullptr;
+    }
+
+    // Consumers map read-write only to update their own cursor slot
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "ERROR: Could not map frame ring " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    FrameRingShmHeader* hdr = (FrameRingShmHeader*)addr;
+    if (hdr->magic.load(std::memory_order_acquire) != FRAME_RING_MAGIC || hdr->version != FRAME_RING_VERSION ||
+        hdr->recordSize != sizeof(FrameRecord) || hdr->slotStride != kSlotStride ||
+        kHeaderBytes + (size_t)hdr->capacity * kSlotStride > (size_t)st.st_size) {
+        std::cerr << "ERROR: Frame ring " << path << " has an incompatible layout" << std::endl;
+        munmap(addr, (size_t)st.st_size);
+        return nullptr;
+    }
+
+    // Claim a free cursor slot, recycling slots of consumers that died
+    const uint32_t self = (uint32_t)getpid();
+    int slot = -1;
+    for (int i = 0; i < FRAME_RING_MAX_CONSUMERS && slot < 0; ++i) {
+        uint32_t owner = hdr->consumers[i].pid.load(std::memory_order_relaxed);
+        if (owner != 0 && processAlive(owner)) {
+            continue;
+        }
+        if (hdr->consumers[i].pid.compare_exchange_strong(owner, self)) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        std::cerr << "ERROR: Frame ring " << path << " has no free consumer slots" << std::endl;
+        munmap(addr, (size_t)st.st_size);
+        return nullptr;
+    }
+
+    std::unique_ptr<FrameRingConsumer> consumer(new FrameRingConsumer());
+    consumer->m_Map = new FrameRingMapping{hdr, (uint8_t*)addr + kHeaderBytes, (size_t)st.st_size,
+                                           hdr->capacity - 1};
+    consumer->m_Slot = slot;
+    consumer->m_Overruns = 0;
+
+    const uint64_t w = hdr->writeSeq.load(std::memory_order_acquire);
+    consumer->m_Cursor = fromOldest ? (w > hdr->capacity ? w - hdr->capacity : 0) : w;
+
+    hdr->consumers[slot].cursor.store(consumer->m_Cursor, std::memory_order_relaxed);
+    hdr->consumers[slot].overruns.store(0, std::memory_order_relaxed);
+    return consumer;
+}
+
+FrameRingConsumer::~FrameRingConsumer()
+{
+    m_Map->header->consumers[m_Slot].pid.store(0, std::memory_order_release);
+    munmap(m_Map->header, m_Map->bytes);
+    delete m_Map;
+}
+
+bool FrameRingConsumer::next(FrameRecord& out)
+{
+    FrameRingShmHeader* hdr = m_Map->header;
+    const uint64_t cap = hdr->capacity;
+
+    while (true) {
+        const uint64_t w = hdr->writeSeq.load(std::memory_order_acquire);
+        if (m_Cursor >= w) {
+            return false;
+        }
+        if (w - m_Cursor > cap) {
+            // Lapped by the producer: skip to the oldest record still present
+            m_Overruns += w - cap - m_Cursor;
+            m_Cursor = w - cap;
+        }
+
+        const FrameRingSlot* slot = m_Map->slot(m_Cursor);
+        const uint64_t expected = 2 * m_Cursor + 2;
+        const uint64_t v1 = slot->seq.load(std::memory_order_acquire);
+        if (v1 != expected) {
+            // Slot already reused for a newer record; re-read writeSeq and skip
+            m_Overruns++;
+            m_Cursor++;
+            continue;
+        }
+
+        memcpy(&out, &slot->record, offsetof(FrameRecord, objects));
+        const uint16_t n = std::min<uint16_t>(out.numObjects, FRAME_RING_MAX_OBJECTS);
+        memcpy(out.objects, slot->record.objects, n * sizeof(FrameRecordObject));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->seq.load(std::memory_order_relaxed) != v1) {
+            // Torn read: the producer overwrote the slot while we copied it
+            m_Overruns++;
+            m_Cursor++;
+            continue;
+        }
+
+        out.numObjects = n;
+        m_Cursor++;
+        FrameRingConsumerSlot& c = hdr->consumers[m_Slot];
+        c.cursor.store(m_Cursor, std::memory_order_relaxed);
+        c.overruns.store(m_Overruns, std::memory_order_relaxed);
+        return true;
+    }
+}
+
+uint64_t FrameRingConsumer::lag() const
+{
+    const uint64_t w = m_Map->header->writeSeq.load(std::memory_order_relaxed);
+    return w > m_Cursor ? w - m_Cursor : 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * Shared-memory SPMC ring of per-frame detection metadata
+ *
+ * The pipeline (single producer) writes one fixed-size FrameRecord per
+ * frame into a POSIX shared-memory ring. Any number of sidecar processes
+ * attach as consumers, each with its own cursor, and read at their own pace.
+ *
+ * The producer never waits: when a consumer falls more than `capacity`
+ * records behind, the oldest records are overwritten and the consumer
+ * skips ahead, counting the lost records as overruns. Every slot carries a
+ * sequence word used as a seqlock, so a reader that races with the writer
+ * detects the torn copy and retries instead of returning mixed data.
+ *
+ * Consumers register their cursor in a small table in the segment so the
+ * producer (or a monitoring tool) can report per-consumer lag; the table is
+ * informational only and never gates the producer.
+ */
+
+#ifndef __FRAME_META_RING_H__
+#define __FRAME_META_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#define FRAME_RING_MAGIC 0x474e5246u  // "FRNG"
+#define FRAME_RING_VERSION 1
+#define FRAME_RING_MAX_OBJECTS 128
+#define FRAME_RING_MAX_CONSUMERS 16
+
+#define FRAME_RECORD_FLAG_TRUNCATED 0x1  // more objects than FRAME_RING_MAX_OBJECTS
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "Shared-memory ring needs lock-free 64-bit atomics"
+#endif
+
+struct FrameRingMapping;
+
+struct FrameRecordObject
+{
+    float left, top, width, height;
+    float confidence;
+    uint32_t globalId;  // 0 when not associated across cameras
+    uint64_t trackId;   // tracker-local id, ~0 when untracked
+    uint16_t classId;
+    uint16_t reserved[3];
+};
+
+struct FrameRecord
+{
+    uint64_t sequence;  // filled in by the producer
+    uint64_t ptsNs;
+    uint64_t wallClockNs;
+    uint32_t sourceId;
+    uint32_t frameNum;
+    uint16_t numObjects;
+    uint16_t flags;
+    uint32_t reserved;
+    FrameRecordObject objects[FRAME_RING_MAX_OBJECTS];
+};
+
+struct FrameRingConsumerInfo
+{
+    uint32_t pid;
+    uint64_t cursor;
+    uint64_t lag;
+    uint64_t overruns;
+};
+
+class FrameRingProducer
+{
+public:
+    // Creates (or replaces) the segment /dev/shm/<name>. Capacity is rounded
+    // up to a power of two. Returns nullptr on failure.
+    static std::unique_ptr<FrameRingProducer> create(const std::string& name, uint32_t capacity);
+    ~FrameRingProducer();
+
+    // Zero-copy write: fill the returned record, then call commit(). The
+    // pointer stays valid until commit(); only one write may be open.
+    FrameRecord* beginWrite();
+    void commit();
+
+    // Copies only the used part of `record` (header + numObjects entries).
+    void publish(const FrameRecord& record);
+
+    uint64_t published() const;
+    uint32_t capacity() const;
+
+    // Snapshot of attached consumers; returns the number written to `out`.
+    uint32_t consumers(FrameRingConsumerInfo* out, uint32_t maxOut) const;
+
+private:
+    FrameRingProducer() {}
+
+    FrameRingMapping* m_Map;
+    std::string m_Name;
+    uint64_t m_OpenSeq;
+};
+
+class FrameRingConsumer
+{
+public:
+    // Attaches to an existing segment. The cursor starts after the newest
+    // record (only new frames are read) unless fromOldest is set. Returns nullptr if the segment does
+    // not exist, has the wrong layout, or all consumer slots are taken.
+    static std::unique_ptr<FrameRingConsumer> open(const std::string& name, bool fromOldest = false);
+    ~FrameRingConsumer();
+
+    // Copies the next record into `out`. Returns false when caught up.
+    // Records overwritten before they could be read are added to overruns().
+    bool next(FrameRecord& out);
+
+    uint64_t cursor() const { return m_Cursor; }
+    uint64_t overruns() const { return m_Overruns; }
+    uint64_t lag() const;
+
+private:
+    FrameRingConsumer() {}
+
+    FrameRingMapping* m_Map;
+    int m_Slot;
+    uint64_t m_Cursor;
+    uint64_t m_Overruns;
+};
+
+#endif
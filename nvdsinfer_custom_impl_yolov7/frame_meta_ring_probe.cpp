@@ -0,0 +1,58 @@
+/*
+ * GStreamer pad probe that feeds the shared-memory frame ring
+ */
+
+#include "frame_meta_ring_probe.h"
+
+#include "gstnvdsmeta.h"
+
+#include <chrono>
+
+extern "C" GstPadProbeReturn frameRingPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData)
+{
+    (void)pad;
+    FrameRingProducer* producer = (FrameRingProducer*)userData;
+    GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    NvDsBatchMeta* batchMeta = buf ? gst_buffer_get_nvds_batch_meta(buf) : nullptr;
+    if (!producer || !batchMeta) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    const uint64_t nowNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    for (NvDsMetaList* l_frame = batchMeta->frame_meta_list; l_frame != nullptr; l_frame = l_frame->next) {
+        NvDsFrameMeta* frameMeta = (NvDsFrameMeta*)(l_frame->data);
+
+        FrameRecord* rec = producer->beginWrite();
+        rec->ptsNs = frameMeta->buf_pts;
+        rec->wallClockNs = frameMeta->ntp_timestamp ? frameMeta->ntp_timestamp : nowNs;
+        rec->sourceId = frameMeta->source_id;
+        rec->frameNum = (uint32_t)frameMeta->frame_num;
+        rec->flags = 0;
+        rec->reserved = 0;
+
+        uint16_t n = 0;
+        for (NvDsMetaList* l_obj = frameMeta->obj_meta_list; l_obj != nullptr; l_obj = l_obj->next) {
+            if (n == FRAME_RING_MAX_OBJECTS) {
+                rec->flags |= FRAME_RECORD_FLAG_TRUNCATED;
+                break;
+            }
+            NvDsObjectMeta* objMeta = (NvDsObjectMeta*)(l_obj->data);
+            FrameRecordObject& o = rec->objects[n++];
+            o.left = objMeta->rect_params.left;
+            o.top = objMeta->rect_params.top;
+            o.width = objMeta->rect_params.width;
+            o.height = objMeta->rect_params.height;
+            o.confidence = objMeta->confidence;
+            o.globalId = 0;
+            o.trackId = objMeta->object_id;
+            o.classId = (uint16_t)objMeta->class_id;
+        }
+        rec->numObjects = n;
+
+        producer->commit();
+    }
+
+    return GST_PAD_PROBE_OK;
+}
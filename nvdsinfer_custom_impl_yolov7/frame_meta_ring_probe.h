@@ -0,0 +1,22 @@
+/*
+ * GStreamer pad probe that feeds the shared-memory frame ring
+ */
+
+#ifndef __FRAME_META_RING_PROBE_H__
+#define __FRAME_META_RING_PROBE_H__
+
+#include "frame_meta_ring.h"
+
+#include <gst/gst.h>
+
+// Attach after the tracker with user_data pointing at a FrameRingProducer:
+//
+//   gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, frameRingPadProbe, producer, NULL);
+//
+// Publishes one record per frame in the batch and always returns
+// GST_PAD_PROBE_OK; the pipeline never waits on ring consumers. No stage
+// writes cross-camera ids into the object meta, so globalId is always 0;
+// consumers that associate key their results by sourceId and trackId.
+extern "C" GstPadProbeReturn frameRingPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData);
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ * Per-source network input resolution selection
+ */
+
+#include "input_resolution.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+bool InputResolutionConfig::load(const std::string& path, InputResolutionConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+
+    const std::string g = "input-resolution";
+    if (!kf.hasGroup(g)) {
+        std::cerr << "ERROR: " << path << " has no [input-resolution] group" << std::endl;
+        return false;
+    }
+
+    const std::vector<int> profiles = kf.getIntList(g, "profiles");
+    if (!profiles.empty()) {
+        config.profiles.clear();
+        for (int p : profiles) {
+            if (p <= 0 || p % 32 != 0) {
+                std::cerr << "ERROR: Input profile " << p << " is not a positive multiple of 32" << std::endl;
+                return false;
+            }
+            config.profiles.push_back((uint32_t)p);
+        }
+        std::sort(config.profiles.begin(), config.profiles.end());
+    }
+    config.defaultProfile = (uint32_t)kf.getInt(g, "default-profile", (int)config.defaultProfile);
+    config.muxWidth = (uint32_t)kf.getInt(g, "mux-width", (int)config.muxWidth);
+    config.muxHeight = (uint32_t)kf.getInt(g, "mux-height", (int)config.muxHeight);
+    config.minTargetPx = kf.getDouble(g, "min-target-px", config.minTargetPx);
+    config.percentile = kf.getDouble(g, "percentile", config.percentile);
+    config.minSamples = (uint32_t)kf.getInt(g, "min-samples", (int)config.minSamples);
+    config.numSources = (uint32_t)kf.getInt(g, "num-sources", (int)config.numSources);
+
+    if (std::find(config.profiles.begin(), config.profiles.end(), config.defaultProfile) == config.profiles.end()) {
+        std::cerr << "ERROR: default-profile " << config.defaultProfile << " is not in profiles" << std::endl;
+        return false;
+    }
+    if (config.muxWidth == 0 || config.muxHeight == 0 || config.percentile <= 0.0 || config.percentile >= 1.0) {
+        std::cerr << "ERROR: " << path << " needs mux-width/mux-height and 0 < percentile < 1" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+InputResolutionSelector::InputResolutionSelector(const InputResolutionConfig& config, uint32_t numSources)
+    : m_Config(config), m_Hist(numSources, std::vector<uint32_t>(kBins, 0)), m_Samples(numSources, 0)
+{
+}
+
+void InputResolutionSelector::observe(uint32_t sourceId, float width, float height)
+{
+    if (sourceId >= m_Hist.size() || width <= 0.0f || height <= 0.0f) {
+        return;
+    }
+    // Shorter side once the frame is squashed to a kBinScale square input
+    const double side = std::min((double)width / m_Config.muxWidth, (double)height / m_Config.muxHeight) * kBinScale;
+    const uint32_t bin = (uint32_t)std::min<double>(side, kBins - 1);
+    m_Hist[sourceId][bin]++;
+    m_Samples[sourceId]++;
+}
+
+uint64_t InputResolutionSelector::samples(uint32_t sourceId) const
+{
+    return sourceId < m_Samples.size() ? m_Samples[sourceId] : 0;
+}
+
+double InputResolutionSelector::percentileSize(uint32_t sourceId, uint32_t profile) const
+{
+    const uint64_t n = samples(sourceId);
+    if (n == 0) {
+        return 0.0;
+    }
+    const uint64_t rank = (uint64_t)std::ceil(m_Config.percentile * n);
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < kBins; ++b) {
+        seen += m_Hist[sourceId][b];
+        if (seen >= rank) {
+            return (double)b * profile / kBinScale;
+        }
+    }
+    return (double)(kBins - 1) * profile / kBinScale;
+}
+
+uint32_t InputResolutionSelector::select(uint32_t sourceId) const
+{
+    if (samples(sourceId) < m_Config.minSamples) {
+        return m_Config.defaultProfile;
+    }
+    // Lower edge of the percentile bin, so the choice errs towards the
+    // larger profile
+    for (uint32_t p : m_Config.profiles) {
+        if (percentileSize(sourceId, p) >= m_Config.minTargetPx) {
+            return p;
+        }
+    }
+    return m_Config.profiles.back();
+}
+
+double InputResolutionSelector::relativeCompute() const
+{
+    if (m_Hist.empty()) {
+        return 1.0;
+    }
+    double pixels = 0.0;
+    for (uint32_t s = 0; s < m_Hist.size(); ++s) {
+        const double p = select(s);
+        pixels += p * p;
+    }
+    const double d = m_Config.defaultProfile;
+    return pixels / (m_Hist.size() * d * d);
+}
+
+bool InputResolutionSelector::writePipelineConfigs(const std::string& dir, const std::string& model,
+                                                   uint32_t maxBatchSize, uint32_t firstGieId) const
+{
+    uint32_t gieId = firstGieId;
+    for (uint32_t p : m_Config.profiles) {
+        std::string srcIds;
+        for (uint32_t s = 0; s < m_Hist.size(); ++s) {
+            if (select(s) == p) {
+                srcIds += (srcIds.empty() ? "" : ";") + std::to_string(s);
+            }
+        }
+        if (srcIds.empty()) {
+            continue;
+        }
+
+        const std::string res = std::to_string(p);
+        const std::string preprocessPath = dir + "/config_preprocess_" + res + ".txt";
+        std::ofstream pre(preprocessPath);
+        pre << "# Generated by InputResolutionSelector: sources on the " << res << "x" << res << " profile\n"
+            << "[property]\n"
+            << "enable=1\n"
+            << "target-unique-ids=" << gieId << "\n"
+            << "network-input-order=0\n"
+            << "process-on-frame=1\n"
+            << "unique-id=" << 100 + gieId << "\n"
+            << "gpu-id=0\n"
+            << "maintain-aspect-ratio=0\n"
+            << "symmetric-padding=0\n"
+            << "processing-width=" << res << "\n"
+            << "processing-height=" << res << "\n"
+            << "scaling-buf-pool-size=6\n"
+            << "tensor-buf-pool-size=6\n"
+            << "network-input-shape=" << maxBatchSize << ";3;" << res << ";" << res << "\n"
+            << "network-color-format=0\n"
+            << "tensor-data-type=0\n"
+            << "tensor-name=input\n"
+            << "scaling-pool-memory-type=0\n"
+            << "scaling-pool-compute-hw=0\n"
+            << "scaling-filter=0\n"
+            << "custom-lib-path=/opt/nvidia/deepstream/deepstream/lib/gst-plugins/libcustom2d_preprocess.so\n"
+            << "custom-tensor-preparation-function=CustomTensorPreparation\n"
+            << "\n"
+            << "[user-configs]\n"
+            << "pixel-normalization-factor=0.003921568\n"
+            << "\n"
+            << "[group-0]\n"
+            << "src-ids=" << srcIds << "\n"
+            << "custom-input-transformation-function=CustomAsyncTransformation\n"
+            << "process-on-roi=0\n";
+        if (!pre) {
+            std::cerr << "ERROR: Failed to write " << preprocessPath << std::endl;
+            return false;
+        }
+
+        const std::string inferPath = dir + "/config_infer_triton_" + res + ".txt";
+        std::ofstream inf(inferPath);
+        inf << "# Generated by InputResolutionSelector: " << res << "x" << res << " profile of " << model << "\n"
+            << "infer_config {\n"
+            << "  unique_id: " << gieId << "\n"
+            << "  gpu_ids: 0\n"
+            << "  max_batch_size: " << maxBatchSize << "\n"
+            << "  backend {\n"
+            << "    inputs [\n"
+            << "      {\n"
+            << "        name: \"input\"\n"
+            << "        dims: [3, " << res << ", " << res << "]\n"
+            << "      }\n"
+            << "    ]\n"
+            << "    outputs [\n"
+            << "      {\n"
+            << "        name: \"output\"\n"
+            << "      }\n"
+            << "    ]\n"
+            << "    triton {\n"
+            << "      model_name: \"" << model << "\"\n"
+            << "      version: -1\n"
+            << "      grpc {\n"
+            << "        url: \"triton:8001\"\n"
+            << "        enable_cuda_buffer_sharing: false\n"
+            << "      }\n"
+            << "    }\n"
+            << "  }\n"
+            << "\n"
+            << "  postprocess {\n"
+            << "    labelfile_path: \"/workspace/labels/coco_labels.txt\"\n"
+            << "    detection {\n"
+            << "      num_detected_classes: 80\n"
+            << "      custom_parse_bbox_func: \"NvDsInferParseYolov7\"\n"
+            << "      nms {\n"
+            << "        confidence_threshold: 0.25\n"
+            << "        iou_threshold: 0.45\n"
+            << "        topk: 300\n"
+            << "      }\n"
+            << "    }\n"
+            << "  }\n"
+            << "\n"
+            << "  custom_lib {\n"
+            << "    path: \"/workspace/nvdsinfer_custom_impl_yolov7/libnvdsinfer_custom_impl_Yolo.so\"\n"
+            << "  }\n"
+            << "}\n"
+            << "\n"
+            << "input_tensor_from_meta {\n"
+            << "  is_first_dim_batch: true\n"
+            << "}\n";
+        if (!inf) {
+            std::cerr << "ERROR: Failed to write " << inferPath << std::endl;
+            return false;
+        }
+        gieId++;
+    }
+    return true;
+}
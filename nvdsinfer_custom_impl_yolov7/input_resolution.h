@@ -0,0 +1,89 @@
+/*
+ * Per-source network input resolution selection
+ *
+ * Close-range cameras see large targets and waste most of a 640x640 input;
+ * wide scenes need more than that to keep small targets detectable. The
+ * selector keeps a histogram of the observed target sizes per source (the
+ * shorter box side after scaling the streammux frame to a square input)
+ * and picks the smallest profile at which the `percentile` smallest
+ * targets still cover at least min-target-px input pixels. Sources with
+ * too few samples stay on the default profile.
+ *
+ * Each profile is served by its own nvdspreprocess + nvinferserver pair
+ * (src-ids restricted to the sources on that profile) in front of one
+ * dynamic-shape engine with one optimization profile per resolution;
+ * writePipelineConfigs() emits those element configs. The parser derives
+ * the input size from the output row count, so one custom lib handles all
+ * profiles.
+ *
+ * Config (key file format, see configs/input_resolution.txt):
+ *
+ *   [input-resolution]
+ *   profiles=320;480;640;960
+ *   default-profile=640
+ *   mux-width=1920
+ *   mux-height=1080
+ *   min-target-px=12
+ *   percentile=0.1
+ *   min-samples=500
+ *   num-sources=2
+ */
+
+#ifndef __INPUT_RESOLUTION_H__
+#define __INPUT_RESOLUTION_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct InputResolutionConfig
+{
+    std::vector<uint32_t> profiles = {320, 480, 640, 960};  // square inputs, ascending
+    uint32_t defaultProfile = 640;
+    uint32_t muxWidth = 1920;
+    uint32_t muxHeight = 1080;
+    double minTargetPx = 12.0;
+    double percentile = 0.1;
+    uint32_t minSamples = 500;
+    uint32_t numSources = 0;
+
+    static bool load(const std::string& path, InputResolutionConfig& config);
+};
+
+class InputResolutionSelector
+{
+public:
+    InputResolutionSelector(const InputResolutionConfig& config, uint32_t numSources);
+
+    // One detected target on `sourceId`, box size in streammux pixels
+    void observe(uint32_t sourceId, float width, float height);
+
+    // Chosen input side length for the source
+    uint32_t select(uint32_t sourceId) const;
+
+    uint64_t samples(uint32_t sourceId) const;
+    // Shorter side of the percentile target in pixels of a profile x profile
+    // input, 0 without samples
+    double percentileSize(uint32_t sourceId, uint32_t profile) const;
+
+    // Network compute of the current selection relative to running every
+    // source at the default profile (pixels per frame)
+    double relativeCompute() const;
+
+    // Writes config_preprocess_<R>.txt and config_infer_triton_<R>.txt for
+    // every profile in use into `dir`. GIE unique ids start at firstGieId.
+    bool writePipelineConfigs(const std::string& dir, const std::string& model, uint32_t maxBatchSize,
+                              uint32_t firstGieId) const;
+
+private:
+    // Bin i holds targets of i..i+1 px at a 2048x2048 input; the last bin
+    // is open-ended (large targets never decide the profile)
+    static const uint32_t kBins = 1024;
+    static const uint32_t kBinScale = 2048;
+
+    InputResolutionConfig m_Config;
+    std::vector<std::vector<uint32_t>> m_Hist;
+    std::vector<uint64_t> m_Samples;
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Minimal INI-style key file reader
+ */
+
+#include "key_file.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static std::string trim(const std::string& s)
+{
+    const char* ws = " \t\r\n";
+    size_t b = s.find_first_not_of(ws);
+    if (b == std::string::npos) {
+        return std::string();
+    }
+    size_t e = s.find_last_not_of(ws);
+    return s.substr(b, e - b + 1);
+}
+
+static std::vector<std::string> splitList(const std::string& value)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+        item = trim(item);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool KeyFile::loadFromFile(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "ERROR: Could not open config file " << path << std::endl;
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return loadFromString(ss.str());
+}
+
+bool KeyFile::loadFromString(const std::string& text)
+{
+    m_Groups.clear();
+    m_Order.clear();
+
+    std::stringstream ss(text);
+    std::string line;
+    std::string group;
+    int lineNo = 0;
+    while (std::getline(ss, line)) {
+        lineNo++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+        if (line[0] == '[') {
+            if (line.back() != ']') {
+                std::cerr << "ERROR: Malformed group header at line " << lineNo << ": " << line << std::endl;
+                return false;
+            }
+            group = trim(line.substr(1, line.size() - 2));
+            if (m_Groups.find(group) == m_Groups.end()) {
+                m_Order.push_back(group);
+            }
+            m_Groups[group];
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos || group.empty()) {
+            std::cerr << "ERROR: Expected key=value inside a group at line " << lineNo << ": " << line << std::endl;
+            return false;
+        }
+        m_Groups[group][trim(line.substr(0, eq))] = trim(line.substr(eq + 1));
+    }
+    return true;
+}
+
+bool KeyFile::hasGroup(const std::string& group) const
+{
+    return m_Groups.find(group) != m_Groups.end();
+}
+
+bool KeyFile::hasKey(const std::string& group, const std::string& key) const
+{
+    auto g = m_Groups.find(group);
+    return g != m_Groups.end() && g->second.find(key) != g->second.end();
+}
+
+std::string KeyFile::getString(const std::string& group, const std::string& key, const std::string& def) const
+{
+    auto g = m_Groups.find(group);
+    if (g == m_Groups.end()) {
+        return def;
+    }
+    auto k = g->second.find(key);
+    return k == g->second.end() ? def : k->second;
+}
+
+int KeyFile::getInt(const std::string& group, const std::string& key, int def) const
+{
+    std::string v = getString(group, key);
+    return v.empty() ? def : atoi(v.c_str());
+}
+
+double KeyFile::getDouble(const std::string& group, const std::string& key, double def) const
+{
+    std::string v = getString(group, key);
+    return v.empty() ? def : atof(v.c_str());
+}
+
+bool KeyFile::getBool(const std::string& group, const std::string& key, bool def) const
+{
+    std::string v = getString(group, key);
+    if (v.empty()) {
+        return def;
+    }
+    return v == "1" || v == "true" || v == "TRUE" || v == "yes";
+}
+
+std::vector<double> KeyFile::getDoubleList(const std::string& group, const std::string& key) const
+{
+    std::vector<double> out;
+    for (const std::string& item : splitList(getString(group, key))) {
+        out.push_back(atof(item.c_str()));
+    }
+    return out;
+}
+
+std::vector<int> KeyFile::getIntList(const std::string& group, const std::string& key) const
+{
+    std::vector<int> out;
+    for (const std::string& item : splitList(getString(group, key))) {
+        out.push_back(atoi(item.c_str()));
+    }
+    return out;
+}
@@ -0,0 +1,40 @@
+/*
+ * Minimal INI-style key file reader
+ *
+ * Reads the same "[group]\nkey=value" format as the DeepStream app configs
+ * (GKeyFile) without pulling GLib into host-side tools. Lines starting with
+ * '#' or ';' are comments; list values are separated by ';'.
+ */
+
+#ifndef __KEY_FILE_H__
+#define __KEY_FILE_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+class KeyFile
+{
+public:
+    bool loadFromFile(const std::string& path);
+    bool loadFromString(const std::string& text);
+
+    bool hasGroup(const std::string& group) const;
+    bool hasKey(const std::string& group, const std::string& key) const;
+
+    // Groups in file order
+    const std::vector<std::string>& groups() const { return m_Order; }
+
+    std::string getString(const std::string& group, const std::string& key, const std::string& def = "") const;
+    int getInt(const std::string& group, const std::string& key, int def = 0) const;
+    double getDouble(const std::string& group, const std::string& key, double def = 0.0) const;
+    bool getBool(const std::string& group, const std::string& key, bool def = false) const;
+    std::vector<double> getDoubleList(const std::string& group, const std::string& key) const;
+    std::vector<int> getIntList(const std::string& group, const std::string& key) const;
+
+private:
+    std::map<std::string, std::map<std::string, std::string>> m_Groups;
+    std::vector<std::string> m_Order;
+};
+
+#endif
@@ -0,0 +1,324 @@
+/*
+ * Priority-aware load shedding under inference back-pressure
+ */
+
+#include "load_shedder.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+bool LoadShedConfig::load(const std::string& path, LoadShedConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+
+    const std::string g = "load-shedding";
+    if (!kf.hasGroup(g)) {
+        std::cerr << "ERROR: " << path << " has no [load-shedding] group" << std::endl;
+        return false;
+    }
+    config.numSources = (uint32_t)std::max(0, kf.getInt(g, "num-sources", (int)config.numSources));
+    config.queueHigh = kf.getDouble(g, "queue-high", config.queueHigh);
+    config.queueLow = kf.getDouble(g, "queue-low", config.queueLow);
+    config.latencyHighMs = kf.getDouble(g, "latency-high-ms", config.latencyHighMs);
+    config.latencyLowMs = kf.getDouble(g, "latency-low-ms", config.latencyLowMs);
+    config.escalateHoldMs = (uint32_t)kf.getInt(g, "escalate-hold-ms", (int)config.escalateHoldMs);
+    config.relaxHoldMs = (uint32_t)kf.getInt(g, "relax-hold-ms", (int)config.relaxHoldMs);
+    config.protectPriority = kf.getInt(g, "protect-priority", config.protectPriority);
+    config.defaultPriority = kf.getInt(g, "default-priority", config.defaultPriority);
+
+    if (kf.hasKey(g, "skip-intervals")) {
+        config.skipIntervals.clear();
+        for (int v : kf.getIntList(g, "skip-intervals")) {
+            if (v > 1) {
+                config.skipIntervals.push_back((uint32_t)v);
+            }
+        }
+    }
+    if (kf.hasKey(g, "resolution-scales")) {
+        config.resolutionScales.clear();
+        for (double v : kf.getDoubleList(g, "resolution-scales")) {
+            if (v > 0.0 && v < 1.0) {
+                config.resolutionScales.push_back((float)v);
+            }
+        }
+    }
+
+    config.sourcePriority.clear();
+    for (const std::string& group : kf.groups()) {
+        if (group.compare(0, 6, "source") != 0) {
+            continue;
+        }
+        const int id = atoi(group.c_str() + 6);
+        if (id < 0) {
+            continue;
+        }
+        if ((size_t)id >= config.sourcePriority.size()) {
+            config.sourcePriority.resize(id + 1, config.defaultPriority);
+        }
+        config.sourcePriority[id] = kf.getInt(group, "priority", config.defaultPriority);
+    }
+
+    if (config.queueLow > config.queueHigh || config.latencyLowMs > config.latencyHighMs) {
+        std::cerr << "ERROR: Load shedding low watermarks must not exceed the high watermarks" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+LoadShedder::LoadShedder(const LoadShedConfig& config, uint32_t numSources)
+    : m_Config(config),
+      m_Sources(new SourceState[numSources]),
+      m_NumSources(numSources),
+      m_Actuator(nullptr),
+      m_Level(0),
+      m_Over(false),
+      m_Under(false),
+      m_OverSinceUs(0),
+      m_UnderSinceUs(0),
+      m_LastQueue(0.0),
+      m_LastLatencyMs(0.0),
+      m_Escalations(0),
+      m_Relaxations(0)
+{
+    int lowest = m_Config.protectPriority;
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        m_Sources[s].priority = s < m_Config.sourcePriority.size() ? m_Config.sourcePriority[s]
+                                                                   : m_Config.defaultPriority;
+        lowest = std::max(lowest, m_Sources[s].priority);
+    }
+
+    // Build the ladder from the lowest-priority class upwards; only classes
+    // that actually have sources get steps.
+    for (int p = lowest; p > m_Config.protectPriority; --p) {
+        bool used = false;
+        for (uint32_t s = 0; s < m_NumSources; ++s) {
+            used = used || m_Sources[s].priority == p;
+        }
+        if (!used) {
+            continue;
+        }
+        for (uint32_t interval : m_Config.skipIntervals) {
+            m_Ladder.push_back(LoadShedStep{p, interval, 0.0f});
+        }
+        for (float scale : m_Config.resolutionScales) {
+            m_Ladder.push_back(LoadShedStep{p, 0, scale});
+        }
+    }
+}
+
+int LoadShedder::observe(double queueDepth, double latencyMs, uint64_t nowUs)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_LastQueue = queueDepth;
+    m_LastLatencyMs = latencyMs;
+
+    const bool over = queueDepth > m_Config.queueHigh || latencyMs > m_Config.latencyHighMs;
+    const bool under = queueDepth < m_Config.queueLow && latencyMs < m_Config.latencyLowMs;
+
+    // Either signal crossing its high watermark counts as overload; relaxing
+    // needs both below their low watermarks. Between the two bands nothing
+    // changes, which is what keeps the controller from oscillating.
+    // Explicit flags: 0 is a valid timestamp (e.g. a stream-time clock)
+    if (over && !m_Over) {
+        m_OverSinceUs = nowUs;
+    }
+    if (under && !m_Under) {
+        m_UnderSinceUs = nowUs;
+    }
+    m_Over = over;
+    m_Under = under;
+
+    const int level = m_Level.load(std::memory_order_relaxed);
+    int target = level;
+    if (over && level < (int)m_Ladder.size() && nowUs - m_OverSinceUs >= (uint64_t)m_Config.escalateHoldMs * 1000) {
+        target = level + 1;
+        m_OverSinceUs = nowUs;  // require a fresh hold period per step
+        m_Escalations++;
+    } else if (under && level > 0 && nowUs - m_UnderSinceUs >= (uint64_t)m_Config.relaxHoldMs * 1000) {
+        target = level - 1;
+        m_UnderSinceUs = nowUs;
+        m_Relaxations++;
+    }
+
+    if (target != level) {
+        applyLevel(target);
+        m_Level.store(target, std::memory_order_relaxed);
+        if (m_OnDecision) {
+            const LoadShedStep& step = m_Ladder[std::max(target, level) - 1];
+            m_OnDecision(LoadShedDecision{nowUs, level, target, queueDepth, latencyMs, step});
+        }
+    }
+    return target;
+}
+
+void LoadShedder::applyLevel(int level)
+{
+    // Recompute every source from scratch: the first `level` steps apply
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        uint32_t interval = 1;
+        float scale = 1.0f;
+        for (int i = 0; i < level; ++i) {
+            const LoadShedStep& step = m_Ladder[i];
+            if (step.priority != m_Sources[s].priority) {
+                continue;
+            }
+            if (step.inferInterval) {
+                interval = step.inferInterval;
+            }
+            if (step.resolutionScale > 0.0f) {
+                scale = step.resolutionScale;
+            }
+        }
+
+        SourceState& src = m_Sources[s];
+        if (src.interval.exchange(interval, std::memory_order_relaxed) != interval && m_Actuator) {
+            m_Actuator->setInferInterval(s, interval);
+        }
+        if (src.scale.exchange(scale, std::memory_order_relaxed) != scale && m_Actuator) {
+            m_Actuator->setResolutionScale(s, scale);
+        }
+    }
+}
+
+bool LoadShedder::shouldInfer(uint32_t sourceId, uint64_t frameNum)
+{
+    if (sourceId >= m_NumSources) {
+        return true;
+    }
+    SourceState& src = m_Sources[sourceId];
+    const uint32_t interval = src.interval.load(std::memory_order_relaxed);
+    if (interval > 1 && frameNum % interval != 0) {
+        src.skipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    src.inferred.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool LoadShedder::shouldInferNext(uint32_t sourceId)
+{
+    if (sourceId >= m_NumSources) {
+        return true;
+    }
+    return shouldInfer(sourceId, m_Sources[sourceId].arrived.fetch_add(1, std::memory_order_relaxed));
+}
+
+void LoadShedder::batchStarted(uint64_t nowUs)
+{
+    std::lock_guard<std::mutex> lock(m_BatchMutex);
+    if (m_BatchStartUs.size() >= kMaxInFlight) {
+        m_BatchStartUs.pop_front();
+    }
+    m_BatchStartUs.push_back(nowUs);
+}
+
+int LoadShedder::batchFinished(uint64_t nowUs)
+{
+    uint64_t startUs;
+    size_t inFlight;
+    {
+        std::lock_guard<std::mutex> lock(m_BatchMutex);
+        if (m_BatchStartUs.empty()) {
+            return level();
+        }
+        inFlight = m_BatchStartUs.size();
+        startUs = m_BatchStartUs.front();
+        m_BatchStartUs.pop_front();
+    }
+    const double latencyMs = nowUs > startUs ? (double)(nowUs - startUs) / 1000.0 : 0.0;
+    return observe((double)inFlight, latencyMs, nowUs);
+}
+
+uint32_t LoadShedder::inferInterval(uint32_t sourceId) const
+{
+    return sourceId < m_NumSources ? m_Sources[sourceId].interval.load(std::memory_order_relaxed) : 1;
+}
+
+float LoadShedder::resolutionScale(uint32_t sourceId) const
+{
+    return sourceId < m_NumSources ? m_Sources[sourceId].scale.load(std::memory_order_relaxed) : 1.0f;
+}
+
+void LoadShedder::writePrometheus(std::string& out) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::ostringstream os;
+
+    os << "# HELP deepstream_loadshed_level Current step on the shedding ladder\n"
+       << "# TYPE deepstream_loadshed_level gauge\n"
+       << "deepstream_loadshed_level " << m_Level.load(std::memory_order_relaxed) << "\n"
+       << "# TYPE deepstream_loadshed_max_level gauge\n"
+       << "deepstream_loadshed_max_level " << m_Ladder.size() << "\n"
+       << "# TYPE deepstream_loadshed_transitions_total counter\n"
+       << "deepstream_loadshed_transitions_total{direction=\"escalate\"} " << m_Escalations << "\n"
+       << "deepstream_loadshed_transitions_total{direction=\"relax\"} " << m_Relaxations << "\n"
+       << "# TYPE deepstream_loadshed_queue_depth gauge\n"
+       << "deepstream_loadshed_queue_depth " << m_LastQueue << "\n"
+       << "# TYPE deepstream_loadshed_latency_ms gauge\n"
+       << "deepstream_loadshed_latency_ms " << m_LastLatencyMs << "\n";
+
+    os << "# TYPE deepstream_loadshed_infer_interval gauge\n";
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        os << "deepstream_loadshed_infer_interval{source=\"" << s << "\",priority=\"" << m_Sources[s].priority
+           << "\"} " << m_Sources[s].interval.load(std::memory_order_relaxed) << "\n";
+    }
+    os << "# TYPE deepstream_loadshed_resolution_scale gauge\n";
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        os << "deepstream_loadshed_resolution_scale{source=\"" << s << "\",priority=\"" << m_Sources[s].priority
+           << "\"} " << m_Sources[s].scale.load(std::memory_order_relaxed) << "\n";
+    }
+    os << "# TYPE deepstream_loadshed_frames_total counter\n";
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        os << "deepstream_loadshed_frames_total{source=\"" << s << "\",decision=\"infer\"} "
+           << m_Sources[s].inferred.load(std::memory_order_relaxed) << "\n"
+           << "deepstream_loadshed_frames_total{source=\"" << s << "\",decision=\"skip\"} "
+           << m_Sources[s].skipped.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out = os.str();
+}
+
+// Sums every sample of `metric` whose label set contains model="<model>"
+static bool sumMetric(const std::string& text, const std::string& metric, const std::string& model, double& sum)
+{
+    const std::string label = "model=\"" + model + "\"";
+    bool found = false;
+    sum = 0.0;
+
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#' || line.compare(0, metric.size(), metric) != 0 ||
+            line.size() <= metric.size() || line[metric.size()] != '{') {
+            continue;
+        }
+        size_t close = line.find('}');
+        if (close == std::string::npos || line.find(label) > close) {
+            continue;
+        }
+        sum += atof(line.c_str() + close + 1);
+        found = true;
+    }
+    return found;
+}
+
+bool parseTritonQueueMetrics(const std::string& text, const std::string& model, double& pending,
+                             double& queueUsTotal, double& requestTotal)
+{
+    if (!sumMetric(text, "nv_inference_request_success", model, requestTotal)) {
+        return false;
+    }
+    sumMetric(text, "nv_inference_queue_duration_us", model, queueUsTotal);
+    // Older Triton releases do not export the pending gauge
+    if (!sumMetric(text, "nv_inference_pending_request_count", model, pending)) {
+        pending = 0.0;
+    }
+    return true;
+}
@@ -0,0 +1,185 @@
+/*
+ * Priority-aware load shedding under inference back-pressure
+ *
+ * The controller watches inference queue depth and latency against high and
+ * low watermarks and walks a fixed shedding ladder one step at a time:
+ *
+ *   for each priority class, lowest priority first:
+ *       raise the inference interval (skip-intervals, e.g. every 2nd, 4th frame)
+ *       then lower the input resolution (resolution-scales, e.g. 0.75, 0.5)
+ *
+ * so low-priority cameras lose frames first, then resolution, and higher
+ * classes are only touched once everything below them is fully shed.
+ * Classes at or above protect-priority (numerically <=) are never shed.
+ * Stepping up needs the overload to persist for escalate-hold-ms, stepping
+ * back down needs both signals below the low watermarks for relax-hold-ms.
+ *
+ * Every transition is reported through the decision callback and counted,
+ * and the current per-source actions are exported in Prometheus text
+ * format by writePrometheus().
+ *
+ * In a pipeline, load_shedder_probe.h feeds it and applies skip intervals:
+ * probes on the inference element time each batch (batchStarted() /
+ * batchFinished()), and probes on the streammux sink pads drop the frames
+ * shouldInferNext() rejects. Resolution steps need a LoadShedActuator from
+ * the host; without one they are only reported.
+ *
+ * Priority 0 is the most important class. Config (key file format):
+ *
+ *   [load-shedding]
+ *   num-sources=0           # at least the highest [source<N>] + 1
+ *   queue-high=8
+ *   queue-low=2
+ *   latency-high-ms=150
+ *   latency-low-ms=60
+ *   escalate-hold-ms=1000
+ *   relax-hold-ms=5000
+ *   protect-priority=0
+ *   default-priority=1
+ *   skip-intervals=2;4
+ *   resolution-scales=0.75;0.5
+ *
+ *   [source<N>]
+ *   priority=0
+ */
+
+#ifndef __LOAD_SHEDDER_H__
+#define __LOAD_SHEDDER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct LoadShedConfig
+{
+    uint32_t numSources = 0;
+    double queueHigh = 8.0;
+    double queueLow = 2.0;
+    double latencyHighMs = 150.0;
+    double latencyLowMs = 60.0;
+    uint32_t escalateHoldMs = 1000;
+    uint32_t relaxHoldMs = 5000;
+    int protectPriority = 0;   // classes with priority <= this keep full fidelity
+    int defaultPriority = 1;
+    std::vector<uint32_t> skipIntervals = {2, 4};
+    std::vector<float> resolutionScales = {0.75f, 0.5f};
+    std::vector<int> sourcePriority;  // indexed by source id
+
+    static bool load(const std::string& path, LoadShedConfig& config);
+};
+
+// One step of the shedding ladder
+struct LoadShedStep
+{
+    int priority;
+    uint32_t inferInterval;  // 0 = unchanged
+    float resolutionScale;   // 0 = unchanged
+};
+
+struct LoadShedDecision
+{
+    uint64_t timestampUs;
+    int fromLevel;
+    int toLevel;
+    double queueDepth;
+    double latencyMs;
+    LoadShedStep step;  // the step applied (escalate) or undone (relax)
+};
+
+// Receives per-source changes so the host can apply them to the pipeline,
+// e.g. by reconfiguring the preprocess scaling for that source.
+class LoadShedActuator
+{
+public:
+    virtual ~LoadShedActuator() {}
+    virtual void setInferInterval(uint32_t sourceId, uint32_t interval) = 0;
+    virtual void setResolutionScale(uint32_t sourceId, float scale) = 0;
+};
+
+class LoadShedder
+{
+public:
+    LoadShedder(const LoadShedConfig& config, uint32_t numSources);
+
+    void setActuator(LoadShedActuator* actuator) { m_Actuator = actuator; }
+    void setDecisionCallback(std::function<void(const LoadShedDecision&)> cb) { m_OnDecision = cb; }
+
+    // Feed the latest back-pressure signals (any rate, e.g. per batch or
+    // from a Triton metrics poll). Returns the level after evaluation.
+    int observe(double queueDepth, double latencyMs, uint64_t nowUs);
+
+    // Hot path for the per-frame probe: false means skip inference on this
+    // frame. Lock-free; safe to call concurrently with observe().
+    bool shouldInfer(uint32_t sourceId, uint64_t frameNum);
+    // shouldInfer() on a frame count kept per source, for callers that see
+    // frames before they are numbered (e.g. ahead of streammux)
+    bool shouldInferNext(uint32_t sourceId);
+
+    // Batch timing feed: a batch entered or left inference. Batches finish
+    // in submission order, so each finish takes the oldest start and calls
+    // observe() with the batches in flight as queue depth and this batch's
+    // time as latency.
+    void batchStarted(uint64_t nowUs);
+    int batchFinished(uint64_t nowUs);
+
+    uint32_t inferInterval(uint32_t sourceId) const;
+    float resolutionScale(uint32_t sourceId) const;
+    int level() const { return m_Level.load(std::memory_order_relaxed); }
+    int maxLevel() const { return (int)m_Ladder.size(); }
+    const std::vector<LoadShedStep>& ladder() const { return m_Ladder; }
+
+    void writePrometheus(std::string& out) const;
+
+private:
+    struct SourceState
+    {
+        int priority = 0;
+        std::atomic<uint32_t> interval{1};
+        std::atomic<float> scale{1.0f};
+        std::atomic<uint64_t> inferred{0};
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<uint64_t> arrived{0};  // shouldInferNext() frame count
+    };
+
+    // A batch whose finish never came must not skew every later one
+    static const size_t kMaxInFlight = 64;
+
+    void applyLevel(int level);
+
+    LoadShedConfig m_Config;
+    std::vector<LoadShedStep> m_Ladder;
+    std::unique_ptr<SourceState[]> m_Sources;
+    uint32_t m_NumSources;
+
+    LoadShedActuator* m_Actuator;
+    std::function<void(const LoadShedDecision&)> m_OnDecision;
+
+    // Controller state, guarded by m_Mutex (observe() is the only writer)
+    mutable std::mutex m_Mutex;
+    std::atomic<int> m_Level;
+    bool m_Over;   // m_OverSinceUs is set
+    bool m_Under;  // m_UnderSinceUs is set
+    uint64_t m_OverSinceUs;
+    uint64_t m_UnderSinceUs;
+    double m_LastQueue;
+    double m_LastLatencyMs;
+    uint64_t m_Escalations;
+    uint64_t m_Relaxations;
+
+    std::mutex m_BatchMutex;
+    std::deque<uint64_t> m_BatchStartUs;  // batches in flight, oldest first
+};
+
+// Extracts one model's pending request gauge and the cumulative queue-time
+// and successful-request counters from a Triton /metrics response (summed
+// over versions). Callers difference two polls to get the average queue
+// time per request. Returns false if the model is absent.
+bool parseTritonQueueMetrics(const std::string& text, const std::string& model, double& pending,
+                             double& queueUsTotal, double& requestTotal);
+
+#endif
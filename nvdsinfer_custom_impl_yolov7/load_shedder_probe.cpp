@@ -0,0 +1,125 @@
+/*
+ * GStreamer pad probes that connect LoadShedder to a pipeline
+ */
+
+#include "load_shedder_probe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static std::unique_ptr<LoadShedder> g_Shedder;
+static std::once_flag g_ShedderOnce;
+
+static uint64_t monotonicUs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+LoadShedder* loadShedder()
+{
+    std::call_once(g_ShedderOnce, []() {
+        const char* env = getenv("DS_LOAD_SHEDDING_CONFIG");
+        const std::string path = env ? env : "/workspace/configs/load_shedding.txt";
+        LoadShedConfig config;
+        if (!LoadShedConfig::load(path, config)) {
+            std::cerr << "WARNING: Load shedding disabled, every frame is inferred" << std::endl;
+            return;
+        }
+        const uint32_t sources = std::max(config.numSources, (uint32_t)config.sourcePriority.size());
+        g_Shedder.reset(new LoadShedder(config, sources));
+        g_Shedder->setDecisionCallback([](const LoadShedDecision& d) {
+            std::cout << "Load shedding: level " << d.fromLevel << " -> " << d.toLevel << " (queue "
+                      << d.queueDepth << ", latency " << d.latencyMs << " ms)" << std::endl;
+        });
+    });
+    return g_Shedder.get();
+}
+
+static void freePadContext(gpointer data)
+{
+    delete (LoadShedPadContext*)data;
+}
+
+bool attachLoadShedder(LoadShedder* shedder, GstElement* streammux, GstElement* infer)
+{
+    if (!shedder || !streammux || !infer) {
+        return false;
+    }
+
+    // Sources are linked through request pads named sink_<source id>
+    std::vector<std::pair<GstPad*, uint32_t>> framePads;
+    GST_OBJECT_LOCK(streammux);
+    for (GList* l = GST_ELEMENT(streammux)->sinkpads; l != nullptr; l = l->next) {
+        GstPad* pad = GST_PAD(l->data);
+        unsigned int sourceId;
+        if (sscanf(GST_PAD_NAME(pad), "sink_%u", &sourceId) == 1) {
+            framePads.emplace_back((GstPad*)gst_object_ref(pad), sourceId);
+        }
+    }
+    GST_OBJECT_UNLOCK(streammux);
+
+    GstPad* inPad = gst_element_get_static_pad(infer, "sink");
+    GstPad* outPad = gst_element_get_static_pad(infer, "src");
+    const bool ok = inPad && outPad && !framePads.empty();
+    if (ok) {
+        gst_pad_add_probe(inPad, GST_PAD_PROBE_TYPE_BUFFER, loadShedBatchInPadProbe, shedder, nullptr);
+        gst_pad_add_probe(outPad, GST_PAD_PROBE_TYPE_BUFFER, loadShedBatchOutPadProbe, shedder, nullptr);
+        for (const auto& p : framePads) {
+            gst_pad_add_probe(p.first, GST_PAD_PROBE_TYPE_BUFFER, loadShedFramePadProbe,
+                              new LoadShedPadContext{shedder, p.second}, freePadContext);
+        }
+    } else {
+        std::cerr << "ERROR: Load shedding needs linked streammux sink pads and the inference element's "
+                  << "sink and src pads" << std::endl;
+    }
+
+    for (const auto& p : framePads) {
+        gst_object_unref(p.first);
+    }
+    if (inPad) {
+        gst_object_unref(inPad);
+    }
+    if (outPad) {
+        gst_object_unref(outPad);
+    }
+    return ok;
+}
+
+extern "C" GstPadProbeReturn loadShedFramePadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData)
+{
+    (void)pad;
+    (void)info;
+    const LoadShedPadContext* ctx = (const LoadShedPadContext*)userData;
+    if (!ctx || ctx->shedder->shouldInferNext(ctx->sourceId)) {
+        return GST_PAD_PROBE_OK;
+    }
+    return GST_PAD_PROBE_DROP;
+}
+
+extern "C" GstPadProbeReturn loadShedBatchInPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData)
+{
+    (void)pad;
+    (void)info;
+    if (userData) {
+        ((LoadShedder*)userData)->batchStarted(monotonicUs());
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+extern "C" GstPadProbeReturn loadShedBatchOutPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData)
+{
+    (void)pad;
+    (void)info;
+    if (userData) {
+        ((LoadShedder*)userData)->batchFinished(monotonicUs());
+    }
+    return GST_PAD_PROBE_OK;
+}
@@ -0,0 +1,48 @@
+/*
+ * GStreamer pad probes that connect LoadShedder to a pipeline
+ *
+ * Three probes, all with a LoadShedder behind them:
+ *
+ *   batch in/out   on the inference element's sink and src pads; every
+ *                  batch is timed from one to the other and fed to
+ *                  batchStarted() / batchFinished(), so the controller sees
+ *                  the batches in flight and the real per-batch latency
+ *   frame          on each streammux sink pad (sink_<source id>); drops the
+ *                  frames shouldInferNext() rejects, which is how skip
+ *                  intervals take effect. A dropped frame is neither
+ *                  inferred nor displayed, and the tracker coasts over it.
+ *
+ * attachLoadShedder() installs all of them once the sources are linked to
+ * streammux. Resolution steps are not applied here (see load_shedder.h).
+ */
+
+#ifndef __LOAD_SHEDDER_PROBE_H__
+#define __LOAD_SHEDDER_PROBE_H__
+
+#include "load_shedder.h"
+
+#include <gst/gst.h>
+
+// The process-wide shedder, configured from $DS_LOAD_SHEDDING_CONFIG
+// (default /workspace/configs/load_shedding.txt). Null when the config does
+// not load.
+LoadShedder* loadShedder();
+
+// Probes streammux's existing sink pads and `infer`'s sink and src pads.
+// False (and nothing attached) when a pad is missing.
+bool attachLoadShedder(LoadShedder* shedder, GstElement* streammux, GstElement* infer);
+
+// user_data for loadShedFramePadProbe
+struct LoadShedPadContext
+{
+    LoadShedder* shedder;
+    uint32_t sourceId;
+};
+
+// user_data is a LoadShedPadContext; GST_PAD_PROBE_DROP for shed frames
+extern "C" GstPadProbeReturn loadShedFramePadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData);
+// user_data is the LoadShedder; always GST_PAD_PROBE_OK
+extern "C" GstPadProbeReturn loadShedBatchInPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData);
+extern "C" GstPadProbeReturn loadShedBatchOutPadProbe(GstPad* pad, GstPadProbeInfo* info, gpointer userData);
+
+#endif
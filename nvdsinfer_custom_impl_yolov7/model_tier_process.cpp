@@ -0,0 +1,155 @@
+/*
+ * nvinferserver custom processor for tiered detection
+ *
+ * Used with configs/config_infer_triton_tiered.txt, which points
+ * nvinferserver at the yolov7_tiered Triton dispatcher. For every batch it:
+ *   - commits pending tier switches at the batch boundary,
+ *   - fills the extra "tier" input with each frame's tier so the dispatcher
+ *     routes that element to the matching detector,
+ *   - measures inference time and feeds it to the router as utilisation
+ *     (batch time / latency-budget-ms). Several batches can be in flight,
+ *     so start times queue up and each completion takes the oldest.
+ *
+ * The tier config is read from $DS_MODEL_TIERS_CONFIG, default
+ * /workspace/configs/model_tiers.txt. Other components (e.g. a tracker
+ * probe that relaxes gates while inTransition()) reach the same router
+ * through modelTierRouter().
+ */
+
+#include "infer_custom_process.h"
+#include "nvdsmeta.h"
+
+#include "model_tier_router.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace nvdsinferserver;
+
+static std::unique_ptr<ModelTierRouter> g_Router;
+static std::once_flag g_RouterOnce;
+
+static uint64_t monotonicUs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+ModelTierRouter* modelTierRouter()
+{
+    std::call_once(g_RouterOnce, []() {
+        const char* env = getenv("DS_MODEL_TIERS_CONFIG");
+        const std::string path = env ? env : "/workspace/configs/model_tiers.txt";
+        ModelTierConfig config;
+        if (!ModelTierConfig::load(path, config)) {
+            std::cerr << "WARNING: Model tiering disabled, every source stays on tier 0" << std::endl;
+            config = ModelTierConfig();
+        }
+        g_Router.reset(new ModelTierRouter(config, config.numSources));
+        g_Router->setSwitchCallback([](const ModelTierSwitch& s) {
+            std::cout << "Model tier: source " << s.sourceId << " " << s.fromTier << " -> " << s.toTier
+                      << " (load " << s.load << ")" << std::endl;
+        });
+    });
+    return g_Router.get();
+}
+
+class ModelTierProcessor : public IInferCustomProcessor
+{
+public:
+    ModelTierProcessor() : m_Router(modelTierRouter()), m_LoadEwma(0.0) {}
+
+    void supportInputMemType(InferMemType& type) override { type = InferMemType::kCpu; }
+
+    bool requireInferLoop() const override { return false; }
+
+    NvDsInferStatus extraInputProcess(const std::vector<IBatchBuffer*>& primaryInputs,
+                                      std::vector<IBatchBuffer*>& extraInputs, const IOptions* options) override
+    {
+        (void)primaryInputs;
+        if (extraInputs.empty()) {
+            std::cerr << "ERROR: Tiered detection needs the extra 'tier' input in the infer config" << std::endl;
+            return NVDSINFER_CUSTOM_LIB_FAILED;
+        }
+
+        std::vector<NvDsFrameMeta*> frames;
+        if (options && options->hasValue(OPTION_NVDS_FRAME_META_LIST)) {
+            if (options->getValueArray(OPTION_NVDS_FRAME_META_LIST, frames) != NVDSINFER_SUCCESS) {
+                return NVDSINFER_CUSTOM_LIB_FAILED;
+            }
+        }
+
+        m_SourceIds.resize(frames.size());
+        for (size_t i = 0; i < frames.size(); ++i) {
+            m_SourceIds[i] = frames[i] ? frames[i]->source_id : 0;
+        }
+        m_Router->beginBatch(m_SourceIds.data(), m_SourceIds.size());
+
+        IBatchBuffer* tierBuf = extraInputs[0];
+        const uint32_t batchSize = tierBuf->getBatchSize();
+        for (uint32_t i = 0; i < batchSize; ++i) {
+            int32_t* dst = static_cast<int32_t*>(tierBuf->getBufPtr(i));
+            *dst = i < m_SourceIds.size() ? (int32_t)m_Router->tier(m_SourceIds[i]) : 0;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        // A batch whose completion never came must not skew every later one
+        if (m_BatchStartUs.size() >= kMaxInFlight) {
+            m_BatchStartUs.pop_front();
+        }
+        m_BatchStartUs.push_back(monotonicUs());
+        return NVDSINFER_SUCCESS;
+    }
+
+    NvDsInferStatus inferenceDone(const IBatchArray* outputs, const IOptions* inOptions) override
+    {
+        (void)outputs;
+        (void)inOptions;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        // Completions arrive in submission order
+        if (m_BatchStartUs.empty()) {
+            return NVDSINFER_SUCCESS;
+        }
+        const uint64_t startUs = m_BatchStartUs.front();
+        m_BatchStartUs.pop_front();
+        const uint64_t now = monotonicUs();
+        const double budgetMs = m_Router->config().latencyBudgetMs;
+        const double load = (double)(now - startUs) / 1000.0 / budgetMs;
+        m_LoadEwma = m_LoadEwma == 0.0 ? load : 0.9 * m_LoadEwma + 0.1 * load;
+        m_Router->observe(m_LoadEwma, now);
+        return NVDSINFER_SUCCESS;
+    }
+
+    void notifyError(NvDsInferStatus status) override
+    {
+        std::cerr << "ERROR: Tiered inference failed with status " << (int)status << std::endl;
+        // The failed batch never completes; later ones would be timed from its start
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_BatchStartUs.empty()) {
+            m_BatchStartUs.pop_front();
+        }
+    }
+
+private:
+    static const size_t kMaxInFlight = 16;
+
+    ModelTierRouter* m_Router;
+    std::vector<uint32_t> m_SourceIds;
+    std::mutex m_Mutex;
+    std::deque<uint64_t> m_BatchStartUs;  // batches in flight, oldest first
+    double m_LoadEwma;
+};
+
+extern "C" IInferCustomProcessor* CreateModelTierProcessor(const char* config, uint32_t configLen)
+{
+    (void)config;
+    (void)configLen;
+    return new ModelTierProcessor();
+}
@@ -0,0 +1,249 @@
+/*
+ * Load-driven model tier routing
+ */
+
+#include "model_tier_router.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+bool ModelTierConfig::load(const std::string& path, ModelTierConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+
+    const std::string g = "model-tiers";
+    if (!kf.hasGroup(g)) {
+        std::cerr << "ERROR: " << path << " has no [model-tiers] group" << std::endl;
+        return false;
+    }
+    config.loadHigh = kf.getDouble(g, "load-high", config.loadHigh);
+    config.loadLow = kf.getDouble(g, "load-low", config.loadLow);
+    config.holdMs = (uint32_t)kf.getInt(g, "hold-ms", (int)config.holdMs);
+    config.minDwellMs = (uint32_t)kf.getInt(g, "min-dwell-ms", (int)config.minDwellMs);
+    config.transitionFrames = (uint32_t)kf.getInt(g, "transition-frames", (int)config.transitionFrames);
+    config.switchOnKeyframe = kf.getBool(g, "switch-on-keyframe", config.switchOnKeyframe);
+    config.latencyBudgetMs = kf.getDouble(g, "latency-budget-ms", config.latencyBudgetMs);
+    config.protectPriority = kf.getInt(g, "protect-priority", config.protectPriority);
+    config.defaultPriority = kf.getInt(g, "default-priority", config.defaultPriority);
+
+    config.tiers.clear();
+    config.sourcePriority.clear();
+    for (const std::string& group : kf.groups()) {
+        if (group.compare(0, 5, "tier-") == 0) {
+            ModelTier tier;
+            tier.name = group.substr(5);
+            tier.model = kf.getString(group, "model");
+            tier.inferConfig = kf.getString(group, "infer-config");
+            tier.cost = kf.getDouble(group, "cost", 1.0);
+            tier.scoreScale = (float)kf.getDouble(group, "score-scale", 1.0);
+            if (tier.model.empty()) {
+                std::cerr << "ERROR: [" << group << "] needs a model" << std::endl;
+                return false;
+            }
+            config.tiers.push_back(tier);
+        } else if (group.compare(0, 6, "source") == 0) {
+            const int id = atoi(group.c_str() + 6);
+            if (id < 0) {
+                continue;
+            }
+            if ((size_t)id >= config.sourcePriority.size()) {
+                config.sourcePriority.resize(id + 1, config.defaultPriority);
+            }
+            config.sourcePriority[id] = kf.getInt(group, "priority", config.defaultPriority);
+        }
+    }
+
+    config.numSources = (uint32_t)kf.getInt(g, "num-sources", (int)config.sourcePriority.size());
+
+    if (config.tiers.empty()) {
+        std::cerr << "ERROR: " << path << " defines no [tier-*] groups" << std::endl;
+        return false;
+    }
+    if (config.loadLow >= config.loadHigh) {
+        std::cerr << "ERROR: load-low must be below load-high" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ModelTierRouter::ModelTierRouter(const ModelTierConfig& config, uint32_t numSources)
+    : m_Config(config),
+      m_Sources(new SourceState[numSources]),
+      m_NumSources(numSources),
+      m_OverSinceUs(0),
+      m_UnderSinceUs(0),
+      m_LastObserveUs(0),
+      m_LastLoad(0.0)
+{
+    if (m_Config.tiers.empty()) {
+        m_Config.tiers.push_back(ModelTier{"full", "yolov7_fp16", "", 1.0, 1.0f});
+    }
+
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        m_Sources[s].priority = s < m_Config.sourcePriority.size() ? m_Config.sourcePriority[s]
+                                                                   : m_Config.defaultPriority;
+        if (m_Sources[s].priority > m_Config.protectPriority) {
+            m_DemoteOrder.push_back(s);
+        }
+    }
+    // Lowest priority (highest number) first; ties by source id for stability
+    std::stable_sort(m_DemoteOrder.begin(), m_DemoteOrder.end(), [this](uint32_t a, uint32_t b) {
+        return m_Sources[a].priority > m_Sources[b].priority;
+    });
+}
+
+bool ModelTierRouter::canSwitch(const SourceState& s, uint64_t nowUs) const
+{
+    return s.lastDecisionUs == 0 || nowUs - s.lastDecisionUs >= (uint64_t)m_Config.minDwellMs * 1000;
+}
+
+void ModelTierRouter::observe(double load, uint64_t nowUs)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_LastLoad = load;
+    m_LastObserveUs = nowUs;
+
+    const bool over = load > m_Config.loadHigh;
+    const bool under = load < m_Config.loadLow;
+    m_OverSinceUs = over ? (m_OverSinceUs ? m_OverSinceUs : nowUs) : 0;
+    m_UnderSinceUs = under ? (m_UnderSinceUs ? m_UnderSinceUs : nowUs) : 0;
+
+    const uint64_t holdUs = (uint64_t)m_Config.holdMs * 1000;
+    const uint32_t cheapest = (uint32_t)m_Config.tiers.size() - 1;
+
+    if (over && nowUs - m_OverSinceUs >= holdUs) {
+        for (uint32_t s : m_DemoteOrder) {
+            SourceState& src = m_Sources[s];
+            const uint32_t desired = src.desired.load(std::memory_order_relaxed);
+            if (desired < cheapest && canSwitch(src, nowUs)) {
+                src.desired.store(desired + 1, std::memory_order_relaxed);
+                src.lastDecisionUs = nowUs;
+                // One source per hold period: let the load signal react first
+                m_OverSinceUs = nowUs;
+                break;
+            }
+        }
+    } else if (under && nowUs - m_UnderSinceUs >= holdUs) {
+        for (auto it = m_DemoteOrder.rbegin(); it != m_DemoteOrder.rend(); ++it) {
+            SourceState& src = m_Sources[*it];
+            const uint32_t desired = src.desired.load(std::memory_order_relaxed);
+            if (desired > 0 && canSwitch(src, nowUs)) {
+                src.desired.store(desired - 1, std::memory_order_relaxed);
+                src.lastDecisionUs = nowUs;
+                m_UnderSinceUs = nowUs;
+                break;
+            }
+        }
+    }
+}
+
+void ModelTierRouter::commit(uint32_t sourceId)
+{
+    SourceState& src = m_Sources[sourceId];
+    const uint32_t desired = src.desired.load(std::memory_order_relaxed);
+    const uint32_t current = src.current.load(std::memory_order_relaxed);
+    if (desired == current) {
+        return;
+    }
+
+    src.current.store(desired, std::memory_order_relaxed);
+    src.transitionLeft.store(m_Config.transitionFrames, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    src.switches++;
+    if (m_OnSwitch) {
+        m_OnSwitch(ModelTierSwitch{m_LastObserveUs, sourceId, current, desired, m_LastLoad});
+    }
+}
+
+void ModelTierRouter::beginBatch(const uint32_t* sourceIds, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t s = sourceIds[i];
+        if (s >= m_NumSources) {
+            continue;
+        }
+        SourceState& src = m_Sources[s];
+        const uint32_t left = src.transitionLeft.load(std::memory_order_relaxed);
+        if (left > 0) {
+            src.transitionLeft.store(left - 1, std::memory_order_relaxed);
+        }
+        if (!m_Config.switchOnKeyframe) {
+            commit(s);
+        }
+    }
+}
+
+void ModelTierRouter::onKeyframe(uint32_t sourceId)
+{
+    if (sourceId < m_NumSources) {
+        commit(sourceId);
+    }
+}
+
+uint32_t ModelTierRouter::tier(uint32_t sourceId) const
+{
+    return sourceId < m_NumSources ? m_Sources[sourceId].current.load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t ModelTierRouter::pendingTier(uint32_t sourceId) const
+{
+    return sourceId < m_NumSources ? m_Sources[sourceId].desired.load(std::memory_order_relaxed) : 0;
+}
+
+bool ModelTierRouter::inTransition(uint32_t sourceId) const
+{
+    return sourceId < m_NumSources && m_Sources[sourceId].transitionLeft.load(std::memory_order_relaxed) > 0;
+}
+
+double ModelTierRouter::relativeCost() const
+{
+    if (m_NumSources == 0) {
+        return 1.0;
+    }
+    double cost = 0.0;
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        cost += m_Config.tiers[tier(s)].cost;
+    }
+    return cost / (m_NumSources * m_Config.tiers[0].cost);
+}
+
+void ModelTierRouter::writePrometheus(std::string& out) const
+{
+    double load;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        load = m_LastLoad;
+    }
+    std::ostringstream os;
+    os << "# TYPE deepstream_model_tier_load gauge\n"
+       << "deepstream_model_tier_load " << load << "\n"
+       << "# TYPE deepstream_model_tier_relative_cost gauge\n"
+       << "deepstream_model_tier_relative_cost " << relativeCost() << "\n"
+       << "# TYPE deepstream_model_tier_sources gauge\n";
+    for (uint32_t t = 0; t < m_Config.tiers.size(); ++t) {
+        uint32_t n = 0;
+        for (uint32_t s = 0; s < m_NumSources; ++s) {
+            n += tier(s) == t;
+        }
+        os << "deepstream_model_tier_sources{tier=\"" << m_Config.tiers[t].name << "\",model=\""
+           << m_Config.tiers[t].model << "\"} " << n << "\n";
+    }
+    os << "# TYPE deepstream_model_tier_current gauge\n";
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        os << "deepstream_model_tier_current{source=\"" << s << "\"} " << tier(s) << "\n";
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    os << "# TYPE deepstream_model_tier_switches_total counter\n";
+    for (uint32_t s = 0; s < m_NumSources; ++s) {
+        os << "deepstream_model_tier_switches_total{source=\"" << s << "\"} " << m_Sources[s].switches << "\n";
+    }
+    out = os.str();
+}
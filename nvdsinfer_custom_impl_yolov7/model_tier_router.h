@@ -0,0 +1,154 @@
+/*
+ * Load-driven model tier routing (e.g. yolov7 full vs. yolov7-tiny)
+ *
+ * Each source is served by one of several detector tiers, ordered from full
+ * fidelity (tier 0) to cheapest. Under sustained load the router demotes
+ * sources one at a time, lowest priority first, to the next cheaper tier;
+ * when load falls it promotes them back in reverse order. Flapping is
+ * prevented three ways: separate load-high/load-low watermarks, a hold time
+ * the condition must persist for, and a minimum dwell time per source
+ * between switches.
+ *
+ * Decisions are only committed at a boundary so the tracker never sees a
+ * frame whose detections came from a mix of models: at the next batch
+ * (beginBatch) or, with switch-on-keyframe, at the source's next keyframe.
+ * For a few frames after a switch inTransition() is true so consumers can
+ * relax association gates while the new model's boxes settle.
+ *
+ * Config (key file format, see configs/model_tiers.txt):
+ *
+ *   [model-tiers]
+ *   load-high=0.9
+ *   load-low=0.6
+ *   hold-ms=2000
+ *   min-dwell-ms=10000
+ *   transition-frames=15
+ *   switch-on-keyframe=0
+ *   latency-budget-ms=33
+ *   num-sources=2          # defaults to the highest [source<N>] + 1
+ *   protect-priority=0
+ *   default-priority=1
+ *
+ *   [tier-<name>]          # in order, full fidelity first
+ *   model=yolov7_fp16
+ *   infer-config=/workspace/configs/config_infer_triton.txt
+ *   cost=1.0               # relative inference cost per frame
+ *   score-scale=1.0        # confidence calibration towards tier 0
+ *
+ *   [source<N>]
+ *   priority=0
+ */
+
+#ifndef __MODEL_TIER_ROUTER_H__
+#define __MODEL_TIER_ROUTER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ModelTier
+{
+    std::string name;
+    std::string model;        // Triton model name
+    std::string inferConfig;  // nvinferserver config holding this tier's parser settings
+    double cost = 1.0;
+    float scoreScale = 1.0f;
+};
+
+struct ModelTierConfig
+{
+    std::vector<ModelTier> tiers;
+    double loadHigh = 0.9;
+    double loadLow = 0.6;
+    uint32_t holdMs = 2000;
+    uint32_t minDwellMs = 10000;
+    uint32_t transitionFrames = 15;
+    bool switchOnKeyframe = false;
+    // Per-batch inference time that counts as full utilisation (load 1.0)
+    double latencyBudgetMs = 33.0;
+    uint32_t numSources = 0;
+    int protectPriority = 0;
+    int defaultPriority = 1;
+    std::vector<int> sourcePriority;
+
+    static bool load(const std::string& path, ModelTierConfig& config);
+};
+
+struct ModelTierSwitch
+{
+    uint64_t timestampUs;
+    uint32_t sourceId;
+    uint32_t fromTier;
+    uint32_t toTier;
+    double load;
+};
+
+class ModelTierRouter
+{
+public:
+    ModelTierRouter(const ModelTierConfig& config, uint32_t numSources);
+
+    void setSwitchCallback(std::function<void(const ModelTierSwitch&)> cb) { m_OnSwitch = cb; }
+
+    // Feed the current utilisation of the inference server (offered work /
+    // capacity, ~1.0 = saturated). May demote or promote one source.
+    void observe(double load, uint64_t nowUs);
+
+    // Batch boundary: commits pending decisions (unless switching waits for
+    // keyframes) and advances transition counters for the given sources.
+    void beginBatch(const uint32_t* sourceIds, size_t count);
+
+    // Keyframe boundary for one source (switch-on-keyframe mode).
+    void onKeyframe(uint32_t sourceId);
+
+    // Tier serving this source right now. Lock-free.
+    uint32_t tier(uint32_t sourceId) const;
+    uint32_t pendingTier(uint32_t sourceId) const;
+    bool inTransition(uint32_t sourceId) const;
+
+    const ModelTierConfig& config() const { return m_Config; }
+    const ModelTier& tierInfo(uint32_t tier) const { return m_Config.tiers[tier]; }
+    uint32_t numTiers() const { return (uint32_t)m_Config.tiers.size(); }
+
+    // Sum of per-frame tier costs over all sources, relative to all-full.
+    double relativeCost() const;
+
+    void writePrometheus(std::string& out) const;
+
+private:
+    struct SourceState
+    {
+        int priority = 0;
+        std::atomic<uint32_t> current{0};
+        std::atomic<uint32_t> desired{0};
+        std::atomic<uint32_t> transitionLeft{0};
+        uint64_t lastDecisionUs = 0;
+        uint64_t switches = 0;
+    };
+
+    void commit(uint32_t sourceId);
+    bool canSwitch(const SourceState& s, uint64_t nowUs) const;
+
+    ModelTierConfig m_Config;
+    std::unique_ptr<SourceState[]> m_Sources;
+    uint32_t m_NumSources;
+    std::vector<uint32_t> m_DemoteOrder;  // lowest priority first
+    std::function<void(const ModelTierSwitch&)> m_OnSwitch;
+
+    mutable std::mutex m_Mutex;
+    uint64_t m_OverSinceUs;
+    uint64_t m_UnderSinceUs;
+    uint64_t m_LastObserveUs;
+    double m_LastLoad;
+};
+
+// Process-wide router shared by the nvinferserver tier processor and any
+// probe that needs tier state; created on first use from
+// $DS_MODEL_TIERS_CONFIG (see model_tier_process.cpp).
+ModelTierRouter* modelTierRouter();
+
+#endif
@@ -4,16 +4,46 @@
  * 
  * Expected output format: [25200, 6] where each detection is:
  * [x1, y1, x2, y2, confidence, class_id]
+ *
+ * Other input resolutions change the row count (6300 at 320x320, 14175 at
+ * 480x480, 56700 at 960x960); see resolveNetworkSize().
+ *
+ * The layout and decode kernel are detected once per output shape and the
+ * candidate boxes go to pre-faulted arenas, see nvdsparsebbox_yolov7.h for
+ * the init and warm-up API. Thresholds, class mask and kernel choice can be
+ * changed at runtime through a watched config file, see parser_config.h.
+ * Other output layouts (names, order, columns, box encoding, element type)
+ * are described by a schema file, see output_schema.h. The same decoders
+ * build without DeepStream as a plain C library, see yolov7_decode.h.
  */
 
+#ifdef YOLOV7_STANDALONE_DECODE
+#include "standalone_infer_types.h"
+#else
 #include "nvdsinfer_custom_impl.h"
+#endif
+#include "nvdsparsebbox_yolov7.h"
+#include "output_schema.h"
+#include "parser_config.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define YOLOV7_PARSER_HAVE_AVX2 1
+#endif
 
 // Utility function to clamp values
 static inline float clamp(const float val, const float minVal, const float maxVal)
@@ -46,12 +76,12 @@ static NvDsInferParseObjectInfo convertBBox(const float& bx1, const float& by1,
 // Add bounding box proposal if it meets criteria
 static void addBBoxProposal(const float bx1, const float by1, const float bx2, const float by2, 
                            const uint& netW, const uint& netH, const int maxIndex, const float maxProb, 
-                           std::vector<NvDsInferParseObjectInfo>& binfo)
+                           const float minBoxSize, std::vector<NvDsInferParseObjectInfo>& binfo)
 {
     NvDsInferParseObjectInfo bbi = convertBBox(bx1, by1, bx2, by2, netW, netH);
     
     // Skip invalid bounding boxes
-    if (bbi.width < 1 || bbi.height < 1) {
+    if (bbi.width < minBoxSize || bbi.height < minBoxSize) {
         return;
     }
     
@@ -60,91 +90,892 @@ static void addBBoxProposal(const float bx1, const float by1, const float bx2, c
     binfo.push_back(bbi);
 }
 
-// Decode raw YOLOv7 tensor output format (85 channels)
-static std::vector<NvDsInferParseObjectInfo> decodeTensorYolov7Raw(const float* output, 
-                                                                   const uint& outputSize, const uint& netW, 
-                                                                   const uint& netH, const std::vector<float>& preclusterThreshold)
+// Index and value of the best class score, first index on ties; scores
+// that are all <= 0 give class 0 with probability 0
+static int argmaxClassScalar(const float* scores, const int numClasses, float& maxProb)
 {
-    std::vector<NvDsInferParseObjectInfo> binfo;
-    
-    // Process each detection in the raw output tensor
-    // Raw YOLOv7 output format: [cx, cy, w, h, objectness, class0_prob, class1_prob, ..., class79_prob]
-    for (uint b = 0; b < outputSize; ++b) {
-        float objectness = output[b * 85 + 4];  // Object confidence
-        
-        if (objectness < 0.1) {  // Skip low objectness detections
-            continue;
+    float best = 0.0f;
+    int bestId = 0;
+    for (int c = 0; c < numClasses; ++c) {
+        if (scores[c] > best) {
+            best = scores[c];
+            bestId = c;
         }
-        
-        // Find best class
-        float maxClassProb = 0.0f;
-        int maxClassId = 0;
-        for (int c = 0; c < 80; ++c) {
-            float classProb = output[b * 85 + 5 + c];
-            if (classProb > maxClassProb) {
-                maxClassProb = classProb;
-                maxClassId = c;
-            }
-        }
-        
-        // Calculate final confidence
-        float confidence = objectness * maxClassProb;
-        
-        // Check if confidence meets threshold for this class
-        if (maxClassId >= preclusterThreshold.size() || confidence < preclusterThreshold[maxClassId]) {
-            continue;
+    }
+    maxProb = best;
+    return bestId;
+}
+
+#ifdef YOLOV7_PARSER_HAVE_AVX2
+__attribute__((target("avx2"))) static int argmaxClassAvx2(const float* scores, const int numClasses, float& maxProb)
+{
+    int c = 0;
+    __m256 vmax = _mm256_setzero_ps();
+    for (; c + 8 <= numClasses; c += 8) {
+        vmax = _mm256_max_ps(vmax, _mm256_loadu_ps(scores + c));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, vmax);
+    float best = 0.0f;
+    for (int i = 0; i < 8; ++i) {
+        best = std::max(best, lanes[i]);
+    }
+    for (; c < numClasses; ++c) {
+        best = std::max(best, scores[c]);
+    }
+
+    maxProb = best;
+    if (best <= 0.0f) {
+        return 0;
+    }
+    for (int i = 0; i < numClasses; ++i) {
+        if (scores[i] == best) {
+            return i;
         }
-        
-        // Extract and convert bounding box coordinates
-        float cx = output[b * 85 + 0];  // Center x
-        float cy = output[b * 85 + 1];  // Center y
-        float w = output[b * 85 + 2];   // Width
-        float h = output[b * 85 + 3];   // Height
-        
-        // Convert center coordinates to corner coordinates
-        float bx1 = cx - w * 0.5f;
-        float by1 = cy - h * 0.5f;
-        float bx2 = cx + w * 0.5f;
-        float by2 = cy + h * 0.5f;
-        
-        addBBoxProposal(bx1, by1, bx2, by2, netW, netH, maxClassId, confidence, binfo);
     }
-    
-    return binfo;
+    return 0;
 }
+#endif
+
+typedef int (*ArgmaxClassFunc)(const float* scores, const int numClasses, float& maxProb);
 
-// Decode YOLOv7 tensor output format (6 channels - processed)
-static std::vector<NvDsInferParseObjectInfo> decodeTensorYolov7(const float* output, 
-                                                                const uint& outputSize, const uint& netW, 
-                                                                const uint& netH, const std::vector<float>& preclusterThreshold)
+// IEEE 754 half to float, subnormals included
+static inline float halfToFloat(const uint16_t h)
 {
-    std::vector<NvDsInferParseObjectInfo> binfo;
-    
-    // Process each detection in the output tensor
-    // YOLOv7 output format: [x1, y1, x2, y2, confidence, class_id]
-    for (uint b = 0; b < outputSize; ++b) {
-        float confidence = output[b * 6 + 4];  // Detection confidence
-        int classId = (int)output[b * 6 + 5];  // Class ID
-        
+    const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        uint32_t e = 113;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            --e;
+        }
+        bits = sign | (e << 23) | ((mantissa & 0x3ff) << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Float to half for the synthetic warm-up tensor: normal range only,
+// mantissa truncated
+static inline uint16_t floatToHalf(const float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    const int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 112;
+    if (exponent <= 0) {
+        return sign;
+    }
+    if (exponent >= 0x1f) {
+        return sign | 0x7c00;
+    }
+    return sign | (uint16_t)(exponent << 10) | (uint16_t)((bits >> 13) & 0x3ff);
+}
+
+// Element types a schema can name; load() widens one value to float,
+// store() (warm-up tensors only) narrows it for `column`
+struct ElemFloat32
+{
+    typedef float Type;
+    static inline float load(const float* p) { return *p; }
+    static inline void store(float* p, const float v, const OutputSchema&, const uint32_t) { *p = v; }
+};
+
+struct ElemFloat16
+{
+    typedef uint16_t Type;
+    static inline float load(const uint16_t* p) { return halfToFloat(*p); }
+    static inline void store(uint16_t* p, const float v, const OutputSchema&, const uint32_t) { *p = floatToHalf(v); }
+};
+
+// INT8 is decoded on its raw bytes (decodeSchemaInt8), so only store()
+struct ElemInt8
+{
+    typedef int8_t Type;
+    static inline void store(int8_t* p, const float v, const OutputSchema& s, const uint32_t column)
+    {
+        const long q = std::lround(v / s.scale[column]) + s.zeroPoint[column];
+        *p = (int8_t)std::max(-128L, std::min(127L, q));
+    }
+};
+
+// Best class score of one candidate. Row-major float32 scores are
+// contiguous and go to the kernel picked for this CPU; other layouts are
+// read with their stride. Same result either way: first index on ties,
+// class 0 with probability 0 when every score is <= 0.
+template <SchemaOrder order, typename Elem, ArgmaxClassFunc argmax>
+struct ClassArgmax
+{
+    static inline int run(const typename Elem::Type* scores, const size_t stride, const int numClasses,
+                          float& maxProb)
+    {
+        float best = 0.0f;
+        int bestId = 0;
+        for (int c = 0; c < numClasses; ++c) {
+            const float v = Elem::load(scores + c * stride);
+            if (v > best) {
+                best = v;
+                bestId = c;
+            }
+        }
+        maxProb = best;
+        return bestId;
+    }
+};
+
+template <ArgmaxClassFunc argmax>
+struct ClassArgmax<kSchemaRowMajor, ElemFloat32, argmax>
+{
+    static inline int run(const float* scores, const size_t, const int numClasses, float& maxProb)
+    {
+        return argmax(scores, numClasses, maxProb);
+    }
+};
+
+struct Yolov7Layout;
+
+typedef void (*DecodeFunc)(const void* output, const Yolov7Layout& layout,
+                           const std::vector<float>& preclusterThreshold, const ParserSettings& settings,
+                           std::vector<NvDsInferParseObjectInfo>& binfo);
+
+// Everything derived from one output shape, computed once
+struct Yolov7Layout
+{
+    NvDsInferDims dims;          // key: tensor dims as reported
+    NvDsInferDataType dataType;  // key: element type as reported
+    uint infoWidth, infoHeight;  // key: network info as reported
+    uint rows, channels;
+    uint netW, netH;             // input size the boxes are in
+    OutputSchema schema;
+    DecodeFunc decode;
+    DecodeFunc decodeScalar;   // used when the settings force the scalar kernel
+    std::string kernel;
+};
+
+// Decodes any output an OutputSchema describes. Order, box encoding, score
+// mode and element type are template parameters, so each instantiation is
+// the loop a hand-written decoder for that layout would be; only the
+// column offsets come from the schema, as loop invariants.
+template <SchemaOrder order, SchemaBoxEncoding encoding, SchemaScoreMode mode, typename Elem, ArgmaxClassFunc argmax>
+static void decodeSchema(const void* output, const Yolov7Layout& layout, const std::vector<float>& preclusterThreshold,
+                         const ParserSettings& settings, std::vector<NvDsInferParseObjectInfo>& binfo)
+{
+    typedef typename Elem::Type T;
+    const OutputSchema& s = layout.schema;
+    const uint rows = layout.rows;
+    // Distance between two values of one candidate, and between candidates
+    const size_t col = order == kSchemaRowMajor ? 1 : rows;
+    const size_t next = order == kSchemaRowMajor ? s.columns : 1;
+    const size_t boxCol = s.box * col;
+    const size_t scoreCol = mode == kSchemaScoreColumn ? s.score * col : 0;
+    const size_t objectnessCol = mode == kSchemaObjectnessClasses ? s.objectness * col : 0;
+    const size_t classScoresCol = mode != kSchemaScoreColumn ? s.classScores * col : 0;
+    const bool hasClassId = s.classId >= 0;
+    const size_t classIdCol = hasClassId ? s.classId * col : 0;
+    const int numClasses = (int)s.numClasses;
+
+    const T* candidate = (const T*)output;
+    for (uint b = 0; b < rows; ++b, candidate += next) {
+        float confidence;
+        int classId;
+        if (mode == kSchemaScoreColumn) {
+            confidence = Elem::load(candidate + scoreCol);
+            classId = hasClassId ? (int)Elem::load(candidate + classIdCol) : 0;
+            if (classId < 0) {
+                continue;
+            }
+        } else {
+            float objectness = 1.0f;
+            if (mode == kSchemaObjectnessClasses) {
+                objectness = Elem::load(candidate + objectnessCol);
+                if (objectness < settings.objectnessThreshold) {  // Skip low objectness detections
+                    continue;
+                }
+            }
+            float maxClassProb;
+            classId = ClassArgmax<order, Elem, argmax>::run(candidate + classScoresCol, col, numClasses, maxClassProb);
+            confidence = objectness * maxClassProb;
+        }
+
         // Check if confidence meets threshold for this class
-        if (classId < 0 || classId >= preclusterThreshold.size()) {
+        if ((size_t)classId >= preclusterThreshold.size() || confidence < preclusterThreshold[classId]) {
             continue;
         }
-        
-        if (confidence < preclusterThreshold[classId]) {
-            continue;
+
+        const float v0 = Elem::load(candidate + boxCol);
+        const float v1 = Elem::load(candidate + boxCol + col);
+        const float v2 = Elem::load(candidate + boxCol + 2 * col);
+        const float v3 = Elem::load(candidate + boxCol + 3 * col);
+        if (encoding == kSchemaXyxy) {
+            addBBoxProposal(v0, v1, v2, v3, layout.netW, layout.netH, classId, confidence, settings.minBoxSize, binfo);
+        } else {
+            // Convert center coordinates to corner coordinates
+            addBBoxProposal(v0 - v2 * 0.5f, v1 - v3 * 0.5f, v0 + v2 * 0.5f, v1 + v3 * 0.5f, layout.netW, layout.netH,
+                            classId, confidence, settings.minBoxSize, binfo);
         }
-        
-        // Extract bounding box coordinates (already in x1, y1, x2, y2 format)
-        float bx1 = output[b * 6 + 0];
-        float by1 = output[b * 6 + 1]; 
-        float bx2 = output[b * 6 + 2];
-        float by2 = output[b * 6 + 3];
-        
-        addBBoxProposal(bx1, by1, bx2, by2, netW, netH, classId, confidence, binfo);
     }
-    
-    return binfo;
+}
+
+// INT8 kernels. In a channel-major tensor the bytes of consecutive
+// candidates are contiguous: argmaxRows reduces the class-score rows of a
+// block of candidates to each one's best byte and class, one contiguous
+// row at a time, and compareMask screens 64 candidates per call. Reading a
+// candidate's classes one by one would touch a page per class. Row-major
+// class scores are contiguous per candidate and go to argmaxInt8.
+
+// best[i], bestId[i] = largest of the `count` bytes p[k * stride + i] and
+// the first k holding it, for i < n
+typedef void (*ArgmaxRowsFunc)(const int8_t* p, const size_t stride, const uint32_t count, const uint32_t n,
+                               int8_t* best, uint16_t* bestId);
+// Bit i set when p[i] >= threshold, for i < 64; threshold in -128..127
+typedef uint64_t (*CompareMaskFunc)(const int8_t* p, const int32_t threshold);
+// Index of the first largest of n contiguous bytes, and the byte
+typedef int (*ArgmaxInt8Func)(const int8_t* p, const int n, int8_t& max);
+
+static void argmaxRowsScalar(const int8_t* p, const size_t stride, const uint32_t count, const uint32_t n,
+                             int8_t* best, uint16_t* bestId)
+{
+    memcpy(best, p, n);
+    memset(bestId, 0, n * sizeof(uint16_t));
+    for (uint32_t k = 1; k < count; ++k) {
+        const int8_t* row = p + k * stride;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (row[i] > best[i]) {
+                best[i] = row[i];
+                bestId[i] = (uint16_t)k;
+            }
+        }
+    }
+}
+
+static uint64_t compareMaskScalar(const int8_t* p, const int32_t threshold)
+{
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; ++i) {
+        mask |= (uint64_t)(p[i] >= threshold) << i;
+    }
+    return mask;
+}
+
+static int argmaxInt8Scalar(const int8_t* p, const int n, int8_t& max)
+{
+    int bestId = 0;
+    for (int c = 1; c < n; ++c) {
+        if (p[c] > p[bestId]) {
+            bestId = c;
+        }
+    }
+    max = p[bestId];
+    return bestId;
+}
+
+#ifdef YOLOV7_PARSER_HAVE_AVX2
+__attribute__((target("avx2"))) static void argmaxRowsAvx2(const int8_t* p, const size_t stride,
+                                                           const uint32_t count, const uint32_t n, int8_t* best,
+                                                           uint16_t* bestId)
+{
+    memcpy(best, p, n);
+    memset(bestId, 0, n * sizeof(uint16_t));
+    for (uint32_t k = 1; k < count; ++k) {
+        const int8_t* row = p + k * stride;
+        const __m256i id = _mm256_set1_epi16((short)k);
+        uint32_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            const __m256i b = _mm256_loadu_si256((const __m256i*)(best + i));
+            const __m256i r = _mm256_loadu_si256((const __m256i*)(row + i));
+            const __m256i gt = _mm256_cmpgt_epi8(r, b);
+            _mm256_storeu_si256((__m256i*)(best + i), _mm256_max_epi8(b, r));
+            // Widen the byte mask to the 16-bit ids
+            __m256i* ids = (__m256i*)(bestId + i);
+            _mm256_storeu_si256(ids, _mm256_blendv_epi8(_mm256_loadu_si256(ids), id,
+                                                        _mm256_cvtepi8_epi16(_mm256_castsi256_si128(gt))));
+            _mm256_storeu_si256(ids + 1, _mm256_blendv_epi8(_mm256_loadu_si256(ids + 1), id,
+                                                            _mm256_cvtepi8_epi16(_mm256_extracti128_si256(gt, 1))));
+        }
+        for (; i < n; ++i) {
+            if (row[i] > best[i]) {
+                best[i] = row[i];
+                bestId[i] = (uint16_t)k;
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2"))) static uint64_t compareMaskAvx2(const int8_t* p, const int32_t threshold)
+{
+    if (threshold == -128) {
+        return ~0ull;
+    }
+    // x >= threshold is x > threshold - 1
+    const __m256i below = _mm256_set1_epi8((char)(threshold - 1));
+    const uint32_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)p), below));
+    const uint32_t hi =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), below));
+    return (uint64_t)hi << 32 | lo;
+}
+
+__attribute__((target("avx512bw"))) static void argmaxRowsAvx512(const int8_t* p, const size_t stride,
+                                                                 const uint32_t count, const uint32_t n, int8_t* best,
+                                                                 uint16_t* bestId)
+{
+    memcpy(best, p, n);
+    memset(bestId, 0, n * sizeof(uint16_t));
+    for (uint32_t k = 1; k < count; ++k) {
+        const int8_t* row = p + k * stride;
+        const __m512i id = _mm512_set1_epi16((short)k);
+        uint32_t i = 0;
+        for (; i + 64 <= n; i += 64) {
+            const __m512i b = _mm512_loadu_si512(best + i);
+            const __m512i r = _mm512_loadu_si512(row + i);
+            const __mmask64 gt = _mm512_cmpgt_epi8_mask(r, b);
+            _mm512_storeu_si512(best + i, _mm512_max_epi8(b, r));
+            _mm512_storeu_si512(bestId + i, _mm512_mask_mov_epi16(_mm512_loadu_si512(bestId + i), (__mmask32)gt, id));
+            _mm512_storeu_si512(bestId + i + 32,
+                                _mm512_mask_mov_epi16(_mm512_loadu_si512(bestId + i + 32), (__mmask32)(gt >> 32), id));
+        }
+        for (; i < n; ++i) {
+            if (row[i] > best[i]) {
+                best[i] = row[i];
+                bestId[i] = (uint16_t)k;
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512bw"))) static uint64_t compareMaskAvx512(const int8_t* p, const int32_t threshold)
+{
+    return _mm512_cmpge_epi8_mask(_mm512_loadu_si512(p), _mm512_set1_epi8((char)threshold));
+}
+
+__attribute__((target("avx2"))) static int argmaxInt8Avx2(const int8_t* p, const int n, int8_t& max)
+{
+    int c = 0;
+    __m256i vmax = _mm256_set1_epi8(-128);
+    for (; c + 32 <= n; c += 32) {
+        vmax = _mm256_max_epi8(vmax, _mm256_loadu_si256((const __m256i*)(p + c)));
+    }
+    __m128i m = _mm_max_epi8(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1));
+    m = _mm_max_epi8(m, _mm_srli_si128(m, 8));
+    m = _mm_max_epi8(m, _mm_srli_si128(m, 4));
+    m = _mm_max_epi8(m, _mm_srli_si128(m, 2));
+    m = _mm_max_epi8(m, _mm_srli_si128(m, 1));
+    int8_t best = (int8_t)_mm_cvtsi128_si32(m);
+    for (; c < n; ++c) {
+        best = std::max(best, p[c]);
+    }
+
+    max = best;
+    const __m256i vbest = _mm256_set1_epi8(best);
+    for (c = 0; c + 32 <= n; c += 32) {
+        const uint32_t eq = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + c)), vbest));
+        if (eq) {
+            return c + __builtin_ctz(eq);
+        }
+    }
+    for (; c < n; ++c) {
+        if (p[c] == best) {
+            return c;
+        }
+    }
+    return 0;
+}
+#endif
+
+// Decodes an INT8 output without dequantizing it first. Each candidate is
+// screened on one raw byte (score or objectness) or on its best class
+// byte, against a threshold converted to int8 once per call; only the
+// candidates that pass are dequantized and go through the same float
+// checks as decodeSchema, so the boxes are those of dequantizing the whole
+// tensor and decoding it as float32.
+template <SchemaOrder order, SchemaBoxEncoding encoding, SchemaScoreMode mode, ArgmaxRowsFunc argmaxRows,
+          CompareMaskFunc compareMask, ArgmaxInt8Func argmaxInt8>
+static void decodeSchemaInt8(const void* output, const Yolov7Layout& layout,
+                             const std::vector<float>& preclusterThreshold, const ParserSettings& settings,
+                             std::vector<NvDsInferParseObjectInfo>& binfo)
+{
+    const OutputSchema& s = layout.schema;
+    const uint rows = layout.rows;
+    const size_t col = order == kSchemaRowMajor ? 1 : rows;
+    const int8_t* tensor = (const int8_t*)output;
+
+    // Screen: the lowest class threshold on the score or best class byte,
+    // or the objectness threshold on the objectness byte
+    float minThreshold = INFINITY;
+    for (const float t : preclusterThreshold) {
+        minThreshold = std::min(minThreshold, t);
+    }
+    int32_t screen;
+    if (mode == kSchemaScoreColumn) {
+        screen = s.quantizeThreshold(s.score, minThreshold);
+    } else if (mode == kSchemaObjectnessClasses) {
+        screen = s.quantizeThreshold(s.objectness, settings.objectnessThreshold);
+    } else {
+        screen = s.quantizeThreshold(s.classScores, minThreshold);
+    }
+    if (screen > 127) {
+        return;
+    }
+
+    auto emit = [&](const int8_t* candidate, const int classId, const float confidence) {
+        if ((size_t)classId >= preclusterThreshold.size() || confidence < preclusterThreshold[classId]) {
+            return;
+        }
+        float v[4];
+        for (uint32_t i = 0; i < 4; ++i) {
+            v[i] = s.dequantize(s.box + i, candidate[(s.box + i) * col]);
+        }
+        if (encoding == kSchemaXyxy) {
+            addBBoxProposal(v[0], v[1], v[2], v[3], layout.netW, layout.netH, classId, confidence, settings.minBoxSize,
+                            binfo);
+        } else {
+            addBBoxProposal(v[0] - v[2] * 0.5f, v[1] - v[3] * 0.5f, v[0] + v[2] * 0.5f, v[1] + v[3] * 0.5f,
+                            layout.netW, layout.netH, classId, confidence, settings.minBoxSize, binfo);
+        }
+    };
+    auto emitScore = [&](const int8_t* candidate) {
+        // Rounded: an integer class id rarely dequantizes to exactly itself
+        const int classId =
+            s.classId >= 0 ? (int)std::lround(s.dequantize(s.classId, candidate[s.classId * col])) : 0;
+        if (classId >= 0) {
+            emit(candidate, classId, s.dequantize(s.score, candidate[s.score * col]));
+        }
+    };
+    // `best` is the candidate's best class byte, first held by class classId
+    auto emitClasses = [&](const int8_t* candidate, const int8_t best, int classId) {
+        float objectness = 1.0f;
+        if (mode == kSchemaObjectnessClasses) {
+            objectness = s.dequantize(s.objectness, candidate[s.objectness * col]);
+            if (objectness < settings.objectnessThreshold) {
+                return;
+            }
+        }
+        // As the float decoders: class 0 with probability 0 when no score is > 0
+        float maxClassProb = s.dequantize(s.classScores, best);
+        if (maxClassProb <= 0.0f) {
+            maxClassProb = 0.0f;
+            classId = 0;
+        }
+        emit(candidate, classId, objectness * maxClassProb);
+    };
+
+    if (order == kSchemaChannelMajor) {
+        const uint32_t kBlock = 1024;
+        int8_t best[kBlock];
+        uint16_t bestId[kBlock];
+        uint64_t masks[kBlock / 64];
+        const uint32_t screenColumn =
+            mode == kSchemaScoreColumn ? s.score : mode == kSchemaObjectnessClasses ? s.objectness : s.classScores;
+        for (uint b0 = 0; b0 < rows; b0 += kBlock) {
+            const uint32_t n = std::min(kBlock, rows - b0);
+            const uint32_t full = n / 64;
+            const int8_t* classes = tensor + (size_t)s.classScores * rows + b0;
+            const int8_t* bytes = tensor + (size_t)screenColumn * rows + b0;
+            if (mode == kSchemaClassScores) {
+                argmaxRows(classes, rows, s.numClasses, n, best, bestId);
+                bytes = best;
+            }
+
+            uint32_t survivors = 0;
+            for (uint32_t m = 0; m < full; ++m) {
+                masks[m] = compareMask(bytes + m * 64, screen);
+                survivors += __builtin_popcountll(masks[m]);
+            }
+            for (uint32_t i = full * 64; i < n; ++i) {
+                survivors += bytes[i] >= screen;
+            }
+            // Past objectness, a few candidates read their classes one by
+            // one; more than one per 64 and the block pass is cheaper
+            const bool blockClasses = mode == kSchemaClassScores || (mode == kSchemaObjectnessClasses &&
+                                                                     survivors > kBlock / 64);
+            if (mode == kSchemaObjectnessClasses && blockClasses) {
+                argmaxRows(classes, rows, s.numClasses, n, best, bestId);
+            }
+
+            auto visit = [&](const uint32_t i) {
+                if (mode == kSchemaScoreColumn) {
+                    emitScore(tensor + b0 + i);
+                } else if (blockClasses) {
+                    emitClasses(tensor + b0 + i, best[i], bestId[i]);
+                } else {
+                    int8_t b;
+                    uint16_t id;
+                    argmaxRowsScalar(classes + i, rows, s.numClasses, 1, &b, &id);
+                    emitClasses(tensor + b0 + i, b, id);
+                }
+            };
+            for (uint32_t m = 0; m < full && survivors; ++m) {
+                for (uint64_t mask = masks[m]; mask; mask &= mask - 1) {
+                    visit(m * 64 + __builtin_ctzll(mask));
+                }
+            }
+            for (uint32_t i = full * 64; i < n; ++i) {
+                if (bytes[i] >= screen) {
+                    visit(i);
+                }
+            }
+        }
+    } else {
+        // The screen byte is one per row; class bytes are contiguous
+        for (uint b = 0; b < rows; ++b) {
+            const int8_t* candidate = tensor + (size_t)b * s.columns;
+            if (mode == kSchemaScoreColumn) {
+                if (candidate[s.score] >= screen) {
+                    emitScore(candidate);
+                }
+                continue;
+            }
+            if (mode == kSchemaObjectnessClasses && candidate[s.objectness] < screen) {
+                continue;
+            }
+            int8_t best;
+            const int classId = argmaxInt8(candidate + s.classScores, (int)s.numClasses, best);
+            if (mode == kSchemaClassScores && best < screen) {
+                continue;
+            }
+            emitClasses(candidate, best, classId);
+        }
+    }
+}
+
+enum SimdLevel
+{
+    kSimdScalar = 0,
+    kSimdAvx2 = 1,
+    kSimdAvx512 = 2,
+};
+
+// The float SIMD argmax applies only where class scores are contiguous floats
+template <SchemaOrder order, SchemaBoxEncoding encoding, SchemaScoreMode mode, typename Elem>
+static DecodeFunc simdDecoder(std::false_type)
+{
+    return nullptr;
+}
+
+template <SchemaOrder order, SchemaBoxEncoding encoding, SchemaScoreMode mode, typename Elem>
+static DecodeFunc simdDecoder(std::true_type)
+{
+#ifdef YOLOV7_PARSER_HAVE_AVX2
+    return decodeSchema<order, encoding, mode, Elem, argmaxClassAvx2>;
+#else
+    return nullptr;
+#endif
+}
+
+template <SchemaOrder order, SchemaBoxEncoding encoding, SchemaScoreMode mode, typename Elem>
+static void selectKernel(Yolov7Layout& layout, const SimdLevel simd)
+{
+    typedef std::integral_constant<bool, order == kSchemaRowMajor && mode != kSchemaScoreColumn &&
+                                             std::is_same<Elem, ElemFloat32>::value>
+        Contiguous;
+    layout.decodeScalar = decodeSchema<order, encoding, mode, Elem, argmaxClassScalar>;
+    layout.decode = layout.decodeScalar;
+    layout.kernel = layout.schema.describe() + "-scalar";
+    const DecodeFunc simdDecode = simdDecoder<order, encoding, mode, Elem>(Contiguous());
+    if (simd >= kSimdAvx2 && simdDecode) {
+        layout.decode = simdDecode;
+        layout.kernel = layout.schema.describe() + "-avx2";
+    }
+}
+
+template <SchemaOrder order, SchemaBoxEncoding encoding, SchemaScoreMode mode>
+static void selectInt8Kernel(Yolov7Layout& layout, const SimdLevel simd)
+{
+    layout.decodeScalar = decodeSchemaInt8<order, encoding, mode, argmaxRowsScalar, compareMaskScalar, argmaxInt8Scalar>;
+    layout.decode = layout.decodeScalar;
+    layout.kernel = layout.schema.describe() + "-scalar";
+#ifdef YOLOV7_PARSER_HAVE_AVX2
+    if (simd == kSimdAvx512) {
+        layout.decode = decodeSchemaInt8<order, encoding, mode, argmaxRowsAvx512, compareMaskAvx512, argmaxInt8Avx2>;
+        layout.kernel = layout.schema.describe() + "-avx512";
+    } else if (simd == kSimdAvx2) {
+        layout.decode = decodeSchemaInt8<order, encoding, mode, argmaxRowsAvx2, compareMaskAvx2, argmaxInt8Avx2>;
+        layout.kernel = layout.schema.describe() + "-avx2";
+    }
+#endif
+}
+
+template <SchemaOrder order, SchemaBoxEncoding encoding, SchemaScoreMode mode>
+static void selectElement(Yolov7Layout& layout, const SimdLevel simd)
+{
+    if (layout.schema.dtype == kSchemaInt8) {
+        selectInt8Kernel<order, encoding, mode>(layout, simd);
+    } else if (layout.schema.dtype == kSchemaFloat16) {
+        selectKernel<order, encoding, mode, ElemFloat16>(layout, simd);
+    } else {
+        selectKernel<order, encoding, mode, ElemFloat32>(layout, simd);
+    }
+}
+
+template <SchemaOrder order, SchemaBoxEncoding encoding>
+static void selectScoreMode(Yolov7Layout& layout, const SimdLevel simd)
+{
+    switch (layout.schema.scoreMode()) {
+    case kSchemaScoreColumn:
+        selectElement<order, encoding, kSchemaScoreColumn>(layout, simd);
+        break;
+    case kSchemaObjectnessClasses:
+        selectElement<order, encoding, kSchemaObjectnessClasses>(layout, simd);
+        break;
+    case kSchemaClassScores:
+        selectElement<order, encoding, kSchemaClassScores>(layout, simd);
+        break;
+    }
+}
+
+template <SchemaOrder order>
+static void selectEncoding(Yolov7Layout& layout, const SimdLevel simd)
+{
+    if (layout.schema.boxEncoding == kSchemaCxcywh) {
+        selectScoreMode<order, kSchemaCxcywh>(layout, simd);
+    } else {
+        selectScoreMode<order, kSchemaXyxy>(layout, simd);
+    }
+}
+
+// Picks the decoder instantiation for layout.schema
+static void selectDecoder(Yolov7Layout& layout, const SimdLevel simd)
+{
+    if (layout.schema.order == kSchemaChannelMajor) {
+        selectEncoding<kSchemaChannelMajor>(layout, simd);
+    } else {
+        selectEncoding<kSchemaRowMajor>(layout, simd);
+    }
+}
+
+// Number of output rows YOLOv7 produces for a netW x netH input: 3 anchors
+// per cell over the stride 8, 16 and 32 grids
+static inline uint yolov7RowCount(const uint netW, const uint netH)
+{
+    return 3 * ((netW / 8) * (netH / 8) + (netW / 16) * (netH / 16) + (netW / 32) * (netH / 32));
+}
+
+// Work out the input size the output rows belong to. With one engine per
+// resolution (or a dynamic-shape engine fed by nvdspreprocess) the network
+// info may describe a different profile than the tensor being parsed, or
+// carry no size at all; in that case assume a square input whose row count
+// matches. Boxes are in input pixels, so netW/netH must match the tensor.
+static bool resolveNetworkSize(const uint rows, NvDsInferNetworkInfo const& networkInfo, uint& netW, uint& netH)
+{
+    netW = networkInfo.width;
+    netH = networkInfo.height;
+    if (netW > 0 && netH > 0 && yolov7RowCount(netW, netH) == rows) {
+        return true;
+    }
+
+    // 63 * side^2 / 1024 rows for a square input
+    const uint side = (uint)std::lround(std::sqrt(rows * 1024.0 / 63.0) / 32.0) * 32;
+    if (side > 0 && yolov7RowCount(side, side) == rows) {
+        std::cerr << "WARNING: " << rows << " output rows do not match network " << networkInfo.width << "x"
+                  << networkInfo.height << ", parsing as " << side << "x" << side << std::endl;
+        netW = side;
+        netH = side;
+        return true;
+    }
+
+    // Not an anchor-grid layout (e.g. a top-k export): trust the network info
+    return netW > 0 && netH > 0;
+}
+
+static const int kMaxLayouts = 8;
+static std::atomic<const Yolov7Layout*> g_Layouts[kMaxLayouts];
+static std::mutex g_LayoutMutex;
+static std::vector<std::unique_ptr<Yolov7Layout>> g_LayoutStore;  // owns every layout ever published
+
+static std::atomic<bool> g_Debug{false};
+static std::atomic<int> g_SimdLevel{kSimdScalar};
+
+static bool sameDims(const NvDsInferDims& a, const NvDsInferDims& b)
+{
+    if (a.numDims != b.numDims) {
+        return false;
+    }
+    for (uint i = 0; i < a.numDims; ++i) {
+        if (a.d[i] != b.d[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::unique_ptr<Yolov7Layout> detectLayout(const NvDsInferDims& dims, const NvDsInferDataType dataType,
+                                                  NvDsInferNetworkInfo const& networkInfo)
+{
+    std::unique_ptr<Yolov7Layout> layout(new Yolov7Layout());
+    layout->dims = dims;
+    layout->dataType = dataType;
+    layout->infoWidth = networkInfo.width;
+    layout->infoHeight = networkInfo.height;
+
+    // Debug output dimensions; stderr, so tools that print results to
+    // stdout are not disturbed
+    const bool debug = parserDebugLogging();
+    if (debug) {
+        std::cerr << "YOLOv7 Output Tensor Debug Info:" << std::endl;
+        std::cerr << "  Number of dimensions: " << dims.numDims << std::endl;
+        for (uint i = 0; i < dims.numDims; i++) {
+            std::cerr << "  Dimension[" << i << "]: " << dims.d[i] << std::endl;
+        }
+    }
+
+    // Candidates along the last two dims: [rows, columns], or [columns, rows]
+    // for a channel-major schema
+    const OutputSchema* schema = outputSchema();
+    const bool channelMajor = schema && schema->order == kSchemaChannelMajor;
+    if (dims.numDims == 2) {
+        // Format: [num_detections, 6] - Direct DeepStream format
+        layout->rows = dims.d[channelMajor ? 1 : 0];
+        layout->channels = dims.d[channelMajor ? 0 : 1];
+    } else if (dims.numDims == 3) {
+        // Format: [1, num_detections, 6] - Batch format
+        layout->rows = dims.d[channelMajor ? 2 : 1];
+        layout->channels = dims.d[channelMajor ? 1 : 2];
+        if (debug) {
+            std::cerr << "  Using batch format, batch_size=" << dims.d[0] << std::endl;
+        }
+    } else {
+        std::cerr << "ERROR: YOLOv7 output should have 2 or 3 dimensions, got: " 
+                  << dims.numDims << std::endl;
+        return nullptr;
+    }
+
+    if (debug) {
+        std::cerr << "YOLOv7 Parsed Dimensions: size=" << layout->rows << ", channels=" << layout->channels
+                  << std::endl;
+    }
+
+    if (schema) {
+        if (layout->channels != schema->columns) {
+            std::cerr << "ERROR: YOLOv7 output has " << layout->channels << " channels, the output schema describes "
+                      << schema->columns << std::endl;
+            return nullptr;
+        }
+        layout->schema = *schema;
+    } else if (layout->channels == 6) {
+        layout->schema = OutputSchema::processed6();
+    } else if (layout->channels == 85) {
+        if (debug) {
+            std::cerr << "WARNING: Raw YOLOv7 output detected (85 channels). Model needs DeepStreamOutput layer!"
+                      << std::endl;
+            std::cerr << "Using fallback parsing for raw output..." << std::endl;
+        }
+        layout->schema = OutputSchema::raw85();
+    } else {
+        std::cerr << "ERROR: YOLOv7 output should have 6 channels [x1,y1,x2,y2,conf,class] or 85 channels [raw], got: " 
+                  << layout->channels << " (set YOLOV7_OUTPUT_SCHEMA to describe other layouts)" << std::endl;
+        return nullptr;
+    }
+
+    // The built-in layouts take the element type the engine reports; a
+    // schema file must agree with it. INT8 needs the file's scale and zero
+    // point, so it is never assumed.
+    if (dataType != FLOAT && dataType != HALF && dataType != INT8) {
+        std::cerr << "ERROR: YOLOv7 output must be FLOAT, HALF or INT8, got data type " << (int)dataType << std::endl;
+        return nullptr;
+    }
+    const SchemaDataType reported = dataType == INT8 ? kSchemaInt8 : dataType == HALF ? kSchemaFloat16 : kSchemaFloat32;
+    const char* reportedName = dataType == INT8 ? "INT8" : dataType == HALF ? "HALF" : "FLOAT";
+    if (schema && schema->dtype != reported) {
+        std::cerr << "ERROR: YOLOv7 output is " << reportedName << ", the output schema says otherwise" << std::endl;
+        return nullptr;
+    }
+    if (!schema && reported == kSchemaInt8) {
+        std::cerr << "ERROR: YOLOv7 output is INT8; set YOLOV7_OUTPUT_SCHEMA with its scale and zero-point" << std::endl;
+        return nullptr;
+    }
+    layout->schema.dtype = reported;
+
+    if (!resolveNetworkSize(layout->rows, networkInfo, layout->netW, layout->netH)) {
+        std::cerr << "ERROR: Cannot determine the network input size for " << layout->rows << " output rows" << std::endl;
+        return nullptr;
+    }
+
+    selectDecoder(*layout, (SimdLevel)g_SimdLevel.load(std::memory_order_relaxed));
+
+    if (debug) {
+        std::cerr << "YOLOv7 layout: " << layout->rows << "x" << layout->channels << " at " << layout->netW << "x"
+                  << layout->netH << ", kernel " << layout->kernel << std::endl;
+    }
+    return layout;
+}
+
+// Lock-free for every shape seen before; the first call per shape detects
+// and publishes it under g_LayoutMutex
+static const Yolov7Layout* findLayout(const NvDsInferDims& dims, const NvDsInferDataType dataType,
+                                      NvDsInferNetworkInfo const& networkInfo)
+{
+    for (int i = 0; i < kMaxLayouts; ++i) {
+        const Yolov7Layout* l = g_Layouts[i].load(std::memory_order_acquire);
+        if (!l) {
+            break;
+        }
+        if (l->infoWidth == networkInfo.width && l->infoHeight == networkInfo.height && l->dataType == dataType &&
+            sameDims(l->dims, dims)) {
+            return l;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_LayoutMutex);
+    for (const auto& l : g_LayoutStore) {
+        if (l->infoWidth == networkInfo.width && l->infoHeight == networkInfo.height && l->dataType == dataType &&
+            sameDims(l->dims, dims)) {
+            return l.get();
+        }
+    }
+    std::unique_ptr<Yolov7Layout> layout = detectLayout(dims, dataType, networkInfo);
+    if (!layout) {
+        return nullptr;
+    }
+    const Yolov7Layout* result = layout.get();
+    g_LayoutStore.push_back(std::move(layout));
+    for (int i = 0; i < kMaxLayouts; ++i) {
+        if (!g_Layouts[i].load(std::memory_order_relaxed)) {
+            g_Layouts[i].store(result, std::memory_order_release);
+            break;
+        }
+    }
+    return result;
+}
+
+// Candidate boxes are collected in one of a few arenas whose capacity is
+// reserved and pre-faulted up front; a call that finds them all busy falls
+// back to a local vector.
+struct ParseArena
+{
+    std::atomic<bool> busy{false};
+    std::vector<NvDsInferParseObjectInfo> objects;
+    std::vector<float> thresholds;  // infer config thresholds merged with the settings
+};
+
+static const int kNumArenas = 4;
+static ParseArena g_Arenas[kNumArenas];
+
+static ParseArena* acquireArena()
+{
+    for (int i = 0; i < kNumArenas; ++i) {
+        if (!g_Arenas[i].busy.load(std::memory_order_relaxed) &&
+            !g_Arenas[i].busy.exchange(true, std::memory_order_acquire)) {
+            return &g_Arenas[i];
+        }
+    }
+    return nullptr;
+}
+
+static void releaseArena(ParseArena* arena)
+{
+    if (arena) {
+        arena->busy.store(false, std::memory_order_release);
+    }
 }
 
 // Main parsing function for YOLOv7 Triton output
@@ -158,70 +989,62 @@ static bool NvDsInferParseCustomYolov7(std::vector<NvDsInferLayerInfo> const& ou
         return false;
     }
     
-    std::vector<NvDsInferParseObjectInfo> objects;
-    
-    const NvDsInferLayerInfo& output = outputLayersInfo[0];
-    
-    // Debug output dimensions
-    std::cout << "YOLOv7 Output Tensor Debug Info:" << std::endl;
-    std::cout << "  Number of dimensions: " << output.inferDims.numDims << std::endl;
-    for (int i = 0; i < output.inferDims.numDims; i++) {
-        std::cout << "  Dimension[" << i << "]: " << output.inferDims.d[i] << std::endl;
-    }
-    
-    // Handle different output formats
-    uint outputSize, outputChannels;
-    
-    if (output.inferDims.numDims == 2) {
-        // Format: [num_detections, 6] - Direct DeepStream format
-        outputSize = output.inferDims.d[0];
-        outputChannels = output.inferDims.d[1];
-    } else if (output.inferDims.numDims == 3) {
-        // Format: [1, num_detections, 6] - Batch format
-        outputSize = output.inferDims.d[1];
-        outputChannels = output.inferDims.d[2];
-        std::cout << "  Using batch format, batch_size=" << output.inferDims.d[0] << std::endl;
-    } else {
-        std::cerr << "ERROR: YOLOv7 output should have 2 or 3 dimensions, got: " 
-                  << output.inferDims.numDims << std::endl;
-        return false;
+    // The schema's layer, or the first output
+    const NvDsInferLayerInfo* layer = &outputLayersInfo[0];
+    const OutputSchema* schema = outputSchema();
+    if (schema && !schema->layer.empty()) {
+        layer = nullptr;
+        for (const NvDsInferLayerInfo& l : outputLayersInfo) {
+            if (l.layerName && schema->layer == l.layerName) {
+                layer = &l;
+                break;
+            }
+        }
+        if (!layer) {
+            std::cerr << "ERROR: Could not find output layer " << schema->layer << " in bbox parsing" << std::endl;
+            return false;
+        }
     }
-    
-    std::cout << "YOLOv7 Parsed Dimensions: size=" << outputSize << ", channels=" << outputChannels << std::endl;
-    
-    if (outputChannels != 6 && outputChannels != 85) {
-        std::cerr << "ERROR: YOLOv7 output should have 6 channels [x1,y1,x2,y2,conf,class] or 85 channels [raw], got: " 
-                  << outputChannels << std::endl;
+    const NvDsInferLayerInfo& output = *layer;
+    const Yolov7Layout* layout = findLayout(output.inferDims, output.dataType, networkInfo);
+    if (!layout) {
         return false;
     }
-    
-    // Handle raw YOLOv7 output (85 channels) vs processed output (6 channels)
-    if (outputChannels == 85) {
-        std::cout << "WARNING: Raw YOLOv7 output detected (85 channels). Model needs DeepStreamOutput layer!" << std::endl;
-        std::cout << "Using fallback parsing for raw output..." << std::endl;
+
+    // One snapshot for the whole call; a reload only affects later calls
+    const ParserSettings& settings = *parserSettings();
+
+    ParseArena* arena = acquireArena();
+    std::vector<NvDsInferParseObjectInfo> fallbackObjects;
+    std::vector<float> fallbackThresholds;
+    std::vector<NvDsInferParseObjectInfo>& objects = arena ? arena->objects : fallbackObjects;
+    objects.clear();
+
+    const std::vector<float>* thresholds = &detectionParams.perClassPreclusterThreshold;
+    if (settings.overridesThresholds) {
+        std::vector<float>& merged = arena ? arena->thresholds : fallbackThresholds;
+        merged.assign(thresholds->begin(), thresholds->end());
+        // Classes past the configured count stay dropped, and stay out of
+        // the INT8 screen's minimum
+        const int classes = std::min((int)merged.size(), PARSER_MAX_CLASSES);
+        for (int c = 0; c < classes; ++c) {
+            if (settings.classThreshold[c] >= 0.0f) {
+                merged[c] = settings.classThreshold[c];
+            }
+        }
+        thresholds = &merged;
     }
-    
-    // Decode detections from tensor using appropriate decoder
-    std::vector<NvDsInferParseObjectInfo> outObjs;
-    if (outputChannels == 85) {
-        // Use raw YOLOv7 decoder
-        outObjs = decodeTensorYolov7Raw((const float*)(output.buffer), 
-                                        outputSize, networkInfo.width, 
-                                        networkInfo.height, 
-                                        detectionParams.perClassPreclusterThreshold);
-    } else {
-        // Use processed YOLOv7 decoder (6 channels)
-        outObjs = decodeTensorYolov7((const float*)(output.buffer), 
-                                     outputSize, networkInfo.width, 
-                                     networkInfo.height, 
-                                     detectionParams.perClassPreclusterThreshold);
+
+    // Decode detections from tensor using the kernel picked for this layout
+    const DecodeFunc decode = settings.forceScalar ? layout->decodeScalar : layout->decode;
+    decode(output.buffer, *layout, *thresholds, settings, objects);
+
+    if (g_Debug.load(std::memory_order_relaxed) || settings.debug) {
+        std::cerr << "YOLOv7 Parsed " << objects.size() << " objects from " << layout->rows << " detections" << std::endl;
     }
     
-    objects.insert(objects.end(), outObjs.begin(), outObjs.end());
-    
-    std::cout << "YOLOv7 Parsed " << objects.size() << " objects from " << outputSize << " detections" << std::endl;
-    
-    objectList = objects;
+    objectList.assign(objects.begin(), objects.end());
+    releaseArena(arena);
     
     return true;
 }
@@ -235,5 +1058,200 @@ extern "C" bool NvDsInferParseYolov7(std::vector<NvDsInferLayerInfo> const& outp
     return NvDsInferParseCustomYolov7(outputLayersInfo, networkInfo, detectionParams, objectList);
 }
 
+// Schema a synthetic tensor with `channels` columns is built and parsed
+// with: the schema file's, else the built-in layout of that width
+static bool syntheticSchema(const unsigned int channels, OutputSchema& schema)
+{
+    const OutputSchema* file = outputSchema();
+    if (file) {
+        schema = *file;
+        return file->columns == channels;
+    }
+    if (channels == 6) {
+        schema = OutputSchema::processed6();
+        return true;
+    }
+    if (channels == 85) {
+        schema = OutputSchema::raw85();
+        return true;
+    }
+    return false;
+}
+
+static NvDsInferDims schemaDims(const OutputSchema& schema, const unsigned int rows)
+{
+    NvDsInferDims dims;
+    memset(&dims, 0, sizeof(dims));
+    dims.numDims = 2;
+    dims.d[0] = schema.order == kSchemaRowMajor ? rows : schema.columns;
+    dims.d[1] = schema.order == kSchemaRowMajor ? schema.columns : rows;
+    dims.numElements = rows * schema.columns;
+    return dims;
+}
+
+static NvDsInferDataType schemaDataType(const OutputSchema& schema)
+{
+    return schema.dtype == kSchemaInt8 ? INT8 : schema.dtype == kSchemaFloat16 ? HALF : FLOAT;
+}
+
+// A zero tensor with a spread of confident boxes, so every stage of the
+// decode (thresholds, box conversion, output copy) runs
+template <typename Elem>
+static void fillSyntheticTensor(const OutputSchema& s, const uint rows, const uint netWidth, const uint netHeight,
+                                std::vector<uint8_t>& bytes)
+{
+    typedef typename Elem::Type T;
+    bytes.assign((size_t)rows * s.columns * sizeof(T), 0);
+    T* tensor = (T*)bytes.data();
+    const size_t col = s.order == kSchemaRowMajor ? 1 : rows;
+    if (std::is_same<Elem, ElemInt8>::value) {
+        // Zero is each column's zero point
+        for (uint r = 0; r < rows; ++r) {
+            T* candidate = tensor + (s.order == kSchemaRowMajor ? (size_t)r * s.columns : r);
+            for (uint32_t c = 0; c < s.columns; ++c) {
+                Elem::store(candidate + c * col, 0.0f, s, c);
+            }
+        }
+    }
+    const uint classes = std::min(80u, s.numClasses);
+    const uint step = std::max(1u, rows / 64);
+    for (uint r = 0; r < rows; r += step) {
+        T* candidate = tensor + (s.order == kSchemaRowMajor ? (size_t)r * s.columns : r);
+        const float x = (float)(r % std::max(1u, netWidth - 64));
+        const float y = (float)((r / 7) % std::max(1u, netHeight - 64));
+        const float xyxy[4] = {x, y, x + 48.0f, y + 96.0f};
+        const float cxcywh[4] = {x + 24.0f, y + 48.0f, 48.0f, 96.0f};
+        for (uint i = 0; i < 4; ++i) {
+            Elem::store(candidate + (s.box + i) * col, s.boxEncoding == kSchemaXyxy ? xyxy[i] : cxcywh[i], s, s.box + i);
+        }
+        if (s.scoreMode() == kSchemaScoreColumn) {
+            Elem::store(candidate + s.score * col, 0.9f, s, s.score);
+            if (s.classId >= 0) {
+                Elem::store(candidate + s.classId * col, (float)(r % classes), s, s.classId);
+            }
+        } else {
+            if (s.objectness >= 0) {
+                Elem::store(candidate + s.objectness * col, 0.9f, s, s.objectness);
+            }
+            const uint32_t c = s.classScores + r % classes;
+            Elem::store(candidate + c * col, 0.9f, s, c);
+        }
+    }
+}
+
+extern "C" bool NvDsInferParseYolov7WarmUp(unsigned int rows, unsigned int channels, unsigned int netWidth,
+                                           unsigned int netHeight, unsigned int iterations)
+{
+    OutputSchema schema;
+    if (rows == 0 || !syntheticSchema(channels, schema)) {
+        std::cerr << "ERROR: Cannot warm up the YOLOv7 parser for " << rows << "x" << channels << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> tensor;
+    if (schema.dtype == kSchemaInt8) {
+        fillSyntheticTensor<ElemInt8>(schema, rows, netWidth, netHeight, tensor);
+    } else if (schema.dtype == kSchemaFloat16) {
+        fillSyntheticTensor<ElemFloat16>(schema, rows, netWidth, netHeight, tensor);
+    } else {
+        fillSyntheticTensor<ElemFloat32>(schema, rows, netWidth, netHeight, tensor);
+    }
+
+    NvDsInferLayerInfo layer;
+    memset(&layer, 0, sizeof(layer));
+    layer.dataType = schemaDataType(schema);
+    layer.inferDims = schemaDims(schema, rows);
+    layer.layerName = schema.layer.empty() ? "output" : schema.layer.c_str();
+    layer.buffer = tensor.data();
+    const std::vector<NvDsInferLayerInfo> layers(1, layer);
+
+    NvDsInferNetworkInfo networkInfo;
+    networkInfo.width = netWidth;
+    networkInfo.height = netHeight;
+    networkInfo.channels = 3;
+
+    NvDsInferParseDetectionParams params;
+    params.numClassesConfigured = 80;
+    params.perClassPreclusterThreshold.assign(80, 0.25f);
+    params.perClassPostclusterThreshold.assign(80, 0.25f);
+
+    std::vector<NvDsInferParseObjectInfo> objects;
+    for (unsigned int i = 0; i < iterations; ++i) {
+        if (!NvDsInferParseCustomYolov7(layers, networkInfo, params, objects)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+extern "C" bool NvDsInferParseYolov7Init(const NvDsInferParseYolov7InitParams* params)
+{
+    NvDsInferParseYolov7InitParams p = {25200, 6, 640, 640, 3};
+    if (params) {
+        p = *params;
+    } else if (outputSchema()) {
+        p.channels = outputSchema()->columns;
+    }
+
+    // Starts the settings watcher when YOLOV7_PARSER_CONFIG is set
+    parserSettings();
+
+    g_Debug.store(parserDebugLogging(), std::memory_order_relaxed);
+#ifdef YOLOV7_PARSER_HAVE_AVX2
+    g_SimdLevel.store(__builtin_cpu_supports("avx512bw") ? kSimdAvx512
+                      : __builtin_cpu_supports("avx2")   ? kSimdAvx2
+                                                         : kSimdScalar,
+                      std::memory_order_relaxed);
+#endif
+
+    // Reserve and touch every arena so the first frames do not page-fault.
+    // Arenas in use by a concurrent parse are waited for.
+    for (int i = 0; i < kNumArenas; ++i) {
+        ParseArena& arena = g_Arenas[i];
+        while (arena.busy.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        if (arena.objects.capacity() < p.maxRows) {
+            arena.objects.reserve(p.maxRows);
+            arena.objects.resize(p.maxRows);
+        }
+        arena.objects.clear();
+        arena.thresholds.reserve(PARSER_MAX_CLASSES);
+        releaseArena(&arena);
+    }
+
+    OutputSchema schema;
+    if (!syntheticSchema(p.channels, schema)) {
+        std::cerr << "ERROR: No output layout with " << p.channels << " channels to initialise" << std::endl;
+        return false;
+    }
+    NvDsInferNetworkInfo networkInfo;
+    networkInfo.width = p.netWidth;
+    networkInfo.height = p.netHeight;
+    networkInfo.channels = 3;
+    if (!findLayout(schemaDims(schema, p.maxRows), schemaDataType(schema), networkInfo)) {
+        return false;
+    }
+
+    return NvDsInferParseYolov7WarmUp(p.maxRows, p.channels, p.netWidth, p.netHeight, p.warmUpIterations);
+}
+
+#ifndef YOLOV7_STANDALONE_DECODE
+// Initialise and warm up when nvinferserver loads the library. Defined
+// after every other static so their constructors have already run. The
+// standalone decode library initialises on its first call instead.
+static struct ParserLoadHook
+{
+    ParserLoadHook()
+    {
+        const char* env = getenv("YOLOV7_PARSER_WARMUP");
+        if (env && strcmp(env, "0") == 0) {
+            return;
+        }
+        NvDsInferParseYolov7Init(nullptr);
+    }
+} g_ParserLoadHook;
+#endif
+
 // Prototype check
-CHECK_CUSTOM_PARSE_FUNC_PROTOTYPE(NvDsInferParseYolov7);
\ No newline at end of file
+CHECK_CUSTOM_PARSE_FUNC_PROTOTYPE(NvDsInferParseYolov7);
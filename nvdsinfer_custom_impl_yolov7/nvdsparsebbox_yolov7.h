@@ -0,0 +1,48 @@
+/*
+ * Init and warm-up API of the YOLOv7 custom parser
+ *
+ * Without it the first NvDsInferParseYolov7() call pays for layout
+ * detection, decode-kernel selection and page faults on freshly grown
+ * vectors. The library runs NvDsInferParseYolov7Init(nullptr) when it is
+ * loaded, so nvinferserver gets a warm parser without any code change; set
+ * YOLOV7_PARSER_WARMUP=0 to skip that, or call Init again from the host
+ * application with the real shape (e.g. after adding a stream with a new
+ * input profile). The standalone decode library (yolov7_decode.h) has no
+ * load hook; it runs the same initialisation on its first decode.
+ *
+ * YOLOV7_PARSER_DEBUG=1 restores the tensor layout, output schema,
+ * settings reload and per-call object count logging, on stderr.
+ */
+
+#ifndef __NVDSPARSEBBOX_YOLOV7_H__
+#define __NVDSPARSEBBOX_YOLOV7_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    unsigned int maxRows;           // largest output row count to expect (25200 at 640x640)
+    unsigned int channels;          // 6 (processed) or 85 (raw)
+    unsigned int netWidth;
+    unsigned int netHeight;
+    unsigned int warmUpIterations;  // synthetic parse calls, 0 = none
+} NvDsInferParseYolov7InitParams;
+
+// Pre-faults the parse arenas, detects the layout for the given shape and
+// selects the decode kernel for this CPU, then runs the warm-up calls.
+// nullptr uses 25200 x 6 at 640x640 with 3 warm-up iterations. Safe to call
+// more than once and concurrently with parsing.
+bool NvDsInferParseYolov7Init(const NvDsInferParseYolov7InitParams* params);
+
+// Runs `iterations` parse calls on a synthetic tensor of the given shape
+// through the same path as real frames.
+bool NvDsInferParseYolov7WarmUp(unsigned int rows, unsigned int channels, unsigned int netWidth,
+                                unsigned int netHeight, unsigned int iterations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
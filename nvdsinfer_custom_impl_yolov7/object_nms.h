@@ -0,0 +1,59 @@
+/*
+ * Per-class NMS over parsed YOLOv7 objects
+ *
+ * The parser emits every candidate above threshold; nvinfer clusters them
+ * afterwards. Code that calls NvDsInferParseYolov7 outside nvinfer (the CPU
+ * detector, the Triton server step) clusters the same way with this.
+ */
+
+#ifndef __OBJECT_NMS_H__
+#define __OBJECT_NMS_H__
+
+#ifdef YOLOV7_STANDALONE_DECODE
+#include "standalone_infer_types.h"
+#else
+#include "nvdsinfer_custom_impl.h"
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+static inline float objectIou(const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b)
+{
+    const float x1 = std::max(a.left, b.left);
+    const float y1 = std::max(a.top, b.top);
+    const float x2 = std::min(a.left + a.width, b.left + b.width);
+    const float y2 = std::min(a.top + a.height, b.top + b.height);
+    const float inter = std::max(0.0f, x2 - x1) * std::max(0.0f, y2 - y1);
+    const float uni = a.width * a.height + b.width * b.height - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+// Greedy per-class NMS, highest confidence first, as nvinfer clusters.
+// Sorts `parsed` in place and replaces `objects` with at most topK keepers.
+static inline void nmsPerClass(std::vector<NvDsInferParseObjectInfo>& parsed, const float iouThreshold,
+                               const uint32_t topK, std::vector<NvDsInferParseObjectInfo>& objects)
+{
+    std::sort(parsed.begin(), parsed.end(), [](const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b) {
+        return a.detectionConfidence > b.detectionConfidence;
+    });
+    objects.clear();
+    for (const NvDsInferParseObjectInfo& o : parsed) {
+        if (objects.size() >= topK) {
+            break;
+        }
+        bool keep = true;
+        for (const NvDsInferParseObjectInfo& k : objects) {
+            if (k.classId == o.classId && objectIou(k, o) > iouThreshold) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            objects.push_back(o);
+        }
+    }
+}
+
+#endif
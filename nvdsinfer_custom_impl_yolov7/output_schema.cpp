@@ -0,0 +1,229 @@
+/*
+ * Declarative description of a detector's output tensor
+ */
+
+#include "output_schema.h"
+#include "key_file.h"
+#include "parser_config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+SchemaScoreMode OutputSchema::scoreMode() const
+{
+    if (classScores < 0) {
+        return kSchemaScoreColumn;
+    }
+    return objectness >= 0 ? kSchemaObjectnessClasses : kSchemaClassScores;
+}
+
+int32_t OutputSchema::quantizeThreshold(const uint32_t column, const float threshold) const
+{
+    // Exactly q >= zero point + threshold / scale; flooring keeps the values
+    // dequantize() could round up to the threshold
+    const double q = std::floor(zeroPoint[column] + (double)threshold / scale[column]);
+    return (int32_t)std::max(-128.0, std::min(128.0, q));
+}
+
+std::string OutputSchema::describe() const
+{
+    static const char* modes[] = {"score", "objcls", "cls"};
+    return std::string(order == kSchemaRowMajor ? "row" : "channel") + "-" +
+           (boxEncoding == kSchemaXyxy ? "xyxy" : "cxcywh") + "-" + modes[scoreMode()] + "-" +
+           (dtype == kSchemaFloat32 ? "f32" : dtype == kSchemaFloat16 ? "f16" : "i8");
+}
+
+static bool columnInside(const char* key, int64_t first, int64_t count, uint32_t columns)
+{
+    if (first < 0 || first + count > columns) {
+        std::cerr << "ERROR: Output schema " << key << " column " << first << " does not fit in " << columns
+                  << " columns" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool OutputSchema::validate() const
+{
+    if (columns == 0) {
+        std::cerr << "ERROR: Output schema needs columns > 0" << std::endl;
+        return false;
+    }
+    if (!columnInside("box", box, 4, columns)) {
+        return false;
+    }
+    if (dtype == kSchemaInt8) {
+        if (scale.size() != columns || zeroPoint.size() != columns) {
+            std::cerr << "ERROR: Output schema needs one scale and zero-point, or one per column" << std::endl;
+            return false;
+        }
+        for (uint32_t c = 0; c < columns; ++c) {
+            if (!(scale[c] > 0.0f) || zeroPoint[c] < -128 || zeroPoint[c] > 127) {
+                std::cerr << "ERROR: Output schema column " << c << " needs scale > 0 and zero-point in -128..127"
+                          << std::endl;
+                return false;
+            }
+        }
+        // Class indices are kept as 16 bits
+        if (numClasses > 65536) {
+            std::cerr << "ERROR: Output schema int8 decoding takes at most 65536 classes" << std::endl;
+            return false;
+        }
+        // Class score bytes are compared with each other
+        for (uint32_t c = 1; classScores >= 0 && c < numClasses && classScores + c < columns; ++c) {
+            if (scale[classScores + c] != scale[classScores] || zeroPoint[classScores + c] != zeroPoint[classScores]) {
+                std::cerr << "ERROR: Output schema class-score columns must share one scale and zero-point"
+                          << std::endl;
+                return false;
+            }
+        }
+    }
+    switch (scoreMode()) {
+    case kSchemaScoreColumn:
+        if (!columnInside("score", score, 1, columns) || (classId >= 0 && !columnInside("class-id", classId, 1, columns))) {
+            return false;
+        }
+        break;
+    case kSchemaObjectnessClasses:
+        if (!columnInside("objectness", objectness, 1, columns)) {
+            return false;
+        }
+        // fall through
+    case kSchemaClassScores:
+        if (numClasses == 0 || !columnInside("class-scores", classScores, numClasses, columns)) {
+            return false;
+        }
+        break;
+    }
+    return true;
+}
+
+bool OutputSchema::load(const std::string& path, OutputSchema& schema)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "output-schema";
+    if (!kf.hasGroup(g)) {
+        std::cerr << "ERROR: " << path << " has no [output-schema] group" << std::endl;
+        return false;
+    }
+
+    OutputSchema s;
+    s.layer = kf.getString(g, "layer", "");
+
+    const std::string order = kf.getString(g, "order", "row-major");
+    if (order == "row-major") {
+        s.order = kSchemaRowMajor;
+    } else if (order == "channel-major") {
+        s.order = kSchemaChannelMajor;
+    } else {
+        std::cerr << "ERROR: Unknown output schema order '" << order << "'" << std::endl;
+        return false;
+    }
+
+    const std::string encoding = kf.getString(g, "box-encoding", "xyxy");
+    if (encoding == "xyxy") {
+        s.boxEncoding = kSchemaXyxy;
+    } else if (encoding == "cxcywh") {
+        s.boxEncoding = kSchemaCxcywh;
+    } else {
+        std::cerr << "ERROR: Unknown output schema box-encoding '" << encoding << "'" << std::endl;
+        return false;
+    }
+
+    const std::string dtype = kf.getString(g, "dtype", "float32");
+    if (dtype == "float32") {
+        s.dtype = kSchemaFloat32;
+    } else if (dtype == "float16") {
+        s.dtype = kSchemaFloat16;
+    } else if (dtype == "int8") {
+        s.dtype = kSchemaInt8;
+    } else {
+        std::cerr << "ERROR: Unknown output schema dtype '" << dtype << "'" << std::endl;
+        return false;
+    }
+
+    const int columns = kf.getInt(g, "columns", 0);
+    const int numClasses = kf.getInt(g, "num-classes", (int)s.numClasses);
+    if (columns <= 0 || numClasses <= 0) {
+        std::cerr << "ERROR: Output schema needs columns and num-classes > 0" << std::endl;
+        return false;
+    }
+    s.columns = (uint32_t)columns;
+    s.numClasses = (uint32_t)numClasses;
+    s.box = (uint32_t)std::max(0, kf.getInt(g, "box", 0));
+    s.objectness = kf.getInt(g, "objectness", -1);
+    s.classScores = kf.getInt(g, "class-scores", -1);
+    s.score = kf.getInt(g, "score", -1);
+    s.classId = kf.getInt(g, "class-id", -1);
+    if (s.dtype == kSchemaInt8) {
+        // One value applies to every column
+        const std::vector<double> scale = kf.getDoubleList(g, "scale");
+        const std::vector<int> zeroPoint = kf.getIntList(g, "zero-point");
+        for (uint32_t c = 0; c < s.columns; ++c) {
+            if (scale.size() == 1 || scale.size() == s.columns) {
+                s.scale.push_back((float)scale[scale.size() == 1 ? 0 : c]);
+            }
+            if (zeroPoint.empty()) {
+                s.zeroPoint.push_back(0);
+            } else if (zeroPoint.size() == 1 || zeroPoint.size() == s.columns) {
+                s.zeroPoint.push_back(zeroPoint[zeroPoint.size() == 1 ? 0 : c]);
+            }
+        }
+    }
+    if (!s.validate()) {
+        return false;
+    }
+
+    schema = s;
+    return true;
+}
+
+OutputSchema OutputSchema::processed6()
+{
+    return OutputSchema();
+}
+
+OutputSchema OutputSchema::raw85()
+{
+    OutputSchema s;
+    s.columns = 85;
+    s.boxEncoding = kSchemaCxcywh;
+    s.objectness = 4;
+    s.classScores = 5;
+    s.score = -1;
+    s.classId = -1;
+    return s;
+}
+
+const OutputSchema* outputSchema()
+{
+    // Function-local so they are ready when the parser's load hook runs
+    // during another translation unit's static initialisation
+    static std::once_flag once;
+    static std::unique_ptr<OutputSchema> loaded;
+    std::call_once(once, []() {
+        const char* path = getenv("YOLOV7_OUTPUT_SCHEMA");
+        if (!path || !*path) {
+            return;
+        }
+        std::unique_ptr<OutputSchema> schema(new OutputSchema());
+        if (!OutputSchema::load(path, *schema)) {
+            std::cerr << "WARNING: Ignoring output schema " << path << ", only [N,6] and [N,85] are parsed"
+                      << std::endl;
+            return;
+        }
+        if (parserDebugLogging()) {
+            std::cerr << "YOLOv7 output schema " << path << ": " << schema->describe() << ", " << schema->columns
+                      << " columns" << std::endl;
+        }
+        loaded = std::move(schema);
+    });
+    return loaded.get();
+}
@@ -0,0 +1,123 @@
+/*
+ * Declarative description of a detector's output tensor
+ *
+ * The parser decodes any output an OutputSchema can describe: one layer,
+ * a candidate per row (row-major, [..., rows, columns]) or per column
+ * (channel-major, [..., columns, rows], as anchor-free exports emit), four
+ * box values in xyxy or cxcywh, and the confidence as one of
+ *
+ *   - a score column plus an optional class-id column ([N,6] exports)
+ *   - objectness times the best of num-classes class scores (raw [N,85])
+ *   - the best class score alone (exports without objectness)
+ *
+ * Each combination of order, box encoding, score mode and element type is
+ * its own decoder instantiation (see nvdsparsebbox_yolov7.cpp), so a new
+ * export gets a decoder with no per-row branching on the layout; column
+ * offsets and strides are read from the schema once per call.
+ *
+ * Without a schema file the parser recognises the two layouts it always
+ * has, [N,6] and [N,85]; they are processed6() and raw85() below. Start
+ * the pipeline with YOLOV7_OUTPUT_SCHEMA=<path> to describe another one.
+ * The schema is read once, when the parser is first used.
+ *
+ * Config (key file format, see configs/yolov7_output_schema.txt):
+ *
+ *   [output-schema]
+ *   layer=output          # layer to parse, empty = the first output
+ *   order=row-major       # row-major | channel-major
+ *   columns=85            # values per candidate
+ *   box=0                 # first of the four box values
+ *   box-encoding=cxcywh   # xyxy | cxcywh
+ *   objectness=4          # -1 = none
+ *   class-scores=5        # first of num-classes scores, -1 = none
+ *   num-classes=80
+ *   score=-1              # confidence column when there are no class scores
+ *   class-id=-1           # class index column, -1 = every box is class 0
+ *   dtype=float32         # float32 | float16 | int8
+ *   scale=1               # int8 only: one value, or one per column
+ *   zero-point=0          # int8 only: one value, or one per column
+ *
+ * INT8 outputs are dequantized as (q - zero-point) * scale, but only for
+ * the candidates that pass a screen on the raw bytes against thresholds
+ * converted to int8 once per call. Channel-major tensors are screened 32
+ * or 64 candidates per SIMD compare. Per-column parameters let coordinates
+ * and scores keep their own range; the class-score columns must share one
+ * scale and zero point so their bytes compare directly.
+ */
+
+#ifndef __OUTPUT_SCHEMA_H__
+#define __OUTPUT_SCHEMA_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum SchemaOrder : uint32_t
+{
+    kSchemaRowMajor = 0,
+    kSchemaChannelMajor = 1,
+};
+
+enum SchemaBoxEncoding : uint32_t
+{
+    kSchemaXyxy = 0,
+    kSchemaCxcywh = 1,
+};
+
+enum SchemaScoreMode : uint32_t
+{
+    kSchemaScoreColumn = 0,        // score (and class-id) columns
+    kSchemaObjectnessClasses = 1,  // objectness * best class score
+    kSchemaClassScores = 2,        // best class score
+};
+
+enum SchemaDataType : uint32_t
+{
+    kSchemaFloat32 = 0,
+    kSchemaFloat16 = 1,
+    kSchemaInt8 = 2,
+};
+
+struct OutputSchema
+{
+    std::string layer;
+    SchemaOrder order = kSchemaRowMajor;
+    uint32_t columns = 6;
+    uint32_t box = 0;
+    SchemaBoxEncoding boxEncoding = kSchemaXyxy;
+    int32_t objectness = -1;
+    int32_t classScores = -1;
+    uint32_t numClasses = 80;
+    int32_t score = 4;
+    int32_t classId = 5;
+    SchemaDataType dtype = kSchemaFloat32;
+    std::vector<float> scale;         // int8: per column, empty otherwise
+    std::vector<int32_t> zeroPoint;   // int8: per column, empty otherwise
+
+    SchemaScoreMode scoreMode() const;
+    // Short name of the combination, e.g. "row-cxcywh-objcls-f32"
+    std::string describe() const;
+
+    // (q - zero point) * scale of `column`, int8 schemas only
+    float dequantize(const uint32_t column, const int8_t q) const { return (q - zeroPoint[column]) * scale[column]; }
+    // Threshold on the raw int8 values of `column`: every q below it
+    // dequantizes below `threshold`. Conservative by at most one step, so
+    // what passes is still compared after dequantization. 128 rejects all.
+    int32_t quantizeThreshold(const uint32_t column, const float threshold) const;
+
+    // Every referenced column lies inside `columns`
+    bool validate() const;
+
+    static bool load(const std::string& path, OutputSchema& schema);
+
+    // [N,6] x1,y1,x2,y2,confidence,class
+    static OutputSchema processed6();
+    // [N,85] cx,cy,w,h,objectness,80 class scores
+    static OutputSchema raw85();
+};
+
+// The schema loaded from YOLOV7_OUTPUT_SCHEMA, read on first use; nullptr
+// when the variable is unset or the file fails to load (reported once).
+const OutputSchema* outputSchema();
+
+#endif
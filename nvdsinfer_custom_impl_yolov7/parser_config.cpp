@@ -0,0 +1,221 @@
+/*
+ * Hot-reloadable YOLOv7 parser settings
+ */
+
+#include "parser_config.h"
+#include "key_file.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Parse calls take microseconds; a superseded snapshot is freed only after
+// this long
+static const std::chrono::seconds kGracePeriod(30);
+
+ParserSettings::ParserSettings()
+{
+    for (int c = 0; c < PARSER_MAX_CLASSES; ++c) {
+        classThreshold[c] = -1.0f;
+    }
+}
+
+bool ParserSettings::load(const std::string& path, ParserSettings& settings)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "parser";
+    if (!kf.hasGroup(g)) {
+        std::cerr << "ERROR: " << path << " has no [parser] group" << std::endl;
+        return false;
+    }
+
+    ParserSettings s;
+    const double confidence = kf.getDouble(g, "confidence-threshold", -1.0);
+    if (confidence > 1.0) {
+        std::cerr << "ERROR: confidence-threshold must be at most 1" << std::endl;
+        return false;
+    }
+    for (int c = 0; c < PARSER_MAX_CLASSES; ++c) {
+        s.classThreshold[c] = (float)confidence;
+    }
+
+    const std::string tg = "class-thresholds";
+    for (int c = 0; c < PARSER_MAX_CLASSES && kf.hasGroup(tg); ++c) {
+        const std::string key = std::to_string(c);
+        if (kf.hasKey(tg, key)) {
+            const double t = kf.getDouble(tg, key, -1.0);
+            if (t < 0.0 || t > 1.0) {
+                std::cerr << "ERROR: [class-thresholds] " << key << " must be within 0..1" << std::endl;
+                return false;
+            }
+            s.classThreshold[c] = (float)t;
+        }
+    }
+
+    const std::vector<int> classIds = kf.getIntList(g, "class-ids");
+    if (!classIds.empty()) {
+        bool enabled[PARSER_MAX_CLASSES] = {};
+        for (int id : classIds) {
+            if (id < 0 || id >= PARSER_MAX_CLASSES) {
+                std::cerr << "ERROR: class-ids entry " << id << " is out of range" << std::endl;
+                return false;
+            }
+            enabled[id] = true;
+        }
+        for (int c = 0; c < PARSER_MAX_CLASSES; ++c) {
+            if (!enabled[c]) {
+                s.classThreshold[c] = 2.0f;
+            }
+        }
+    }
+
+    for (int c = 0; c < PARSER_MAX_CLASSES; ++c) {
+        s.overridesThresholds |= s.classThreshold[c] >= 0.0f;
+    }
+
+    s.objectnessThreshold = (float)kf.getDouble(g, "objectness-threshold", s.objectnessThreshold);
+    s.minBoxSize = (float)kf.getDouble(g, "min-box-size", s.minBoxSize);
+    s.debug = kf.getBool(g, "debug", false);
+
+    const std::string kernel = kf.getString(g, "kernel", "auto");
+    if (kernel != "auto" && kernel != "scalar") {
+        std::cerr << "ERROR: kernel must be auto or scalar, got " << kernel << std::endl;
+        return false;
+    }
+    s.forceScalar = kernel == "scalar";
+
+    settings = s;
+    return true;
+}
+
+std::unique_ptr<ParserConfigWatcher> ParserConfigWatcher::start(const std::string& path)
+{
+    std::unique_ptr<ParserConfigWatcher> w(new ParserConfigWatcher());
+    w->m_Path = path;
+    const size_t slash = path.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    w->m_FileName = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    if (!w->reload()) {
+        return nullptr;
+    }
+
+    w->m_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (w->m_InotifyFd < 0) {
+        std::cerr << "ERROR: inotify_init1 failed, parser config will not be reloaded" << std::endl;
+        return nullptr;
+    }
+    if (inotify_add_watch(w->m_InotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        std::cerr << "ERROR: Cannot watch " << dir << " for parser config changes" << std::endl;
+        return nullptr;
+    }
+
+    w->m_Thread = std::thread(&ParserConfigWatcher::run, w.get());
+    return w;
+}
+
+ParserConfigWatcher::~ParserConfigWatcher()
+{
+    m_Stop.store(true);
+    if (m_Thread.joinable()) {
+        m_Thread.join();
+    }
+    if (m_InotifyFd >= 0) {
+        close(m_InotifyFd);
+    }
+}
+
+bool ParserConfigWatcher::reload()
+{
+    std::lock_guard<std::mutex> lock(m_ReloadMutex);
+
+    std::unique_ptr<ParserSettings> next(new ParserSettings());
+    if (!ParserSettings::load(m_Path, *next)) {
+        m_Failures.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "WARNING: Keeping previous parser settings, " << m_Path << " did not load" << std::endl;
+        return false;
+    }
+    next->generation = ++m_Generation;
+
+    // Publish, then retire the old snapshot; readers that loaded it before
+    // the store keep using it until their parse call returns
+    const auto now = std::chrono::steady_clock::now();
+    m_Current.store(next.get(), std::memory_order_release);
+    if (m_Owned) {
+        m_Retired.push_back(Retired{std::move(m_Owned), now});
+    }
+    m_Owned = std::move(next);
+
+    while (!m_Retired.empty() && now - m_Retired.front().retiredAt > kGracePeriod) {
+        m_Retired.erase(m_Retired.begin());
+    }
+
+    m_Reloads.fetch_add(1, std::memory_order_relaxed);
+    if (parserDebugLogging()) {
+        std::cerr << "YOLOv7 parser settings generation " << m_Generation << " loaded from " << m_Path << std::endl;
+    }
+    return true;
+}
+
+void ParserConfigWatcher::run()
+{
+    alignas(struct inotify_event) char buf[4096];
+    while (!m_Stop.load()) {
+        struct pollfd pfd = {m_InotifyFd, POLLIN, 0};
+        if (poll(&pfd, 1, 500) <= 0) {
+            continue;
+        }
+
+        bool changed = false;
+        ssize_t len;
+        while ((len = read(m_InotifyFd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+                if (ev->len > 0 && m_FileName == ev->name) {
+                    changed = true;
+                }
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        // One reload per burst of events (an editor save is several)
+        if (changed) {
+            reload();
+        }
+    }
+}
+
+static std::unique_ptr<ParserConfigWatcher> g_Watcher;
+static std::once_flag g_WatcherOnce;
+
+const ParserSettings* parserSettings()
+{
+    std::call_once(g_WatcherOnce, []() {
+        const char* path = getenv("YOLOV7_PARSER_CONFIG");
+        if (path && *path) {
+            g_Watcher = ParserConfigWatcher::start(path);
+            if (!g_Watcher) {
+                std::cerr << "WARNING: Using built-in parser settings" << std::endl;
+            }
+        }
+    });
+    // Function-local so it is ready even when called from another
+    // translation unit's static initialisation (the parser's load hook)
+    static const ParserSettings defaults;
+    return g_Watcher ? g_Watcher->current() : &defaults;
+}
+
+bool parserDebugLogging()
+{
+    static const bool debug = []() {
+        const char* env = getenv("YOLOV7_PARSER_DEBUG");
+        return env && strcmp(env, "0") != 0;
+    }();
+    return debug;
+}
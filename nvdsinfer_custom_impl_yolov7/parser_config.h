@@ -0,0 +1,113 @@
+/*
+ * Hot-reloadable YOLOv7 parser settings
+ *
+ * The parser reads its tunables from an immutable ParserSettings snapshot.
+ * ParserConfigWatcher watches the config file's directory with inotify (so
+ * editors that save via rename are seen too), re-reads the file on change
+ * and publishes the new snapshot with one atomic pointer store. A parse
+ * call loads the pointer once and uses that snapshot to the end, so calls
+ * in flight finish on the old settings and no reader ever takes a lock.
+ * A file that fails to load leaves the current snapshot in place.
+ *
+ * Superseded snapshots are reclaimed after a grace period far longer than
+ * any parse call (RCU with a time-based grace period); reloads are rare,
+ * so the few kilobytes this keeps alive do not matter.
+ *
+ * Config (key file format, see configs/yolov7_parser.txt):
+ *
+ *   [parser]
+ *   confidence-threshold=0.25   # overrides the infer config, -1 = keep it
+ *   class-ids=0;2               # class mask, empty = every class
+ *   objectness-threshold=0.1    # raw [N,85] output only
+ *   min-box-size=1              # pixels, both sides
+ *   kernel=auto                 # auto | scalar
+ *   debug=0
+ *
+ *   [class-thresholds]
+ *   0=0.4                       # per-class override, wins over the above
+ */
+
+#ifndef __PARSER_CONFIG_H__
+#define __PARSER_CONFIG_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PARSER_MAX_CLASSES 80
+
+struct ParserSettings
+{
+    // Effective pre-cluster threshold per class; negative = use the infer
+    // config's value, above 1 = class masked out
+    float classThreshold[PARSER_MAX_CLASSES];
+    bool overridesThresholds = false;
+    float objectnessThreshold = 0.1f;
+    float minBoxSize = 1.0f;
+    bool forceScalar = false;
+    bool debug = false;
+    uint64_t generation = 0;  // 0 = built-in defaults, then 1 per load
+
+    ParserSettings();
+
+    static bool load(const std::string& path, ParserSettings& settings);
+};
+
+class ParserConfigWatcher
+{
+public:
+    ~ParserConfigWatcher();
+
+    // Loads `path` and starts watching it. Returns nullptr if the first
+    // load fails or inotify is unavailable.
+    static std::unique_ptr<ParserConfigWatcher> start(const std::string& path);
+
+    // Current snapshot; never null, valid for at least the grace period
+    // after it is superseded. Lock-free.
+    const ParserSettings* current() const { return m_Current.load(std::memory_order_acquire); }
+
+    // Re-reads the file now (also what the inotify thread calls)
+    bool reload();
+
+    uint64_t reloads() const { return m_Reloads.load(std::memory_order_relaxed); }
+    uint64_t failures() const { return m_Failures.load(std::memory_order_relaxed); }
+
+private:
+    struct Retired
+    {
+        std::unique_ptr<const ParserSettings> settings;
+        std::chrono::steady_clock::time_point retiredAt;
+    };
+
+    ParserConfigWatcher() {}
+    void run();
+
+    std::string m_Path;
+    std::string m_FileName;
+    int m_InotifyFd = -1;
+    std::atomic<bool> m_Stop{false};
+    std::thread m_Thread;
+
+    std::atomic<const ParserSettings*> m_Current{nullptr};
+    std::unique_ptr<const ParserSettings> m_Owned;  // the snapshot m_Current points to
+    std::vector<Retired> m_Retired;
+    std::mutex m_ReloadMutex;  // serialises writers only
+    uint64_t m_Generation = 0;
+    std::atomic<uint64_t> m_Reloads{0};
+    std::atomic<uint64_t> m_Failures{0};
+};
+
+// Settings the parser uses: the watcher's snapshot when the library was
+// loaded with YOLOV7_PARSER_CONFIG=<path>, built-in defaults otherwise.
+const ParserSettings* parserSettings();
+
+// YOLOV7_PARSER_DEBUG is set and not 0: layout, schema and settings
+// messages go to stderr. Nothing the parser logs goes to stdout.
+bool parserDebugLogging();
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Server-side detect -> crop step for the Triton detect_reid model
+ */
+
+#include "server_step.h"
+#include "nvdsinfer_custom_impl.h"
+#include "object_nms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+extern "C" bool NvDsInferParseYolov7(std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+                                     NvDsInferNetworkInfo const& networkInfo,
+                                     NvDsInferParseDetectionParams const& detectionParams,
+                                     std::vector<NvDsInferParseObjectInfo>& objectList);
+
+// Per thread, so Python threads may call in concurrently; vectors keep
+// their capacity between calls
+struct DecodeScratch
+{
+    std::vector<NvDsInferLayerInfo> layers;
+    NvDsInferParseDetectionParams params;
+    std::vector<NvDsInferParseObjectInfo> parsed;
+    std::vector<NvDsInferParseObjectInfo> objects;
+};
+
+static thread_local DecodeScratch t_Decode;
+
+extern "C" int Yolov7ServerStepDecode(const float* output, unsigned int dim0, unsigned int dim1,
+                                      const Yolov7ServerStepParams* params, float* boxes, unsigned int maxBoxes)
+{
+    if (!output || !params || (!boxes && maxBoxes > 0) || dim0 == 0 || dim1 == 0) {
+        std::cerr << "ERROR: Invalid arguments to Yolov7ServerStepDecode" << std::endl;
+        return -1;
+    }
+
+    DecodeScratch& s = t_Decode;
+    if (s.layers.empty()) {
+        NvDsInferLayerInfo layer;
+        memset(&layer, 0, sizeof(layer));
+        layer.dataType = FLOAT;
+        layer.inferDims.numDims = 2;
+        layer.layerName = "output";
+        s.layers.assign(1, layer);
+    }
+    NvDsInferLayerInfo& layer = s.layers[0];
+    layer.inferDims.d[0] = dim0;
+    layer.inferDims.d[1] = dim1;
+    layer.inferDims.numElements = dim0 * dim1;
+    layer.buffer = const_cast<float*>(output);
+
+    NvDsInferNetworkInfo networkInfo;
+    networkInfo.width = params->netWidth;
+    networkInfo.height = params->netHeight;
+    networkInfo.channels = 3;
+
+    s.params.numClassesConfigured = params->numClasses;
+    s.params.perClassPreclusterThreshold.assign(params->numClasses, params->confidenceThreshold);
+    s.params.perClassPostclusterThreshold.assign(params->numClasses, params->confidenceThreshold);
+
+    if (!NvDsInferParseYolov7(s.layers, networkInfo, s.params, s.parsed)) {
+        return -1;
+    }
+    nmsPerClass(s.parsed, params->nmsIou, std::min(params->topK, maxBoxes), s.objects);
+
+    for (size_t i = 0; i < s.objects.size(); ++i) {
+        const NvDsInferParseObjectInfo& o = s.objects[i];
+        float* row = boxes + i * 6;
+        row[0] = o.left;
+        row[1] = o.top;
+        row[2] = o.left + o.width;
+        row[3] = o.top + o.height;
+        row[4] = o.detectionConfidence;
+        row[5] = (float)o.classId;
+    }
+    return (int)s.objects.size();
+}
+
+extern "C" void Yolov7ServerStepCrop(const float* image, unsigned int netWidth, unsigned int netHeight,
+                                     const float* boxes, unsigned int count, unsigned int boxStride,
+                                     unsigned int cropWidth, unsigned int cropHeight, const float* mean,
+                                     const float* stddev, float* crops)
+{
+    const size_t srcPlane = (size_t)netWidth * netHeight;
+    const size_t plane = (size_t)cropWidth * cropHeight;
+    float scale[3], bias[3];
+    for (int ch = 0; ch < 3; ++ch) {
+        scale[ch] = 1.0f / stddev[ch];
+        bias[ch] = -mean[ch] / stddev[ch];
+    }
+    std::vector<int32_t> x0s(cropWidth), x1s(cropWidth);
+    std::vector<float> fxs(cropWidth);
+
+    for (unsigned int i = 0; i < count; ++i) {
+        const float* box = boxes + (size_t)i * boxStride;
+        float* dst = crops + (size_t)i * 3 * plane;
+        const float left = std::max(0.0f, box[0]);
+        const float top = std::max(0.0f, box[1]);
+        const float right = std::min((float)netWidth, box[2]);
+        const float bottom = std::min((float)netHeight, box[3]);
+        if (right - left < 1.0f || bottom - top < 1.0f) {
+            std::fill(dst, dst + 3 * plane, 0.0f);
+            continue;
+        }
+
+        // Bilinear taps with pixel centres aligned, clamped to the box, as
+        // the in-process ReID embedder resizes
+        const float sx = (right - left) / cropWidth;
+        const float sy = (bottom - top) / cropHeight;
+        const int32_t maxX = (int32_t)std::ceil(right) - 1;
+        const int32_t maxY = (int32_t)std::ceil(bottom) - 1;
+        for (unsigned int x = 0; x < cropWidth; ++x) {
+            const float fx = std::max(left, left + (x + 0.5f) * sx - 0.5f);
+            const int32_t x0 = std::min((int32_t)fx, maxX);
+            x0s[x] = x0;
+            x1s[x] = std::min(x0 + 1, maxX);
+            fxs[x] = fx - x0;
+        }
+
+        for (unsigned int y = 0; y < cropHeight; ++y) {
+            const float fy = std::max(top, top + (y + 0.5f) * sy - 0.5f);
+            const int32_t y0 = std::min((int32_t)fy, maxY);
+            const int32_t y1 = std::min(y0 + 1, maxY);
+            const float wy = fy - y0;
+            for (int ch = 0; ch < 3; ++ch) {
+                const float* row0 = image + ch * srcPlane + (size_t)y0 * netWidth;
+                const float* row1 = image + ch * srcPlane + (size_t)y1 * netWidth;
+                float* out = dst + ch * plane + (size_t)y * cropWidth;
+                for (unsigned int x = 0; x < cropWidth; ++x) {
+                    const float wx = fxs[x];
+                    const float a = row0[x0s[x]] + wx * (row0[x1s[x]] - row0[x0s[x]]);
+                    const float b = row1[x0s[x]] + wx * (row1[x1s[x]] - row1[x0s[x]]);
+                    out[x] = (a + wy * (b - a)) * scale[ch] + bias[ch];
+                }
+            }
+        }
+    }
+}
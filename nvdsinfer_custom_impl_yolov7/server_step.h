@@ -0,0 +1,56 @@
+/*
+ * Server-side detect -> crop step for the Triton detect_reid model
+ *
+ * The detect_reid Python BLS model (models/detect_reid) runs the detector,
+ * then needs boxes and ReID crops before it can call the embedder. Doing
+ * that in NumPy would fork the decode logic, so it loads this library with
+ * ctypes instead: Decode goes through NvDsInferParseYolov7 and the same
+ * per-class NMS as the CPU detector (object_nms.h), Crop cuts the boxes out
+ * of the detector's own input tensor and resizes them for the embedder.
+ * Both take plain arrays so NumPy buffers pass straight through.
+ *
+ * Build with `make server-step`: it needs the DeepStream headers but links
+ * nothing beyond libstdc++, so the .so built in the DeepStream container
+ * loads in the Triton one. The parser's load hook, YOLOV7_PARSER_CONFIG
+ * and YOLOV7_PARSER_DEBUG behave as in the nvinferserver library.
+ */
+
+#ifndef __SERVER_STEP_H__
+#define __SERVER_STEP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    unsigned int netWidth;           // detector input the boxes are in
+    unsigned int netHeight;
+    unsigned int numClasses;
+    float confidenceThreshold;       // every class; the parser config may override
+    float nmsIou;
+    unsigned int topK;               // boxes kept after NMS
+} Yolov7ServerStepParams;
+
+// Decodes one image's float32 detector output and clusters it. dim0 x dim1
+// is the tensor's shape: [rows, 6 | 85], or what YOLOV7_OUTPUT_SCHEMA
+// describes (see output_schema.h). Writes up to maxBoxes rows of [x1, y1,
+// x2, y2, confidence, class] in network pixels, highest confidence first,
+// and returns how many; -1 when the parser rejects the tensor.
+int Yolov7ServerStepDecode(const float* output, unsigned int dim0, unsigned int dim1,
+                           const Yolov7ServerStepParams* params, float* boxes, unsigned int maxBoxes);
+
+// Cuts `count` boxes (rows of boxStride floats starting x1, y1, x2, y2) out
+// of a planar RGB [3, netHeight, netWidth] image scaled to [0, 1], the
+// detector's input, and bilinearly resizes each to cropWidth x cropHeight
+// normalised with mean/stddev (3 floats each, RGB). Writes [count, 3,
+// cropHeight, cropWidth]. A box with nothing inside the image gives zeros.
+void Yolov7ServerStepCrop(const float* image, unsigned int netWidth, unsigned int netHeight, const float* boxes,
+                          unsigned int count, unsigned int boxStride, unsigned int cropWidth,
+                          unsigned int cropHeight, const float* mean, const float* stddev, float* crops);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * DeepStream parser types for builds without DeepStream
+ *
+ * The decode library (yolov7_decode.h) compiles the parser with
+ * YOLOV7_STANDALONE_DECODE, and this header stands in for
+ * nvdsinfer_custom_impl.h. It declares only the types that the parser and
+ * object_nms.h use. Nothing built this way passes them to DeepStream, so
+ * they need the same members but not the same layout.
+ */
+
+#ifndef __STANDALONE_INFER_TYPES_H__
+#define __STANDALONE_INFER_TYPES_H__
+
+#include <sys/types.h>
+#include <type_traits>
+#include <vector>
+
+#define NVDSINFER_MAX_DIMS 8
+
+typedef enum
+{
+    FLOAT = 0,
+    HALF = 1,
+    INT8 = 2,
+    INT32 = 3,
+} NvDsInferDataType;
+
+typedef struct
+{
+    unsigned int numDims;
+    unsigned int d[NVDSINFER_MAX_DIMS];
+    unsigned int numElements;
+} NvDsInferDims;
+
+typedef struct
+{
+    NvDsInferDataType dataType;
+    NvDsInferDims inferDims;
+    int bindingIndex;
+    const char* layerName;
+    void* buffer;
+    int isInput;
+} NvDsInferLayerInfo;
+
+typedef struct
+{
+    unsigned int width;
+    unsigned int height;
+    unsigned int channels;
+} NvDsInferNetworkInfo;
+
+typedef struct
+{
+    unsigned int classId;
+    float left;
+    float top;
+    float width;
+    float height;
+    float detectionConfidence;
+} NvDsInferParseObjectInfo;
+
+typedef struct
+{
+    unsigned int numClassesConfigured;
+    std::vector<float> perClassPreclusterThreshold;
+    std::vector<float> perClassPostclusterThreshold;
+} NvDsInferParseDetectionParams;
+
+typedef bool (*NvDsInferParseCustomFunc)(std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+                                         NvDsInferNetworkInfo const& networkInfo,
+                                         NvDsInferParseDetectionParams const& detectionParams,
+                                         std::vector<NvDsInferParseObjectInfo>& objectList);
+
+#define CHECK_CUSTOM_PARSE_FUNC_PROTOTYPE(customParseFunc)                                   \
+    static_assert(std::is_same<decltype(&customParseFunc), NvDsInferParseCustomFunc>::value, \
+                  #customParseFunc " does not match NvDsInferParseCustomFunc")
+
+#endif
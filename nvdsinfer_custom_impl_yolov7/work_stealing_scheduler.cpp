@@ -0,0 +1,512 @@
+/*
+ * Process-wide work-stealing scheduler for the native CPU stages
+ */
+
+#include "work_stealing_scheduler.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <pthread.h>
+#include <sched.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static thread_local const WorkStealingScheduler* t_Scheduler = nullptr;
+static thread_local int t_Worker = -1;
+
+bool SchedulerConfig::load(const std::string& path, SchedulerConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "scheduler";
+    SchedulerConfig c;
+    c.maxWorkers = (uint32_t)std::max(0, kf.getInt(g, "max-workers", (int)c.maxWorkers));
+    c.reservedCores = (uint32_t)std::max(0, kf.getInt(g, "reserved-cores", (int)c.reservedCores));
+    c.cpus = kf.getIntList(g, "cpus");
+    c.numaNode = kf.getInt(g, "numa-node", c.numaNode);
+    c.pin = kf.getBool(g, "pin", c.pin);
+    c.dequeCapacity = (uint32_t)std::max(0, kf.getInt(g, "deque-capacity", (int)c.dequeCapacity));
+    c.spinUs = (uint32_t)std::max(0, kf.getInt(g, "spin-us", (int)c.spinUs));
+    if (c.dequeCapacity < 2 || c.numaNode < -1 ||
+        std::any_of(c.cpus.begin(), c.cpus.end(), [](int cpu) { return cpu < 0 || cpu >= CPU_SETSIZE; })) {
+        std::cerr << "ERROR: " << path << ": [scheduler] needs deque-capacity >= 2, numa-node >= -1 "
+                  << "and valid cpus" << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+static std::vector<int> processCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Parses a sysfs CPU list such as "0-3,8-11"
+static std::vector<int> nodeCpus(int node)
+{
+    std::vector<int> cpus;
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return cpus;
+    }
+    int first = 0, last = 0;
+    char sep = 0;
+    while (fscanf(f, "%d", &first) == 1) {
+        last = first;
+        if (fscanf(f, "%c", &sep) == 1 && sep == '-') {
+            if (fscanf(f, "%d", &last) != 1) {
+                break;
+            }
+            if (fscanf(f, "%c", &sep) != 1) {
+                sep = 0;
+            }
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (sep != ',') {
+            break;
+        }
+    }
+    fclose(f);
+    return cpus;
+}
+
+static void setAffinity(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        std::cerr << "ERROR: Cannot set scheduler worker affinity" << std::endl;
+    }
+}
+
+WorkStealingScheduler::JobDeque::JobDeque(uint32_t capacity) : m_Top(0), m_Bottom(0)
+{
+    uint32_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_Slots.reset(new std::atomic<SchedulerJob*>[size]);
+    for (uint32_t i = 0; i < size; ++i) {
+        m_Slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    m_Mask = size - 1;
+}
+
+bool WorkStealingScheduler::JobDeque::push(SchedulerJob* job)
+{
+    const int64_t b = m_Bottom.load(std::memory_order_relaxed);
+    const int64_t t = m_Top.load(std::memory_order_acquire);
+    if (b - t > m_Mask) {
+        return false;
+    }
+    m_Slots[b & m_Mask].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_Bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+SchedulerJob* WorkStealingScheduler::JobDeque::pop()
+{
+    const int64_t b = m_Bottom.load(std::memory_order_relaxed) - 1;
+    m_Bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = m_Top.load(std::memory_order_relaxed);
+    if (t > b) {
+        m_Bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    SchedulerJob* job = m_Slots[b & m_Mask].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last job: race the thieves for it
+        if (!m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        m_Bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+SchedulerJob* WorkStealingScheduler::JobDeque::steal()
+{
+    int64_t t = m_Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = m_Bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+    SchedulerJob* job = m_Slots[t & m_Mask].load(std::memory_order_relaxed);
+    if (!m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+bool WorkStealingScheduler::JobDeque::empty() const
+{
+    return m_Top.load(std::memory_order_acquire) >= m_Bottom.load(std::memory_order_acquire);
+}
+
+WorkStealingScheduler::WorkStealingScheduler(const SchedulerConfig& config) : m_Config(config)
+{
+    const std::vector<int> allowed = processCpus();
+    std::vector<int> cpus;
+    if (!config.cpus.empty()) {
+        cpus = config.cpus;
+    } else if (config.numaNode >= 0) {
+        cpus = nodeCpus(config.numaNode);
+        if (cpus.empty()) {
+            std::cerr << "ERROR: No CPUs found for NUMA node " << config.numaNode << std::endl;
+        }
+    }
+    if (!cpus.empty()) {
+        // Never place a worker outside the process affinity mask
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                                  [&](int cpu) { return !std::binary_search(allowed.begin(), allowed.end(), cpu); }),
+                   cpus.end());
+        if (cpus.empty()) {
+            std::cerr << "ERROR: None of the scheduler CPUs are usable, using the process CPUs" << std::endl;
+        }
+    }
+    if (cpus.empty()) {
+        cpus = allowed.empty() ? std::vector<int>{0} : allowed;
+    }
+
+    const uint32_t available =
+        cpus.size() > config.reservedCores ? (uint32_t)cpus.size() - config.reservedCores : 1u;
+    const uint32_t count = config.maxWorkers ? std::min(config.maxWorkers, available) : available;
+    // The reserved CPUs are the first of the set
+    const std::vector<int> own(cpus.end() - count, cpus.end());
+
+    for (uint32_t i = 0; i < count; ++i) {
+        std::unique_ptr<Worker> w(new Worker);
+        if (config.pin) {
+            w->cpu = own[i];
+        } else {
+            w->cpuSet = own;
+        }
+        m_Workers.push_back(std::move(w));
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        m_Workers[i]->thread = std::thread(&WorkStealingScheduler::workerLoop, this, i);
+    }
+    // Thieves index every deque, so none may be missing once submit() runs
+    while (m_Ready.load(std::memory_order_acquire) < count) {
+        std::this_thread::yield();
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_ParkMutex);
+        m_Stopping.store(true);
+        m_WakeEpoch++;
+    }
+    m_ParkCv.notify_all();
+    for (std::unique_ptr<Worker>& w : m_Workers) {
+        w->thread.join();
+    }
+}
+
+static std::mutex g_SharedMutex;
+static std::unique_ptr<WorkStealingScheduler> g_Shared;
+static SchedulerConfig g_SharedConfig;
+
+WorkStealingScheduler& WorkStealingScheduler::shared()
+{
+    std::lock_guard<std::mutex> lock(g_SharedMutex);
+    if (!g_Shared) {
+        g_Shared.reset(new WorkStealingScheduler(g_SharedConfig));
+    }
+    return *g_Shared;
+}
+
+bool WorkStealingScheduler::configureShared(const SchedulerConfig& config)
+{
+    std::lock_guard<std::mutex> lock(g_SharedMutex);
+    if (g_Shared) {
+        return false;
+    }
+    g_SharedConfig = config;
+    return true;
+}
+
+int WorkStealingScheduler::currentWorker() const
+{
+    return t_Scheduler == this ? t_Worker : -1;
+}
+
+void WorkStealingScheduler::submit(SchedulerJob* job)
+{
+    const int me = currentWorker();
+    if (me >= 0) {
+        Worker& w = *m_Workers[me];
+        if (!w.deque->push(job)) {
+            w.inlined.fetch_add(1, std::memory_order_relaxed);
+            job->run(job);
+            return;
+        }
+        wakeOne();
+        return;
+    }
+    m_InjectedTotal.fetch_add(1, std::memory_order_relaxed);
+    inject(job);
+}
+
+void WorkStealingScheduler::requeue(SchedulerJob* job)
+{
+    const int me = currentWorker();
+    if (me >= 0 && m_Workers[me]->deque->push(job)) {
+        wakeOne();
+        return;
+    }
+    m_InjectedTotal.fetch_add(1, std::memory_order_relaxed);
+    inject(job);
+}
+
+void WorkStealingScheduler::inject(SchedulerJob* job)
+{
+    job->next = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_InjectMutex);
+        if (m_InjectTail) {
+            m_InjectTail->next = job;
+        } else {
+            m_InjectHead = job;
+        }
+        m_InjectTail = job;
+        m_Injected.fetch_add(1, std::memory_order_release);
+    }
+    wakeOne();
+}
+
+void WorkStealingScheduler::wakeOne()
+{
+    // Pairs with the fence in workerLoop(): either the sleeper sees the job
+    // or this sees the sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_Sleeping.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_ParkMutex);
+        m_WakeEpoch++;
+    }
+    m_ParkCv.notify_one();
+}
+
+SchedulerJob* WorkStealingScheduler::takeInjected()
+{
+    if (m_Injected.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(m_InjectMutex);
+    SchedulerJob* job = m_InjectHead;
+    if (job) {
+        m_InjectHead = job->next;
+        if (!m_InjectHead) {
+            m_InjectTail = nullptr;
+        }
+        job->next = nullptr;
+        m_Injected.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+SchedulerJob* WorkStealingScheduler::findWork(uint32_t index, uint64_t& rng)
+{
+    Worker& self = *m_Workers[index];
+    if (SchedulerJob* job = self.deque->pop()) {
+        return job;
+    }
+    // External work before stealing, so frames entering the pool are not
+    // starved by jobs that spawn more jobs
+    if (SchedulerJob* job = takeInjected()) {
+        return job;
+    }
+    const uint32_t n = (uint32_t)m_Workers.size();
+    if (n < 2) {
+        return nullptr;
+    }
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    const uint32_t start = (uint32_t)(rng % n);
+    for (uint32_t k = 0; k < n; ++k) {
+        const uint32_t victim = (start + k) % n;
+        if (victim == index) {
+            continue;
+        }
+        if (SchedulerJob* job = m_Workers[victim]->deque->steal()) {
+            self.stolen.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+bool WorkStealingScheduler::anyWork() const
+{
+    if (m_Injected.load(std::memory_order_acquire) > 0) {
+        return true;
+    }
+    for (const std::unique_ptr<Worker>& w : m_Workers) {
+        if (!w->deque->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingScheduler::workerLoop(uint32_t index)
+{
+    Worker& self = *m_Workers[index];
+    if (self.cpu >= 0) {
+        setAffinity(std::vector<int>{self.cpu});
+    } else if (!self.cpuSet.empty()) {
+        setAffinity(self.cpuSet);
+    }
+    self.deque.reset(new JobDeque(m_Config.dequeCapacity));
+    t_Scheduler = this;
+    t_Worker = (int)index;
+    m_Ready.fetch_add(1, std::memory_order_release);
+    // Stealing reads every other deque, so wait for all of them
+    while (m_Ready.load(std::memory_order_acquire) < m_Workers.size()) {
+        std::this_thread::yield();
+    }
+
+    uint64_t rng = 0x9e3779b97f4a7c15ull * (index + 1);
+    const std::chrono::microseconds spin(m_Config.spinUs);
+    while (true) {
+        SchedulerJob* job = findWork(index, rng);
+        if (!job && m_Config.spinUs > 0) {
+            const Clock::time_point until = Clock::now() + spin;
+            while (!job && !m_Stopping.load(std::memory_order_relaxed) && Clock::now() < until) {
+                std::this_thread::yield();
+                job = findWork(index, rng);
+            }
+        }
+        if (job) {
+            job->run(job);
+            self.executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_ParkMutex);
+        if (m_Stopping.load()) {
+            break;
+        }
+        const uint64_t epoch = m_WakeEpoch;
+        m_Sleeping.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!anyWork()) {
+            self.parks.fetch_add(1, std::memory_order_relaxed);
+            m_ParkCv.wait(lock, [&]() { return m_WakeEpoch != epoch || m_Stopping.load(); });
+        }
+        m_Sleeping.fetch_sub(1);
+    }
+    t_Scheduler = nullptr;
+    t_Worker = -1;
+}
+
+SchedulerStats WorkStealingScheduler::stats() const
+{
+    SchedulerStats s;
+    for (const std::unique_ptr<Worker>& w : m_Workers) {
+        s.executed += w->executed.load(std::memory_order_relaxed);
+        s.stolen += w->stolen.load(std::memory_order_relaxed);
+        s.inlined += w->inlined.load(std::memory_order_relaxed);
+        s.parks += w->parks.load(std::memory_order_relaxed);
+    }
+    s.injected = m_InjectedTotal.load(std::memory_order_relaxed);
+    return s;
+}
+
+Strand::Strand(WorkStealingScheduler& scheduler) : m_Scheduler(scheduler)
+{
+    m_Drain.run = &Strand::drain;
+    m_Drain.strand = this;
+}
+
+void Strand::post(SchedulerJob* job)
+{
+    job->next = nullptr;
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Tail) {
+            m_Tail->next = job;
+        } else {
+            m_Head = job;
+        }
+        m_Tail = job;
+        if (!m_Scheduled) {
+            m_Scheduled = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        m_Scheduler.requeue(&m_Drain);
+    }
+}
+
+void Strand::drain(SchedulerJob* self)
+{
+    Strand* s = static_cast<DrainJob*>(self)->strand;
+    for (uint32_t i = 0; i < kBatch; ++i) {
+        SchedulerJob* job;
+        {
+            std::lock_guard<std::mutex> lock(s->m_Mutex);
+            job = s->m_Head;
+            if (!job) {
+                s->m_Scheduled = false;
+                return;
+            }
+            s->m_Head = job->next;
+            if (!s->m_Head) {
+                s->m_Tail = nullptr;
+            }
+        }
+        // The job may post itself on to another strand while it runs
+        job->next = nullptr;
+        job->run(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(s->m_Mutex);
+        if (!s->m_Head) {
+            s->m_Scheduled = false;
+            return;
+        }
+    }
+    // Still busy: requeue on this worker rather than loop, so what the batch
+    // posted sits below it where idle workers can steal it. Not behind the
+    // injection queue: finishing frames already in flight beats starting
+    // new ones. A full deque sends it there anyway.
+    s->m_Scheduler.requeue(&s->m_Drain);
+}
@@ -0,0 +1,200 @@
+/*
+ * Process-wide work-stealing scheduler for the native CPU stages
+ *
+ * Native CPU stages that each bring their own threads, next to
+ * DeepStream's GStreamer threads, oversubscribe the cores and pay a
+ * wake-up per hand-off. This gives them one pool of at most max-workers
+ * threads to share instead. Its users so far are the CPU detector
+ * (cpu_detector.h) and tools/bench_pipeline_scaling. The parser does not
+ * run on it yet, and the plugin starts no pool unless a caller asks for
+ * one:
+ *
+ *   - every worker owns a Chase-Lev deque: it pushes and pops jobs at the
+ *     bottom (LIFO, cache-warm), idle workers steal from the top
+ *   - jobs submitted from outside the pool (pad probes, the release loop
+ *     of a benchmark) go through one injection queue
+ *   - a worker with nothing to run or steal spins for spin-us and then
+ *     parks, so an idle pool costs no CPU
+ *   - Strand runs its jobs one at a time in submission order on whichever
+ *     worker is free, for state that must not be touched concurrently
+ *     (one tracker per source, the global associator, clip triggers)
+ *
+ * Jobs are intrusive (SchedulerJob embedded in the caller's struct), so
+ * submitting never allocates. A full deque runs the job inline instead,
+ * except for a strand's drain, which goes to the injection queue: running
+ * it inline could recurse through drain -> requeue -> drain.
+ *
+ * Placement: workers take their CPUs from `cpus`, else from the CPU list
+ * of numa-node, else from the process affinity mask; the first
+ * reserved-cores of that set are left to GStreamer. With pin=1 each worker
+ * is bound to one of the remaining CPUs, otherwise all of them share
+ * those. A worker allocates its deque after it is placed, so the memory
+ * is first-touched on its own node.
+ *
+ * Config (key file format, see configs/scheduler.txt):
+ *
+ *   [scheduler]
+ *   max-workers=0           # 0 = every CPU in the set minus reserved-cores
+ *   reserved-cores=2
+ *   cpus=                   # ';'-separated CPU ids, empty = see above
+ *   numa-node=-1            # -1 = any node
+ *   pin=1
+ *   deque-capacity=1024     # per worker, rounded up to a power of two
+ *   spin-us=50
+ */
+
+#ifndef __WORK_STEALING_SCHEDULER_H__
+#define __WORK_STEALING_SCHEDULER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SchedulerConfig
+{
+    uint32_t maxWorkers = 0;
+    uint32_t reservedCores = 2;
+    std::vector<int> cpus;
+    int numaNode = -1;
+    bool pin = true;
+    uint32_t dequeCapacity = 1024;
+    uint32_t spinUs = 50;
+
+    static bool load(const std::string& path, SchedulerConfig& config);
+};
+
+// Embed in the job's own struct; `run` receives the same pointer back
+struct SchedulerJob
+{
+    void (*run)(SchedulerJob* job) = nullptr;
+    SchedulerJob* next = nullptr;  // link while queued outside a deque
+};
+
+struct SchedulerStats
+{
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+    uint64_t injected = 0;  // submitted from outside the pool
+    uint64_t inlined = 0;   // ran in place of a push to a full deque
+    uint64_t parks = 0;
+};
+
+class WorkStealingScheduler
+{
+public:
+    explicit WorkStealingScheduler(const SchedulerConfig& config);
+    ~WorkStealingScheduler();
+
+    // The process-wide instance, started on first use with the config from
+    // configureShared() or the defaults
+    static WorkStealingScheduler& shared();
+    // False (and no effect) once shared() has been used
+    static bool configureShared(const SchedulerConfig& config);
+
+    // Any thread; from a worker the job goes to its own deque
+    void submit(SchedulerJob* job);
+
+    uint32_t workers() const { return (uint32_t)m_Workers.size(); }
+    // CPU of worker i, -1 when not pinned
+    int workerCpu(uint32_t i) const { return m_Workers[i]->cpu; }
+    // Index of the calling worker, -1 outside the pool
+    int currentWorker() const;
+    SchedulerStats stats() const;
+
+private:
+    // Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP'13), fixed size
+    class JobDeque
+    {
+    public:
+        explicit JobDeque(uint32_t capacity);
+        bool push(SchedulerJob* job);  // owner only; false when full
+        SchedulerJob* pop();           // owner only
+        SchedulerJob* steal();         // any thread
+        bool empty() const;
+
+    private:
+        std::unique_ptr<std::atomic<SchedulerJob*>[]> m_Slots;
+        int64_t m_Mask;
+        // Padding keeps thieves (top) and the owner (bottom) on separate
+        // cache lines; alignas would need C++17 aligned new
+        char m_Pad0[64];
+        std::atomic<int64_t> m_Top;
+        char m_Pad1[64];
+        std::atomic<int64_t> m_Bottom;
+    };
+
+    struct Worker
+    {
+        int cpu = -1;
+        std::vector<int> cpuSet;  // when not pinned
+        std::unique_ptr<JobDeque> deque;
+        std::thread thread;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> inlined{0};
+        std::atomic<uint64_t> parks{0};
+    };
+
+    void workerLoop(uint32_t index);
+    SchedulerJob* findWork(uint32_t index, uint64_t& rng);
+    void inject(SchedulerJob* job);
+    // submit(), but to the injection queue rather than inline when the
+    // worker's deque is full
+    void requeue(SchedulerJob* job);
+    SchedulerJob* takeInjected();
+    bool anyWork() const;
+    void wakeOne();
+
+    SchedulerConfig m_Config;
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::atomic<uint32_t> m_Ready{0};  // workers with a deque
+
+    std::mutex m_InjectMutex;
+    SchedulerJob* m_InjectHead = nullptr;
+    SchedulerJob* m_InjectTail = nullptr;
+    std::atomic<uint64_t> m_Injected{0};
+    std::atomic<uint64_t> m_InjectedTotal{0};
+
+    std::mutex m_ParkMutex;
+    std::condition_variable m_ParkCv;
+    std::atomic<uint32_t> m_Sleeping{0};
+    uint64_t m_WakeEpoch = 0;
+    std::atomic<bool> m_Stopping{false};
+
+    friend class Strand;
+};
+
+// Runs posted jobs one at a time, in post order, on the scheduler
+class Strand
+{
+public:
+    explicit Strand(WorkStealingScheduler& scheduler);
+
+    // Any thread; `job` must stay alive until it has run
+    void post(SchedulerJob* job);
+
+private:
+    static void drain(SchedulerJob* self);
+
+    // Jobs run per turn before the strand yields its worker
+    static const uint32_t kBatch = 32;
+
+    WorkStealingScheduler& m_Scheduler;
+    std::mutex m_Mutex;
+    SchedulerJob* m_Head = nullptr;
+    SchedulerJob* m_Tail = nullptr;
+    bool m_Scheduled = false;
+
+    struct DrainJob : SchedulerJob
+    {
+        Strand* strand;
+    };
+    DrainJob m_Drain;  // queued on the scheduler while jobs are pending
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Standalone YOLOv7 output decoding
+ */
+
+#include "yolov7_decode.h"
+#include "nvdsparsebbox_yolov7.h"
+#include "object_nms.h"
+#include "output_schema.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+extern "C" bool NvDsInferParseYolov7(std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+                                     NvDsInferNetworkInfo const& networkInfo,
+                                     NvDsInferParseDetectionParams const& detectionParams,
+                                     std::vector<NvDsInferParseObjectInfo>& objectList);
+
+static size_t elementSize(const NvDsInferDataType dataType)
+{
+    return dataType == FLOAT ? 4 : dataType == HALF ? 2 : 1;
+}
+
+// Per thread; vectors keep their capacity between calls
+struct DecodeScratch
+{
+    std::vector<NvDsInferLayerInfo> layers;
+    NvDsInferParseDetectionParams params;
+    std::vector<NvDsInferParseObjectInfo> parsed;
+    std::vector<NvDsInferParseObjectInfo> objects;
+};
+
+static thread_local DecodeScratch t_Decode;
+static std::once_flag g_InitOnce;
+
+extern "C" int Yolov7Decode(const void* output, int dataType, unsigned int batch, unsigned int dim0,
+                            unsigned int dim1, const Yolov7DecodeParams* params, unsigned int maxDetections,
+                            float* boxes, float* scores, int* classIds, int* counts)
+{
+    const bool outputs = maxDetections == 0 || (boxes && scores && classIds);
+    if (!output || !params || !counts || !outputs || dim0 == 0 || dim1 == 0 || params->numClasses == 0 ||
+        dataType < YOLOV7_DECODE_FLOAT32 || dataType > YOLOV7_DECODE_INT8) {
+        std::cerr << "ERROR: Invalid arguments to Yolov7Decode" << std::endl;
+        return -1;
+    }
+
+    // What the plugin's load hook does, on the first call
+    std::call_once(g_InitOnce, []() {
+        const char* env = getenv("YOLOV7_PARSER_WARMUP");
+        if (!env || strcmp(env, "0") != 0) {
+            NvDsInferParseYolov7Init(nullptr);
+        }
+    });
+
+    DecodeScratch& s = t_Decode;
+    if (s.layers.empty()) {
+        NvDsInferLayerInfo layer;
+        memset(&layer, 0, sizeof(layer));
+        layer.inferDims.numDims = 2;
+        s.layers.assign(1, layer);
+    }
+    NvDsInferLayerInfo& layer = s.layers[0];
+    layer.dataType = dataType == YOLOV7_DECODE_INT8 ? INT8 : dataType == YOLOV7_DECODE_FLOAT16 ? HALF : FLOAT;
+    layer.inferDims.d[0] = dim0;
+    layer.inferDims.d[1] = dim1;
+    layer.inferDims.numElements = dim0 * dim1;
+    // The one layer is the one the output schema names
+    const OutputSchema* schema = outputSchema();
+    layer.layerName = schema && !schema->layer.empty() ? schema->layer.c_str() : "output";
+
+    NvDsInferNetworkInfo networkInfo;
+    networkInfo.width = params->netWidth;
+    networkInfo.height = params->netHeight;
+    networkInfo.channels = 3;
+
+    s.params.numClassesConfigured = params->numClasses;
+    if (params->classThresholds) {
+        s.params.perClassPreclusterThreshold.assign(params->classThresholds,
+                                                    params->classThresholds + params->numClasses);
+    } else {
+        s.params.perClassPreclusterThreshold.assign(params->numClasses, params->confidenceThreshold);
+    }
+    s.params.perClassPostclusterThreshold = s.params.perClassPreclusterThreshold;
+
+    const unsigned int topK = std::min(params->topK ? params->topK : maxDetections, maxDetections);
+    const size_t tensorBytes = (size_t)dim0 * dim1 * elementSize(layer.dataType);
+    int total = 0;
+    for (unsigned int b = 0; b < batch; ++b) {
+        layer.buffer = const_cast<char*>((const char*)output + b * tensorBytes);
+        if (!NvDsInferParseYolov7(s.layers, networkInfo, s.params, s.parsed)) {
+            return -1;
+        }
+        nmsPerClass(s.parsed, params->nmsIou, topK, s.objects);
+
+        const size_t first = (size_t)b * maxDetections;
+        for (size_t i = 0; i < s.objects.size(); ++i) {
+            const NvDsInferParseObjectInfo& o = s.objects[i];
+            float* box = boxes + (first + i) * 4;
+            box[0] = o.left;
+            box[1] = o.top;
+            box[2] = o.left + o.width;
+            box[3] = o.top + o.height;
+            scores[first + i] = o.detectionConfidence;
+            classIds[first + i] = (int)o.classId;
+        }
+        counts[b] = (int)s.objects.size();
+        total += counts[b];
+    }
+    return total;
+}
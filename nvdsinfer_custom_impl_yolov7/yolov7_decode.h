@@ -0,0 +1,70 @@
+/*
+ * Standalone YOLOv7 output decoding
+ *
+ * Offline analytics and test tools can use the parser's decoders without
+ * DeepStream through this C API. It takes a raw output buffer, its shape,
+ * element type and thresholds, and writes clustered detections into flat
+ * arrays owned by the caller. The decode path is NvDsInferParseYolov7
+ * itself: the same layout detection, output schema (YOLOV7_OUTPUT_SCHEMA,
+ * see output_schema.h), per-CPU SIMD kernels, runtime settings
+ * (YOLOV7_PARSER_CONFIG) and warm-up, which runs on the first call rather
+ * than when the library is loaded. NMS is object_nms.h, the
+ * same as the CPU detector and the Triton server step.
+ *
+ * Build with `make decode-lib`. It needs no DeepStream, CUDA or GStreamer
+ * header or library, and links nothing beyond libstdc++. The parser is
+ * compiled against standalone_infer_types.h. The Python binding in
+ * src/detection/yolov7_decode.py passes NumPy arrays without copying them.
+ *
+ * Nothing is written to stdout; errors, and with YOLOV7_PARSER_DEBUG=1 the
+ * layout, schema and settings messages, go to stderr.
+ *
+ * Calls are reentrant: every thread keeps its own scratch. For offline
+ * reprocessing of many captured tensors, decode a batch per call and run
+ * one caller per core.
+ */
+
+#ifndef __YOLOV7_DECODE_H__
+#define __YOLOV7_DECODE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    YOLOV7_DECODE_FLOAT32 = 0,
+    YOLOV7_DECODE_FLOAT16 = 1,  // IEEE half, as uint16 bits
+    YOLOV7_DECODE_INT8 = 2,     // needs an output schema with scale and zero-point
+} Yolov7DecodeDataType;
+
+typedef struct
+{
+    unsigned int netWidth;           // network input the boxes are in
+    unsigned int netHeight;
+    unsigned int numClasses;
+    float confidenceThreshold;       // for every class unless classThresholds is set
+    const float* classThresholds;    // numClasses values, or NULL
+    float nmsIou;                    // per-class NMS IoU, 1 keeps every box
+    unsigned int topK;               // boxes kept per tensor, 0 = maxDetections
+} Yolov7DecodeParams;
+
+// Decodes `batch` tensors stored back to back, each dim0 x dim1 elements
+// of `dataType`. The shape is the one the engine reports: [rows, 6 | 85],
+// or what the output schema describes. For tensor b, writes up to
+// maxDetections detections, highest confidence first, at offset
+// b * maxDetections:
+//   boxes     4 floats each, x1, y1, x2, y2 in network pixels
+//   scores    1 float each
+//   classIds  1 int each
+// counts[b] receives how many were written. Returns the total over the
+// batch, or -1 when the arguments or a tensor's shape are rejected.
+int Yolov7Decode(const void* output, int dataType, unsigned int batch, unsigned int dim0, unsigned int dim1,
+                 const Yolov7DecodeParams* params, unsigned int maxDetections, float* boxes, float* scores,
+                 int* classIds, int* counts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
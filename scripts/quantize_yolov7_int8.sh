@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# INT8 dynamic quantization of a YOLOv7(-tiny) ONNX export for the CPU
+# detector (nvdsinfer_custom_impl_yolov7/cpu_detector.h)
+#
+# Weights of Conv/MatMul become UINT8 (ConvInteger/MatMulInteger, which the
+# ONNX Runtime CPU execution provider implements for uint8 weights);
+# activations are quantized per batch at run time, so no calibration set is
+# needed. The last convolutions (the Detect head, whose outputs are decoded
+# into boxes) stay FP32 so box coordinates keep their precision.
+#
+# Needs: pip install onnx onnxruntime
+#
+# Usage: scripts/quantize_yolov7_int8.sh <fp32.onnx> [int8.onnx] [fp32-head-convs]
+
+set -e
+
+INPUT="$1"
+OUTPUT="${2:-models/yolov7_tiny_int8/1/model.onnx}"
+HEAD_CONVS="${3:-3}"
+
+if [ -z "$INPUT" ] || [ ! -f "$INPUT" ]; then
+    echo "Usage: $0 <fp32.onnx> [int8.onnx] [fp32-head-convs]"
+    exit 1
+fi
+
+mkdir -p "$(dirname "$OUTPUT")"
+
+python3 - "$INPUT" "$OUTPUT" "$HEAD_CONVS" <<'PYEOF'
+import sys
+
+import onnx
+from onnxruntime.quantization import QuantType, quantize_dynamic
+
+src, dst, head = sys.argv[1], sys.argv[2], int(sys.argv[3])
+
+# Nodes are stored in topological order, so the head convolutions are the
+# last ones
+convs = [n.name for n in onnx.load(src).graph.node if n.op_type == "Conv"]
+unnamed = [i for i, name in enumerate(convs) if not name]
+if unnamed:
+    sys.exit("Conv nodes without names cannot be excluded; re-export with names")
+keep = convs[-head:] if head > 0 else []
+
+# No quant_pre_process(): its graph optimisation may rename the head nodes
+quantize_dynamic(src, dst, weight_type=QuantType.QUInt8, op_types_to_quantize=["Conv", "MatMul"],
+                 nodes_to_exclude=keep)
+print(f"{len(convs) - len(keep)} of {len(convs)} Conv nodes quantized, FP32 head: {', '.join(keep) or 'none'}")
+PYEOF
+
+echo "INT8 model: $OUTPUT ($(ls -lh "$OUTPUT" | awk '{print $5}'))"
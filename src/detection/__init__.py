@@ -0,0 +1,18 @@
+"""
+Detection Output Decoding
+=========================
+
+NumPy access to the DeepStream YOLOv7 parser outside DeepStream, for
+offline analytics and test tools.
+
+Components:
+-----------
+- Yolov7Decoder: decodes raw detector output tensors with libyolov7_decode.so
+"""
+
+from .yolov7_decode import DecodeResult, Yolov7Decoder
+
+__all__ = [
+    "DecodeResult",
+    "Yolov7Decoder",
+]
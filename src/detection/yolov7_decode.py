@@ -0,0 +1,140 @@
+"""
+YOLOv7 Output Decoding
+======================
+
+ctypes binding of libyolov7_decode.so (nvdsinfer_custom_impl_yolov7/
+yolov7_decode.h). It gives the DeepStream parser's decoders and per-class
+NMS with no DeepStream install. Build the library with
+
+    cd nvdsinfer_custom_impl_yolov7 && make decode-lib
+
+Arrays go to the library as pointers, so nothing is copied in either
+direction. The input must already be C-contiguous float32, float16 or
+int8. Results are written straight into the output arrays, which can be
+passed back in to reuse them across calls. ctypes releases the GIL for the
+call, so a thread pool of decoders scales across cores when reprocessing
+many captured tensors.
+"""
+
+import ctypes
+import os
+from collections import namedtuple
+from pathlib import Path
+
+import numpy as np
+
+DEFAULT_LIBRARY = Path(__file__).resolve().parent.parent.parent / "nvdsinfer_custom_impl_yolov7" / "libyolov7_decode.so"
+
+# Yolov7DecodeDataType
+_DATA_TYPES = {
+    np.dtype(np.float32): 0,
+    np.dtype(np.float16): 1,
+    np.dtype(np.int8): 2,
+}
+
+# boxes [batch, max, 4] x1,y1,x2,y2; scores [batch, max]; class_ids
+# [batch, max]; counts [batch], valid rows per tensor
+DecodeResult = namedtuple("DecodeResult", ["boxes", "scores", "class_ids", "counts"])
+
+
+class DecodeParams(ctypes.Structure):
+    """Mirrors Yolov7DecodeParams in yolov7_decode.h."""
+
+    _fields_ = [
+        ("netWidth", ctypes.c_uint),
+        ("netHeight", ctypes.c_uint),
+        ("numClasses", ctypes.c_uint),
+        ("confidenceThreshold", ctypes.c_float),
+        ("classThresholds", ctypes.POINTER(ctypes.c_float)),
+        ("nmsIou", ctypes.c_float),
+        ("topK", ctypes.c_uint),
+    ]
+
+
+def _check_out(out, batch, max_detections):
+    """The native decoder writes `batch` rows of every array; refuses any it would overrun."""
+    arrays = (("boxes", out.boxes, np.float32), ("scores", out.scores, np.float32),
+              ("class_ids", out.class_ids, np.int32), ("counts", out.counts, np.int32))
+    for name, array, dtype in arrays:
+        if not isinstance(array, np.ndarray) or array.dtype != dtype:
+            raise TypeError("out.%s must be a %s array" % (name, np.dtype(dtype).name))
+        if not array.flags["C_CONTIGUOUS"] or not array.flags["WRITEABLE"]:
+            raise ValueError("out.%s must be writeable and C-contiguous (see Yolov7Decoder.allocate)" % name)
+    rows = out.counts.shape[0] if out.counts.ndim == 1 else 0
+    shapes = ((out.boxes, (rows, max_detections, 4)), (out.scores, (rows, max_detections)),
+              (out.class_ids, (rows, max_detections)))
+    if rows < batch or any(array.shape != shape for array, shape in shapes):
+        raise ValueError("out does not hold %d x %d detections (see Yolov7Decoder.allocate)" %
+                         (batch, max_detections))
+
+
+class Yolov7Decoder:
+    """Decodes raw YOLOv7 output tensors the way the DeepStream parser does.
+
+    schema: an output schema file (configs/yolov7_output_schema.txt) for
+    layouts other than [N,6] and [N,85], and for INT8 outputs. The library
+    reads it from YOLOV7_OUTPUT_SCHEMA when it is loaded, so one schema
+    applies per process.
+    """
+
+    def __init__(self, library=None, schema=None):
+        if schema is not None:
+            os.environ["YOLOV7_OUTPUT_SCHEMA"] = str(schema)
+        self.lib = ctypes.CDLL(str(library or DEFAULT_LIBRARY))
+        float_p = ctypes.POINTER(ctypes.c_float)
+        int_p = ctypes.POINTER(ctypes.c_int)
+        self.lib.Yolov7Decode.argtypes = [
+            ctypes.c_void_p, ctypes.c_int, ctypes.c_uint, ctypes.c_uint, ctypes.c_uint,
+            ctypes.POINTER(DecodeParams), ctypes.c_uint, float_p, float_p, int_p, int_p]
+        self.lib.Yolov7Decode.restype = ctypes.c_int
+
+    @staticmethod
+    def allocate(batch, max_detections):
+        """Output arrays for decode(out=...)."""
+        return DecodeResult(
+            np.empty((batch, max_detections, 4), dtype=np.float32),
+            np.empty((batch, max_detections), dtype=np.float32),
+            np.empty((batch, max_detections), dtype=np.int32),
+            np.empty((batch,), dtype=np.int32))
+
+    def decode(self, output, net_size=(640, 640), num_classes=80, confidence_threshold=0.25,
+               class_thresholds=None, nms_iou=0.45, top_k=0, max_detections=300, out=None):
+        """Decodes [dim0, dim1] or [batch, dim0, dim1] detector output.
+
+        net_size is (width, height) of the network input the boxes are in.
+        nms_iou=1 keeps every box above threshold, top_k=0 keeps up to
+        max_detections per tensor. Returns a DecodeResult whose rows past
+        counts[b] are undefined.
+        """
+        if output.dtype not in _DATA_TYPES:
+            raise TypeError("output must be float32, float16 or int8, got %s" % output.dtype)
+        if not output.flags["C_CONTIGUOUS"]:
+            raise ValueError("output must be C-contiguous (np.ascontiguousarray)")
+        if output.ndim not in (2, 3):
+            raise ValueError("output must be [dim0, dim1] or [batch, dim0, dim1], got %s" % (output.shape,))
+        batch = output.shape[0] if output.ndim == 3 else 1
+        dim0, dim1 = output.shape[-2:]
+
+        if out is None:
+            out = self.allocate(batch, max_detections)
+        else:
+            _check_out(out, batch, max_detections)
+
+        params = DecodeParams(net_size[0], net_size[1], num_classes, confidence_threshold, None, nms_iou, top_k)
+        if class_thresholds is not None:
+            thresholds = np.ascontiguousarray(class_thresholds, dtype=np.float32)
+            if thresholds.shape != (num_classes,):
+                raise ValueError("class_thresholds needs %d values" % num_classes)
+            params.classThresholds = thresholds.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+
+        n = self.lib.Yolov7Decode(
+            output.ctypes.data, _DATA_TYPES[output.dtype], batch, dim0, dim1, ctypes.byref(params), max_detections,
+            out.boxes.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+            out.scores.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+            out.class_ids.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),
+            out.counts.ctypes.data_as(ctypes.POINTER(ctypes.c_int)))
+        if n < 0:
+            raise RuntimeError("parser rejected a %s %s output" % (output.dtype, (dim0, dim1)))
+        if out.boxes.shape[0] != batch:
+            out = DecodeResult(out.boxes[:batch], out.scores[:batch], out.class_ids[:batch], out.counts[:batch])
+        return out
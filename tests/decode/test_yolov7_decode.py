@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+"""
+Standalone YOLOv7 Decode Test
+=============================
+
+Decodes random [N,85] float32, [N,6] float16 and channel-major [84,N] int8
+outputs through src/detection (libyolov7_decode.so) and compares them with
+a NumPy reference decode and greedy per-class NMS. It also checks that a
+batch decodes like its tensors one by one, that output arrays passed back
+in are filled in place, that inputs needing a copy and output arrays too
+small or of the wrong type are refused, and that a per-class threshold
+override leaves classes past num_classes dropped. Build the library first:
+
+    cd nvdsinfer_custom_impl_yolov7 && make decode-lib
+
+The INT8 and override checks run in child processes because the output
+schema and parser config they need are read once per process.
+"""
+
+import argparse
+import json
+import logging
+import os
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+import numpy as np
+
+PROJECT_ROOT = Path(__file__).parent.parent.parent
+sys.path.insert(0, str(PROJECT_ROOT / "src"))
+
+from detection import Yolov7Decoder  # noqa: E402
+
+logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
+logger = logging.getLogger(__name__)
+
+NET_SIZE = 640
+ROWS = 25200
+CONFIDENCE = 0.3
+NMS_IOU = 0.45
+MAX_DETECTIONS = 300
+OBJECTNESS_THRESHOLD = 0.1  # parser_config.h defaults
+MIN_BOX_SIZE = 1.0
+
+
+def random_raw(rng, rows, classes=80):
+    """[rows, 5 + classes] cx,cy,w,h,objectness,scores with sparse confident rows."""
+    out = np.zeros((rows, 5 + classes), dtype=np.float32)
+    out[:, 0:2] = rng.uniform(0, NET_SIZE, (rows, 2))
+    out[:, 2:4] = rng.uniform(2, 160, (rows, 2))
+    hot = rng.random(rows) < 0.02
+    out[hot, 4] = rng.uniform(0.05, 1.0, hot.sum())
+    out[hot, 5 + rng.integers(0, classes, hot.sum())] = rng.uniform(0.1, 1.0, hot.sum())
+    return out
+
+
+def random_processed(rng, rows, classes=80):
+    """[rows, 6] x1,y1,x2,y2,confidence,class."""
+    out = np.zeros((rows, 6), dtype=np.float32)
+    xy = rng.uniform(0, NET_SIZE - 40, (rows, 2))
+    out[:, 0:2] = xy
+    out[:, 2:4] = xy + rng.uniform(4, 200, (rows, 2))
+    hot = rng.random(rows) < 0.02
+    out[hot, 4] = rng.uniform(0.1, 1.0, hot.sum())
+    out[:, 5] = rng.integers(0, classes, rows)
+    return out
+
+
+def reference_decode(boxes, confidence, class_ids):
+    """Thresholds, xyxy clamping and the minimum box size, as the parser applies them."""
+    keep = confidence >= CONFIDENCE
+    boxes = np.clip(boxes[keep], 0, NET_SIZE)
+    confidence, class_ids = confidence[keep], class_ids[keep]
+    wide = (boxes[:, 2] - boxes[:, 0] >= MIN_BOX_SIZE) & (boxes[:, 3] - boxes[:, 1] >= MIN_BOX_SIZE)
+    return boxes[wide], confidence[wide], class_ids[wide]
+
+
+def reference_nms(boxes, confidence, class_ids):
+    order = np.argsort(-confidence, kind="stable")
+    kept = []
+    for i in order:
+        if len(kept) >= MAX_DETECTIONS:
+            break
+        if all(class_ids[k] != class_ids[i] or iou(boxes[k], boxes[i]) <= NMS_IOU for k in kept):
+            kept.append(i)
+    return boxes[kept], confidence[kept], class_ids[kept]
+
+
+def iou(a, b):
+    x1, y1 = max(a[0], b[0]), max(a[1], b[1])
+    x2, y2 = min(a[2], b[2]), min(a[3], b[3])
+    inter = max(0.0, x2 - x1) * max(0.0, y2 - y1)
+    union = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter
+    return inter / union if union > 0 else 0.0
+
+
+def reference_raw(raw):
+    """[rows, 85] float -> (boxes, confidence, class) before NMS."""
+    objectness = raw[:, 4]
+    scores = raw[:, 5:]
+    class_ids = scores.argmax(axis=1)
+    best = np.maximum(scores.max(axis=1), 0.0)
+    class_ids[best <= 0] = 0
+    confidence = np.where(objectness >= OBJECTNESS_THRESHOLD, objectness * best, -1.0).astype(np.float32)
+    half = raw[:, 2:4] * 0.5
+    boxes = np.concatenate([raw[:, 0:2] - half, raw[:, 0:2] + half], axis=1)
+    return reference_decode(boxes, confidence, class_ids)
+
+
+def canonical(boxes, confidence, class_ids):
+    """Rows in one order whatever the sort did with equal confidences."""
+    order = np.lexsort((boxes[:, 1], boxes[:, 0], class_ids, -confidence))
+    return boxes[order], confidence[order], class_ids[order]
+
+
+def matches(result, b, expected):
+    boxes, confidence, class_ids = canonical(*reference_nms(*expected))
+    n = result.counts[b]
+    got_boxes, got_confidence, got_ids = canonical(result.boxes[b, :n], result.scores[b, :n], result.class_ids[b, :n])
+    return bool(n == len(boxes) and np.allclose(got_boxes, boxes, atol=1e-3) and
+                np.allclose(got_confidence, confidence, atol=1e-5) and (got_ids == class_ids).all())
+
+
+def decode(decoder, output, out=None):
+    return decoder.decode(output, net_size=(NET_SIZE, NET_SIZE), confidence_threshold=CONFIDENCE, nms_iou=NMS_IOU,
+                          max_detections=MAX_DETECTIONS, out=out)
+
+
+def int8_child(library):
+    """Channel-major [84, N] int8 with per-column scales; runs with the schema set."""
+    rng = np.random.default_rng(3)
+    rows = 8400
+    raw = random_raw(rng, rows)
+    logical = np.concatenate([raw[:, :4], raw[:, 5:]], axis=1)  # no objectness
+    scale = np.array([NET_SIZE / 127.0] * 4 + [1.0 / 255.0] * 80, dtype=np.float32)
+    zero_point = np.array([0] * 4 + [-128] * 80, dtype=np.int32)
+    q = np.clip(np.rint(logical / scale + zero_point), -128, 127).astype(np.int8)
+    tensor = np.ascontiguousarray(q.T)
+    dequantized = (q.astype(np.int32) - zero_point).astype(np.float32) * scale
+
+    scores = dequantized[:, 4:]
+    class_ids = scores.argmax(axis=1)
+    best = np.maximum(scores.max(axis=1), 0.0)
+    class_ids[best <= 0] = 0
+    half = dequantized[:, 2:4] * 0.5
+    boxes = np.concatenate([dequantized[:, 0:2] - half, dequantized[:, 0:2] + half], axis=1)
+
+    result = decode(Yolov7Decoder(library), tensor)
+    return {"int8": matches(result, 0, reference_decode(boxes, best, class_ids)), "count": int(result.counts[0])}
+
+
+def override_child(library):
+    """[N,6] with class ids up to 79 decoded as 10 classes, class 0 overridden to 0.5."""
+    rng = np.random.default_rng(5)
+    classes = 10
+    processed = random_processed(rng, ROWS)
+    result = Yolov7Decoder(library).decode(processed, net_size=(NET_SIZE, NET_SIZE), num_classes=classes,
+                                           confidence_threshold=CONFIDENCE, nms_iou=1.0,
+                                           max_detections=ROWS)
+    confidence, class_ids = processed[:, 4], processed[:, 5].astype(np.int64)
+    threshold = np.where(class_ids == 0, 0.5, CONFIDENCE)
+    known = (class_ids < classes) & (confidence >= threshold)
+    boxes, confidence, class_ids = reference_decode(processed[known, :4], confidence[known], class_ids[known])
+    n = int(result.counts[0])
+    return {"override": matches(result, 0, (boxes, confidence, class_ids)) and
+            bool((result.class_ids[0, :n] < classes).all()), "count": n}
+
+
+def write_parser_config(path):
+    path.write_text("[parser]\nconfidence-threshold=-1\n\n[class-thresholds]\n0=0.5\n")
+
+
+def run_child(library, flag, env):
+    child = subprocess.run([sys.executable, __file__, "--library", library, flag],
+                           env=dict(os.environ, **env), capture_output=True, text=True)
+    lines = [l for l in child.stdout.splitlines() if l.startswith("{")]
+    if child.returncode != 0 or not lines:
+        logger.error(child.stderr)
+        return None
+    return json.loads(lines[-1])
+
+
+def write_int8_schema(path):
+    path.write_text("\n".join([
+        "[output-schema]",
+        "order=channel-major",
+        "columns=84",
+        "box-encoding=cxcywh",
+        "class-scores=4",
+        "num-classes=80",
+        "dtype=int8",
+        "scale=" + ";".join([str(NET_SIZE / 127.0)] * 4 + [str(1.0 / 255.0)] * 80),
+        "zero-point=" + ";".join(["0"] * 4 + ["-128"] * 80),
+        "",
+    ]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--library", default=str(PROJECT_ROOT / "nvdsinfer_custom_impl_yolov7" /
+                                                  "libyolov7_decode.so"))
+    parser.add_argument("--batch", type=int, default=8)
+    parser.add_argument("--int8-child", action="store_true", help=argparse.SUPPRESS)
+    parser.add_argument("--override-child", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.int8_child:
+        print(json.dumps(int8_child(args.library)))
+        return 0
+    if args.override_child:
+        print(json.dumps(override_child(args.library)))
+        return 0
+
+    decoder = Yolov7Decoder(args.library)
+    rng = np.random.default_rng(7)
+    results = {}
+
+    raw = random_raw(rng, ROWS)
+    results["raw85_float32"] = matches(decode(decoder, raw), 0, reference_raw(raw))
+
+    processed = random_processed(rng, ROWS).astype(np.float16)
+    widened = processed.astype(np.float32)
+    expected = reference_decode(widened[:, :4], widened[:, 4], widened[:, 5].astype(np.int64))
+    results["processed6_float16"] = matches(decode(decoder, processed), 0, expected)
+
+    batch = np.stack([random_processed(rng, ROWS) for _ in range(args.batch)])
+    out = Yolov7Decoder.allocate(args.batch, MAX_DETECTIONS)
+    batched = decode(decoder, batch, out=out)
+    same = batched.boxes is out.boxes and batched.counts is out.counts
+    for b in range(args.batch):
+        single = decode(decoder, batch[b])
+        n = single.counts[0]
+        same &= bool(batched.counts[b] == n and (batched.boxes[b, :n] == single.boxes[0, :n]).all() and
+                     (batched.class_ids[b, :n] == single.class_ids[0, :n]).all())
+    results["batch_in_place"] = same
+
+    try:
+        decode(decoder, batch[:, :, ::2])
+        results["refuses_copies"] = False
+    except ValueError:
+        results["refuses_copies"] = True
+
+    # Each output array the native decoder would overrun is refused
+    bad_outs = [out._replace(scores=out.scores[:, :10]), out._replace(class_ids=out.class_ids.astype(np.int64)),
+                out._replace(counts=out.counts[:1]), out._replace(boxes=np.asfortranarray(out.boxes))]
+    refused = 0
+    for bad in bad_outs:
+        try:
+            decode(decoder, batch, out=bad)
+        except (TypeError, ValueError):
+            refused += 1
+    results["refuses_bad_out"] = refused == len(bad_outs)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        schema = Path(tmp) / "int8_schema.txt"
+        write_int8_schema(schema)
+        int8 = run_child(args.library, "--int8-child", {"YOLOV7_OUTPUT_SCHEMA": str(schema)}) or \
+            {"int8": False, "count": -1}
+        config = Path(tmp) / "parser.txt"
+        write_parser_config(config)
+        override = run_child(args.library, "--override-child", {"YOLOV7_PARSER_CONFIG": str(config)}) or \
+            {"override": False, "count": -1}
+    results["int8_channel_major"] = int8["int8"]
+    results["override_known_classes"] = override["override"]
+
+    iterations = 20
+    start = time.perf_counter()
+    for _ in range(iterations):
+        decode(decoder, batch, out=out)
+    rate = iterations * args.batch / (time.perf_counter() - start)
+
+    logger.info(f"raw85 {decode(decoder, raw).counts[0]}, int8 {int8['count']}, "
+                f"override {override['count']} boxes; "
+                f"[{ROWS},6] batch of {args.batch}: {rate:.0f} tensors/s on one thread")
+    for name, passed in results.items():
+        (logger.info if passed else logger.error)(f"{'✅' if passed else '❌'} {name}")
+    return 0 if all(results.values()) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""
+Detect -> ReID Server Step Test (CPU stand-in)
+==============================================
+
+Runs models/detect_reid/1/model.py outside Triton against CPU stand-ins:
+a fake triton_python_backend_utils routes the BLS sub-requests to a
+synthetic detector (planted boxes, duplicates and a non-person box) and a
+deterministic NumPy embedder, or to ONNX exports of the real models on
+ONNX Runtime's CPU provider with --detector-onnx / --reid-onnx. The server
+step library must be built first:
+
+    cd nvdsinfer_custom_impl_yolov7 && make server-step CUDA_VER=12.6
+
+Checks that the parser and NMS keep exactly the planted boxes, that every
+person box gets the embedding of its own crop (cut by an independent NumPy
+reference), that other classes get zeros and that ReID is called in
+batches no larger than reid_max_batch across the request's images.
+"""
+
+import argparse
+import importlib.util
+import json
+import logging
+import re
+import sys
+import time
+import types
+from pathlib import Path
+
+import numpy as np
+
+logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
+logger = logging.getLogger(__name__)
+
+PROJECT_ROOT = Path(__file__).parent.parent.parent
+MODEL_DIR = PROJECT_ROOT / "models" / "detect_reid"
+NET_SIZE = 640
+ROWS = 25200
+
+
+def make_pb_utils(models, calls):
+    """Minimal triton_python_backend_utils whose exec() runs `models` locally."""
+    pb = types.ModuleType("triton_python_backend_utils")
+
+    class TritonError:
+        def __init__(self, msg):
+            self.msg = msg
+
+        def message(self):
+            return self.msg
+
+    class TritonModelException(Exception):
+        pass
+
+    class Tensor:
+        def __init__(self, name, array):
+            self.name = name
+            self.array = np.asarray(array)
+
+        def as_numpy(self):
+            return self.array
+
+    class InferenceResponse:
+        def __init__(self, output_tensors, error=None):
+            self.output_tensors = output_tensors
+            self.err = error
+
+        def has_error(self):
+            return self.err is not None
+
+        def error(self):
+            return self.err
+
+    class InferenceRequest:
+        def __init__(self, model_name, requested_output_names, inputs):
+            self.model_name = model_name
+            self.inputs = inputs
+
+        def exec(self):
+            batch = self.inputs[0].as_numpy()
+            calls.append((self.model_name, batch.shape[0]))
+            return InferenceResponse([Tensor("output", models[self.model_name](batch))])
+
+    def get_tensor(holder, name):
+        tensors = holder.inputs if hasattr(holder, "inputs") else holder.output_tensors
+        return next((t for t in tensors if t.name == name), None)
+
+    def get_output_config_by_name(config, name):
+        return next((o for o in config["output"] if o["name"] == name), None)
+
+    pb.TritonError = TritonError
+    pb.TritonModelException = TritonModelException
+    pb.Tensor = Tensor
+    pb.InferenceResponse = InferenceResponse
+    pb.InferenceRequest = InferenceRequest
+    pb.get_input_tensor_by_name = get_tensor
+    pb.get_output_tensor_by_name = get_tensor
+    pb.get_output_config_by_name = get_output_config_by_name
+    return pb
+
+
+def load_model_config():
+    """The parts of config.pbtxt model.py reads, as Triton's JSON."""
+    text = (MODEL_DIR / "config.pbtxt").read_text()
+    params = dict(re.findall(r'key:\s*"(\w+)"\s*value:\s*\{\s*string_value:\s*"([^"]*)"', text))
+    dims = re.search(r'name:\s*"embeddings".*?dims:\s*\[([^\]]*)\]', text, re.S).group(1)
+    return {
+        "parameters": {k: {"string_value": v} for k, v in params.items()},
+        "output": [{"name": "embeddings", "dims": [int(d) for d in dims.split(",")]}],
+    }
+
+
+class SyntheticDetector:
+    """[N, 25200, 6] outputs with planted boxes; the rest stays below threshold."""
+
+    def __init__(self, seed):
+        self.rng = np.random.default_rng(seed)
+        self.planted = {}
+
+    def plant(self, image_index, count):
+        # One box per grid cell so planted boxes never suppress each other
+        cols = int(np.ceil(np.sqrt(count)))
+        cell = NET_SIZE / cols
+        boxes = []
+        for k in range(count):
+            w, h = self.rng.uniform(0.4, 0.9, size=2) * cell
+            x1 = (k % cols) * cell + self.rng.uniform(0, cell - w)
+            y1 = (k // cols) * cell + self.rng.uniform(0, cell - h)
+            cls = 2 if k == count - 1 else 0  # last one is a car
+            boxes.append([x1, y1, x1 + w, y1 + h, 0.9 - 0.5 * k / count, cls])
+        self.planted[image_index] = np.array(boxes, dtype=np.float32)
+
+    def __call__(self, images):
+        out = np.zeros((images.shape[0], ROWS, 6), dtype=np.float32)
+        out[:, :, 4] = self.rng.uniform(0.0, 0.2, size=(images.shape[0], ROWS))
+        for i in range(images.shape[0]):
+            rows = self.rng.choice(ROWS, size=2 * len(self.planted[i]), replace=False)
+            for k, box in enumerate(self.planted[i]):
+                out[i, rows[2 * k]] = box
+                # Shifted duplicate with lower confidence, NMS must drop it
+                dup = box.copy()
+                dup[:4] += 3.0
+                dup[4] -= 0.02
+                out[i, rows[2 * k + 1]] = dup
+        return out
+
+
+class SyntheticEmbedder:
+    """Channel means over a 4x4 grid projected to 512-D and L2-normalised."""
+
+    def __init__(self, seed, size=512):
+        self.projection = np.random.default_rng(seed).standard_normal((48, size)).astype(np.float32)
+
+    def __call__(self, crops):
+        n, c, h, w = crops.shape
+        pooled = crops.reshape(n, c, 4, h // 4, 4, w // 4).mean(axis=(3, 5)).reshape(n, -1)
+        emb = pooled @ self.projection
+        return (emb / np.maximum(np.linalg.norm(emb, axis=1, keepdims=True), 1e-12)).astype(np.float32)
+
+
+class OnnxModel:
+    def __init__(self, path):
+        import onnxruntime as ort
+        self.session = ort.InferenceSession(str(path), providers=["CPUExecutionProvider"])
+        self.input = self.session.get_inputs()[0].name
+
+    def __call__(self, batch):
+        return self.session.run(None, {self.input: batch.astype(np.float32)})[0]
+
+
+def reference_crop(image, box, height, width, mean, std):
+    """NumPy version of Yolov7ServerStepCrop for one box."""
+    _, img_h, img_w = image.shape
+    left, top = max(0.0, box[0]), max(0.0, box[1])
+    right, bottom = min(float(img_w), box[2]), min(float(img_h), box[3])
+    fx = np.maximum(left, left + (np.arange(width) + 0.5) * (right - left) / width - 0.5)
+    fy = np.maximum(top, top + (np.arange(height) + 0.5) * (bottom - top) / height - 0.5)
+    max_x, max_y = int(np.ceil(right)) - 1, int(np.ceil(bottom)) - 1
+    x0 = np.minimum(fx.astype(np.int32), max_x)
+    y0 = np.minimum(fy.astype(np.int32), max_y)
+    x1, y1 = np.minimum(x0 + 1, max_x), np.minimum(y0 + 1, max_y)
+    wx, wy = (fx - x0)[None, None, :], (fy - y0)[None, :, None]
+    a = image[:, y0][:, :, x0] + wx * (image[:, y0][:, :, x1] - image[:, y0][:, :, x0])
+    b = image[:, y1][:, :, x0] + wx * (image[:, y1][:, :, x1] - image[:, y1][:, :, x0])
+    return ((a + wy * (b - a) - mean[:, None, None]) / std[:, None, None]).astype(np.float32)
+
+
+def iou(a, b):
+    w = max(0.0, min(a[2], b[2]) - max(a[0], b[0]))
+    h = max(0.0, min(a[3], b[3]) - max(a[1], b[1]))
+    inter = w * h
+    return inter / ((a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--library", default=str(PROJECT_ROOT / "nvdsinfer_custom_impl_yolov7" /
+                                                  "libyolov7_server_step.so"))
+    parser.add_argument("--detector-onnx", help="run this ONNX detector instead of the synthetic one")
+    parser.add_argument("--reid-onnx", help="run this ONNX ReID model instead of the synthetic one")
+    parser.add_argument("--batch", type=int, default=2)
+    parser.add_argument("--people", type=int, default=12, help="planted boxes per image, the last is a car")
+    parser.add_argument("--iterations", type=int, default=5)
+    args = parser.parse_args()
+
+    if not Path(args.library).exists():
+        logger.error(f"❌ {args.library} not found, build it with `make server-step`")
+        return 1
+
+    config = load_model_config()
+    config["parameters"]["server_step_library"] = {"string_value": args.library}
+    reid_max_batch = int(config["parameters"]["reid_max_batch"]["string_value"])
+    height, width = [int(v) for v in config["parameters"]["reid_input_size"]["string_value"].split(";")]
+    mean = np.array([float(v) for v in config["parameters"]["reid_mean"]["string_value"].split(";")], np.float32)
+    std = np.array([float(v) for v in config["parameters"]["reid_std"]["string_value"].split(";")], np.float32)
+
+    detector = OnnxModel(args.detector_onnx) if args.detector_onnx else SyntheticDetector(7)
+    embedder = OnnxModel(args.reid_onnx) if args.reid_onnx else SyntheticEmbedder(11)
+    calls = []
+    models = {
+        config["parameters"]["detector_model"]["string_value"]: detector,
+        config["parameters"]["reid_model"]["string_value"]: embedder,
+    }
+    sys.modules["triton_python_backend_utils"] = make_pb_utils(models, calls)
+    pb_utils = sys.modules["triton_python_backend_utils"]
+
+    spec = importlib.util.spec_from_file_location("detect_reid_model", MODEL_DIR / "1" / "model.py")
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    model = module.TritonPythonModel()
+    model.initialize({"model_config": json.dumps(config), "model_repository": str(MODEL_DIR),
+                      "model_version": "1"})
+
+    rng = np.random.default_rng(3)
+    images = rng.uniform(0.0, 1.0, size=(args.batch, 3, NET_SIZE, NET_SIZE)).astype(np.float32)
+    if not args.detector_onnx:
+        for i in range(args.batch):
+            detector.plant(i, args.people)
+
+    results = {}
+    latencies = []
+    for _ in range(args.iterations):
+        calls.clear()
+        request = types.SimpleNamespace(inputs=[pb_utils.Tensor("input", images)])
+        start = time.perf_counter()
+        response = model.execute([request])[0]
+        latencies.append((time.perf_counter() - start) * 1000.0)
+        if response.has_error():
+            logger.error(f"❌ execute failed: {response.error().message()}")
+            return 1
+    boxes = pb_utils.get_output_tensor_by_name(response, "boxes").as_numpy()
+    embeddings = pb_utils.get_output_tensor_by_name(response, "embeddings").as_numpy()
+    count = pb_utils.get_output_tensor_by_name(response, "count").as_numpy()
+
+    reid_calls = [n for name, n in calls if name != config["parameters"]["detector_model"]["string_value"]]
+    crops = sum(int(np.isin(boxes[i, :count[i, 0], 5], model.reid_class_ids).sum()) for i in range(args.batch))
+    results["reid_batching"] = all(n <= reid_max_batch for n in reid_calls) and sum(reid_calls) == crops
+
+    ok_boxes = ok_embeddings = True
+    for i in range(args.batch):
+        valid = boxes[i, :count[i, 0]]
+        if not args.detector_onnx:
+            planted = detector.planted[i]
+            matched = len(valid) == len(planted) and all(
+                max(iou(p, v) for v in valid) > 0.99 for p in planted)
+            ok_boxes &= matched
+        for k, box in enumerate(valid):
+            if box[5] in model.reid_class_ids:
+                expected = embedder(reference_crop(images[i], box, height, width, mean, std)[None])[0]
+                ok_embeddings &= bool(np.allclose(embeddings[i, k], expected, atol=1e-4))
+            else:
+                ok_embeddings &= not embeddings[i, k].any()
+        ok_embeddings &= not embeddings[i, count[i, 0]:].any()
+    results["decode_nms"] = bool(ok_boxes)
+    results["embeddings"] = bool(ok_embeddings)
+
+    logger.info(f"boxes per image {count.reshape(-1).tolist()}, ReID calls {reid_calls}, "
+                f"median {np.median(latencies):.1f} ms per request")
+    for name, passed in results.items():
+        (logger.info if passed else logger.error)(f"{'✅' if passed else '❌'} {name}")
+    return 0 if all(results.values()) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,226 @@
+/*
+ * Sparse vs dense assignment benchmark
+ *
+ * Builds random gated association problems, rows (detections or ended
+ * tracklets) x columns (live tracks), in which each row keeps a fraction
+ * `density` of the columns as candidates. Link costs are uniform in
+ * [-1, 0) and leaving a row unassigned costs 0, as in the tracklet linker.
+ * Each problem is solved three ways:
+ *
+ *   sparse  SparseAssignment on the candidate edges (sparse_assignment.h)
+ *   dense   the same shortest-augmenting-path method (Crouse's
+ *           rectangular LAPJV) on the full matrix, non-candidates at the
+ *           unassigned cost; filling the matrix is included
+ *   greedy  cheapest edge first while both ends are free
+ *
+ * and the tool reports the time taken by each. It also checks that the
+ * sparse total equals the dense optimum, and shows how far above the
+ * optimum the greedy total is.
+ *
+ * Usage: bench_assignment [--rows 1000] [--cols 5000] [--densities 0.001;0.01;0.1;1]
+ *            [--dense-max 1] [--seed 1]
+ */
+
+#include "sparse_assignment.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point from)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+}
+
+// Rectangular shortest augmenting path on a dense rows x cols matrix,
+// rows <= cols; every row is assigned. Returns the total cost.
+static double denseAssign(const std::vector<double>& cost, uint32_t rows, uint32_t cols,
+                          std::vector<int32_t>& colOfRow)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> u(rows, 0.0), v(cols, 0.0), shortest(cols);
+    std::vector<int32_t> path(cols), rowOfCol(cols, -1);
+    std::vector<uint32_t> remaining(cols);
+    std::vector<bool> scannedRow(rows), scannedCol(cols);
+    colOfRow.assign(rows, -1);
+
+    for (uint32_t row = 0; row < rows; ++row) {
+        std::fill(shortest.begin(), shortest.end(), inf);
+        std::fill(scannedRow.begin(), scannedRow.end(), false);
+        std::fill(scannedCol.begin(), scannedCol.end(), false);
+        for (uint32_t j = 0; j < cols; ++j) {
+            remaining[j] = cols - 1 - j;
+        }
+        uint32_t left = cols;
+        double minVal = 0.0;
+        int32_t sink = -1;
+        uint32_t i = row;
+        while (sink < 0) {
+            scannedRow[i] = true;
+            uint32_t index = 0;
+            double lowest = inf;
+            const double* c = &cost[(size_t)i * cols];
+            for (uint32_t k = 0; k < left; ++k) {
+                const uint32_t j = remaining[k];
+                const double r = minVal + c[j] - u[i] - v[j];
+                if (r < shortest[j]) {
+                    path[j] = (int32_t)i;
+                    shortest[j] = r;
+                }
+                if (shortest[j] < lowest || (shortest[j] == lowest && rowOfCol[j] < 0)) {
+                    lowest = shortest[j];
+                    index = k;
+                }
+            }
+            minVal = lowest;
+            const uint32_t j = remaining[index];
+            if (rowOfCol[j] < 0) {
+                sink = (int32_t)j;
+            } else {
+                i = (uint32_t)rowOfCol[j];
+            }
+            scannedCol[j] = true;
+            remaining[index] = remaining[--left];
+        }
+
+        u[row] += minVal;
+        for (uint32_t r = 0; r < rows; ++r) {
+            if (scannedRow[r] && r != row) {
+                u[r] += minVal - shortest[colOfRow[r]];
+            }
+        }
+        for (uint32_t j = 0; j < cols; ++j) {
+            if (scannedCol[j]) {
+                v[j] -= minVal - shortest[j];
+            }
+        }
+        for (int32_t j = sink;;) {
+            const int32_t r = path[j];
+            rowOfCol[j] = r;
+            std::swap(colOfRow[r], j);
+            if (r == (int32_t)row) {
+                break;
+            }
+        }
+    }
+
+    double total = 0.0;
+    for (uint32_t r = 0; r < rows; ++r) {
+        total += cost[(size_t)r * cols + colOfRow[r]];
+    }
+    return total;
+}
+
+static double greedyAssign(std::vector<AssignmentEdge> edges, uint32_t rows, uint32_t cols)
+{
+    std::sort(edges.begin(), edges.end(),
+              [](const AssignmentEdge& a, const AssignmentEdge& b) { return a.cost < b.cost; });
+    std::vector<bool> rowUsed(rows), colUsed(cols);
+    double total = 0.0;
+    for (const AssignmentEdge& e : edges) {
+        if (e.cost < 0.0f && !rowUsed[e.row] && !colUsed[e.col]) {
+            rowUsed[e.row] = colUsed[e.col] = true;
+            total += e.cost;
+        }
+    }
+    return total;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t rows = 1000, cols = 5000;
+    std::string densities = "0.0005;0.001;0.002;0.005;0.01;0.05;0.2;1";
+    double denseMax = 1.0;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--rows") {
+            rows = (uint32_t)atoi(v);
+        } else if (a == "--cols") {
+            cols = (uint32_t)atoi(v);
+        } else if (a == "--densities") {
+            densities = v;
+        } else if (a == "--dense-max") {
+            denseMax = atof(v);
+        } else if (a == "--seed") {
+            seed = (uint32_t)atoi(v);
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+    if (rows == 0 || cols == 0) {
+        fprintf(stderr, "ERROR: --rows and --cols must be positive\n");
+        return 1;
+    }
+
+    printf("%u rows x %u columns, link costs in [-1, 0), unassigned 0\n", rows, cols);
+    printf("%8s %9s %9s %10s %10s %10s %8s %8s\n", "density", "edges/row", "edges", "sparse_ms", "dense_ms",
+           "greedy_ms", "optimal", "greedy+");
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(-1.0f, 0.0f);
+    SparseAssignment solver;
+    std::vector<AssignmentEdge> edges;
+    std::vector<int32_t> colOfRow;
+    std::vector<uint32_t> columns(cols);
+    std::stringstream list(densities);
+    std::string item;
+    bool allOptimal = true;
+    while (std::getline(list, item, ';')) {
+        const double density = atof(item.c_str());
+        const uint32_t perRow = std::min(cols, std::max(1u, (uint32_t)std::lround(density * cols)));
+
+        // perRow distinct candidates per row: a partial Fisher-Yates shuffle
+        edges.clear();
+        for (uint32_t j = 0; j < cols; ++j) {
+            columns[j] = j;
+        }
+        for (uint32_t r = 0; r < rows; ++r) {
+            for (uint32_t k = 0; k < perRow; ++k) {
+                std::swap(columns[k], columns[k + rng() % (cols - k)]);
+                edges.push_back(AssignmentEdge{r, columns[k], uniform(rng)});
+            }
+        }
+
+        Clock::time_point t0 = Clock::now();
+        const double sparse = solver.solve(rows, cols, edges, 0.0f, colOfRow);
+        const double sparseMs = elapsedMs(t0);
+
+        t0 = Clock::now();
+        const double greedy = greedyAssign(edges, rows, cols);
+        const double greedyMs = elapsedMs(t0);
+
+        char denseMs[16] = "-", optimal[16] = "-";
+        if (density <= denseMax) {
+            // Enough columns at the unassigned cost that any row can stay out
+            t0 = Clock::now();
+            const uint32_t denseCols = cols + rows;
+            std::vector<double> matrix((size_t)rows * denseCols, 0.0);
+            for (const AssignmentEdge& e : edges) {
+                double& c = matrix[(size_t)e.row * denseCols + e.col];
+                c = std::min(c, (double)e.cost);
+            }
+            std::vector<int32_t> assigned;
+            const double dense = denseAssign(matrix, rows, denseCols, assigned);
+            snprintf(denseMs, sizeof(denseMs), "%.1f", elapsedMs(t0));
+            const bool same = std::fabs(sparse - dense) <= 1e-4 * std::max(1.0, std::fabs(dense));
+            snprintf(optimal, sizeof(optimal), "%s", same ? "yes" : "NO");
+            allOptimal &= same;
+        }
+
+        printf("%8g %9u %9zu %10.2f %10s %10.2f %8s %7.2f%%\n", density, perRow, edges.size(), sparseMs, denseMs,
+               greedyMs, optimal, sparse < 0.0 ? 100.0 * (greedy - sparse) / -sparse : 0.0);
+    }
+    return allOptimal ? 0 : 1;
+}
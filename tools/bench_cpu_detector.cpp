@@ -0,0 +1,333 @@
+/*
+ * CPU detector sizing: frames per second per core of the YOLOv7 CPU path
+ *
+ * Feeds synthetic RGBA frames from 1, 2, 4 ... streams into a CpuDetector
+ * (see cpu_detector.h) on its own WorkStealingScheduler and measures what
+ * the box sustains: ONNX Runtime inference, letterboxing and
+ * NvDsInferParseYolov7 + NMS, as a site without a GPU would run them.
+ *
+ * With --fps 0 (the default) every stream offers a new frame as soon as it
+ * has room in its queue, which measures capacity; with --fps N each stream
+ * releases N frames per second and frames that find their queue full are
+ * dropped, which checks a planned load.
+ *
+ * Per step: achieved fps, fps per core (frames over CPU seconds, the
+ * number to size hardware with), cores used, dropped frames, p50/p99
+ * latency (submit to result), mean per-frame time in letterbox, inference
+ * and parse, objects per frame and the number of lanes.
+ *
+ * Output: a table on stdout and, with --json, one JSON object per step.
+ *
+ * Needs ONNX Runtime and the DeepStream headers (not its libraries):
+ *   make WITH_ONNXRUNTIME=1 ORT_DIR=/opt/onnxruntime DS_INCLUDES=...
+ *
+ * Usage: bench_cpu_detector [--config configs/cpu_detector.txt] [--model path.onnx]
+ *            [--scheduler-config configs/scheduler.txt] [--streams 1;2;4;8]
+ *            [--fps 0] [--seconds 10] [--warmup 2] [--frame-width 1280] [--frame-height 720]
+ *            [--json results.jsonl]
+ */
+
+#include "cpu_detector.h"
+#include "work_stealing_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchOptions
+{
+    CpuDetectorConfig detector;
+    SchedulerConfig scheduler;
+    double fps = 0.0;
+    double seconds = 10.0;
+    double warmup = 2.0;
+    uint32_t frameWidth = 1280;
+    uint32_t frameHeight = 720;
+};
+
+struct StepResult
+{
+    uint32_t streams = 0;
+    uint32_t lanes = 0;
+    uint32_t workers = 0;
+    double offeredFps = 0.0;
+    double achievedFps = 0.0;
+    double fpsPerCore = 0.0;
+    double cpuCores = 0.0;
+    uint64_t frames = 0;
+    uint64_t dropped = 0;
+    double latencyP50Ms = 0.0;
+    double latencyP99Ms = 0.0;
+    double preprocessMs = 0.0;
+    double inferenceMs = 0.0;
+    double parseMs = 0.0;
+    double objectsPerFrame = 0.0;
+    double framesPerBatch = 0.0;
+};
+
+// Latencies from the result callback, which runs on several workers
+struct LatencySink
+{
+    std::mutex mutex;
+    Clock::time_point origin;
+    std::atomic<bool> measuring{false};
+    std::vector<uint32_t> latencyUs;
+};
+
+static double cpuSeconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static uint64_t sinceUs(Clock::time_point origin)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin).count();
+}
+
+static double percentileMs(std::vector<uint32_t>& us, double q)
+{
+    if (us.empty()) {
+        return 0.0;
+    }
+    const size_t k = std::min(us.size() - 1, (size_t)(q * us.size()));
+    std::nth_element(us.begin(), us.begin() + k, us.end());
+    return us[k] / 1000.0;
+}
+
+// Textured RGBA frame, different per stream
+static void makeFrame(uint32_t stream, uint32_t width, uint32_t height, std::vector<uint8_t>& frame)
+{
+    std::mt19937 rng(stream + 1);
+    frame.resize((size_t)width * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* row = &frame[(size_t)y * width * 4];
+        for (uint32_t x = 0; x < width; ++x) {
+            row[x * 4 + 0] = (uint8_t)(x * 3 + y + stream * 40 + (rng() & 15));
+            row[x * 4 + 1] = (uint8_t)(x + y * 2);
+            row[x * 4 + 2] = (uint8_t)((x ^ y) + (rng() & 31));
+            row[x * 4 + 3] = 255;
+        }
+    }
+}
+
+static bool runStep(uint32_t streams, const BenchOptions& opt, StepResult& r)
+{
+    std::vector<std::vector<uint8_t>> frames(streams);
+    for (uint32_t s = 0; s < streams; ++s) {
+        makeFrame(s, opt.frameWidth, opt.frameHeight, frames[s]);
+    }
+
+    WorkStealingScheduler scheduler(opt.scheduler);
+    LatencySink sink;
+    sink.origin = Clock::now();
+    CpuDetectorConfig config = opt.detector;
+    config.maxStreams = std::max(config.maxStreams, streams);
+    std::unique_ptr<CpuDetector> detector =
+        CpuDetector::create(config, scheduler, [&sink](const CpuDetectorResult& result) {
+            if (!sink.measuring.load(std::memory_order_relaxed)) {
+                return;
+            }
+            const uint32_t us = (uint32_t)(sinceUs(sink.origin) - result.frame->timestampUs);
+            std::lock_guard<std::mutex> lock(sink.mutex);
+            sink.latencyUs.push_back(us);
+        });
+    if (!detector) {
+        return false;
+    }
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point measureStart = start + std::chrono::duration_cast<Clock::duration>(
+                                                       std::chrono::duration<double>(opt.warmup));
+    const Clock::time_point end = measureStart + std::chrono::duration_cast<Clock::duration>(
+                                                     std::chrono::duration<double>(opt.seconds));
+    const Clock::duration period = opt.fps > 0.0 ? std::chrono::duration_cast<Clock::duration>(
+                                                       std::chrono::duration<double>(1.0 / opt.fps))
+                                                 : Clock::duration::zero();
+    CpuDetectorStats before;
+    double cpuStart = 0.0;
+    bool measuring = false;
+    uint64_t droppedAtStart = 0;
+    Clock::time_point next = start;
+    while (true) {
+        const Clock::time_point now = Clock::now();
+        if (now >= end) {
+            break;
+        }
+        if (!measuring && now >= measureStart) {
+            measuring = true;
+            before = detector->stats();
+            droppedAtStart = before.dropped;
+            cpuStart = cpuSeconds();
+            sink.measuring.store(true);
+        }
+        if (opt.fps > 0.0 && now < next) {
+            std::this_thread::sleep_until(next);
+            continue;
+        }
+        for (uint32_t s = 0; s < streams; ++s) {
+            CpuFrame f;
+            f.stream = s;
+            f.timestampUs = sinceUs(sink.origin);
+            f.pixels = frames[s].data();
+            f.width = opt.frameWidth;
+            f.height = opt.frameHeight;
+            f.stride = opt.frameWidth * 4;
+            f.format = kCpuPixelRgba;
+            f.user = nullptr;
+            detector->submit(f);
+        }
+        if (opt.fps > 0.0) {
+            next += period;
+        } else {
+            // Capacity mode: come back when a slot may have freed up
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    const CpuDetectorStats after = detector->stats();
+    const double wall = std::chrono::duration<double>(Clock::now() - measureStart).count();
+    const double cpu = cpuSeconds() - cpuStart;
+    sink.measuring.store(false);
+    detector->flush();
+
+    const uint64_t processed = after.frames - before.frames;
+    const uint64_t batches = after.batches - before.batches;
+    r = StepResult();
+    r.streams = streams;
+    r.lanes = detector->lanes();
+    r.workers = scheduler.workers();
+    r.offeredFps = opt.fps * streams;
+    r.frames = processed;
+    r.dropped = opt.fps > 0.0 ? after.dropped - droppedAtStart : 0;
+    r.achievedFps = wall > 0.0 ? processed / wall : 0.0;
+    r.fpsPerCore = cpu > 0.0 ? processed / cpu : 0.0;
+    r.cpuCores = wall > 0.0 ? cpu / wall : 0.0;
+    {
+        std::lock_guard<std::mutex> lock(sink.mutex);
+        r.latencyP50Ms = percentileMs(sink.latencyUs, 0.50);
+        r.latencyP99Ms = percentileMs(sink.latencyUs, 0.99);
+    }
+    if (processed > 0) {
+        r.preprocessMs = (after.preprocessUs - before.preprocessUs) / 1000.0 / processed;
+        r.inferenceMs = (after.inferenceUs - before.inferenceUs) / 1000.0 / processed;
+        r.parseMs = (after.parseUs - before.parseUs) / 1000.0 / processed;
+        r.objectsPerFrame = (double)(after.objects - before.objects) / processed;
+    }
+    r.framesPerBatch = batches > 0 ? (double)processed / batches : 0.0;
+    return true;
+}
+
+static std::string toJson(const StepResult& r)
+{
+    std::ostringstream os;
+    os << "{\"streams\":" << r.streams << ",\"lanes\":" << r.lanes << ",\"workers\":" << r.workers
+       << ",\"offered_fps\":" << r.offeredFps << ",\"achieved_fps\":" << r.achievedFps
+       << ",\"fps_per_core\":" << r.fpsPerCore << ",\"cpu_cores\":" << r.cpuCores << ",\"frames\":" << r.frames
+       << ",\"dropped\":" << r.dropped << ",\"latency_ms\":{\"p50\":" << r.latencyP50Ms
+       << ",\"p99\":" << r.latencyP99Ms << "},\"per_frame_ms\":{\"letterbox\":" << r.preprocessMs
+       << ",\"inference\":" << r.inferenceMs << ",\"parse\":" << r.parseMs << "}"
+       << ",\"objects_per_frame\":" << r.objectsPerFrame << ",\"frames_per_batch\":" << r.framesPerBatch << "}";
+    return os.str();
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+    // Benchmark the whole box unless a scheduler config says otherwise
+    opt.scheduler.reservedCores = 0;
+    std::vector<int> steps = {1, 2, 4, 8};
+    std::string jsonPath;
+    std::string model;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--config") {
+            if (!CpuDetectorConfig::load(v, opt.detector)) {
+                return 1;
+            }
+        } else if (a == "--model") {
+            model = v;
+        } else if (a == "--scheduler-config") {
+            if (!SchedulerConfig::load(v, opt.scheduler)) {
+                return 1;
+            }
+        } else if (a == "--streams") {
+            steps.clear();
+            std::stringstream ss(v);
+            std::string item;
+            while (std::getline(ss, item, ';')) {
+                if (atoi(item.c_str()) > 0) {
+                    steps.push_back(atoi(item.c_str()));
+                }
+            }
+        } else if (a == "--fps") {
+            opt.fps = atof(v);
+        } else if (a == "--seconds") {
+            opt.seconds = atof(v);
+        } else if (a == "--warmup") {
+            opt.warmup = atof(v);
+        } else if (a == "--frame-width") {
+            opt.frameWidth = (uint32_t)std::max(1, atoi(v));
+        } else if (a == "--frame-height") {
+            opt.frameHeight = (uint32_t)std::max(1, atoi(v));
+        } else if (a == "--json") {
+            jsonPath = v;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+    if (!model.empty()) {
+        opt.detector.model = model;
+    }
+    if (steps.empty()) {
+        fprintf(stderr, "ERROR: --streams must be non-empty\n");
+        return 1;
+    }
+    FILE* json = nullptr;
+    if (!jsonPath.empty()) {
+        json = jsonPath == "-" ? stdout : fopen(jsonPath.c_str(), "w");
+        if (!json) {
+            fprintf(stderr, "ERROR: Cannot create %s\n", jsonPath.c_str());
+            return 1;
+        }
+    }
+
+    printf("%7s %5s %7s | %8s %8s %8s %5s %6s | %8s %8s | %8s %8s %8s | %6s %6s\n", "streams", "lanes", "workers",
+           "offered", "achieved", "fps/core", "cores", "drop", "lat_p50", "lat_p99", "letterbx", "infer", "parse",
+           "obj/f", "f/batch");
+    for (int streams : steps) {
+        StepResult r;
+        if (!runStep((uint32_t)streams, opt, r)) {
+            return 1;
+        }
+        printf("%7u %5u %7u | %8.1f %8.1f %8.2f %5.2f %6llu | %7.1fm %7.1fm | %7.2fm %7.2fm %7.2fm | %6.1f %6.2f\n",
+               r.streams, r.lanes, r.workers, r.offeredFps, r.achievedFps, r.fpsPerCore, r.cpuCores,
+               (unsigned long long)r.dropped, r.latencyP50Ms, r.latencyP99Ms, r.preprocessMs, r.inferenceMs,
+               r.parseMs, r.objectsPerFrame, r.framesPerBatch);
+        fflush(stdout);
+        if (json) {
+            fprintf(json, "%s\n", toJson(r).c_str());
+            fflush(json);
+        }
+    }
+    if (json && json != stdout) {
+        fclose(json);
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Event publisher benchmark
+ *
+ * Feeds simulated per-frame tracker output for many streams through the
+ * EventPublisher and reports observation throughput and wire bytes per
+ * event for each publisher mode, next to a per-object JSON baseline.
+ *
+ * Usage: bench_event_publisher [streams] [objects_per_frame] [seconds] [fps]
+ */
+
+#include "event_publisher.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+struct BenchMode
+{
+    const char* name;
+    bool latestPerTrack;
+    bool compress;
+};
+
+// Size of a minimal per-object JSON message carrying the same fields
+static size_t jsonBytes(const EventObservation& o)
+{
+    char buf[512];
+    int n = snprintf(buf, sizeof(buf),
+                     "{\"sensorId\":%u,\"@timestamp\":%llu,\"object\":{\"id\":\"%llu\",\"globalId\":\"GT_%06u\","
+                     "\"classId\":%u,\"confidence\":%.3f,\"bbox\":{\"left\":%.1f,\"top\":%.1f,"
+                     "\"width\":%.1f,\"height\":%.1f}}}",
+                     o.sourceId, (unsigned long long)o.timestampUs, (unsigned long long)o.trackId, o.globalId,
+                     o.classId, o.confidence, o.left, o.top, o.width, o.height);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// Deterministic pseudo-scene: objects drift slowly and tracks turn over
+// every 10 seconds so windows contain a realistic mix of old and new ids.
+static void makeObservation(uint32_t source, uint32_t obj, uint64_t frame, uint32_t fps, EventObservation& o)
+{
+    const uint64_t generation = frame / (10 * fps);
+    const float t = (float)(frame % (10 * fps)) / (float)fps;
+    o.sourceId = source;
+    o.timestampUs = frame * 1000000ull / fps;
+    o.trackId = generation * 100000 + source * 1000 + obj;
+    o.globalId = (uint32_t)(o.trackId % 50000) + 1;
+    o.classId = obj % 4 == 0 ? 2 : 0;
+    o.confidence = 0.5f + 0.4f * (float)((obj * 37) % 100) / 100.0f;
+    o.left = 20.0f + (float)((obj * 53) % 560) + 12.0f * t;
+    o.top = 40.0f + (float)((obj * 97) % 420) + 3.0f * std::sin(t);
+    o.width = 40.0f + (float)(obj % 7) * 6.0f;
+    o.height = 90.0f + (float)(obj % 5) * 10.0f;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t streams = argc > 1 ? (uint32_t)atoi(argv[1]) : 64;
+    const uint32_t objects = argc > 2 ? (uint32_t)atoi(argv[2]) : 20;
+    const uint32_t seconds = argc > 3 ? (uint32_t)atoi(argv[3]) : 10;
+    const uint32_t fps = argc > 4 ? (uint32_t)atoi(argv[4]) : 30;
+    const uint64_t frames = (uint64_t)seconds * fps;
+
+    std::cout << "streams=" << streams << " objects_per_frame=" << objects << " seconds=" << seconds
+              << " fps=" << fps << std::endl;
+
+    // JSON baseline over one frame of every stream
+    {
+        EventObservation o;
+        size_t total = 0;
+        for (uint32_t s = 0; s < streams; ++s) {
+            for (uint32_t j = 0; j < objects; ++j) {
+                makeObservation(s, j, 0, fps, o);
+                total += jsonBytes(o);
+            }
+        }
+        printf("mode=json_per_object bytes_per_event=%.1f\n", (double)total / (streams * objects));
+    }
+
+    const BenchMode modes[] = {
+        {"binary_every_observation", false, false},
+        {"binary_latest_per_track", true, false},
+        {"zstd_every_observation", false, true},
+        {"zstd_latest_per_track", true, true},
+    };
+
+    for (const BenchMode& mode : modes) {
+#ifndef WITH_ZSTD
+        if (mode.compress) {
+            printf("mode=%s skipped (built without WITH_ZSTD=1)\n", mode.name);
+            continue;
+        }
+#endif
+        EventPublisherConfig config;
+        config.windowMs = 1000;
+        config.latestPerTrack = mode.latestPerTrack;
+        config.compress = mode.compress;
+        // The benchmark measures encoding cost, not transport back-pressure
+        config.maxQueuedBatches = 1u << 20;
+
+        EventPublisher publisher(config, createEventTransport("file:///dev/null"));
+        EventObservation o;
+
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (uint64_t f = 0; f < frames; ++f) {
+            for (uint32_t s = 0; s < streams; ++s) {
+                for (uint32_t j = 0; j < objects; ++j) {
+                    makeObservation(s, j, f, fps, o);
+                    publisher.publish(o);
+                }
+            }
+        }
+        const double publishSec =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        publisher.drain();
+        const double totalSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        const EventPublisherStats st = publisher.stats();
+        printf("mode=%s observations=%llu records=%llu batches=%llu dropped=%llu "
+               "publish_obs_per_sec=%.0f end_to_end_obs_per_sec=%.0f "
+               "raw_bytes_per_event=%.2f wire_bytes_per_event=%.2f\n",
+               mode.name, (unsigned long long)st.observations, (unsigned long long)st.records,
+               (unsigned long long)st.batches, (unsigned long long)st.droppedBatches,
+               st.observations / publishSec, st.observations / totalSec,
+               (double)st.rawBytes / st.observations, (double)st.publishedBytes / st.observations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Shared-memory frame ring benchmark
+ *
+ * Forks one fast and one deliberately slow consumer, then publishes frames
+ * as fast as possible. Reports producer throughput (which must not depend
+ * on the consumers) and how many records each consumer read or lost.
+ *
+ * Usage: bench_frame_ring [frames] [objects_per_frame] [capacity]
+ */
+
+#include "frame_meta_ring.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+static const char* kRingName = "/bench_frame_ring";
+
+static int runConsumer(const char* label, int slowEveryN, uint64_t frames)
+{
+    std::unique_ptr<FrameRingConsumer> consumer = FrameRingConsumer::open(kRingName, true);
+    if (!consumer) {
+        return 1;
+    }
+
+    FrameRecord* rec = new FrameRecord;
+    uint64_t read = 0;
+    uint64_t objects = 0;
+    uint64_t lastSeq = 0;
+    bool ordered = true;
+    while (consumer->cursor() < frames) {
+        if (!consumer->next(*rec)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        if (read > 0 && rec->sequence <= lastSeq) {
+            ordered = false;
+        }
+        lastSeq = rec->sequence;
+        read++;
+        objects += rec->numObjects;
+        if (slowEveryN > 0 && read % slowEveryN == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    printf("consumer=%s read=%llu overruns=%llu objects=%llu ordered=%d\n", label, (unsigned long long)read,
+           (unsigned long long)consumer->overruns(), (unsigned long long)objects, ordered ? 1 : 0);
+    // Children leave via _exit, which does not flush stdio
+    fflush(stdout);
+    delete rec;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const uint64_t frames = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    const uint32_t objects = argc > 2 ? (uint32_t)atoi(argv[2]) : 20;
+    const uint32_t capacity = argc > 3 ? (uint32_t)atoi(argv[3]) : 1024;
+
+    std::unique_ptr<FrameRingProducer> producer = FrameRingProducer::create(kRingName, capacity);
+    if (!producer) {
+        return 1;
+    }
+
+    pid_t children[2];
+    const int slowEvery[2] = {0, 100};
+    const char* labels[2] = {"fast", "slow"};
+    for (int i = 0; i < 2; ++i) {
+        children[i] = fork();
+        if (children[i] == 0) {
+            _exit(runConsumer(labels[i], slowEvery[i], frames));
+        }
+    }
+
+    // Give consumers time to attach so the fast one can keep up from the start
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    FrameRecord* rec = new FrameRecord;
+    memset(rec, 0, sizeof(*rec));
+    const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (uint64_t f = 0; f < frames; ++f) {
+        rec->sourceId = (uint32_t)(f % 64);
+        rec->frameNum = (uint32_t)(f / 64);
+        rec->ptsNs = f * 33333333ull;
+        rec->numObjects = (uint16_t)objects;
+        for (uint32_t j = 0; j < objects; ++j) {
+            rec->objects[j].trackId = j;
+            rec->objects[j].left = (float)j;
+        }
+        producer->publish(*rec);
+    }
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    FrameRingConsumerInfo info[FRAME_RING_MAX_CONSUMERS];
+    const uint32_t n = producer->consumers(info, FRAME_RING_MAX_CONSUMERS);
+    printf("producer frames=%llu objects_per_frame=%u capacity=%u frames_per_sec=%.0f ns_per_frame=%.1f\n",
+           (unsigned long long)frames, objects, producer->capacity(), frames / sec, sec * 1e9 / frames);
+    for (uint32_t i = 0; i < n; ++i) {
+        printf("attached pid=%u lag=%llu overruns=%llu\n", info[i].pid, (unsigned long long)info[i].lag,
+               (unsigned long long)info[i].overruns);
+    }
+    fflush(stdout);
+
+    for (int i = 0; i < 2; ++i) {
+        int status = 0;
+        waitpid(children[i], &status, 0);
+    }
+    delete rec;
+    return 0;
+}
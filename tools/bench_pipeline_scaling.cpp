@@ -0,0 +1,856 @@
+/*
+ * End-to-end CPU scaling benchmark: parse -> track -> associate -> analytics
+ *
+ * Runs the CPU side of the pipeline on synthetic cameras (see
+ * synthetic_scene.h) at their real frame rate and ramps the number of
+ * sources (1, 2, 4 ... 64 by default) to find where it stops keeping up.
+ * Per frame and source:
+ *
+ *   render     the scene's detector output is written into a host tensor
+ *              (stands in for the device-to-host copy of the output layer)
+ *   parse      NvDsInferParseYolov7 on that tensor, then per-class NMS as
+ *              nvinfer/nvinferserver cluster it (iou 0.45, top-k 300)
+ *   track      one IouTracker per source
+ *   associate  confirmed tracks with their embeddings go to one
+ *              GlobalAssociator shared by every source; tracks in shadow
+ *              for lost-after-frames are offered for re-stitching
+ *   analytics  one ClipTrigger (see clip_trigger.h) shared by every source,
+ *              with an entrance zone per camera, gets the tracks with their
+ *              global ids
+ *
+ * --scheduler picks how the stages get their threads:
+ *
+ *   pools   independent pools, as each stage would bring its own: render,
+ *           parse and track on --workers threads with sources sharded
+ *           across them (a source is always on the same thread, so its
+ *           tracker sees frames in order), plus one association and one
+ *           analytics thread, connected by blocking queues
+ *   shared  every stage as jobs on one WorkStealingScheduler (see
+ *           work_stealing_scheduler.h) capped at --workers threads: a
+ *           strand per source keeps its frames in order, association and
+ *           analytics are one strand each
+ *   both    each step once per mode, to compare CPU at equal throughput
+ *
+ * Each source may have --queue frames in flight; a frame released while
+ * that many are pending is dropped, as a leaky queue upstream would.
+ *
+ * For each step the benchmark reports per-stage mean/p99 time and the
+ * frames per second one core sustains in that stage, achieved vs offered
+ * frame rate, p50/p99 frame latency (release to analytics done), CPU
+ * cores used, resident memory growth, the associator's gallery size and
+ * how many global tracks were created and re-stitched (id churn).
+ * A step "keeps up" when it drops nothing, processes >= 98% of offered
+ * frames and its p99 latency stays within --budget-ms.
+ *
+ * Output: a table on stdout and, with --json, one JSON object per step
+ * (JSON lines) for comparing releases and sizing hardware.
+ *
+ * Needs the DeepStream headers (not its libraries, nor a GPU) for the
+ * parser: make DS_INCLUDES=/opt/nvidia/deepstream/deepstream/sources/includes
+ *
+ * Usage: bench_pipeline_scaling [--sources 1;2;4;8;16;32;64] [--seconds 10] [--warmup 2]
+ *            [--workers N] [--queue 4] [--layout 6|85] [--budget-ms 100]
+ *            [--scheduler pools|shared|both] [--scheduler-config configs/scheduler.txt]
+ *            [--scene configs/synthetic_scene.txt] [--tracking configs/tracking_native.txt]
+ *            [--json results.jsonl]
+ */
+
+#include "nvdsinfer_custom_impl.h"
+#include "clip_trigger.h"
+#include "global_associator.h"
+#include "iou_tracker.h"
+#include "synthetic_scene.h"
+#include "work_stealing_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+extern "C" bool NvDsInferParseYolov7(std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+                                     NvDsInferNetworkInfo const& networkInfo,
+                                     NvDsInferParseDetectionParams const& detectionParams,
+                                     std::vector<NvDsInferParseObjectInfo>& objectList);
+
+typedef std::chrono::steady_clock Clock;
+
+static const float kNmsIou = 0.45f;
+static const size_t kNmsTopK = 300;
+static const float kConfidenceThreshold = 0.25f;
+
+struct TrackedForAssociation
+{
+    uint64_t trackId;
+    TrackBox box;
+    float confidence;
+    int embedding;      // index into the job's embeddings, -1 = none
+    uint64_t globalId;  // set by association
+};
+
+// A confirmed track the tracker just lost, for re-stitching
+struct LostTrack
+{
+    uint64_t trackId;
+    TrackBox box;  // predicted
+    float vx, vy;  // pixels per second
+};
+
+struct StepContext;
+
+// One frame of one source on its way through the stages; with the shared
+// scheduler it is its own SchedulerJob, `run` pointing at the next stage
+struct FrameJob : SchedulerJob
+{
+    StepContext* step;
+    uint32_t source;
+    uint64_t timestampUs;
+    Clock::time_point released;
+    std::vector<SceneProposal> proposals;
+    std::vector<SceneDetection> truth;
+    std::vector<float> embeddings;
+    std::vector<TrackedForAssociation> tracked;
+    std::vector<LostTrack> lost;
+    std::vector<uint64_t> ended;
+    uint32_t renderUs, parseUs, trackUs;
+};
+
+// Blocking FIFO of job pointers
+class JobQueue
+{
+public:
+    void push(FrameJob* job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Jobs.push_back(job);
+        }
+        m_Cv.notify_one();
+    }
+
+    // nullptr once closed and drained
+    FrameJob* pop()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Cv.wait(lock, [this]() { return !m_Jobs.empty() || m_Closed; });
+        if (m_Jobs.empty()) {
+            return nullptr;
+        }
+        FrameJob* job = m_Jobs.front();
+        m_Jobs.pop_front();
+        return job;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Closed = true;
+        }
+        m_Cv.notify_all();
+    }
+
+private:
+    std::mutex m_Mutex;
+    std::condition_variable m_Cv;
+    std::deque<FrameJob*> m_Jobs;
+    bool m_Closed = false;
+};
+
+struct StageSamples
+{
+    std::vector<uint32_t> render, parse, track, associate, analytics, latencyUs;
+
+    void merge(const StageSamples& o)
+    {
+        render.insert(render.end(), o.render.begin(), o.render.end());
+        parse.insert(parse.end(), o.parse.begin(), o.parse.end());
+        track.insert(track.end(), o.track.begin(), o.track.end());
+        associate.insert(associate.end(), o.associate.begin(), o.associate.end());
+        analytics.insert(analytics.end(), o.analytics.begin(), o.analytics.end());
+        latencyUs.insert(latencyUs.end(), o.latencyUs.begin(), o.latencyUs.end());
+    }
+};
+
+struct StageStat
+{
+    double meanUs;
+    double p99Us;
+    double fpsPerCore;
+};
+
+static StageStat stageStat(std::vector<uint32_t>& v)
+{
+    StageStat s = {0.0, 0.0, 0.0};
+    if (v.empty()) {
+        return s;
+    }
+    double sum = 0.0;
+    for (uint32_t x : v) {
+        sum += x;
+    }
+    s.meanUs = sum / v.size();
+    const size_t k = std::min(v.size() - 1, (size_t)(0.99 * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    s.p99Us = v[k];
+    s.fpsPerCore = s.meanUs > 0.0 ? 1e6 / s.meanUs : 0.0;
+    return s;
+}
+
+static double percentileMs(std::vector<uint32_t>& v, double p)
+{
+    if (v.empty()) {
+        return 0.0;
+    }
+    const size_t k = std::min(v.size() - 1, (size_t)(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k] / 1000.0;
+}
+
+static double residentMb()
+{
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0.0;
+    }
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(f);
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+static double cpuSeconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static inline uint32_t elapsedUs(Clock::time_point from, Clock::time_point to)
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+// Greedy per-class NMS, highest confidence first
+static void nms(std::vector<NvDsInferParseObjectInfo>& objects, std::vector<TrackerDetection>& out)
+{
+    std::sort(objects.begin(), objects.end(),
+              [](const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b) {
+                  return a.detectionConfidence > b.detectionConfidence;
+              });
+    out.clear();
+    for (const NvDsInferParseObjectInfo& o : objects) {
+        if (out.size() >= kNmsTopK) {
+            break;
+        }
+        const TrackBox box = {o.left, o.top, o.width, o.height};
+        bool keep = true;
+        for (const TrackerDetection& k : out) {
+            if (k.classId == (int)o.classId && trackBoxIou(k.box, box) > kNmsIou) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            out.push_back(TrackerDetection{box, o.detectionConfidence, (int)o.classId});
+        }
+    }
+}
+
+enum SchedulerMode
+{
+    kPools = 0,   // render/parse/track workers plus an association and an analytics thread
+    kShared = 1,  // every stage as jobs on one WorkStealingScheduler
+};
+
+struct StepResult
+{
+    uint32_t sources;
+    const char* scheduler;
+    uint32_t workers;  // threads doing the stages
+    double offeredFps;
+    double achievedFps;
+    uint64_t frames;
+    uint64_t dropped;
+    StageStat render, parse, track, associate, analytics;
+    double latencyP50Ms, latencyP99Ms;
+    double cpuCores;
+    double rssStartMb, rssEndMb;
+    double associatorMb;
+    uint64_t globalTracks;
+    uint64_t globalCreated;
+    uint64_t stitched;
+    uint64_t localTracks;
+    uint64_t detections;
+    uint64_t clipEvents;
+    SchedulerStats schedulerStats;
+    bool keepsUp;
+};
+
+struct BenchOptions
+{
+    double seconds = 10.0;
+    double warmup = 2.0;
+    uint32_t workers = 0;
+    uint32_t queue = 4;
+    uint32_t channels = 6;
+    double budgetMs = 100.0;
+    std::vector<SchedulerMode> modes = {kPools};
+    SchedulerConfig scheduler;
+    SyntheticSceneConfig scene;
+    IouTrackerConfig tracker;
+    AssociatorConfig associator;
+};
+
+class NullRecorder : public ClipRecorder
+{
+public:
+    bool startClip(uint32_t, uint32_t, uint32_t) override { return true; }
+    void stopClip(uint32_t) override {}
+};
+
+// Parser and tracker scratch of one worker thread
+struct WorkerContext
+{
+    std::vector<float> tensor;
+    std::vector<NvDsInferLayerInfo> layers;
+    NvDsInferNetworkInfo networkInfo;
+    NvDsInferParseDetectionParams params;
+    std::vector<NvDsInferParseObjectInfo> objects;
+    std::vector<TrackerDetection> detections;
+    std::vector<TrackedObject> active;
+    std::vector<TerminatedTrack> terminated;
+    std::vector<int> truthOf;
+    StageSamples samples;
+
+    WorkerContext(uint32_t rows, uint32_t channels, const SyntheticSceneConfig& scene)
+        : tensor((size_t)rows * channels), layers(1)
+    {
+        NvDsInferLayerInfo& layer = layers[0];
+        memset(&layer, 0, sizeof(layer));
+        layer.dataType = FLOAT;
+        layer.inferDims.numDims = 2;
+        layer.inferDims.d[0] = rows;
+        layer.inferDims.d[1] = channels;
+        layer.inferDims.numElements = rows * channels;
+        layer.layerName = "output";
+        layer.buffer = tensor.data();
+        networkInfo.width = scene.netWidth;
+        networkInfo.height = scene.netHeight;
+        networkInfo.channels = 3;
+        params.numClassesConfigured = 80;
+        params.perClassPreclusterThreshold.assign(80, kConfidenceThreshold);
+        params.perClassPostclusterThreshold.assign(80, kConfidenceThreshold);
+    }
+};
+
+// Everything one step shares between its stages
+struct StepContext
+{
+    const BenchOptions& opt;
+    const SyntheticSceneConfig& sceneConfig;
+    SyntheticScene& scene;
+    uint32_t dim;
+    GlobalAssociator associator;
+    std::vector<std::unique_ptr<IouTracker>> trackers;
+    NullRecorder recorder;
+    ClipTrigger trigger;
+    std::vector<ClipTrackObject> clipObjects;
+    uint64_t lastExpireUs = 0;
+    uint64_t clipEvents = 0;
+
+    std::vector<std::vector<FrameJob*>> freeJobs;
+    std::mutex freeMutex;
+    std::atomic<bool> measuring{false};
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> inFlight{0};
+    StageSamples serialSamples;  // association and analytics
+    std::vector<std::unique_ptr<WorkerContext>> workers;
+
+    // kShared only
+    std::unique_ptr<WorkStealingScheduler> scheduler;
+    std::vector<std::unique_ptr<Strand>> sourceStrands;
+    std::unique_ptr<Strand> associateStrand;
+    std::unique_ptr<Strand> analyticsStrand;
+
+    StepContext(const BenchOptions& o, const SyntheticSceneConfig& sc, SyntheticScene& s,
+                const ClipTriggerConfig& clips)
+        : opt(o), sceneConfig(sc), scene(s), dim(sc.embeddingDim), associator(o.associator, sc.embeddingDim),
+          trigger(clips, &recorder)
+    {
+        trigger.setEventCallback([this](const ClipEvent&) { clipEvents++; });
+    }
+};
+
+// Render, parse and track one frame; per source these run in frame order
+static void parseFrame(StepContext& c, WorkerContext& w, FrameJob* job)
+{
+    const Clock::time_point t0 = Clock::now();
+    if (c.opt.channels == 6) {
+        c.scene.renderTensor6(job->proposals, w.tensor.data());
+    } else {
+        c.scene.renderTensor85(job->proposals, w.tensor.data());
+    }
+    const Clock::time_point t1 = Clock::now();
+    NvDsInferParseYolov7(w.layers, w.networkInfo, w.params, w.objects);
+    nms(w.objects, w.detections);
+    const Clock::time_point t2 = Clock::now();
+    c.trackers[job->source]->update(w.detections, w.active, w.terminated);
+
+    // The ReID model would embed each tracked crop; here the embedding of
+    // the scene object under the detection is used
+    w.truthOf.assign(w.detections.size(), -1);
+    for (size_t d = 0; d < w.detections.size(); ++d) {
+        float best = 0.5f;
+        for (size_t g = 0; g < job->truth.size(); ++g) {
+            const SceneDetection& t = job->truth[g];
+            const TrackBox tb = {t.x1, t.y1, t.x2 - t.x1, t.y2 - t.y1};
+            const float iou = trackBoxIou(w.detections[d].box, tb);
+            if (iou > best) {
+                best = iou;
+                w.truthOf[d] = (int)g;
+            }
+        }
+    }
+    job->tracked.clear();
+    for (const TrackedObject& o : w.active) {
+        if (o.confirmed && o.detection != TrackedObject::kNoDetection) {
+            job->tracked.push_back(TrackedForAssociation{o.trackId, o.box, o.confidence, w.truthOf[o.detection], 0});
+        }
+    }
+    job->lost.clear();
+    for (const TrackedObject& o : w.active) {
+        if (o.confirmed && o.missed == c.opt.associator.stitching.lostAfterFrames) {
+            const float fps = (float)c.sceneConfig.fps;
+            job->lost.push_back(LostTrack{o.trackId, o.box, o.vx * fps, o.vy * fps});
+        }
+    }
+    job->ended.clear();
+    for (const TerminatedTrack& t : w.terminated) {
+        if (t.confirmed) {
+            job->ended.push_back(t.trackId);
+        }
+    }
+    const Clock::time_point t3 = Clock::now();
+    job->renderUs = elapsedUs(t0, t1);
+    job->parseUs = elapsedUs(t1, t2);
+    job->trackUs = elapsedUs(t2, t3);
+    if (c.measuring.load(std::memory_order_relaxed)) {
+        w.samples.render.push_back(job->renderUs);
+        w.samples.parse.push_back(job->parseUs);
+        w.samples.track.push_back(job->trackUs);
+    }
+}
+
+// Global: one frame at a time across every source
+static void associateFrame(StepContext& c, FrameJob* job)
+{
+    const Clock::time_point t0 = Clock::now();
+    for (TrackedForAssociation& t : job->tracked) {
+        AssociationInput in;
+        in.camera = job->source;
+        in.localId = t.trackId;
+        in.confidence = t.confidence;
+        in.box = t.box;
+        in.embedding = t.embedding >= 0 ? &job->embeddings[(size_t)t.embedding * c.dim] : nullptr;
+        t.globalId = c.associator.associate(in, job->timestampUs);
+    }
+    for (const LostTrack& t : job->lost) {
+        c.associator.suspendLocalTrack(job->source, t.trackId, t.box, t.vx, t.vy, job->timestampUs);
+    }
+    for (uint64_t id : job->ended) {
+        c.associator.endLocalTrack(job->source, id);
+    }
+    if (job->timestampUs > c.lastExpireUs + 1000000) {
+        c.associator.expire(job->timestampUs);
+        c.lastExpireUs = job->timestampUs;
+    }
+    if (c.measuring.load(std::memory_order_relaxed)) {
+        c.serialSamples.associate.push_back(elapsedUs(t0, Clock::now()));
+    }
+}
+
+// Zone-entry and new-global-id triggers, then the job is done
+static void analyzeFrame(StepContext& c, FrameJob* job)
+{
+    const Clock::time_point t0 = Clock::now();
+    c.clipObjects.clear();
+    for (const TrackedForAssociation& t : job->tracked) {
+        c.clipObjects.push_back(
+            ClipTrackObject{t.trackId, (uint32_t)t.globalId, 0, t.box.left, t.box.top, t.box.width, t.box.height});
+    }
+    c.trigger.onFrame(job->source, job->timestampUs, c.sceneConfig.netWidth, c.sceneConfig.netHeight,
+                      c.clipObjects.data(), c.clipObjects.size());
+    const Clock::time_point t1 = Clock::now();
+    if (c.measuring.load(std::memory_order_relaxed)) {
+        c.serialSamples.analytics.push_back(elapsedUs(t0, t1));
+        c.serialSamples.latencyUs.push_back(elapsedUs(job->released, t1));
+        c.processed.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(c.freeMutex);
+        c.freeJobs[job->source].push_back(job);
+    }
+    c.inFlight.fetch_sub(1, std::memory_order_release);
+}
+
+// kShared: each stage hands the job on to the next stage's strand
+static void runAnalytics(SchedulerJob* j)
+{
+    FrameJob* job = static_cast<FrameJob*>(j);
+    analyzeFrame(*job->step, job);
+}
+
+static void runAssociate(SchedulerJob* j)
+{
+    FrameJob* job = static_cast<FrameJob*>(j);
+    StepContext& c = *job->step;
+    associateFrame(c, job);
+    job->run = &runAnalytics;
+    c.analyticsStrand->post(job);
+}
+
+static void runParse(SchedulerJob* j)
+{
+    FrameJob* job = static_cast<FrameJob*>(j);
+    StepContext& c = *job->step;
+    parseFrame(c, *c.workers[c.scheduler->currentWorker()], job);
+    job->run = &runAssociate;
+    c.associateStrand->post(job);
+}
+
+static StepResult runStep(uint32_t sources, SchedulerMode mode, const BenchOptions& opt)
+{
+    SyntheticSceneConfig sceneConfig = opt.scene;
+    sceneConfig.sources = sources;
+    SyntheticScene scene(sceneConfig);
+    const uint32_t rows = scene.rows();
+    const uint32_t dim = sceneConfig.embeddingDim;
+
+    // An entrance zone on the lower left of every camera
+    ClipTriggerConfig clips;
+    for (uint32_t s = 0; s < sources; ++s) {
+        clips.zones.push_back(ClipZone{"entrance", s, {0.05f, 0.55f, 0.35f, 0.55f, 0.35f, 1.0f, 0.05f, 1.0f}});
+    }
+    StepContext c(opt, sceneConfig, scene, clips);
+    for (uint32_t s = 0; s < sources; ++s) {
+        c.trackers.emplace_back(new IouTracker(opt.tracker));
+    }
+
+    // Per-source pools of free jobs; an empty pool means --queue frames
+    // of that source are still in flight
+    std::vector<FrameJob> jobs((size_t)sources * opt.queue);
+    c.freeJobs.resize(sources);
+    for (uint32_t s = 0; s < sources; ++s) {
+        for (uint32_t q = 0; q < opt.queue; ++q) {
+            FrameJob* job = &jobs[(size_t)s * opt.queue + q];
+            job->step = &c;
+            job->source = s;
+            c.freeJobs[s].push_back(job);
+        }
+    }
+
+    // Render, parse and track with sources sharded across the pool workers
+    // (a source is always on the same thread, so its tracker sees frames in
+    // order); association and analytics are global
+    uint32_t workers = std::max(1u, std::min(sources, opt.workers));
+    std::vector<JobQueue> workerQueues(mode == kPools ? workers : 0);
+    JobQueue assocQueue, analyticsQueue;
+    std::vector<std::thread> threads;
+    if (mode == kShared) {
+        SchedulerConfig schedulerConfig = opt.scheduler;
+        schedulerConfig.maxWorkers = opt.workers;
+        c.scheduler.reset(new WorkStealingScheduler(schedulerConfig));
+        workers = c.scheduler->workers();
+        for (uint32_t s = 0; s < sources; ++s) {
+            c.sourceStrands.emplace_back(new Strand(*c.scheduler));
+        }
+        c.associateStrand.reset(new Strand(*c.scheduler));
+        c.analyticsStrand.reset(new Strand(*c.scheduler));
+    }
+    for (uint32_t w = 0; w < workers; ++w) {
+        c.workers.emplace_back(new WorkerContext(rows, opt.channels, sceneConfig));
+    }
+    if (mode == kPools) {
+        for (uint32_t w = 0; w < workers; ++w) {
+            threads.emplace_back([&, w]() {
+                while (FrameJob* job = workerQueues[w].pop()) {
+                    parseFrame(c, *c.workers[w], job);
+                    assocQueue.push(job);
+                }
+            });
+        }
+        threads.emplace_back([&]() {
+            while (FrameJob* job = assocQueue.pop()) {
+                associateFrame(c, job);
+                analyticsQueue.push(job);
+            }
+        });
+        threads.emplace_back([&]() {
+            while (FrameJob* job = analyticsQueue.pop()) {
+                analyzeFrame(c, job);
+            }
+        });
+    }
+
+    // Release every source's frame once per frame period
+    const double fps = sceneConfig.fps;
+    const uint64_t warmupFrames = (uint64_t)(opt.warmup * fps);
+    const uint64_t totalFrames = warmupFrames + (uint64_t)(opt.seconds * fps);
+    uint64_t dropped = 0, released = 0, detectionsIn = 0;
+    double rssStart = 0.0, cpuStart = 0.0;
+    Clock::time_point measureStart;
+    const Clock::time_point start = Clock::now();
+    for (uint64_t f = 0; f < totalFrames; ++f) {
+        if (f == warmupFrames) {
+            rssStart = residentMb();
+            cpuStart = cpuSeconds();
+            measureStart = Clock::now();
+            c.measuring.store(true);
+        }
+        std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)(f * 1e6 / fps)));
+        if (f > 0) {
+            scene.step();
+        }
+        const Clock::time_point now = Clock::now();
+        for (uint32_t s = 0; s < sources; ++s) {
+            FrameJob* job = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(c.freeMutex);
+                if (!c.freeJobs[s].empty()) {
+                    job = c.freeJobs[s].back();
+                    c.freeJobs[s].pop_back();
+                }
+            }
+            const bool counted = f >= warmupFrames;
+            if (!job) {
+                dropped += counted ? 1 : 0;
+                continue;
+            }
+            const SceneFrame& frame = scene.frame(s);
+            job->timestampUs = frame.timestampUs;
+            job->released = now;
+            job->proposals = scene.proposals(s);
+            job->truth = frame.detections;
+            job->embeddings.resize(frame.detections.size() * dim);
+            scene.writeEmbeddings(s, job->embeddings.data());
+            released += counted ? 1 : 0;
+            detectionsIn += counted ? frame.detections.size() : 0;
+            c.inFlight.fetch_add(1, std::memory_order_relaxed);
+            if (mode == kShared) {
+                job->run = &runParse;
+                c.sourceStrands[s]->post(job);
+            } else {
+                workerQueues[s % workerQueues.size()].push(job);
+            }
+        }
+    }
+    const double measuredSec = std::chrono::duration<double>(Clock::now() - measureStart).count();
+    // Frames still queued at the end count as processed late, not dropped
+    if (mode == kShared) {
+        while (c.inFlight.load(std::memory_order_acquire) > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    } else {
+        for (JobQueue& q : workerQueues) {
+            q.close();
+        }
+        for (uint32_t w = 0; w < workerQueues.size(); ++w) {
+            threads[w].join();
+        }
+        assocQueue.close();
+        threads[workerQueues.size()].join();
+        analyticsQueue.close();
+        threads[workerQueues.size() + 1].join();
+    }
+    // CPU includes draining the queues, so divide by the wall time to match
+    const double cpuUsed = cpuSeconds() - cpuStart;
+    const double drainedSec = std::chrono::duration<double>(Clock::now() - measureStart).count();
+
+    StageSamples all = c.serialSamples;
+    for (const std::unique_ptr<WorkerContext>& w : c.workers) {
+        all.merge(w->samples);
+    }
+
+    StepResult r;
+    r.sources = sources;
+    r.scheduler = mode == kShared ? "shared" : "pools";
+    r.workers = mode == kShared ? workers : workers + 2;
+    r.offeredFps = sources * fps;
+    r.frames = c.processed.load();
+    r.achievedFps = measuredSec > 0.0 ? std::min(released, r.frames) / measuredSec : 0.0;
+    r.dropped = dropped;
+    r.render = stageStat(all.render);
+    r.parse = stageStat(all.parse);
+    r.track = stageStat(all.track);
+    r.associate = stageStat(all.associate);
+    r.analytics = stageStat(all.analytics);
+    r.latencyP50Ms = percentileMs(all.latencyUs, 0.50);
+    r.latencyP99Ms = percentileMs(all.latencyUs, 0.99);
+    r.cpuCores = drainedSec > 0.0 ? cpuUsed / drainedSec : 0.0;
+    r.rssStartMb = rssStart;
+    r.rssEndMb = residentMb();
+    r.associatorMb = c.associator.memoryBytes() / (1024.0 * 1024.0);
+    r.globalTracks = c.associator.globalTracks();
+    r.globalCreated = c.associator.stats().newTracks;
+    r.stitched = c.associator.stats().stitched;
+    uint64_t local = 0;
+    for (const auto& t : c.trackers) {
+        local += t->tracksCreated();
+    }
+    r.localTracks = local;
+    r.detections = detectionsIn;
+    r.clipEvents = c.clipEvents;
+    if (c.scheduler) {
+        r.schedulerStats = c.scheduler->stats();
+    }
+    r.keepsUp = dropped == 0 && r.achievedFps >= 0.98 * r.offeredFps && r.latencyP99Ms <= opt.budgetMs;
+    return r;
+}
+
+static std::string toJson(const StepResult& r)
+{
+    std::ostringstream os;
+    auto stage = [&os](const char* name, const StageStat& s, bool first) {
+        os << (first ? "" : ",") << "\"" << name << "\":{\"mean_us\":" << s.meanUs << ",\"p99_us\":" << s.p99Us
+           << ",\"fps_per_core\":" << s.fpsPerCore << "}";
+    };
+    os << "{\"sources\":" << r.sources << ",\"scheduler\":\"" << r.scheduler << "\",\"workers\":" << r.workers << ",\"offered_fps\":" << r.offeredFps
+       << ",\"achieved_fps\":" << r.achievedFps << ",\"frames\":" << r.frames << ",\"dropped\":" << r.dropped
+       << ",\"detections\":" << r.detections;
+    os << ",\"stages\":{";
+    stage("render", r.render, true);
+    stage("parse", r.parse, false);
+    stage("track", r.track, false);
+    stage("associate", r.associate, false);
+    stage("analytics", r.analytics, false);
+    os << "},\"latency_ms\":{\"p50\":" << r.latencyP50Ms << ",\"p99\":" << r.latencyP99Ms << "}"
+       << ",\"cpu_cores\":" << r.cpuCores << ",\"rss_mb\":{\"start\":" << r.rssStartMb << ",\"end\":" << r.rssEndMb
+       << ",\"growth\":" << r.rssEndMb - r.rssStartMb << "}"
+       << ",\"associator\":{\"global_tracks\":" << r.globalTracks << ",\"global_created\":" << r.globalCreated
+       << ",\"stitched\":" << r.stitched << ",\"local_tracks\":" << r.localTracks
+       << ",\"memory_mb\":" << r.associatorMb << "}"
+       << ",\"clip_events\":" << r.clipEvents;
+    if (std::string(r.scheduler) == "shared") {
+        const SchedulerStats& st = r.schedulerStats;
+        os << ",\"scheduler_stats\":{\"executed\":" << st.executed << ",\"stolen\":" << st.stolen
+           << ",\"injected\":" << st.injected << ",\"inlined\":" << st.inlined << ",\"parks\":" << st.parks << "}";
+    }
+    os << ",\"keeps_up\":" << (r.keepsUp ? "true" : "false") << "}";
+    return os.str();
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+    opt.workers = std::max(1u, std::thread::hardware_concurrency() > 2 ? std::thread::hardware_concurrency() - 2 : 1u);
+    std::vector<int> steps = {1, 2, 4, 8, 16, 32, 64};
+    std::string jsonPath;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--sources") {
+            steps.clear();
+            std::stringstream ss(v);
+            std::string item;
+            while (std::getline(ss, item, ';')) {
+                if (atoi(item.c_str()) > 0) {
+                    steps.push_back(atoi(item.c_str()));
+                }
+            }
+        } else if (a == "--seconds") {
+            opt.seconds = atof(v);
+        } else if (a == "--warmup") {
+            opt.warmup = atof(v);
+        } else if (a == "--workers") {
+            opt.workers = (uint32_t)std::max(1, atoi(v));
+        } else if (a == "--queue") {
+            opt.queue = (uint32_t)std::max(1, atoi(v));
+        } else if (a == "--layout") {
+            opt.channels = (uint32_t)atoi(v);
+        } else if (a == "--budget-ms") {
+            opt.budgetMs = atof(v);
+        } else if (a == "--scene") {
+            if (!SyntheticSceneConfig::load(v, opt.scene)) {
+                return 1;
+            }
+        } else if (a == "--tracking") {
+            if (!IouTrackerConfig::load(v, opt.tracker) || !AssociatorConfig::load(v, opt.associator)) {
+                return 1;
+            }
+        } else if (a == "--scheduler") {
+            const std::string m = v;
+            if (m == "pools") {
+                opt.modes = {kPools};
+            } else if (m == "shared") {
+                opt.modes = {kShared};
+            } else if (m == "both") {
+                opt.modes = {kPools, kShared};
+            } else {
+                fprintf(stderr, "ERROR: --scheduler must be pools, shared or both\n");
+                return 1;
+            }
+        } else if (a == "--scheduler-config") {
+            if (!SchedulerConfig::load(v, opt.scheduler)) {
+                return 1;
+            }
+        } else if (a == "--json") {
+            jsonPath = v;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+    if ((opt.channels != 6 && opt.channels != 85) || steps.empty()) {
+        fprintf(stderr, "ERROR: --layout must be 6 or 85 and --sources non-empty\n");
+        return 1;
+    }
+    FILE* json = nullptr;
+    if (!jsonPath.empty()) {
+        json = jsonPath == "-" ? stdout : fopen(jsonPath.c_str(), "w");
+        if (!json) {
+            fprintf(stderr, "ERROR: Cannot create %s\n", jsonPath.c_str());
+            return 1;
+        }
+    }
+
+    printf("%7s %6s %7s %8s %8s %6s | %8s %8s %8s %8s %8s | %8s %8s | %5s %8s %7s %6s %7s %6s %s\n",
+           "sources", "sched", "threads", "offered", "achieved", "drop", "parse", "track", "assoc", "assoc99",
+           "analyt", "lat_p50", "lat_p99", "cores", "rss_grow", "gallery", "gal_mb", "created", "stitch", "ok");
+    for (int sources : steps) {
+        for (SchedulerMode mode : opt.modes) {
+            const StepResult r = runStep((uint32_t)sources, mode, opt);
+            printf("%7u %6s %7u %8.0f %8.1f %6llu | %7.0fu %7.0fu %7.0fu %7.0fu %7.0fu | %7.1fm %7.1fm | %5.2f "
+                   "%7.1fM %7llu %6.1f %7llu %6llu %s\n",
+                   r.sources, r.scheduler, r.workers, r.offeredFps, r.achievedFps, (unsigned long long)r.dropped,
+                   r.parse.meanUs, r.track.meanUs, r.associate.meanUs, r.associate.p99Us, r.analytics.meanUs,
+                   r.latencyP50Ms, r.latencyP99Ms, r.cpuCores, r.rssEndMb - r.rssStartMb,
+                   (unsigned long long)r.globalTracks, r.associatorMb, (unsigned long long)r.globalCreated,
+                   (unsigned long long)r.stitched, r.keepsUp ? "yes" : "NO");
+            fflush(stdout);
+            if (json) {
+                fprintf(json, "%s\n", toJson(r).c_str());
+                fflush(json);
+            }
+        }
+    }
+    if (json && json != stdout) {
+        fclose(json);
+    }
+    return 0;
+}
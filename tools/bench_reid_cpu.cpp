@@ -0,0 +1,384 @@
+/*
+ * ReID embedding throughput on the ONNX Runtime CPU execution provider
+ *
+ * Runs tracking_native/reid_embedder.h on person-sized crops of synthetic
+ * RGBA frames and sweeps the batch size and the intra-op pool size, so an
+ * edge box without a GPU can be sized for ReID. Each step runs --instances
+ * embedders side by side, one per thread, on disjoint CPUs (from the
+ * config's cpus, else the process affinity mask): instance i gets
+ * `threads` CPUs, pins its own thread to the first and ONNX Runtime's pool
+ * to the rest.
+ *
+ * Per step: crops per second, crops per second per core (crops over CPU
+ * seconds, the number to size hardware with), cores used, p50/p99 batch
+ * latency and the share of time spent cropping/resizing. Before the sweep
+ * one crop is embedded alone and inside a full batch; the two embeddings
+ * must match (max abs difference is printed), which checks the batch
+ * bindings.
+ *
+ * Output: a table on stdout and, with --json, one JSON object per step.
+ *
+ * Needs ONNX Runtime: make WITH_ONNXRUNTIME=1 ORT_DIR=/opt/onnxruntime
+ *
+ * Usage: bench_reid_cpu [--config configs/reid/reid_cpu_embedder.txt] [--model path.onnx]
+ *            [--batches 1;4;8;16] [--threads 1;2;4] [--instances 1]
+ *            [--seconds 5] [--warmup 1] [--json results.jsonl]
+ */
+
+#include "reid_embedder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const uint32_t kFrameWidth = 1920;
+static const uint32_t kFrameHeight = 1080;
+static const uint32_t kCropCount = 256;
+
+struct BenchOptions
+{
+    ReidEmbedderConfig embedder;
+    std::vector<int> batches = {1, 4, 8, 16};
+    std::vector<int> threads = {1, 2, 4};
+    uint32_t instances = 1;
+    double seconds = 5.0;
+    double warmup = 1.0;
+};
+
+struct StepResult
+{
+    uint32_t batch = 0;
+    uint32_t threads = 0;
+    uint32_t instances = 0;
+    uint64_t crops = 0;
+    double cropsPerSec = 0.0;
+    double cropsPerCore = 0.0;
+    double cpuCores = 0.0;
+    double batchP50Ms = 0.0;
+    double batchP99Ms = 0.0;
+    double preprocessShare = 0.0;
+};
+
+static double cpuSeconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static std::vector<int> parseList(const char* v)
+{
+    std::vector<int> out;
+    std::stringstream ss(v);
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+        if (atoi(item.c_str()) > 0) {
+            out.push_back(atoi(item.c_str()));
+        }
+    }
+    return out;
+}
+
+static std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) {
+                cpus.push_back(c);
+            }
+        }
+    }
+    return cpus;
+}
+
+static void pinThread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        fprintf(stderr, "WARNING: Cannot pin to CPU %d\n", cpu);
+    }
+}
+
+// Textured frame (so resizing reads real data) and person-shaped boxes
+static void makeScene(std::vector<uint8_t>& frame, std::vector<TrackBox>& boxes)
+{
+    std::mt19937 rng(7);
+    frame.resize((size_t)kFrameWidth * kFrameHeight * 4);
+    for (uint32_t y = 0; y < kFrameHeight; ++y) {
+        uint8_t* row = &frame[(size_t)y * kFrameWidth * 4];
+        for (uint32_t x = 0; x < kFrameWidth; ++x) {
+            row[x * 4 + 0] = (uint8_t)(x * 7 + y * 3 + (rng() & 15));
+            row[x * 4 + 1] = (uint8_t)(x * 2 + y * 5);
+            row[x * 4 + 2] = (uint8_t)((x ^ y) + (rng() & 31));
+            row[x * 4 + 3] = 255;
+        }
+    }
+    std::uniform_real_distribution<float> height(60.0f, 480.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    boxes.clear();
+    for (uint32_t i = 0; i < kCropCount; ++i) {
+        const float h = height(rng);
+        const float w = h * (0.35f + 0.15f * unit(rng));
+        boxes.push_back({unit(rng) * (kFrameWidth - w), unit(rng) * (kFrameHeight - h), w, h});
+    }
+}
+
+static double percentileMs(std::vector<uint32_t>& us, double q)
+{
+    if (us.empty()) {
+        return 0.0;
+    }
+    const size_t k = std::min(us.size() - 1, (size_t)(q * us.size()));
+    std::nth_element(us.begin(), us.begin() + k, us.end());
+    return us[k] / 1000.0;
+}
+
+struct InstanceContext
+{
+    std::unique_ptr<ReidEmbedder> embedder;
+    int callerCpu = -1;
+    std::vector<uint32_t> batchUs;
+    uint64_t crops = 0;
+    ReidEmbedderStats statsStart;  // when measuring began
+    bool measured = false;
+    bool failed = false;
+};
+
+static bool runStep(uint32_t batch, uint32_t threads, const BenchOptions& opt, const std::vector<ReidCrop>& crops,
+                    StepResult& r)
+{
+    const std::vector<int> pool = opt.embedder.cpus.empty() ? allowedCpus() : opt.embedder.cpus;
+    const bool pin = pool.size() >= (size_t)threads * opt.instances;
+    if (!pin) {
+        fprintf(stderr, "WARNING: %u x %u threads need more than %zu CPUs, not pinning\n", opt.instances, threads,
+                pool.size());
+    }
+
+    std::vector<InstanceContext> instances(opt.instances);
+    for (uint32_t i = 0; i < opt.instances; ++i) {
+        ReidEmbedderConfig c = opt.embedder;
+        c.intraOpThreads = threads;
+        c.cpus.clear();
+        if (pin) {
+            c.cpus.assign(pool.begin() + i * threads, pool.begin() + (i + 1) * threads);
+            instances[i].callerCpu = c.cpus[0];
+        }
+        instances[i].embedder = ReidEmbedder::create(c);
+        if (!instances[i].embedder) {
+            return false;
+        }
+    }
+
+    std::atomic<bool> measuring(false);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < opt.instances; ++i) {
+        workers.emplace_back([&, i]() {
+            InstanceContext& ctx = instances[i];
+            if (ctx.callerCpu >= 0) {
+                pinThread(ctx.callerCpu);
+            }
+            std::vector<float> embeddings((size_t)batch * ctx.embedder->embeddingDim());
+            size_t next = (size_t)i * batch;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (next + batch > crops.size()) {
+                    next = 0;
+                }
+                const bool measure = measuring.load(std::memory_order_relaxed);
+                if (measure && !ctx.measured) {
+                    ctx.statsStart = ctx.embedder->stats();
+                    ctx.measured = true;
+                }
+                const Clock::time_point start = Clock::now();
+                if (!ctx.embedder->embed(&crops[next], batch, embeddings.data())) {
+                    ctx.failed = true;
+                    return;
+                }
+                next += batch;
+                if (measure) {
+                    ctx.batchUs.push_back(
+                        (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+                    ctx.crops += batch;
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.warmup));
+    const double cpuStart = cpuSeconds();
+    const Clock::time_point wallStart = Clock::now();
+    measuring.store(true);
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.seconds));
+    stop.store(true);
+    for (std::thread& t : workers) {
+        t.join();
+    }
+    // The last batch of each instance runs past the window; count it
+    const double wall = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    const double cpu = cpuSeconds() - cpuStart;
+
+    std::vector<uint32_t> batchUs;
+    uint64_t preprocessUs = 0, inferenceUs = 0;
+    r = StepResult();
+    for (InstanceContext& ctx : instances) {
+        if (ctx.failed) {
+            return false;
+        }
+        r.crops += ctx.crops;
+        batchUs.insert(batchUs.end(), ctx.batchUs.begin(), ctx.batchUs.end());
+        preprocessUs += ctx.embedder->stats().preprocessUs - ctx.statsStart.preprocessUs;
+        inferenceUs += ctx.embedder->stats().inferenceUs - ctx.statsStart.inferenceUs;
+    }
+    r.batch = batch;
+    r.threads = threads;
+    r.instances = opt.instances;
+    r.cropsPerSec = wall > 0.0 ? r.crops / wall : 0.0;
+    r.cropsPerCore = cpu > 0.0 ? r.crops / cpu : 0.0;
+    r.cpuCores = wall > 0.0 ? cpu / wall : 0.0;
+    r.batchP50Ms = percentileMs(batchUs, 0.50);
+    r.batchP99Ms = percentileMs(batchUs, 0.99);
+    r.preprocessShare =
+        preprocessUs + inferenceUs > 0 ? (double)preprocessUs / (double)(preprocessUs + inferenceUs) : 0.0;
+    return true;
+}
+
+// Embedding of crop 0 alone vs as the last of a full batch
+static bool checkBatching(const BenchOptions& opt, const std::vector<ReidCrop>& crops)
+{
+    std::unique_ptr<ReidEmbedder> embedder = ReidEmbedder::create(opt.embedder);
+    if (!embedder) {
+        return false;
+    }
+    const uint32_t dim = embedder->embeddingDim();
+    const uint32_t n = embedder->maxBatch();
+    std::vector<ReidCrop> batch(crops.begin() + 1, crops.begin() + n);
+    batch.push_back(crops[0]);
+    std::vector<float> alone(dim), batched((size_t)n * dim);
+    if (!embedder->embed(&crops[0], 1, alone.data()) || !embedder->embed(batch.data(), n, batched.data())) {
+        return false;
+    }
+    float diff = 0.0f, norm = 0.0f;
+    for (uint32_t k = 0; k < dim; ++k) {
+        diff = std::max(diff, std::fabs(alone[k] - batched[(size_t)(n - 1) * dim + k]));
+        norm += alone[k] * alone[k];
+    }
+    printf("model %ux%u -> %u, max batch %u: batch-of-%u vs single max abs diff %.2e (|e| %.3f)\n",
+           embedder->inputWidth(), embedder->inputHeight(), dim, n, n, diff, std::sqrt(norm));
+    return diff <= 1e-3f * std::max(1.0f, std::sqrt(norm));
+}
+
+static std::string toJson(const StepResult& r)
+{
+    std::ostringstream os;
+    os << "{\"batch\":" << r.batch << ",\"intra_op_threads\":" << r.threads << ",\"instances\":" << r.instances
+       << ",\"crops\":" << r.crops << ",\"crops_per_sec\":" << r.cropsPerSec
+       << ",\"crops_per_sec_per_core\":" << r.cropsPerCore << ",\"cpu_cores\":" << r.cpuCores
+       << ",\"batch_ms\":{\"p50\":" << r.batchP50Ms << ",\"p99\":" << r.batchP99Ms << "}"
+       << ",\"preprocess_share\":" << r.preprocessShare << "}";
+    return os.str();
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+    std::string jsonPath;
+    std::string model;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--config") {
+            if (!ReidEmbedderConfig::load(v, opt.embedder)) {
+                return 1;
+            }
+        } else if (a == "--model") {
+            model = v;
+        } else if (a == "--batches") {
+            opt.batches = parseList(v);
+        } else if (a == "--threads") {
+            opt.threads = parseList(v);
+        } else if (a == "--instances") {
+            opt.instances = (uint32_t)std::max(1, atoi(v));
+        } else if (a == "--seconds") {
+            opt.seconds = atof(v);
+        } else if (a == "--warmup") {
+            opt.warmup = atof(v);
+        } else if (a == "--json") {
+            jsonPath = v;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+    if (!model.empty()) {
+        opt.embedder.model = model;
+    }
+    if (opt.batches.empty() || opt.threads.empty()) {
+        fprintf(stderr, "ERROR: --batches and --threads must be non-empty\n");
+        return 1;
+    }
+    FILE* json = nullptr;
+    if (!jsonPath.empty()) {
+        json = jsonPath == "-" ? stdout : fopen(jsonPath.c_str(), "w");
+        if (!json) {
+            fprintf(stderr, "ERROR: Cannot create %s\n", jsonPath.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> frame;
+    std::vector<TrackBox> boxes;
+    makeScene(frame, boxes);
+    std::vector<ReidCrop> crops;
+    for (const TrackBox& box : boxes) {
+        crops.push_back({frame.data(), kFrameWidth, kFrameHeight, kFrameWidth * 4, kReidRgba, box});
+    }
+    if (!checkBatching(opt, crops)) {
+        fprintf(stderr, "ERROR: Batched embeddings differ from single-crop ones\n");
+        return 1;
+    }
+
+    printf("%5s %7s %9s | %9s %13s %6s | %8s %8s | %6s\n", "batch", "threads", "instances", "crops/s",
+           "crops/s/core", "cores", "batch50", "batch99", "prep%");
+    for (int threads : opt.threads) {
+        for (int batch : opt.batches) {
+            if ((uint32_t)batch > opt.embedder.maxBatch) {
+                continue;
+            }
+            StepResult r;
+            if (!runStep((uint32_t)batch, (uint32_t)threads, opt, crops, r)) {
+                return 1;
+            }
+            printf("%5u %7u %9u | %9.1f %13.1f %6.2f | %7.1fm %7.1fm | %5.1f%%\n", r.batch, r.threads,
+                   r.instances, r.cropsPerSec, r.cropsPerCore, r.cpuCores, r.batchP50Ms, r.batchP99Ms,
+                   100.0 * r.preprocessShare);
+            fflush(stdout);
+            if (json) {
+                fprintf(json, "%s\n", toJson(r).c_str());
+                fflush(json);
+            }
+        }
+    }
+    if (json && json != stdout) {
+        fclose(json);
+    }
+    return 0;
+}
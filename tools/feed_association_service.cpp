@@ -0,0 +1,227 @@
+/*
+ * Streams a synthetic scene into the native association service
+ *
+ * Runs a SyntheticScene (see synthetic_scene.h) through one IouTracker per
+ * source, as the pipeline does, and sends every frame of tracker output in
+ * the service wire format (see association_service.h) over its Unix socket
+ * or TCP port. Reports the rate the service accepted frames at; with
+ * --rate 0 frames are sent as fast as back-pressure allows.
+ *
+ * Usage: feed_association_service [--scene configs/synthetic_scene.txt]
+ *            [--tracking configs/tracking_native.txt] [--sources N] [--seconds 60]
+ *            [--rate 1.0] [--no-embeddings 1]
+ *            (--socket /tmp/deepstream-association.sock | --port N)
+ */
+
+#include "association_service.h"
+#include "iou_tracker.h"
+#include "synthetic_scene.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static int connectTo(const std::string& socketPath, int port)
+{
+    if (port > 0) {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        return fd;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return -1;
+}
+
+static bool sendAll(int fd, const void* data, size_t length)
+{
+    const char* p = (const char*)data;
+    while (length > 0) {
+        const ssize_t n = send(fd, p, length, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    SyntheticSceneConfig sceneConfig;
+    IouTrackerConfig trackerConfig;
+    AssociatorConfig associatorConfig;
+    std::string socketPath = "/tmp/deepstream-association.sock";
+    double seconds = 60.0, rate = 1.0;
+    int sources = -1, port = 0;
+    bool withEmbeddings = true;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--scene") {
+            if (!SyntheticSceneConfig::load(v, sceneConfig)) {
+                return 1;
+            }
+        } else if (a == "--tracking") {
+            if (!IouTrackerConfig::load(v, trackerConfig) || !AssociatorConfig::load(v, associatorConfig)) {
+                return 1;
+            }
+        } else if (a == "--sources") {
+            sources = atoi(v);
+        } else if (a == "--seconds") {
+            seconds = atof(v);
+        } else if (a == "--rate") {
+            rate = atof(v);
+        } else if (a == "--no-embeddings") {
+            withEmbeddings = atoi(v) == 0;
+        } else if (a == "--socket") {
+            socketPath = v;
+        } else if (a == "--port") {
+            port = atoi(v);
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+    if (seconds <= 0.0 || rate < 0.0) {
+        fprintf(stderr, "ERROR: --seconds must be positive and --rate not negative\n");
+        return 1;
+    }
+    if (sources > 0) {
+        sceneConfig.sources = (uint32_t)sources;
+    }
+
+    const int fd = connectTo(socketPath, port);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Cannot connect to %s\n", port > 0 ? std::to_string(port).c_str() : socketPath.c_str());
+        return 1;
+    }
+
+    SyntheticScene scene(sceneConfig);
+    const uint32_t dim = sceneConfig.embeddingDim;
+    const float fps = (float)sceneConfig.fps;
+    std::vector<std::unique_ptr<IouTracker>> trackers;
+    for (uint32_t s = 0; s < sceneConfig.sources; ++s) {
+        trackers.emplace_back(new IouTracker(trackerConfig));
+    }
+
+    std::vector<TrackerDetection> detections;
+    std::vector<TrackedObject> active;
+    std::vector<TerminatedTrack> terminated;
+    std::vector<float> embeddings, wireEmbeddings;
+    std::vector<ServiceDetection> wire;
+    uint64_t sentFrames = 0, sentDetections = 0, bytes = 0;
+    const uint64_t frames = (uint64_t)(seconds * sceneConfig.fps);
+    const Clock::time_point start = Clock::now();
+    for (uint64_t f = 0; f < frames; ++f) {
+        scene.step();
+        for (uint32_t s = 0; s < sceneConfig.sources; ++s) {
+            const SceneFrame& frame = scene.frame(s);
+            detections.clear();
+            for (const SceneDetection& d : frame.detections) {
+                detections.push_back(TrackerDetection{{d.x1, d.y1, d.x2 - d.x1, d.y2 - d.y1}, d.confidence, 0});
+            }
+            embeddings.resize(frame.detections.size() * (size_t)dim);
+            scene.writeEmbeddings(s, embeddings.data());
+            trackers[s]->update(detections, active, terminated);
+
+            // Lost and ended tracks carry a zero embedding to keep rows aligned
+            wire.clear();
+            wireEmbeddings.clear();
+            for (const TrackedObject& o : active) {
+                if (!o.confirmed) {
+                    continue;
+                }
+                ServiceDetection d;
+                d.localId = o.trackId;
+                d.confidence = o.confidence;
+                d.box = o.box;
+                d.vx = o.vx * fps;
+                d.vy = o.vy * fps;
+                if (o.detection == TrackedObject::kNoDetection) {
+                    if (o.missed != associatorConfig.stitching.lostAfterFrames) {
+                        continue;
+                    }
+                    d.event = kServiceLost;
+                    wireEmbeddings.resize(wireEmbeddings.size() + dim, 0.0f);
+                } else {
+                    d.event = kServiceObserve;
+                    const float* e = &embeddings[(size_t)o.detection * dim];
+                    wireEmbeddings.insert(wireEmbeddings.end(), e, e + dim);
+                }
+                wire.push_back(d);
+            }
+            for (const TerminatedTrack& t : terminated) {
+                if (t.confirmed) {
+                    ServiceDetection d;
+                    memset(&d, 0, sizeof(d));
+                    d.localId = t.trackId;
+                    d.event = kServiceEnded;
+                    wire.push_back(d);
+                    wireEmbeddings.resize(wireEmbeddings.size() + dim, 0.0f);
+                }
+            }
+
+            ServiceFrameHeader header;
+            header.magic = ASSOCIATION_WIRE_MAGIC;
+            header.camera = s;
+            header.timestampUs = frame.timestampUs;
+            header.count = (uint32_t)wire.size();
+            header.embeddingDim = withEmbeddings ? dim : 0;
+            const size_t embeddingBytes = withEmbeddings ? wireEmbeddings.size() * sizeof(float) : 0;
+            if (!sendAll(fd, &header, sizeof(header)) ||
+                !sendAll(fd, wire.data(), wire.size() * sizeof(ServiceDetection)) ||
+                !sendAll(fd, wireEmbeddings.data(), embeddingBytes)) {
+                fprintf(stderr, "ERROR: The service closed the connection after %llu frames\n",
+                        (unsigned long long)sentFrames);
+                close(fd);
+                return 1;
+            }
+            sentFrames++;
+            sentDetections += wire.size();
+            bytes += sizeof(header) + wire.size() * sizeof(ServiceDetection) + embeddingBytes;
+        }
+        if (rate > 0.0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)((f + 1) * 1e6 / fps / rate)));
+        }
+    }
+    close(fd);
+
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("%llu frames, %llu detections, %.1f MB in %.2f s: %.0f frames/s, %.0f detections/s\n",
+           (unsigned long long)sentFrames, (unsigned long long)sentDetections, bytes / 1e6, elapsed,
+           sentFrames / elapsed, sentDetections / elapsed);
+    return 0;
+}
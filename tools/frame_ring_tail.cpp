@@ -0,0 +1,51 @@
+/*
+ * Minimal sidecar consumer for the shared-memory frame ring
+ *
+ * Attaches to a running pipeline's ring and prints one line per frame.
+ * Serves as a reference for writing out-of-process consumers.
+ *
+ * Usage: frame_ring_tail <ring-name> [--from-oldest]
+ */
+
+#include "frame_meta_ring.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <ring-name> [--from-oldest]\n", argv[0]);
+        return 1;
+    }
+    const bool fromOldest = argc > 2 && strcmp(argv[2], "--from-oldest") == 0;
+
+    std::unique_ptr<FrameRingConsumer> consumer = FrameRingConsumer::open(argv[1], fromOldest);
+    if (!consumer) {
+        return 1;
+    }
+
+    FrameRecord* rec = new FrameRecord;
+    uint64_t reportedOverruns = 0;
+    while (true) {
+        if (!consumer->next(*rec)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (consumer->overruns() != reportedOverruns) {
+            printf("# skipped %llu overwritten records\n",
+                   (unsigned long long)(consumer->overruns() - reportedOverruns));
+            reportedOverruns = consumer->overruns();
+        }
+        printf("seq=%llu source=%u frame=%u objects=%u", (unsigned long long)rec->sequence, rec->sourceId,
+               rec->frameNum, rec->numObjects);
+        for (uint16_t i = 0; i < rec->numObjects; ++i) {
+            const FrameRecordObject& o = rec->objects[i];
+            printf(" [%llu/%u c%u %.0f,%.0f,%.0fx%.0f]", (unsigned long long)o.trackId, o.globalId, o.classId,
+                   o.left, o.top, o.width, o.height);
+        }
+        printf("\n");
+    }
+}
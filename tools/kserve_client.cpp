@@ -0,0 +1,235 @@
+/*
+ * Minimal KServe v2 (Triton HTTP) client
+ */
+
+#include "kserve_client.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+KServeClient::KServeClient(const std::string& url) : m_Port("80"), m_Fd(-1)
+{
+    std::string rest = url;
+    const size_t scheme = rest.find("://");
+    if (scheme != std::string::npos) {
+        rest = rest.substr(scheme + 3);
+    }
+    rest = rest.substr(0, rest.find('/'));
+    const size_t colon = rest.rfind(':');
+    if (colon != std::string::npos) {
+        m_Host = rest.substr(0, colon);
+        m_Port = rest.substr(colon + 1);
+    } else {
+        m_Host = rest;
+    }
+}
+
+KServeClient::~KServeClient()
+{
+    if (m_Fd >= 0) {
+        close(m_Fd);
+    }
+}
+
+bool KServeClient::connectSocket()
+{
+    if (m_Fd >= 0) {
+        return true;
+    }
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+    if (getaddrinfo(m_Host.c_str(), m_Port.c_str(), &hints, &res) != 0) {
+        m_Error = "cannot resolve " + m_Host;
+        return false;
+    }
+    for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+        const int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            m_Fd = fd;
+            break;
+        }
+        close(fd);
+    }
+    freeaddrinfo(res);
+    if (m_Fd < 0) {
+        m_Error = "cannot connect to " + m_Host + ":" + m_Port;
+        return false;
+    }
+    return true;
+}
+
+bool KServeClient::sendAll(const void* data, size_t len)
+{
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        const ssize_t n = send(m_Fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+bool KServeClient::request(const std::string& method, const std::string& path, const std::string& extraHeaders,
+                           const void* body1, size_t len1, const void* body2, size_t len2, int& status,
+                           std::string& body)
+{
+    // One retry on a fresh connection: the server may have closed an idle
+    // keep-alive socket since the last request
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!connectSocket()) {
+            return false;
+        }
+        std::ostringstream head;
+        head << method << " " << path << " HTTP/1.1\r\n"
+             << "Host: " << m_Host << "\r\n"
+             << "Content-Length: " << len1 + len2 << "\r\n"
+             << extraHeaders << "\r\n";
+        const std::string h = head.str();
+        if (!sendAll(h.data(), h.size()) || (len1 && !sendAll(body1, len1)) || (len2 && !sendAll(body2, len2))) {
+            close(m_Fd);
+            m_Fd = -1;
+            continue;
+        }
+
+        std::string in;
+        char buf[16384];
+        size_t headerEnd = std::string::npos;
+        while (headerEnd == std::string::npos) {
+            const ssize_t n = recv(m_Fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                break;
+            }
+            in.append(buf, (size_t)n);
+            headerEnd = in.find("\r\n\r\n");
+        }
+        if (headerEnd == std::string::npos) {
+            close(m_Fd);
+            m_Fd = -1;
+            continue;
+        }
+
+        status = atoi(in.c_str() + in.find(' ') + 1);
+        size_t contentLength = 0;
+        const std::string headers = in.substr(0, headerEnd);
+        std::string lower = headers;
+        for (char& c : lower) {
+            c = (char)tolower(c);
+        }
+        const size_t cl = lower.find("content-length:");
+        if (cl != std::string::npos) {
+            contentLength = strtoul(headers.c_str() + cl + 15, nullptr, 10);
+        }
+
+        body = in.substr(headerEnd + 4);
+        while (body.size() < contentLength) {
+            const ssize_t n = recv(m_Fd, buf, std::min(sizeof(buf), contentLength - body.size()), 0);
+            if (n <= 0) {
+                m_Error = "connection closed mid-response";
+                close(m_Fd);
+                m_Fd = -1;
+                return false;
+            }
+            body.append(buf, (size_t)n);
+        }
+        if (lower.find("connection: close") != std::string::npos) {
+            close(m_Fd);
+            m_Fd = -1;
+        }
+        return true;
+    }
+    m_Error = "request to " + path + " failed";
+    return false;
+}
+
+bool KServeClient::ready()
+{
+    int status = 0;
+    std::string body;
+    return request("GET", "/v2/health/ready", "", nullptr, 0, nullptr, 0, status, body) && status == 200;
+}
+
+bool KServeClient::infer(const std::string& model, const std::string& inputName,
+                         const std::vector<int64_t>& elementShape, uint32_t batch, const float* data,
+                         const std::string& outputName)
+{
+    size_t elements = batch;
+    std::ostringstream shape;
+    shape << "[" << batch;
+    for (int64_t d : elementShape) {
+        shape << "," << d;
+        elements *= (size_t)d;
+    }
+    shape << "]";
+    const size_t bytes = elements * sizeof(float);
+
+    std::ostringstream json;
+    json << "{\"inputs\":[{\"name\":\"" << inputName << "\",\"shape\":" << shape.str()
+         << ",\"datatype\":\"FP32\",\"parameters\":{\"binary_data_size\":" << bytes << "}}],"
+         << "\"outputs\":[{\"name\":\"" << outputName << "\",\"parameters\":{\"binary_data\":true}}]}";
+    const std::string header = json.str();
+
+    std::ostringstream extra;
+    extra << "Content-Type: application/octet-stream\r\n"
+          << "Inference-Header-Content-Length: " << header.size() << "\r\n";
+
+    int status = 0;
+    std::string body;
+    if (!request("POST", "/v2/models/" + model + "/infer", extra.str(), header.data(), header.size(), data, bytes,
+                 status, body)) {
+        return false;
+    }
+    if (status != 200) {
+        m_Error = "infer returned HTTP " + std::to_string(status) + ": " + body.substr(0, 200);
+        return false;
+    }
+    return true;
+}
+
+bool KServeClient::loadModel(const std::string& model, const std::string& configJson)
+{
+    // The override travels as a JSON string inside the JSON body
+    std::string escaped;
+    for (char c : configJson) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    const std::string body = "{\"parameters\":{\"config\":\"" + escaped + "\"}}";
+
+    int status = 0;
+    std::string response;
+    if (!request("POST", "/v2/repository/models/" + model + "/load", "Content-Type: application/json\r\n",
+                 body.data(), body.size(), nullptr, 0, status, response)) {
+        return false;
+    }
+    if (status != 200) {
+        m_Error = "load returned HTTP " + std::to_string(status) + ": " + response.substr(0, 200);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+ * Minimal KServe v2 (Triton HTTP) client
+ *
+ * Just enough HTTP/1.1 over a keep-alive socket for load generation: binary
+ * tensor inference requests (the binary_data extension, so a 640x640 image
+ * is not turned into JSON text) and repository load with a config override.
+ * No TLS, chunked encoding or redirects. One client per thread.
+ */
+
+#ifndef __KSERVE_CLIENT_H__
+#define __KSERVE_CLIENT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class KServeClient
+{
+public:
+    // url: http://host:port
+    explicit KServeClient(const std::string& url);
+    ~KServeClient();
+
+    bool ready();
+
+    // One FP32 inference of `batch` elements of `elementShape`. `data` must
+    // hold batch * product(elementShape) floats. The response body is read
+    // and discarded.
+    bool infer(const std::string& model, const std::string& inputName, const std::vector<int64_t>& elementShape,
+               uint32_t batch, const float* data, const std::string& outputName);
+
+    // POST /v2/repository/models/<model>/load with a JSON config override
+    // (needs tritonserver --model-control-mode=explicit)
+    bool loadModel(const std::string& model, const std::string& configJson);
+
+    const std::string& lastError() const { return m_Error; }
+
+private:
+    bool connectSocket();
+    bool request(const std::string& method, const std::string& path, const std::string& extraHeaders,
+                 const void* body1, size_t len1, const void* body2, size_t len2, int& status, std::string& body);
+    bool sendAll(const void* data, size_t len);
+
+    std::string m_Host;
+    std::string m_Port;
+    int m_Fd;
+    std::string m_Error;
+};
+
+#endif
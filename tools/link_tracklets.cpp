@@ -0,0 +1,138 @@
+/*
+ * Offline tracklet linking over a recorded detection log
+ *
+ * Reads a columnar detection log (see detection_log.h), links its
+ * tracklets into identities with TrackletLinker (min-cost assignment, see
+ * tracklet_linker.h) and writes the result back into the log as the
+ * offline_id column, row for row.
+ *
+ * When the log carries ground truth (identity.npy, e.g. from
+ * record_detection_log) the online global_id and the offline_id columns
+ * are scored the same way:
+ *
+ *   ids/person  distinct ids given to one identity (1.0 is ideal)
+ *   wrong       detections whose id mostly belongs to another identity
+ *
+ * Usage: link_tracklets [--config configs/tracklet_linking.txt] [--threads N]
+ *            [--column offline_id] [--dry-run] <log-dir>
+ */
+
+#include "detection_log.h"
+#include "tracklet_linker.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Score
+{
+    double idsPerIdentity;
+    double wrongFraction;
+    uint64_t ids;
+};
+
+static Score score(const uint64_t* ids, const uint64_t* identity, uint64_t rows)
+{
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>> byIdentity, byId;
+    for (uint64_t r = 0; r < rows; ++r) {
+        // Id 0: the online associator had not decided yet (decision-window-ms)
+        if (identity[r] != 0 && ids[r] != 0) {
+            byIdentity[identity[r]][ids[r]]++;
+            byId[ids[r]][identity[r]]++;
+        }
+    }
+    Score s;
+    uint64_t sum = 0;
+    for (const auto& kv : byIdentity) {
+        sum += kv.second.size();
+    }
+    s.idsPerIdentity = byIdentity.empty() ? 0.0 : (double)sum / byIdentity.size();
+    uint64_t total = 0, wrong = 0;
+    for (const auto& kv : byId) {
+        uint64_t n = 0, majority = 0;
+        for (const auto& c : kv.second) {
+            n += c.second;
+            majority = std::max(majority, c.second);
+        }
+        total += n;
+        wrong += n - majority;
+    }
+    s.wrongFraction = total ? (double)wrong / total : 0.0;
+    s.ids = byId.size();
+    return s;
+}
+
+int main(int argc, char** argv)
+{
+    LinkerConfig config;
+    std::string dir, column = "offline_id";
+    int threads = -1;
+    bool dryRun = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--dry-run") {
+            dryRun = true;
+        } else if (a == "--config" && i + 1 < argc) {
+            if (!LinkerConfig::load(argv[++i], config)) {
+                return 1;
+            }
+        } else if (a == "--threads" && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (a == "--column" && i + 1 < argc) {
+            column = argv[++i];
+        } else if (a.compare(0, 2, "--") != 0 && dir.empty()) {
+            dir = a;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+    if (dir.empty()) {
+        fprintf(stderr, "Usage: %s [--config file] [--threads N] [--column name] [--dry-run] <log-dir>\n", argv[0]);
+        return 1;
+    }
+    if (threads >= 0) {
+        config.threads = (uint32_t)threads;
+    }
+
+    std::unique_ptr<DetectionLog> log = DetectionLog::open(dir);
+    if (!log) {
+        return 1;
+    }
+    TrackletLinker linker(config);
+    linker.build(*log);
+    linker.solve();
+    const std::vector<uint64_t> ids = linker.rowIdentities(*log);
+
+    const LinkerStats& st = linker.stats();
+    printf("%llu rows, %llu tracklets (%llu split off), %llu windows, %llu edges, %llu links "
+           "(%llu dropped at window edges), %llu identities\n",
+           (unsigned long long)st.rows, (unsigned long long)st.tracklets, (unsigned long long)st.splits,
+           (unsigned long long)st.windows,
+           (unsigned long long)st.edges, (unsigned long long)st.links, (unsigned long long)st.conflicts,
+           (unsigned long long)st.identities);
+    printf("build %.1f ms, solve %.1f ms\n", st.buildMs, st.solveMs);
+
+    if (log->identity()) {
+        const Score online = score(log->globalId(), log->identity(), log->rows());
+        const Score offline = score(ids.data(), log->identity(), log->rows());
+        printf("%-8s %8s %10s %7s\n", "ids", "count", "ids/person", "wrong");
+        printf("%-8s %8llu %10.2f %6.2f%%\n", "online", (unsigned long long)online.ids, online.idsPerIdentity,
+               100.0 * online.wrongFraction);
+        printf("%-8s %8llu %10.2f %6.2f%%\n", "offline", (unsigned long long)offline.ids, offline.idsPerIdentity,
+               100.0 * offline.wrongFraction);
+    }
+
+    if (!dryRun) {
+        if (!DetectionLog::writeColumn(dir, column, ids)) {
+            return 1;
+        }
+        printf("wrote %s/%s.npy\n", dir.c_str(), column.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Per-source input resolution planner
+ *
+ * Collects target sizes per source, either from a running pipeline's frame
+ * ring or from a synthetic scene mix (close-range doorway, corridor and
+ * wide lobby cameras in turn), runs InputResolutionSelector and prints the chosen
+ * profile per source with the network compute relative to the default
+ * profile. With an output directory it also writes the per-profile
+ * nvdspreprocess and nvinferserver configs.
+ *
+ * Usage: plan_input_resolution <config|-> <ring-name|--synthetic> [seconds] [out-dir]
+ */
+
+#include "frame_meta_ring.h"
+#include "input_resolution.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+static void collectSynthetic(InputResolutionSelector& selector, const InputResolutionConfig& config,
+                             uint32_t sources, uint32_t seconds)
+{
+    std::mt19937 rng(7);
+    const uint32_t frames = seconds * 30;
+    // Person height as a fraction of the frame height per camera type:
+    // close-range doorway, corridor, wide lobby
+    const float minFrac[3] = {0.35f, 0.10f, 0.04f};
+    const float maxFrac[3] = {0.90f, 0.30f, 0.12f};
+    const int perFrame[3] = {2, 4, 8};
+    for (uint32_t s = 0; s < sources; ++s) {
+        const int type = s % 3;
+        std::uniform_real_distribution<float> heightFrac(minFrac[type], maxFrac[type]);
+        for (uint32_t f = 0; f < frames; ++f) {
+            for (int i = 0; i < perFrame[type]; ++i) {
+                const float h = heightFrac(rng) * config.muxHeight;
+                selector.observe(s, h * 0.4f, h);
+            }
+        }
+    }
+}
+
+static bool collectFromRing(InputResolutionSelector& selector, const std::string& name, uint32_t numSources,
+                            uint32_t seconds)
+{
+    std::unique_ptr<FrameRingConsumer> consumer = FrameRingConsumer::open(name);
+    if (!consumer) {
+        return false;
+    }
+    FrameRecord* rec = new FrameRecord;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (!consumer->next(*rec)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (rec->sourceId >= numSources) {
+            continue;
+        }
+        for (uint16_t i = 0; i < rec->numObjects; ++i) {
+            selector.observe(rec->sourceId, rec->objects[i].width, rec->objects[i].height);
+        }
+    }
+    delete rec;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <config|-> <ring-name|--synthetic> [seconds] [out-dir]\n", argv[0]);
+        return 1;
+    }
+    InputResolutionConfig config;
+    if (std::string(argv[1]) != "-" && !InputResolutionConfig::load(argv[1], config)) {
+        return 1;
+    }
+    const bool synthetic = strcmp(argv[2], "--synthetic") == 0;
+    const uint32_t seconds = argc > 3 ? (uint32_t)atoi(argv[3]) : 60;
+    const uint32_t sources = config.numSources ? config.numSources : 6;
+
+    InputResolutionSelector selector(config, sources);
+    if (synthetic) {
+        collectSynthetic(selector, config, sources, seconds);
+    } else if (!collectFromRing(selector, argv[2], sources, seconds)) {
+        return 1;
+    }
+
+    printf("mux=%ux%u min_target_px=%.0f percentile=%.2f default=%u\n", config.muxWidth, config.muxHeight,
+           config.minTargetPx, config.percentile, config.defaultProfile);
+    for (uint32_t s = 0; s < sources; ++s) {
+        const uint32_t p = selector.select(s);
+        printf("source=%u samples=%llu target_side_at_%u=%.1fpx profile=%u compute=%.3f\n", s,
+               (unsigned long long)selector.samples(s), p, selector.percentileSize(s, p), p,
+               (double)p * p / ((double)config.defaultProfile * config.defaultProfile));
+    }
+    printf("relative_compute=%.3f\n", selector.relativeCompute());
+
+    if (argc > 4 && !selector.writePipelineConfigs(argv[4], "yolov7_fp16_dynres", 4, 1)) {
+        return 1;
+    }
+    return 0;
+}
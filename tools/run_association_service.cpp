@@ -0,0 +1,64 @@
+/*
+ * Runs the native association service (see association_service.h)
+ *
+ * Binds the configured sockets, serves until SIGINT/SIGTERM and writes a
+ * last snapshot on the way out.
+ *
+ * Usage: run_association_service [--config configs/association_service.txt]
+ *            [--tracking configs/tracking_native.txt]
+ */
+
+#include "association_service.h"
+
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    ServiceConfig serviceConfig;
+    AssociatorConfig associatorConfig;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--config") {
+            if (!ServiceConfig::load(v, serviceConfig)) {
+                return 1;
+            }
+        } else if (a == "--tracking") {
+            if (!AssociatorConfig::load(v, associatorConfig)) {
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+
+    // Blocked before any thread starts, so only the waiter below sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::unique_ptr<AssociationService> service = AssociationService::create(serviceConfig, associatorConfig);
+    if (!service) {
+        return 1;
+    }
+    printf("association service: %u threads, socket %s, tcp port %u, metrics port %u\n", serviceConfig.threads,
+           serviceConfig.unixSocket.empty() ? "off" : serviceConfig.unixSocket.c_str(), service->tcpPort(),
+           service->metricsPort());
+    fflush(stdout);
+
+    std::thread waiter([&]() {
+        int signal = 0;
+        sigwait(&signals, &signal);
+        service->stop();
+    });
+    service->run();
+    waiter.join();
+    printf("association service stopped\n");
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Load shedding simulation
+ *
+ * Drives LoadShedder with a simple queueing model of the inference server:
+ * every source offers frames at a fixed rate, each inferred frame costs
+ * time proportional to its input area (resolution scale squared), and the
+ * server drains work at a fixed capacity. Halfway through, the offered load
+ * jumps (cameras added), then falls back. Prints per-phase per-priority
+ * inference rates, peak queue depth and every controller decision.
+ *
+ * Usage: sim_load_shedder [config] [sources] [capacity_fps] [seconds]
+ */
+
+#include "load_shedder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    LoadShedConfig config;
+    if (argc > 1 && std::string(argv[1]) != "-" && !LoadShedConfig::load(argv[1], config)) {
+        return 1;
+    }
+    const uint32_t sources = argc > 2 ? (uint32_t)atoi(argv[2]) : 16;
+    const double capacityFps = argc > 3 ? atof(argv[3]) : 300.0;
+    const uint32_t seconds = argc > 4 ? (uint32_t)atoi(argv[4]) : 120;
+    const uint32_t fps = 30;
+
+    // Unless configured, a quarter of the cameras are critical, the rest
+    // alternate between normal and low priority.
+    if (config.sourcePriority.size() < sources) {
+        for (uint32_t s = (uint32_t)config.sourcePriority.size(); s < sources; ++s) {
+            config.sourcePriority.push_back(s % 4 == 0 ? 0 : (s % 2 ? 2 : 1));
+        }
+    }
+
+    LoadShedder shedder(config, sources);
+    shedder.setDecisionCallback([](const LoadShedDecision& d) {
+        printf("t=%.1fs level %d -> %d queue=%.1f latency=%.0fms step{priority=%d interval=%u scale=%.2f}\n",
+               d.timestampUs / 1e6, d.fromLevel, d.toLevel, d.queueDepth, d.latencyMs, d.step.priority,
+               d.step.inferInterval, d.step.resolutionScale);
+    });
+
+    // Overload phase: between 1/3 and 2/3 of the run all cameras are active;
+    // otherwise only half of them are.
+    double backlogSec = 0.0;  // seconds of server work queued
+    double peakQueue = 0.0;
+    std::vector<double> inferredByPrio(3, 0.0), offeredByPrio(3, 0.0);
+
+    const uint64_t ticks = (uint64_t)seconds * fps;
+    for (uint64_t f = 0; f < ticks; ++f) {
+        const uint64_t nowUs = f * 1000000ull / fps;
+        const bool overload = f >= ticks / 3 && f < 2 * ticks / 3;
+        const uint32_t active = overload ? sources : sources / 2;
+
+        for (uint32_t s = 0; s < active; ++s) {
+            const int prio = std::min(2, config.sourcePriority[s]);
+            if (overload) {
+                offeredByPrio[prio] += 1.0;
+            }
+            if (!shedder.shouldInfer(s, f)) {
+                continue;
+            }
+            const float scale = shedder.resolutionScale(s);
+            backlogSec += (double)(scale * scale) / capacityFps;
+            if (overload) {
+                inferredByPrio[prio] += 1.0;
+            }
+        }
+
+        backlogSec = std::max(0.0, backlogSec - 1.0 / fps);
+        const double queue = backlogSec * capacityFps;
+        const double latencyMs = backlogSec * 1000.0 + 1000.0 / capacityFps;
+        peakQueue = std::max(peakQueue, queue);
+        shedder.observe(queue, latencyMs, nowUs);
+    }
+
+    printf("sources=%u capacity_fps=%.0f ladder_steps=%d final_level=%d peak_queue=%.1f\n", sources,
+           capacityFps, shedder.maxLevel(), shedder.level(), peakQueue);
+    const char* names[3] = {"critical", "normal", "low"};
+    for (int p = 0; p < 3; ++p) {
+        if (offeredByPrio[p] > 0) {
+            printf("overload_phase priority=%s inferred_fraction=%.3f\n", names[p],
+                   inferredByPrio[p] / offeredByPrio[p]);
+        }
+    }
+
+    std::string metrics;
+    shedder.writePrometheus(metrics);
+    printf("%s", metrics.c_str());
+    return 0;
+}
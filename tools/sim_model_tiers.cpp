@@ -0,0 +1,126 @@
+/*
+ * Model tiering load-generator simulation
+ *
+ * Offers frames from every source at a fixed rate to a model of the
+ * inference server: each frame costs its tier's relative cost divided by
+ * the server capacity (in full-model frames per second), and frames that
+ * arrive while more than max-queue-ms of work is queued are dropped. The
+ * same load pattern (half the cameras, then all of them, then half again)
+ * runs once with tiering disabled and once with ModelTierRouter in charge,
+ * and the processed frame rate, drop rate and switch counts are compared.
+ *
+ * Usage: sim_model_tiers [config] [sources] [capacity_fps] [seconds]
+ */
+
+#include "model_tier_router.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct SimResult
+{
+    double processed;
+    double dropped;
+    double offered;
+    double fullFraction;  // processed frames served by tier 0
+    uint64_t switches;
+};
+
+static SimResult run(const ModelTierConfig& config, uint32_t sources, double capacityFps, uint32_t seconds,
+                     bool tiering, bool verbose)
+{
+    const uint32_t fps = 30;
+    const double maxBacklogSec = 0.2;
+
+    ModelTierRouter router(config, sources);
+    SimResult r = {0.0, 0.0, 0.0, 0.0, 0};
+    router.setSwitchCallback([&](const ModelTierSwitch& s) {
+        r.switches++;
+        if (verbose) {
+            printf("t=%.1fs source %u tier %u -> %u load=%.2f\n", s.timestampUs / 1e6, s.sourceId, s.fromTier,
+                   s.toTier, s.load);
+        }
+    });
+
+    std::vector<uint32_t> ids(sources);
+    for (uint32_t s = 0; s < sources; ++s) {
+        ids[s] = s;
+    }
+
+    double backlogSec = 0.0;
+    double load = 0.0;
+    double fullFrames = 0.0;
+    const uint64_t ticks = (uint64_t)seconds * fps;
+    for (uint64_t f = 0; f < ticks; ++f) {
+        const uint64_t nowUs = f * 1000000ull / fps;
+        const bool peak = f >= ticks / 3 && f < 2 * ticks / 3;
+        const uint32_t active = peak ? sources : sources / 2;
+
+        router.beginBatch(ids.data(), active);
+        double offeredWork = 0.0;
+        for (uint32_t s = 0; s < active; ++s) {
+            const uint32_t t = router.tier(s);
+            const double work = router.tierInfo(t).cost / capacityFps;
+            offeredWork += work;
+            r.offered += 1.0;
+            if (backlogSec > maxBacklogSec) {
+                r.dropped += 1.0;
+                continue;
+            }
+            backlogSec += work;
+            r.processed += 1.0;
+            fullFrames += t == 0;
+        }
+        backlogSec = std::max(0.0, backlogSec - 1.0 / fps);
+
+        // Utilisation as the processor sees it: offered work per unit of
+        // server time, smoothed like the per-batch latency EWMA
+        load = 0.9 * load + 0.1 * (offeredWork * fps);
+        if (tiering) {
+            router.observe(load, nowUs);
+        }
+    }
+
+    r.fullFraction = r.processed > 0 ? fullFrames / r.processed : 0.0;
+    r.processed /= seconds;
+    r.dropped /= seconds;
+    r.offered /= seconds;
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    ModelTierConfig config;
+    if (argc > 1 && std::string(argv[1]) != "-" && !ModelTierConfig::load(argv[1], config)) {
+        return 1;
+    }
+    const uint32_t sources = argc > 2 ? (uint32_t)atoi(argv[2]) : 16;
+    const double capacityFps = argc > 3 ? atof(argv[3]) : 300.0;
+    const uint32_t seconds = argc > 4 ? (uint32_t)atoi(argv[4]) : 180;
+
+    if (config.tiers.empty()) {
+        config.tiers.push_back(ModelTier{"full", "yolov7_fp16", "", 1.0, 1.0f});
+        config.tiers.push_back(ModelTier{"tiny", "yolov7_tiny_fp16", "", 0.3, 1.1f});
+    }
+    // Unless configured, a quarter of the cameras are critical, the rest
+    // alternate between normal and low priority.
+    for (uint32_t s = (uint32_t)config.sourcePriority.size(); s < sources; ++s) {
+        config.sourcePriority.push_back(s % 4 == 0 ? 0 : (s % 2 ? 2 : 1));
+    }
+
+    const SimResult base = run(config, sources, capacityFps, seconds, false, false);
+    const SimResult tiered = run(config, sources, capacityFps, seconds, true, true);
+
+    printf("sources=%u capacity_fps=%.0f tiers=%zu seconds=%u\n", sources, capacityFps, config.tiers.size(),
+           seconds);
+    printf("full_only processed_fps=%.1f dropped_fps=%.1f offered_fps=%.1f\n", base.processed, base.dropped,
+           base.offered);
+    printf("tiered    processed_fps=%.1f dropped_fps=%.1f offered_fps=%.1f full_fraction=%.3f switches=%llu\n",
+           tiered.processed, tiered.dropped, tiered.offered, tiered.fullFraction,
+           (unsigned long long)tiered.switches);
+    printf("throughput_gain=%.2fx\n", base.processed > 0 ? tiered.processed / base.processed : 0.0);
+    return 0;
+}
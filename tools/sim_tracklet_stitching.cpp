@@ -0,0 +1,258 @@
+/*
+ * Tracklet re-stitching simulation
+ *
+ * Feeds the ground-truth detections and embeddings of a synthetic scene
+ * (see synthetic_scene.h; occluders and missed detections break local
+ * tracks) through one IouTracker per source and the GlobalAssociator:
+ * with [stitching] disabled, as configured, as configured with batched
+ * decisions (decision-window-ms, 500 unless configured or given), and as
+ * configured with k-reciprocal re-ranking ([rerank], k 10 unless
+ * configured or given). It compares:
+ *
+ *   created    global tracks started
+ *   stitched   new local tracks that took over a lost track's global id
+ *   ids/person distinct global ids given to one identity (1.0 is ideal)
+ *   wrong      detections whose global id mostly belongs to another
+ *              identity (false stitches or ReID merges)
+ *   pending    detections of provisional tracks, which get no global id
+ *              and are left out of ids/person and wrong
+ *   decide     longest time a new local track waited for its decision
+ *   rejected   gallery matches above reid-threshold that re-ranking
+ *              turned down, and reordered ones it sent to another track
+ *   gallery    global tracks held at the end, and their memory
+ *   assoc      mean associator time per frame of one source
+ *
+ * Usage: sim_tracklet_stitching [--scene configs/synthetic_scene.txt]
+ *            [--tracking configs/tracking_native.txt] [--sources 4] [--seconds 120] [--seed 1]
+ *            [--decision-window-ms 500] [--rerank-k 10]
+ */
+
+#include "global_associator.h"
+#include "iou_tracker.h"
+#include "synthetic_scene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct SimResult
+{
+    uint64_t created;
+    uint64_t stitched;
+    double idsPerIdentity;
+    double wrongFraction;
+    double pendingFraction;
+    double maxDecisionMs;
+    uint64_t rerankRejected;
+    uint64_t rerankReordered;
+    uint64_t gallery;
+    double galleryMb;
+    double assocUs;
+};
+
+static SimResult run(const SyntheticSceneConfig& sceneConfig, const IouTrackerConfig& trackerConfig,
+                     const AssociatorConfig& associatorConfig, double seconds)
+{
+    SyntheticScene scene(sceneConfig);
+    const uint32_t sources = sceneConfig.sources;
+    const uint32_t dim = sceneConfig.embeddingDim;
+    const float fps = (float)sceneConfig.fps;
+    GlobalAssociator associator(associatorConfig, dim);
+    std::vector<std::unique_ptr<IouTracker>> trackers;
+    for (uint32_t s = 0; s < sources; ++s) {
+        trackers.emplace_back(new IouTracker(trackerConfig));
+    }
+
+    // identity -> global id -> detections, and the reverse
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>> byIdentity, byGlobal;
+    std::vector<TrackerDetection> detections;
+    std::vector<TrackedObject> active;
+    std::vector<TerminatedTrack> terminated;
+    std::vector<float> embeddings;
+    double assocUs = 0.0;
+    uint64_t assocFrames = 0;
+    uint64_t pending = 0, associated = 0;
+
+    const uint64_t frames = (uint64_t)(seconds * sceneConfig.fps);
+    for (uint64_t f = 0; f < frames; ++f) {
+        scene.step();
+        for (uint32_t s = 0; s < sources; ++s) {
+            const SceneFrame& frame = scene.frame(s);
+            detections.clear();
+            for (const SceneDetection& d : frame.detections) {
+                detections.push_back(TrackerDetection{{d.x1, d.y1, d.x2 - d.x1, d.y2 - d.y1}, d.confidence, 0});
+            }
+            embeddings.resize(frame.detections.size() * (size_t)dim);
+            scene.writeEmbeddings(s, embeddings.data());
+            trackers[s]->update(detections, active, terminated);
+
+            const Clock::time_point t0 = Clock::now();
+            for (const TrackedObject& o : active) {
+                if (!o.confirmed) {
+                    continue;
+                }
+                if (o.detection == TrackedObject::kNoDetection) {
+                    if (o.missed == associatorConfig.stitching.lostAfterFrames) {
+                        associator.suspendLocalTrack(s, o.trackId, o.box, o.vx * fps, o.vy * fps,
+                                                     frame.timestampUs);
+                    }
+                    continue;
+                }
+                AssociationInput in;
+                in.camera = s;
+                in.localId = o.trackId;
+                in.confidence = o.confidence;
+                in.box = o.box;
+                in.embedding = &embeddings[(size_t)o.detection * dim];
+                const uint64_t globalId = associator.associate(in, frame.timestampUs);
+                const uint64_t identity = frame.detections[o.detection].identity;
+                associated++;
+                if (globalId == 0) {
+                    pending++;
+                } else if (identity != 0) {
+                    byIdentity[identity][globalId]++;
+                    byGlobal[globalId][identity]++;
+                }
+            }
+            for (const TerminatedTrack& t : terminated) {
+                if (t.confirmed) {
+                    associator.endLocalTrack(s, t.trackId);
+                }
+            }
+            if (s == 0 && f % (uint64_t)sceneConfig.fps == 0) {
+                associator.expire(frame.timestampUs);
+            }
+            assocUs += std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+            assocFrames++;
+        }
+    }
+
+    SimResult r;
+    r.created = associator.stats().newTracks;
+    r.stitched = associator.stats().stitched;
+    uint64_t ids = 0;
+    for (const auto& kv : byIdentity) {
+        ids += kv.second.size();
+    }
+    r.idsPerIdentity = byIdentity.empty() ? 0.0 : (double)ids / byIdentity.size();
+    uint64_t total = 0, wrong = 0;
+    for (const auto& kv : byGlobal) {
+        uint64_t sum = 0, majority = 0;
+        for (const auto& c : kv.second) {
+            sum += c.second;
+            majority = std::max(majority, c.second);
+        }
+        total += sum;
+        wrong += sum - majority;
+    }
+    r.wrongFraction = total ? (double)wrong / total : 0.0;
+    r.pendingFraction = associated ? (double)pending / associated : 0.0;
+    r.maxDecisionMs = associator.stats().maxDecisionLatencyUs / 1e3;
+    r.rerankRejected = associator.stats().rerankRejected;
+    r.rerankReordered = associator.stats().rerankReordered;
+    r.gallery = associator.globalTracks();
+    r.galleryMb = associator.memoryBytes() / (1024.0 * 1024.0);
+    r.assocUs = assocFrames ? assocUs / assocFrames : 0.0;
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    SyntheticSceneConfig sceneConfig;
+    IouTrackerConfig trackerConfig;
+    AssociatorConfig associatorConfig;
+    double seconds = 120.0;
+    int sources = -1;
+    int seed = -1;
+    int windowMs = -1;
+    int rerankK = -1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--scene") {
+            if (!SyntheticSceneConfig::load(v, sceneConfig)) {
+                return 1;
+            }
+        } else if (a == "--tracking") {
+            if (!IouTrackerConfig::load(v, trackerConfig) || !AssociatorConfig::load(v, associatorConfig)) {
+                return 1;
+            }
+        } else if (a == "--sources") {
+            sources = atoi(v);
+        } else if (a == "--seconds") {
+            seconds = atof(v);
+        } else if (a == "--seed") {
+            seed = atoi(v);
+        } else if (a == "--decision-window-ms") {
+            windowMs = atoi(v);
+        } else if (a == "--rerank-k") {
+            rerankK = atoi(v);
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", a.c_str());
+            return 1;
+        }
+    }
+    if (sources > 0) {
+        sceneConfig.sources = (uint32_t)sources;
+    }
+    if (seed >= 0) {
+        sceneConfig.seed = (uint32_t)seed;
+    }
+    if (seconds <= 0.0) {
+        fprintf(stderr, "ERROR: --seconds must be positive\n");
+        return 1;
+    }
+
+    AssociatorConfig immediate = associatorConfig;
+    immediate.decisionWindowMs = 0;
+    immediate.rerank.enable = false;
+    AssociatorConfig off = immediate;
+    off.stitching.enable = false;
+    AssociatorConfig batched = associatorConfig;
+    if (windowMs >= 0) {
+        batched.decisionWindowMs = (uint32_t)windowMs;
+    } else if (batched.decisionWindowMs == 0) {
+        batched.decisionWindowMs = 500;
+    }
+    batched.decisionTickMs = std::min(batched.decisionTickMs, std::max(1u, batched.decisionWindowMs));
+    batched.rerank.enable = false;
+    AssociatorConfig reranked = immediate;
+    reranked.rerank.enable = true;
+    if (rerankK > 0) {
+        reranked.rerank.k = (uint32_t)rerankK;
+    }
+    const SimResult a = run(sceneConfig, trackerConfig, off, seconds);
+    const SimResult b = run(sceneConfig, trackerConfig, immediate, seconds);
+    const SimResult c = run(sceneConfig, trackerConfig, batched, seconds);
+    const SimResult d = run(sceneConfig, trackerConfig, reranked, seconds);
+
+    printf("%u sources, %.0f s at %.0f fps\n", sceneConfig.sources, seconds, sceneConfig.fps);
+    printf("%-12s %8s %8s %10s %7s %8s %8s %9s %8s %8s %8s\n", "stitching", "created", "stitched", "ids/person",
+           "wrong", "pending", "decide", "rejected", "gallery", "gal_mb", "assoc");
+    const char* on = associatorConfig.stitching.enable ? "on" : "off";
+    char batchedName[32];
+    snprintf(batchedName, sizeof(batchedName), "%s+%ums", on, batched.decisionWindowMs);
+    char rerankName[32];
+    snprintf(rerankName, sizeof(rerankName), "%s+k%u", on, reranked.rerank.k);
+    const SimResult* rs[4] = {&a, &b, &c, &d};
+    const char* names[4] = {"off", on, batchedName, rerankName};
+    for (int i = 0; i < 4; ++i) {
+        const SimResult& r = *rs[i];
+        char rejected[32];
+        snprintf(rejected, sizeof(rejected), "%llu/%llu", (unsigned long long)r.rerankRejected,
+                 (unsigned long long)r.rerankReordered);
+        printf("%-12s %8llu %8llu %10.2f %6.2f%% %7.2f%% %6.0fms %9s %8llu %8.1f %7.1fu\n", names[i],
+               (unsigned long long)r.created, (unsigned long long)r.stitched, r.idsPerIdentity,
+               100.0 * r.wrongFraction, 100.0 * r.pendingFraction, r.maxDecisionMs, rejected,
+               (unsigned long long)r.gallery, r.galleryMb, r.assocUs);
+    }
+    return 0;
+}
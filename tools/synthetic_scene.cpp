@@ -0,0 +1,572 @@
+/*
+ * Synthetic multi-camera scene for parser, tracker and associator benchmarks
+ */
+
+#include "synthetic_scene.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static const uint32_t kNoiseTableSize = 1u << 16;
+static const double kPi = 3.14159265358979323846;
+
+// Person class id in the COCO label file
+static const int kPersonClass = 0;
+
+bool SyntheticSceneConfig::load(const std::string& path, SyntheticSceneConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    SyntheticSceneConfig c;
+    c.sources = (uint32_t)kf.getInt("scene", "sources", (int)c.sources);
+    c.fps = kf.getDouble("scene", "fps", c.fps);
+    c.netWidth = (uint32_t)kf.getInt("scene", "net-width", (int)c.netWidth);
+    c.netHeight = (uint32_t)kf.getInt("scene", "net-height", (int)c.netHeight);
+    c.seed = (uint32_t)kf.getInt("scene", "seed", (int)c.seed);
+
+    c.objectsPerSource = kf.getDouble("population", "objects-per-source", c.objectsPerSource);
+    c.surgePeriodS = kf.getDouble("population", "surge-period-s", c.surgePeriodS);
+    c.surgeDurationS = kf.getDouble("population", "surge-duration-s", c.surgeDurationS);
+    c.surgeFactor = kf.getDouble("population", "surge-factor", c.surgeFactor);
+    c.groupFraction = kf.getDouble("population", "group-fraction", c.groupFraction);
+    c.groupSize = (uint32_t)kf.getInt("population", "group-size", (int)c.groupSize);
+
+    c.speedPxS = kf.getDouble("motion", "speed-px-s", c.speedPxS);
+    c.speedJitter = kf.getDouble("motion", "speed-jitter", c.speedJitter);
+    c.turnRate = kf.getDouble("motion", "turn-rate", c.turnRate);
+
+    c.heightPx = kf.getDouble("appearance", "height-px", c.heightPx);
+    c.heightJitter = kf.getDouble("appearance", "height-jitter", c.heightJitter);
+    c.aspect = kf.getDouble("appearance", "aspect", c.aspect);
+    c.perspective = kf.getDouble("appearance", "perspective", c.perspective);
+
+    c.occludersPerSource = (uint32_t)kf.getInt("occlusion", "occluders-per-source", (int)c.occludersPerSource);
+    c.occluderSize = kf.getDouble("occlusion", "occluder-size", c.occluderSize);
+    c.occlusionMiss = kf.getDouble("occlusion", "occlusion-miss", c.occlusionMiss);
+
+    c.boxJitter = kf.getDouble("noise", "box-jitter", c.boxJitter);
+    c.missRate = kf.getDouble("noise", "miss-rate", c.missRate);
+    c.falsePositivesPerFrame = kf.getDouble("noise", "false-positives-per-frame", c.falsePositivesPerFrame);
+    c.duplicates = (uint32_t)kf.getInt("noise", "duplicates", (int)c.duplicates);
+    c.backgroundScore = kf.getDouble("noise", "background-score", c.backgroundScore);
+
+    c.handoffProbability = kf.getDouble("handoff", "probability", c.handoffProbability);
+    c.minTransitS = kf.getDouble("handoff", "min-transit-s", c.minTransitS);
+    c.maxTransitS = kf.getDouble("handoff", "max-transit-s", c.maxTransitS);
+
+    c.embeddingDim = (uint32_t)kf.getInt("embedding", "dim", (int)c.embeddingDim);
+    c.identityNoise = kf.getDouble("embedding", "identity-noise", c.identityNoise);
+    c.cameraBias = kf.getDouble("embedding", "camera-bias", c.cameraBias);
+
+    if (c.sources == 0 || c.fps <= 0.0 || c.netWidth % 32 != 0 || c.netHeight % 32 != 0 || c.netWidth == 0 ||
+        c.netHeight == 0) {
+        std::cerr << "ERROR: " << path << ": sources and fps must be positive, net size a non-zero multiple of 32"
+                  << std::endl;
+        return false;
+    }
+    if (c.embeddingDim == 0 || c.maxTransitS < c.minTransitS || c.perspective <= 0.0) {
+        std::cerr << "ERROR: " << path << ": invalid embedding dim, transit range or perspective" << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+// splitmix64: decorrelates keys used to index the noise table
+static inline uint64_t mix64(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+SyntheticScene::SyntheticScene(const SyntheticSceneConfig& config)
+    : m_Config(config), m_FrameNum(0), m_NextIdentity(1), m_Rng(config.seed)
+{
+    const uint32_t w = m_Config.netWidth, h = m_Config.netHeight;
+    m_Rows = 3 * ((w / 8) * (h / 8) + (w / 16) * (h / 16) + (w / 32) * (h / 32));
+
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    m_NoiseTable.resize(kNoiseTableSize);
+    for (float& v : m_NoiseTable) {
+        v = gauss(m_Rng);
+    }
+
+    // Empty rows: a box at the anchor cell with a score skewed towards 0
+    m_Background6.resize((size_t)m_Rows * 6);
+    m_Background85.resize((size_t)m_Rows * 85);
+    const float bg = (float)m_Config.backgroundScore;
+    uint32_t row = 0;
+    for (uint32_t stride : {8u, 16u, 32u}) {
+        const uint32_t gw = w / stride, gh = h / stride;
+        for (uint32_t a = 0; a < 3; ++a) {
+            for (uint32_t gy = 0; gy < gh; ++gy) {
+                for (uint32_t gx = 0; gx < gw; ++gx, ++row) {
+                    const float cx = (gx + 0.5f) * stride, cy = (gy + 0.5f) * stride;
+                    const float bw = stride * (1.0f + a) * (0.5f + uni(m_Rng));
+                    const float bh = bw * (1.0f + uni(m_Rng));
+                    const float u = uni(m_Rng);
+                    float* r6 = &m_Background6[(size_t)row * 6];
+                    r6[0] = cx - bw * 0.5f;
+                    r6[1] = cy - bh * 0.5f;
+                    r6[2] = cx + bw * 0.5f;
+                    r6[3] = cy + bh * 0.5f;
+                    r6[4] = bg * u * u * u;
+                    r6[5] = (float)(row % 80);
+                    float* r85 = &m_Background85[(size_t)row * 85];
+                    r85[0] = cx;
+                    r85[1] = cy;
+                    r85[2] = bw;
+                    r85[3] = bh;
+                    r85[4] = bg * u * u;
+                    for (int c = 0; c < 80; ++c) {
+                        r85[5 + c] = 0.3f * uni(m_Rng);
+                    }
+                }
+            }
+        }
+    }
+
+    m_Sources.resize(m_Config.sources);
+    for (uint32_t s = 0; s < m_Config.sources; ++s) {
+        Source& src = m_Sources[s];
+        src.frame.source = s;
+        src.frame.frameNum = 0;
+        src.frame.timestampUs = 0;
+
+        for (uint32_t o = 0; o < m_Config.occludersPerSource; ++o) {
+            const float side = (float)m_Config.occluderSize;
+            const float ow = side * w * (0.5f + uni(m_Rng)), oh = side * h * (0.5f + uni(m_Rng));
+            const float ox = uni(m_Rng) * (w - ow), oy = (0.2f + 0.6f * uni(m_Rng)) * (h - oh);
+            src.occluders.push_back(Rect{ox, oy, ox + ow, oy + oh});
+        }
+
+        src.bias.resize(m_Config.embeddingDim);
+        double norm = 0.0;
+        for (float& v : src.bias) {
+            v = gauss(m_Rng);
+            norm += (double)v * v;
+        }
+        for (float& v : src.bias) {
+            v = (float)(v / std::sqrt(norm));
+        }
+
+        const uint32_t initial = (uint32_t)std::lround(m_Config.objectsPerSource);
+        for (uint32_t i = 0; i < initial; ++i) {
+            spawn(src, m_NextIdentity++, false);
+        }
+        render(src, s);
+    }
+}
+
+bool SyntheticScene::surging() const
+{
+    if (m_Config.surgePeriodS <= 0.0) {
+        return false;
+    }
+    const double t = m_FrameNum / m_Config.fps;
+    return std::fmod(t, m_Config.surgePeriodS) >= m_Config.surgePeriodS - m_Config.surgeDurationS;
+}
+
+uint64_t SyntheticScene::population() const
+{
+    uint64_t n = 0;
+    for (const Source& src : m_Sources) {
+        n += src.people.size();
+    }
+    return n;
+}
+
+void SyntheticScene::spawn(Source& src, uint64_t identity, bool fromEdge)
+{
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    const double w = m_Config.netWidth, h = m_Config.netHeight;
+    const double horizon = 0.2 * h;
+
+    Person p;
+    p.identity = identity;
+    p.heightScale = std::max(0.5, 1.0 + m_Config.heightJitter * gauss(m_Rng));
+    double heading;
+    if (fromEdge) {
+        // Walk in from the left, right or bottom edge, roughly inwards
+        const double e = uni(m_Rng);
+        if (e < 0.4) {
+            p.x = 0.0;
+            p.y = horizon + uni(m_Rng) * (h - horizon);
+            heading = 0.0;
+        } else if (e < 0.8) {
+            p.x = w;
+            p.y = horizon + uni(m_Rng) * (h - horizon);
+            heading = kPi;
+        } else {
+            p.x = uni(m_Rng) * w;
+            p.y = h;
+            heading = -kPi / 2;
+        }
+        heading += (uni(m_Rng) - 0.5) * kPi / 2;
+    } else {
+        p.x = uni(m_Rng) * w;
+        p.y = horizon + uni(m_Rng) * (h - horizon);
+        heading = uni(m_Rng) * 2 * kPi;
+    }
+    const double speed = m_Config.speedPxS * std::max(0.1, 1.0 + m_Config.speedJitter * gauss(m_Rng));
+    p.vx = speed * std::cos(heading);
+    p.vy = speed * std::sin(heading) * 0.5;  // depth motion looks slower
+    src.people.push_back(p);
+
+    // Companions walk alongside with the same velocity
+    if (fromEdge && m_Config.groupSize > 1 && uni(m_Rng) < m_Config.groupFraction) {
+        for (uint32_t g = 1; g < m_Config.groupSize; ++g) {
+            Person c = p;
+            c.identity = m_NextIdentity++;
+            c.heightScale = std::max(0.5, 1.0 + m_Config.heightJitter * gauss(m_Rng));
+            c.x += gauss(m_Rng) * m_Config.heightPx * m_Config.aspect;
+            c.y += gauss(m_Rng) * m_Config.heightPx * 0.15;
+            src.people.push_back(c);
+        }
+    }
+}
+
+void SyntheticScene::step()
+{
+    m_FrameNum++;
+    const double dt = 1.0 / m_Config.fps;
+    const double w = m_Config.netWidth, h = m_Config.netHeight;
+    const double horizon = 0.2 * h;
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    const double target = m_Config.objectsPerSource * (surging() ? m_Config.surgeFactor : 1.0);
+
+    for (uint32_t s = 0; s < m_Config.sources; ++s) {
+        Source& src = m_Sources[s];
+        for (size_t i = 0; i < src.people.size();) {
+            Person& p = src.people[i];
+            const double turn = m_Config.turnRate * std::sqrt(dt) * gauss(m_Rng);
+            const double c = std::cos(turn), sn = std::sin(turn);
+            const double vx = p.vx * c - p.vy * sn;
+            p.vy = p.vx * sn + p.vy * c;
+            p.vx = vx;
+            p.x += p.vx * dt;
+            p.y += p.vy * dt;
+            // Stay below the horizon
+            if (p.y < horizon) {
+                p.y = horizon;
+                p.vy = -p.vy;
+            }
+            if (p.x < -20.0 || p.x > w + 20.0 || p.y > h + 20.0) {
+                if (m_Config.sources > 1 && uni(m_Rng) < m_Config.handoffProbability) {
+                    uint32_t to = (uint32_t)(uni(m_Rng) * (m_Config.sources - 1));
+                    to += to >= s ? 1 : 0;
+                    const double transit =
+                        m_Config.minTransitS + uni(m_Rng) * (m_Config.maxTransitS - m_Config.minTransitS);
+                    m_Transit.push_back(
+                        Transit{p.identity, to, m_FrameNum + (uint64_t)std::lround(transit * m_Config.fps)});
+                }
+                src.people[i] = src.people.back();
+                src.people.pop_back();
+                continue;
+            }
+            ++i;
+        }
+
+        // Births pull the population towards the (possibly surging) target
+        const double deficit = std::max(0.0, target - (double)src.people.size());
+        std::poisson_distribution<uint32_t> births(deficit * dt / 2.0);
+        for (uint32_t b = births(m_Rng); b > 0; --b) {
+            spawn(src, m_NextIdentity++, true);
+        }
+    }
+
+    // Transit lengths differ, so the queue is not ordered by arrival
+    for (size_t i = 0; i < m_Transit.size();) {
+        if (m_Transit[i].arriveFrame <= m_FrameNum) {
+            spawn(m_Sources[m_Transit[i].toSource], m_Transit[i].identity, true);
+            m_Transit.erase(m_Transit.begin() + i);
+            continue;
+        }
+        ++i;
+    }
+
+    for (uint32_t s = 0; s < m_Config.sources; ++s) {
+        render(m_Sources[s], s);
+    }
+}
+
+// YOLOv7 head order: stride 8, 16 and 32 blocks, each [anchor][gy][gx]
+uint32_t SyntheticScene::anchorRow(float cx, float cy, float h, uint32_t anchor) const
+{
+    const uint32_t w = m_Config.netWidth, nh = m_Config.netHeight;
+    uint32_t base = 0, stride = 8;
+    if (h >= 64.0f) {
+        base += 3 * (w / 8) * (nh / 8);
+        stride = 16;
+    }
+    if (h >= 160.0f) {
+        base += 3 * (w / 16) * (nh / 16);
+        stride = 32;
+    }
+    const uint32_t gw = w / stride, gh = nh / stride;
+    const uint32_t gx = (uint32_t)std::min<float>(gw - 1, std::max(0.0f, cx / stride));
+    const uint32_t gy = (uint32_t)std::min<float>(gh - 1, std::max(0.0f, cy / stride));
+    return base + (anchor % 3) * gw * gh + gy * gw + gx;
+}
+
+uint32_t SyntheticScene::claimRow(std::vector<bool>& used, uint32_t row) const
+{
+    while (used[row]) {
+        row = (row + 1) % m_Rows;
+    }
+    used[row] = true;
+    return row;
+}
+
+static float overlapArea(float ax1, float ay1, float ax2, float ay2, float bx1, float by1, float bx2, float by2)
+{
+    const float iw = std::min(ax2, bx2) - std::max(ax1, bx1);
+    const float ih = std::min(ay2, by2) - std::max(ay1, by1);
+    return iw > 0.0f && ih > 0.0f ? iw * ih : 0.0f;
+}
+
+void SyntheticScene::render(Source& src, uint32_t s)
+{
+    SceneFrame& frame = src.frame;
+    frame.source = s;
+    frame.frameNum = m_FrameNum;
+    frame.timestampUs = (uint64_t)std::llround(m_FrameNum * 1e6 / m_Config.fps);
+    frame.detections.clear();
+    src.proposals.clear();
+
+    const float W = (float)m_Config.netWidth, H = (float)m_Config.netHeight;
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+
+    // True boxes; people lower in the view are nearer and hide the others
+    struct Box
+    {
+        size_t person;
+        float x1, y1, x2, y2;
+    };
+    std::vector<Box> boxes;
+    boxes.reserve(src.people.size());
+    for (size_t i = 0; i < src.people.size(); ++i) {
+        const Person& p = src.people[i];
+        const float depth = (float)(m_Config.perspective + (1.0 - m_Config.perspective) * (p.y / H));
+        const float bh = (float)(m_Config.heightPx * p.heightScale) * depth;
+        const float bw = bh * (float)m_Config.aspect;
+        boxes.push_back(Box{i, (float)p.x - bw * 0.5f, (float)p.y - bh, (float)p.x + bw * 0.5f, (float)p.y});
+    }
+    std::sort(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) { return a.y2 > b.y2; });
+
+    std::vector<bool> used(m_Rows, false);
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        const Box& b = boxes[i];
+        const float area = (b.x2 - b.x1) * (b.y2 - b.y1);
+        const float visibleArea = overlapArea(b.x1, b.y1, b.x2, b.y2, 0.0f, 0.0f, W, H);
+        float hidden = 1.0f - visibleArea / area;
+        for (const Rect& o : src.occluders) {
+            hidden += overlapArea(b.x1, b.y1, b.x2, b.y2, o.x1, o.y1, o.x2, o.y2) / area;
+        }
+        for (size_t j = 0; j < i; ++j) {
+            const Box& f = boxes[j];
+            hidden += overlapArea(b.x1, b.y1, b.x2, b.y2, f.x1, f.y1, f.x2, f.y2) / area;
+        }
+        hidden = std::min(1.0f, hidden);
+        if (hidden > m_Config.occlusionMiss || uni(m_Rng) < m_Config.missRate) {
+            continue;
+        }
+
+        const float bh = b.y2 - b.y1, bw = b.x2 - b.x1;
+        const float j = (float)m_Config.boxJitter;
+        SceneDetection d;
+        d.identity = src.people[b.person].identity;
+        d.x1 = std::max(0.0f, b.x1 + gauss(m_Rng) * j * bw);
+        d.y1 = std::max(0.0f, b.y1 + gauss(m_Rng) * j * bh);
+        d.x2 = std::min(W, b.x2 + gauss(m_Rng) * j * bw);
+        d.y2 = std::min(H, b.y2 + gauss(m_Rng) * j * bh);
+        if (d.x2 - d.x1 < 2.0f || d.y2 - d.y1 < 2.0f) {
+            continue;
+        }
+        const float small = bh < 40.0f ? 0.25f * (1.0f - bh / 40.0f) : 0.0f;
+        d.confidence = std::min(0.98f, std::max(0.05f, 0.9f - 0.55f * hidden - small + 0.04f * gauss(m_Rng)));
+        d.occlusion = hidden;
+
+        const float cx = (d.x1 + d.x2) * 0.5f, cy = (d.y1 + d.y2) * 0.5f;
+        d.row = claimRow(used, anchorRow(cx, cy, d.y2 - d.y1, 1));
+        src.proposals.push_back(SceneProposal{d.row, d.x1, d.y1, d.x2, d.y2, d.confidence});
+
+        // Weaker, shifted proposals from the other anchors and neighbouring
+        // cells, as NMS / clustering would see them
+        for (uint32_t k = 0; k < m_Config.duplicates; ++k) {
+            const float dx = gauss(m_Rng) * 0.08f * bw, dy = gauss(m_Rng) * 0.08f * bh;
+            const uint32_t row = claimRow(used, anchorRow(cx + dx, cy + dy, d.y2 - d.y1, k % 2 == 0 ? 0 : 2));
+            const float score = d.confidence * (0.55f + 0.35f * uni(m_Rng));
+            src.proposals.push_back(SceneProposal{row, d.x1 + dx, d.y1 + dy, d.x2 + dx, d.y2 + dy, score});
+        }
+        frame.detections.push_back(d);
+    }
+
+    std::poisson_distribution<uint32_t> fps((double)m_Config.falsePositivesPerFrame);
+    for (uint32_t f = fps(m_Rng); f > 0; --f) {
+        const float bh = (float)m_Config.heightPx * (0.3f + 0.7f * uni(m_Rng));
+        const float bw = bh * (0.3f + 0.7f * uni(m_Rng));
+        SceneDetection d;
+        d.identity = 0;
+        d.x1 = uni(m_Rng) * (W - bw);
+        d.y1 = uni(m_Rng) * (H - bh);
+        d.x2 = d.x1 + bw;
+        d.y2 = d.y1 + bh;
+        d.confidence = 0.25f + 0.3f * uni(m_Rng);
+        d.occlusion = 0.0f;
+        d.row = claimRow(used, anchorRow((d.x1 + d.x2) * 0.5f, (d.y1 + d.y2) * 0.5f, bh, 1));
+        src.proposals.push_back(SceneProposal{d.row, d.x1, d.y1, d.x2, d.y2, d.confidence});
+        frame.detections.push_back(d);
+    }
+}
+
+void SyntheticScene::writeTensor6(uint32_t source, float* out) const
+{
+    renderTensor6(m_Sources[source].proposals, out);
+}
+
+void SyntheticScene::writeTensor85(uint32_t source, float* out) const
+{
+    renderTensor85(m_Sources[source].proposals, out);
+}
+
+void SyntheticScene::renderTensor6(const std::vector<SceneProposal>& proposals, float* out) const
+{
+    memcpy(out, m_Background6.data(), m_Background6.size() * sizeof(float));
+    for (const SceneProposal& p : proposals) {
+        float* r = out + (size_t)p.row * 6;
+        r[0] = p.x1;
+        r[1] = p.y1;
+        r[2] = p.x2;
+        r[3] = p.y2;
+        r[4] = p.score;
+        r[5] = (float)kPersonClass;
+    }
+}
+
+void SyntheticScene::renderTensor85(const std::vector<SceneProposal>& proposals, float* out) const
+{
+    memcpy(out, m_Background85.data(), m_Background85.size() * sizeof(float));
+    for (const SceneProposal& p : proposals) {
+        float* r = out + (size_t)p.row * 85;
+        r[0] = (p.x1 + p.x2) * 0.5f;
+        r[1] = (p.y1 + p.y2) * 0.5f;
+        r[2] = p.x2 - p.x1;
+        r[3] = p.y2 - p.y1;
+        // objectness * class score = score
+        const float root = std::sqrt(p.score);
+        r[4] = root;
+        for (int c = 0; c < 80; ++c) {
+            r[5 + c] = 0.01f;
+        }
+        r[5 + kPersonClass] = root;
+    }
+}
+
+void SyntheticScene::embedding(uint64_t identity, uint32_t source, uint64_t noiseKey, float occlusion,
+                               float* out) const
+{
+    const uint32_t dim = m_Config.embeddingDim;
+    const uint32_t mask = kNoiseTableSize - 1;
+    // Odd strides walk the whole table, so two keys rarely share a sequence
+    const uint64_t ih = mix64(identity), nh = mix64(noiseKey);
+    const uint32_t iOff = (uint32_t)ih & mask, iStride = (uint32_t)(ih >> 32) | 1u;
+    const uint32_t nOff = (uint32_t)nh & mask, nStride = (uint32_t)(nh >> 32) | 1u;
+    const float scale = 1.0f / std::sqrt((float)dim);
+    const float noise = (float)m_Config.identityNoise * (1.0f + 2.0f * occlusion) * scale;
+    const float bias = (float)m_Config.cameraBias;
+    const std::vector<float>& cam = m_Sources[source].bias;
+
+    double norm = 0.0;
+    for (uint32_t k = 0; k < dim; ++k) {
+        const float v = m_NoiseTable[(iOff + k * iStride) & mask] * scale + bias * cam[k] +
+                        noise * m_NoiseTable[(nOff + k * nStride) & mask];
+        out[k] = v;
+        norm += (double)v * v;
+    }
+    const float inv = (float)(1.0 / std::sqrt(std::max(norm, 1e-12)));
+    for (uint32_t k = 0; k < dim; ++k) {
+        out[k] *= inv;
+    }
+}
+
+void SyntheticScene::writeEmbeddings(uint32_t source, float* out) const
+{
+    const SceneFrame& frame = m_Sources[source].frame;
+    for (size_t i = 0; i < frame.detections.size(); ++i) {
+        const SceneDetection& d = frame.detections[i];
+        const uint64_t key = (frame.frameNum * m_Config.sources + source) * 4096 + i;
+        // A false positive looks like nobody seen before or after
+        const uint64_t identity = d.identity ? d.identity : (1ull << 63) | key;
+        embedding(identity, source, key, d.occlusion, out + i * m_Config.embeddingDim);
+    }
+}
+
+std::string NpyWriter::header(uint64_t rows) const
+{
+    std::string shape = "(" + std::to_string(rows) + ",";
+    for (size_t i = 0; i < m_Trailing.size(); ++i) {
+        shape += (i ? ", " : " ") + std::to_string(m_Trailing[i]);
+    }
+    shape += ")";
+    std::string dict = "{'descr': '<f4', 'fortran_order': False, 'shape': " + shape + ", }";
+    // Fixed-size header so the row count can be rewritten in place; magic
+    // (6) + version (2) + length (2) + dict + padding + '\n' = 128 bytes
+    dict.resize(127 - 10, ' ');
+    dict += '\n';
+    std::string h("\x93NUMPY\x01\x00", 8);
+    h += (char)(dict.size() & 0xff);
+    h += (char)(dict.size() >> 8);
+    return h + dict;
+}
+
+bool NpyWriter::open(const std::string& path, const std::vector<uint64_t>& trailing)
+{
+    close();
+    m_Trailing = trailing;
+    m_Rows = 0;
+    m_File = fopen(path.c_str(), "wb");
+    if (!m_File) {
+        std::cerr << "ERROR: Cannot create " << path << std::endl;
+        return false;
+    }
+    const std::string h = header(0);
+    return fwrite(h.data(), 1, h.size(), m_File) == h.size();
+}
+
+bool NpyWriter::append(const float* data, uint64_t rows)
+{
+    size_t perRow = 1;
+    for (uint64_t d : m_Trailing) {
+        perRow *= (size_t)d;
+    }
+    const size_t n = (size_t)rows * perRow;
+    if (!m_File || fwrite(data, sizeof(float), n, m_File) != n) {
+        return false;
+    }
+    m_Rows += rows;
+    return true;
+}
+
+bool NpyWriter::close()
+{
+    if (!m_File) {
+        return true;
+    }
+    const std::string h = header(m_Rows);
+    const bool ok = fseek(m_File, 0, SEEK_SET) == 0 && fwrite(h.data(), 1, h.size(), m_File) == h.size();
+    fclose(m_File);
+    m_File = nullptr;
+    return ok;
+}
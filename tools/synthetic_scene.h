@@ -0,0 +1,226 @@
+/*
+ * Synthetic multi-camera scene for parser, tracker and associator benchmarks
+ *
+ * Simulates people walking through N camera views and renders what the
+ * detector would have produced for each frame, without video or a GPU:
+ *
+ *   - the [rows, 6] end-to-end output ([x1, y1, x2, y2, conf, class]) and
+ *     the raw [rows, 85] output ([cx, cy, w, h, obj, 80 class scores]) that
+ *     NvDsInferParseYolov7 accepts, rows = 25200 at 640x640. Each object
+ *     lands in the anchor-grid row its centre and size select, with a few
+ *     weaker duplicate proposals in neighbouring rows; every other row
+ *     carries low background scores, so threshold loops do their real work.
+ *   - one embedding per detection (512-d like reid_resnet50): a fixed unit
+ *     vector per identity plus a per-camera bias and per-frame noise that
+ *     grows with occlusion, L2-normalised.
+ *   - ground truth: identity, box and tensor row of every detection.
+ *
+ * Knobs: population per view and periodic crowd surges (object count),
+ * walking speed and turning (motion), static occluders and person-person
+ * overlap (occlusion), group spawning (density), box jitter, missed and
+ * false detections and embedding noise (noise). People leaving a view may
+ * reappear in another after a transit delay, which gives the cross-camera
+ * associator real hand-offs to find. Runs are deterministic for a seed.
+ *
+ * Config (key file, see configs/synthetic_scene.txt); every key optional:
+ *
+ *   [scene]            sources, fps, net-width, net-height, seed
+ *   [population]       objects-per-source, surge-period-s, surge-duration-s,
+ *                      surge-factor, group-fraction, group-size
+ *   [motion]           speed-px-s, speed-jitter, turn-rate
+ *   [appearance]       height-px, height-jitter, aspect, perspective
+ *   [occlusion]        occluders-per-source, occluder-size, occlusion-miss
+ *   [noise]            box-jitter, miss-rate, false-positives-per-frame,
+ *                      duplicates, background-score
+ *   [handoff]          probability, min-transit-s, max-transit-s
+ *   [embedding]        dim, identity-noise, camera-bias
+ */
+
+#ifndef __SYNTHETIC_SCENE_H__
+#define __SYNTHETIC_SCENE_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+struct SyntheticSceneConfig
+{
+    uint32_t sources = 4;
+    double fps = 30.0;
+    uint32_t netWidth = 640;
+    uint32_t netHeight = 640;
+    uint32_t seed = 1;
+
+    double objectsPerSource = 15.0;
+    double surgePeriodS = 0.0;  // 0 = no surges
+    double surgeDurationS = 10.0;
+    double surgeFactor = 3.0;
+    double groupFraction = 0.2;  // spawns that bring companions
+    uint32_t groupSize = 3;
+
+    double speedPxS = 45.0;
+    double speedJitter = 0.3;  // relative
+    double turnRate = 0.2;     // rad/s standard deviation of heading drift
+
+    double heightPx = 110.0;  // at the bottom of the view
+    double heightJitter = 0.2;
+    double aspect = 0.4;       // width / height
+    double perspective = 0.5;  // size at the top of the view relative to the bottom
+
+    uint32_t occludersPerSource = 2;
+    double occluderSize = 0.15;   // fraction of the view side
+    double occlusionMiss = 0.6;   // hidden fraction above which a detection is lost
+
+    double boxJitter = 0.03;  // relative to box size
+    double missRate = 0.03;
+    double falsePositivesPerFrame = 0.5;
+    uint32_t duplicates = 2;        // weaker proposals per object
+    double backgroundScore = 0.05;  // max score of empty rows
+
+    double handoffProbability = 0.5;
+    double minTransitS = 2.0;
+    double maxTransitS = 8.0;
+
+    uint32_t embeddingDim = 512;
+    double identityNoise = 0.4;
+    double cameraBias = 0.15;
+
+    static bool load(const std::string& path, SyntheticSceneConfig& config);
+};
+
+struct SceneDetection
+{
+    uint64_t identity;  // 0 = false positive
+    uint32_t row;       // row of the strongest proposal in the tensors
+    float x1, y1, x2, y2;
+    float confidence;
+    float occlusion;  // hidden fraction, 0..1
+};
+
+// One tensor row that differs from the background
+struct SceneProposal
+{
+    uint32_t row;
+    float x1, y1, x2, y2;
+    float score;
+};
+
+struct SceneFrame
+{
+    uint32_t source;
+    uint64_t frameNum;
+    uint64_t timestampUs;
+    std::vector<SceneDetection> detections;
+};
+
+class SyntheticScene
+{
+public:
+    explicit SyntheticScene(const SyntheticSceneConfig& config);
+
+    const SyntheticSceneConfig& config() const { return m_Config; }
+
+    // Output rows per frame for the configured network size
+    uint32_t rows() const { return m_Rows; }
+
+    // Advances every source by one frame
+    void step();
+
+    const SceneFrame& frame(uint32_t source) const { return m_Sources[source].frame; }
+
+    // Current frame of `source` as detector output; `out` holds rows() * 6
+    // or rows() * 85 floats
+    void writeTensor6(uint32_t source, float* out) const;
+    void writeTensor85(uint32_t source, float* out) const;
+
+    // The rows of frame(source) that differ from the background. Rendering
+    // them only reads state fixed at construction, so a copy can be turned
+    // into a tensor on another thread while the scene steps on.
+    const std::vector<SceneProposal>& proposals(uint32_t source) const { return m_Sources[source].proposals; }
+    void renderTensor6(const std::vector<SceneProposal>& proposals, float* out) const;
+    void renderTensor85(const std::vector<SceneProposal>& proposals, float* out) const;
+
+    // frame(source).detections.size() * embeddingDim floats, same order
+    void writeEmbeddings(uint32_t source, float* out) const;
+
+    // People currently inside any view and waiting in transit between views
+    uint64_t population() const;
+    uint64_t inTransit() const { return m_Transit.size(); }
+    bool surging() const;
+
+private:
+    struct Person
+    {
+        uint64_t identity;
+        double x, y;  // bottom centre in network pixels
+        double vx, vy;
+        double heightScale;
+    };
+
+    struct Transit
+    {
+        uint64_t identity;
+        uint32_t toSource;
+        uint64_t arriveFrame;
+    };
+
+    struct Rect
+    {
+        float x1, y1, x2, y2;
+    };
+
+
+    struct Source
+    {
+        std::vector<Person> people;
+        std::vector<Rect> occluders;
+        std::vector<float> bias;  // camera embedding bias, unit length
+        std::vector<SceneProposal> proposals;
+        SceneFrame frame;
+    };
+
+    void spawn(Source& src, uint64_t identity, bool fromEdge);
+    void render(Source& src, uint32_t s);
+    uint32_t anchorRow(float cx, float cy, float h, uint32_t anchor) const;
+    uint32_t claimRow(std::vector<bool>& used, uint32_t row) const;
+    void embedding(uint64_t identity, uint32_t source, uint64_t noiseKey, float occlusion, float* out) const;
+
+    SyntheticSceneConfig m_Config;
+    uint32_t m_Rows;
+    uint64_t m_FrameNum;
+    uint64_t m_NextIdentity;
+    std::vector<Source> m_Sources;
+    // Background rows shared by every source (8.6 MB for the raw layout)
+    std::vector<float> m_Background6;
+    std::vector<float> m_Background85;
+    std::deque<Transit> m_Transit;
+    std::mt19937_64 m_Rng;
+    // N(0,1) samples; identity vectors and per-frame noise are strided reads
+    // from it, so no per-identity state is kept
+    std::vector<float> m_NoiseTable;
+};
+
+// Streaming .npy writer: the shape's first dimension is patched on close()
+class NpyWriter
+{
+public:
+    NpyWriter() : m_File(nullptr), m_Rows(0) {}
+    ~NpyWriter() { close(); }
+
+    // float32, C order, shape [rows, trailing...]
+    bool open(const std::string& path, const std::vector<uint64_t>& trailing);
+    bool append(const float* data, uint64_t rows);
+    bool close();
+
+private:
+    std::string header(uint64_t rows) const;
+
+    FILE* m_File;
+    std::vector<uint64_t> m_Trailing;
+    uint64_t m_Rows;
+};
+
+#endif
@@ -0,0 +1,619 @@
+/*
+ * Triton dynamic batching auto-tuner
+ *
+ * Replays a request trace (arrival offsets and per-request batch sizes)
+ * against a sweep of server and client settings and recommends the
+ * dynamic_batching / instance_group values on the throughput-latency
+ * frontier that meet a p99 target:
+ *
+ *   preferred_batch_size sets  x  max_queue_delay_microseconds
+ *     x  instance counts  x  client in-flight depth
+ *
+ * Two backends run the same sweep:
+ *
+ *   --local     discrete-event model of Triton's dynamic batcher (preferred
+ *               sizes, queue delay, instances sharing one GPU) with a
+ *               linear latency model, so a full sweep takes seconds and
+ *               needs no server. Fit --latency from a few perf_analyzer
+ *               runs of the real model.
+ *   --endpoint  a KServe v2 HTTP server. Each point reloads the model with
+ *               a config override (tritonserver --model-control-mode=explicit)
+ *               and replays the trace in real time from --depth clients.
+ *
+ * Trace file: one "offset_us,batch" line per request ('#' comments). Without
+ * one, --cameras cameras at --fps whose frames DeepStream batches in pairs
+ * are synthesised with jitter.
+ *
+ * Usage:
+ *   triton_batch_tuner --local [--latency fixed_ms,per_item_ms] [--contention 0.35]
+ *   triton_batch_tuner --endpoint http://triton:8000 --model yolov7_fp16 --input input:3x640x640
+ *   common: [--trace file.csv | --cameras 8 --fps 30 --batch 2] [--seconds 20] [--rate-scale 1]
+ *           [--max-batch 8] [--p99-ms 100] [--csv results.csv]
+ */
+
+#include "kserve_client.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TraceRequest
+{
+    double offsetUs;
+    uint32_t batch;
+};
+
+struct TunePoint
+{
+    std::vector<uint32_t> preferred;
+    uint32_t delayUs;
+    uint32_t instances;
+    uint32_t depth;
+};
+
+struct PointResult
+{
+    TunePoint point;
+    double itemsPerSec;
+    double p50Ms;
+    double p99Ms;
+    uint64_t requests;
+    uint64_t errors;
+};
+
+// Per-batch GPU time of one model instance: fixed + perItem * batch,
+// stretched by `contention` for every other instance busy at the same time
+struct LatencyModel
+{
+    double fixedMs = 6.0;
+    double perItemMs = 3.0;
+    double contention = 0.35;
+    double networkUs = 300.0;
+
+    double serviceUs(uint32_t batch, uint32_t othersBusy) const
+    {
+        return (fixedMs + perItemMs * batch) * 1000.0 * (1.0 + contention * othersBusy);
+    }
+};
+
+static bool loadTrace(const std::string& path, std::vector<TraceRequest>& trace)
+{
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "ERROR: Cannot open trace %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        double offset = 0.0;
+        unsigned batch = 0;
+        if (sscanf(line.c_str(), "%lf,%u", &offset, &batch) == 2 && batch > 0) {
+            trace.push_back(TraceRequest{offset, batch});
+        }
+    }
+    std::sort(trace.begin(), trace.end(),
+              [](const TraceRequest& a, const TraceRequest& b) { return a.offsetUs < b.offsetUs; });
+    return !trace.empty();
+}
+
+// DeepStream sends one request per muxer batch: `cameras` streams at `fps`
+// grouped `batch` frames per request, with a little capture jitter
+static void synthesizeTrace(uint32_t cameras, double fps, uint32_t batch, double seconds,
+                            std::vector<TraceRequest>& trace)
+{
+    std::mt19937 rng(42);
+    std::normal_distribution<double> jitter(0.0, 2000.0);
+    const uint32_t groups = std::max(1u, (cameras + batch - 1) / batch);
+    const double frameUs = 1e6 / fps;
+    for (double t = 0.0; t < seconds * 1e6; t += frameUs) {
+        for (uint32_t g = 0; g < groups; ++g) {
+            const uint32_t n = std::min(batch, cameras - g * batch);
+            const double phase = frameUs * g / groups;
+            trace.push_back(TraceRequest{std::max(0.0, t + phase + jitter(rng)), n});
+        }
+    }
+    std::sort(trace.begin(), trace.end(),
+              [](const TraceRequest& a, const TraceRequest& b) { return a.offsetUs < b.offsetUs; });
+}
+
+static double percentile(std::vector<double>& v, double p)
+{
+    if (v.empty()) {
+        return 0.0;
+    }
+    const size_t k = std::min(v.size() - 1, (size_t)std::ceil(p * v.size()) - 1);
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// Discrete-event replay against a model of the dynamic batcher. A request
+// waits at the client while `depth` requests are in flight, then in the
+// server queue until an instance is free and either a preferred batch size
+// can be formed or the oldest request has waited delayUs.
+static PointResult simulateLocal(const std::vector<TraceRequest>& trace, const TunePoint& point,
+                                 const LatencyModel& model, uint32_t maxBatch)
+{
+    struct Completion
+    {
+        double timeUs;
+        uint32_t instance;
+        std::vector<size_t> requests;
+        bool operator>(const Completion& o) const { return timeUs > o.timeUs; }
+    };
+
+    const size_t n = trace.size();
+    std::vector<double> sentUs(n, 0.0), doneUs(n, 0.0);
+    std::deque<size_t> clientWait, serverQueue;
+    std::vector<bool> instanceBusy(point.instances, false);
+    std::priority_queue<Completion, std::vector<Completion>, std::greater<Completion>> completions;
+    uint32_t inFlight = 0;
+    uint32_t busy = 0;
+    size_t nextArrival = 0;
+    double deadlineUs = -1.0;
+    double now = 0.0;
+
+    auto send = [&](size_t r) {
+        sentUs[r] = now + model.networkUs * 0.5;
+        serverQueue.push_back(r);
+        inFlight++;
+    };
+
+    auto dispatch = [&]() {
+        deadlineUs = -1.0;
+        while (busy < point.instances && !serverQueue.empty()) {
+            // Requests that fit in one batch, in queue order
+            uint32_t total = 0;
+            size_t take = 0;
+            size_t preferredTake = 0;
+            for (size_t i = 0; i < serverQueue.size(); ++i) {
+                const uint32_t b = trace[serverQueue[i]].batch;
+                if (total + b > maxBatch) {
+                    break;
+                }
+                total += b;
+                take = i + 1;
+                if (std::find(point.preferred.begin(), point.preferred.end(), total) != point.preferred.end()) {
+                    preferredTake = take;
+                }
+            }
+            const bool full = take < serverQueue.size() || total == maxBatch;
+            const double oldest = sentUs[serverQueue.front()];
+            if (preferredTake == 0 && !full && now < oldest + point.delayUs) {
+                deadlineUs = oldest + point.delayUs;
+                return;
+            }
+            if (preferredTake > 0 && !full) {
+                take = preferredTake;
+            }
+
+            Completion c;
+            uint32_t items = 0;
+            for (size_t i = 0; i < take; ++i) {
+                c.requests.push_back(serverQueue.front());
+                items += trace[serverQueue.front()].batch;
+                serverQueue.pop_front();
+            }
+            uint32_t inst = 0;
+            while (instanceBusy[inst]) {
+                ++inst;
+            }
+            instanceBusy[inst] = true;
+            c.instance = inst;
+            c.timeUs = now + model.serviceUs(items, busy);
+            busy++;
+            completions.push(c);
+        }
+    };
+
+    while (nextArrival < n || !completions.empty() || !serverQueue.empty()) {
+        const double tArrival = nextArrival < n ? trace[nextArrival].offsetUs : 1e300;
+        const double tDone = completions.empty() ? 1e300 : completions.top().timeUs;
+        const double tDeadline = deadlineUs >= 0.0 ? deadlineUs : 1e300;
+        now = std::min(tArrival, std::min(tDone, tDeadline));
+
+        if (now == tDone) {
+            Completion c = completions.top();
+            completions.pop();
+            instanceBusy[c.instance] = false;
+            busy--;
+            for (size_t r : c.requests) {
+                doneUs[r] = now + model.networkUs * 0.5;
+                inFlight--;
+                if (!clientWait.empty()) {
+                    const size_t next = clientWait.front();
+                    clientWait.pop_front();
+                    send(next);
+                }
+            }
+        } else if (now == tArrival) {
+            if (inFlight < point.depth) {
+                send(nextArrival);
+            } else {
+                clientWait.push_back(nextArrival);
+            }
+            nextArrival++;
+        }
+        dispatch();
+        if (serverQueue.empty() && completions.empty() && nextArrival >= n && !clientWait.empty()) {
+            send(clientWait.front());
+            clientWait.pop_front();
+            dispatch();
+        }
+    }
+
+    PointResult res = {point, 0.0, 0.0, 0.0, (uint64_t)n, 0};
+    std::vector<double> lat(n);
+    double items = 0.0, last = 0.0;
+    for (size_t r = 0; r < n; ++r) {
+        lat[r] = (doneUs[r] - trace[r].offsetUs) / 1000.0;
+        items += trace[r].batch;
+        last = std::max(last, doneUs[r]);
+    }
+    res.itemsPerSec = last > trace.front().offsetUs ? items * 1e6 / (last - trace.front().offsetUs) : 0.0;
+    res.p50Ms = percentile(lat, 0.50);
+    res.p99Ms = percentile(lat, 0.99);
+    return res;
+}
+
+struct RemoteOptions
+{
+    std::string endpoint;
+    std::string model;
+    std::string inputName = "input";
+    std::vector<int64_t> elementShape = {3, 640, 640};
+    std::string outputName = "output";
+    bool reconfigure = true;
+};
+
+static std::string configOverride(const TunePoint& p, uint32_t maxBatch)
+{
+    std::ostringstream os;
+    os << "{\"max_batch_size\":" << maxBatch << ",\"dynamic_batching\":{\"preferred_batch_size\":[";
+    for (size_t i = 0; i < p.preferred.size(); ++i) {
+        os << (i ? "," : "") << p.preferred[i];
+    }
+    os << "],\"max_queue_delay_microseconds\":" << p.delayUs << "},\"instance_group\":[{\"count\":" << p.instances
+       << ",\"kind\":\"KIND_GPU\"}]}";
+    return os.str();
+}
+
+// Real-time replay: a dispatcher releases requests at their trace offsets,
+// `depth` client threads with their own connections send them
+static PointResult runRemote(const std::vector<TraceRequest>& trace, const TunePoint& point,
+                             const RemoteOptions& opt, uint32_t maxBatch)
+{
+    PointResult res = {point, 0.0, 0.0, 0.0, 0, 0};
+    if (opt.reconfigure) {
+        KServeClient admin(opt.endpoint);
+        if (!admin.loadModel(opt.model, configOverride(point, maxBatch))) {
+            fprintf(stderr, "ERROR: Reconfiguring %s failed: %s\n", opt.model.c_str(), admin.lastError().c_str());
+            res.errors = trace.size();
+            return res;
+        }
+    }
+
+    size_t elements = maxBatch;
+    for (int64_t d : opt.elementShape) {
+        elements *= (size_t)d;
+    }
+    const std::vector<float> payload(elements, 0.0f);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<size_t> ready;
+    bool finished = false;
+    std::vector<double> lat(trace.size(), -1.0);
+    std::atomic<uint64_t> errors{0};
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    auto sinceStartUs = [&]() { return std::chrono::duration<double, std::micro>(Clock::now() - start).count(); };
+
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < point.depth; ++w) {
+        workers.emplace_back([&]() {
+            KServeClient client(opt.endpoint);
+            while (true) {
+                size_t r;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return !ready.empty() || finished; });
+                    if (ready.empty()) {
+                        return;
+                    }
+                    r = ready.front();
+                    ready.pop_front();
+                }
+                if (client.infer(opt.model, opt.inputName, opt.elementShape, trace[r].batch, payload.data(),
+                                 opt.outputName)) {
+                    lat[r] = (sinceStartUs() - trace[r].offsetUs) / 1000.0;
+                } else {
+                    errors++;
+                }
+            }
+        });
+    }
+
+    for (size_t r = 0; r < trace.size(); ++r) {
+        std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)trace[r].offsetUs));
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(r);
+        cv.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+    const double elapsedUs = sinceStartUs();
+
+    std::vector<double> ok;
+    double items = 0.0;
+    for (size_t r = 0; r < trace.size(); ++r) {
+        if (lat[r] >= 0.0) {
+            ok.push_back(lat[r]);
+            items += trace[r].batch;
+        }
+    }
+    res.requests = ok.size();
+    res.errors = errors.load();
+    res.itemsPerSec = elapsedUs > 0 ? items * 1e6 / elapsedUs : 0.0;
+    res.p50Ms = percentile(ok, 0.50);
+    res.p99Ms = percentile(ok, 0.99);
+    return res;
+}
+
+// Powers of two up to maxBatch, alone and in adjacent pairs; sizes below
+// the smallest request can never be formed and are skipped
+static std::vector<std::vector<uint32_t>> preferredSets(uint32_t minBatch, uint32_t maxBatch)
+{
+    std::vector<std::vector<uint32_t>> sets;
+    for (uint32_t b = 1; b <= maxBatch; b *= 2) {
+        if (b >= minBatch) {
+            sets.push_back({b});
+        }
+    }
+    for (uint32_t b = std::max(2u, minBatch); b * 2 <= maxBatch; b *= 2) {
+        sets.push_back({b, b * 2});
+    }
+    return sets;
+}
+
+static std::string preferredString(const std::vector<uint32_t>& p)
+{
+    std::string s;
+    for (size_t i = 0; i < p.size(); ++i) {
+        s += (i ? ";" : "") + std::to_string(p[i]);
+    }
+    return s;
+}
+
+int main(int argc, char** argv)
+{
+    LatencyModel model;
+    RemoteOptions remote;
+    std::string tracePath, csvPath;
+    bool local = false;
+    uint32_t cameras = 8, batch = 2, maxBatch = 8;
+    double fps = 30.0, seconds = 20.0, rateScale = 1.0, p99TargetMs = 100.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : "";
+        if (a == "--local") {
+            local = true;
+            continue;
+        }
+        if (a == "--no-reconfigure") {
+            remote.reconfigure = false;
+            continue;
+        }
+        ++i;
+        if (a == "--endpoint") {
+            remote.endpoint = v;
+        } else if (a == "--model") {
+            remote.model = v;
+        } else if (a == "--input") {
+            // name:CxHxW
+            const std::string s = v;
+            const size_t colon = s.find(':');
+            remote.inputName = s.substr(0, colon);
+            remote.elementShape.clear();
+            std::stringstream dims(colon == std::string::npos ? "" : s.substr(colon + 1));
+            std::string d;
+            while (std::getline(dims, d, 'x')) {
+                remote.elementShape.push_back(atoll(d.c_str()));
+            }
+        } else if (a == "--output") {
+            remote.outputName = v;
+        } else if (a == "--trace") {
+            tracePath = v;
+        } else if (a == "--cameras") {
+            cameras = (uint32_t)atoi(v);
+        } else if (a == "--fps") {
+            fps = atof(v);
+        } else if (a == "--batch") {
+            batch = (uint32_t)atoi(v);
+        } else if (a == "--seconds") {
+            seconds = atof(v);
+        } else if (a == "--rate-scale") {
+            rateScale = atof(v);
+        } else if (a == "--max-batch") {
+            maxBatch = (uint32_t)atoi(v);
+        } else if (a == "--p99-ms") {
+            p99TargetMs = atof(v);
+        } else if (a == "--latency") {
+            sscanf(v, "%lf,%lf", &model.fixedMs, &model.perItemMs);
+        } else if (a == "--contention") {
+            model.contention = atof(v);
+        } else if (a == "--csv") {
+            csvPath = v;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option %s (see the header of triton_batch_tuner.cpp)\n", a.c_str());
+            return 1;
+        }
+    }
+    if (!local && (remote.endpoint.empty() || remote.model.empty())) {
+        fprintf(stderr, "ERROR: Pass --local, or --endpoint and --model\n");
+        return 1;
+    }
+
+    std::vector<TraceRequest> trace;
+    if (!tracePath.empty()) {
+        if (!loadTrace(tracePath, trace)) {
+            return 1;
+        }
+    } else {
+        synthesizeTrace(cameras, fps, batch, seconds, trace);
+    }
+    for (TraceRequest& r : trace) {
+        r.offsetUs /= rateScale;
+        r.batch = std::min(r.batch, maxBatch);
+    }
+
+    if (!local) {
+        KServeClient probe(remote.endpoint);
+        if (!probe.ready()) {
+            fprintf(stderr, "ERROR: %s is not ready: %s\n", remote.endpoint.c_str(), probe.lastError().c_str());
+            return 1;
+        }
+    }
+
+    const uint32_t delays[] = {0, 100, 500, 1000, 2000, 5000, 10000};
+    const uint32_t instanceCounts[] = {1, 2, 3};
+    const uint32_t depths[] = {1, 2, 4, 8, 16};
+
+    uint32_t minRequest = maxBatch;
+    for (const TraceRequest& r : trace) {
+        minRequest = std::min(minRequest, r.batch);
+    }
+
+    std::vector<PointResult> results;
+    for (const auto& pref : preferredSets(minRequest, maxBatch)) {
+        for (uint32_t delay : delays) {
+            for (uint32_t inst : instanceCounts) {
+                for (uint32_t depth : depths) {
+                    const TunePoint p = {pref, delay, inst, depth};
+                    results.push_back(local ? simulateLocal(trace, p, model, maxBatch)
+                                            : runRemote(trace, p, remote, maxBatch));
+                }
+            }
+        }
+    }
+
+    // Cheapest settings first: fewer instances (GPU memory), shallower
+    // client queues, shorter delays. Among points with the same throughput
+    // and p99 (within 0.1%) only the cheapest one stays on the frontier.
+    std::stable_sort(results.begin(), results.end(), [](const PointResult& a, const PointResult& b) {
+        if (a.point.instances != b.point.instances) {
+            return a.point.instances < b.point.instances;
+        }
+        if (a.point.depth != b.point.depth) {
+            return a.point.depth < b.point.depth;
+        }
+        return a.point.delayUs < b.point.delayUs;
+    });
+
+    // Frontier over throughput, p99 and instance count: a point is dropped
+    // when another one is at least as good on all three and better on one
+    std::vector<const PointResult*> frontier;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const PointResult& r = results[i];
+        if (r.errors > 0) {
+            continue;
+        }
+        bool dominated = false;
+        for (size_t j = 0; j < results.size() && !dominated; ++j) {
+            const PointResult& o = results[j];
+            if (j == i || o.errors > 0) {
+                continue;
+            }
+            const bool asGood = o.itemsPerSec >= r.itemsPerSec * 0.999 && o.p99Ms <= r.p99Ms * 1.001 &&
+                                o.point.instances <= r.point.instances;
+            const bool better = o.itemsPerSec > r.itemsPerSec * 1.001 || o.p99Ms < r.p99Ms * 0.999 ||
+                                o.point.instances < r.point.instances;
+            dominated = asGood && (better || j < i);
+        }
+        if (!dominated) {
+            frontier.push_back(&r);
+        }
+    }
+    std::sort(frontier.begin(), frontier.end(),
+              [](const PointResult* a, const PointResult* b) { return a->p99Ms < b->p99Ms; });
+
+    double offeredItems = 0.0;
+    for (const TraceRequest& r : trace) {
+        offeredItems += r.batch;
+    }
+    const double offeredRate = offeredItems * 1e6 / std::max(1.0, trace.back().offsetUs - trace.front().offsetUs);
+    printf("backend=%s requests=%zu offered_items_per_sec=%.1f max_batch=%u p99_target_ms=%.1f points=%zu\n",
+           local ? "local" : remote.endpoint.c_str(), trace.size(), offeredRate, maxBatch, p99TargetMs,
+           results.size());
+    printf("%-10s %8s %9s %6s %11s %8s %8s\n", "preferred", "delay_us", "instances", "depth", "items_per_s",
+           "p50_ms", "p99_ms");
+    for (const PointResult* r : frontier) {
+        printf("%-10s %8u %9u %6u %11.1f %8.2f %8.2f\n", preferredString(r->point.preferred).c_str(),
+               r->point.delayUs, r->point.instances, r->point.depth, r->itemsPerSec, r->p50Ms, r->p99Ms);
+    }
+
+    // Recommendation: among frontier points within 2% of the best throughput
+    // that meets the p99 target, prefer fewer instances, then lower p99
+    const PointResult* best = nullptr;
+    for (const PointResult* r : frontier) {
+        if (r->p99Ms <= p99TargetMs && (!best || r->itemsPerSec > best->itemsPerSec)) {
+            best = r;
+        }
+    }
+    if (best) {
+        const PointResult* pick = best;
+        for (const PointResult* r : frontier) {
+            if (r->p99Ms <= p99TargetMs && r->itemsPerSec >= 0.98 * best->itemsPerSec &&
+                (r->point.instances < pick->point.instances ||
+                 (r->point.instances == pick->point.instances && r->p99Ms < pick->p99Ms))) {
+                pick = r;
+            }
+        }
+        printf("\nrecommended: items_per_s=%.1f p99_ms=%.2f client_depth=%u\n", pick->itemsPerSec, pick->p99Ms,
+               pick->point.depth);
+        printf("dynamic_batching {\n  max_queue_delay_microseconds: %u\n  preferred_batch_size: [ ",
+               pick->point.delayUs);
+        for (size_t i = 0; i < pick->point.preferred.size(); ++i) {
+            printf("%s%u", i ? ", " : "", pick->point.preferred[i]);
+        }
+        printf(" ]\n}\ninstance_group [ { count: %u kind: KIND_GPU } ]\n", pick->point.instances);
+    } else {
+        printf("\nno point meets p99 <= %.1f ms; lower the offered load or relax the target\n", p99TargetMs);
+    }
+
+    if (!csvPath.empty()) {
+        std::ofstream csv(csvPath);
+        csv << "preferred,delay_us,instances,depth,items_per_sec,p50_ms,p99_ms,requests,errors\n";
+        for (const PointResult& r : results) {
+            csv << preferredString(r.point.preferred) << "," << r.point.delayUs << "," << r.point.instances << ","
+                << r.point.depth << "," << r.itemsPerSec << "," << r.p50Ms << "," << r.p99Ms << "," << r.requests
+                << "," << r.errors << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,452 @@
+/*
+ * Native association service (C++20)
+ */
+
+#include "association_service.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+bool ServiceConfig::load(const std::string& path, ServiceConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "service";
+    ServiceConfig c;
+    c.threads = (uint32_t)std::max(1, kf.getInt(g, "threads", (int)c.threads));
+    c.embeddingDim = (uint32_t)std::max(0, kf.getInt(g, "embedding-dim", (int)c.embeddingDim));
+    c.queueFrames = (uint32_t)std::max(0, kf.getInt(g, "queue-frames", (int)c.queueFrames));
+    c.maxDetections = (uint32_t)std::max(0, kf.getInt(g, "max-detections", (int)c.maxDetections));
+    c.maxCameras = (uint32_t)std::max(0, kf.getInt(g, "max-cameras", (int)c.maxCameras));
+    c.unixSocket = kf.getString(g, "unix-socket", c.unixSocket);
+    c.tcpPort = (uint32_t)std::max(0, kf.getInt(g, "tcp-port", (int)c.tcpPort));
+    c.metricsPort = (uint32_t)std::max(0, kf.getInt(g, "metrics-port", (int)c.metricsPort));
+    c.snapshotPath = kf.getString(g, "snapshot-path", c.snapshotPath);
+    c.snapshotIntervalS = kf.getDouble(g, "snapshot-interval-s", c.snapshotIntervalS);
+    c.expireIntervalS = kf.getDouble(g, "expire-interval-s", c.expireIntervalS);
+    if (c.embeddingDim == 0 || c.queueFrames == 0 || c.maxDetections == 0 || c.tcpPort > 65535 ||
+        c.maxCameras == 0 || c.maxCameras > GlobalAssociator::kMaxCameras ||
+        c.metricsPort > 65535 || c.snapshotIntervalS <= 0.0 || c.expireIntervalS <= 0.0) {
+        std::cerr << "ERROR: " << path << ": [service] needs positive embedding-dim, queue-frames, "
+                  << "max-detections and intervals, max-cameras up to " << GlobalAssociator::kMaxCameras
+                  << " and ports below 65536" << std::endl;
+        return false;
+    }
+    if (c.unixSocket.size() >= sizeof(((sockaddr_un*)nullptr)->sun_path)) {
+        std::cerr << "ERROR: " << path << ": unix-socket path is too long" << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+static int listenUnix(const std::string& path)
+{
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listenTcp(uint32_t port, uint16_t& bound)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    socklen_t length = sizeof(addr);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0 ||
+        getsockname(fd, (sockaddr*)&addr, &length) != 0) {
+        close(fd);
+        return -1;
+    }
+    bound = ntohs(addr.sin_port);
+    return fd;
+}
+
+AssociationService::AssociationService(const ServiceConfig& config, const AssociatorConfig& associator)
+    : m_Config(config), m_Associator(associator, config.embeddingDim), m_AssociatorLock(m_Loop),
+      m_Slots(config.queueFrames), m_Free(m_Loop, config.queueFrames), m_Ready(m_Loop, config.queueFrames)
+{
+    // Every buffer is sized up front; frames only ever move slot indices
+    for (uint32_t i = 0; i < config.queueFrames; ++i) {
+        m_Slots[i].detections.resize(config.maxDetections);
+        m_Slots[i].embeddings.resize((size_t)config.maxDetections * config.embeddingDim);
+        m_Free.tryPush(i);
+    }
+}
+
+AssociationService::~AssociationService()
+{
+    for (int fd : {m_UnixFd, m_TcpFd, m_MetricsFd}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (m_UnixFd >= 0) {
+        unlink(m_Config.unixSocket.c_str());
+    }
+}
+
+std::unique_ptr<AssociationService> AssociationService::create(const ServiceConfig& config,
+                                                               const AssociatorConfig& associator)
+{
+    std::unique_ptr<AssociationService> service(new AssociationService(config, associator));
+    if (!service->m_Loop.valid()) {
+        return nullptr;
+    }
+    if (!config.unixSocket.empty()) {
+        service->m_UnixFd = listenUnix(config.unixSocket);
+        if (service->m_UnixFd < 0) {
+            std::cerr << "ERROR: Cannot listen on " << config.unixSocket << ": " << strerror(errno) << std::endl;
+            return nullptr;
+        }
+    }
+    if (config.tcpPort != 0) {
+        service->m_TcpFd = listenTcp(config.tcpPort, service->m_TcpPort);
+        if (service->m_TcpFd < 0) {
+            std::cerr << "ERROR: Cannot listen on port " << config.tcpPort << ": " << strerror(errno) << std::endl;
+            return nullptr;
+        }
+    }
+    if (config.metricsPort != 0) {
+        service->m_MetricsFd = listenTcp(config.metricsPort, service->m_MetricsPort);
+        if (service->m_MetricsFd < 0) {
+            std::cerr << "ERROR: Cannot listen on metrics port " << config.metricsPort << ": " << strerror(errno)
+                      << std::endl;
+            return nullptr;
+        }
+    }
+    return service;
+}
+
+bool AssociationService::submit(uint32_t camera, uint64_t timestampUs, const ServiceDetection* detections,
+                                uint32_t count, const float* embeddings)
+{
+    if (camera >= m_Config.maxCameras) {
+        m_ProtocolErrors.fetch_add(1, std::memory_order_relaxed);
+        m_FramesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    uint32_t index;
+    if (count > m_Config.maxDetections || m_Loop.stopping() || !m_Free.tryPop(index)) {
+        m_FramesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    FrameSlot& slot = m_Slots[index];
+    slot.camera = camera;
+    slot.timestampUs = timestampUs;
+    slot.count = count;
+    slot.hasEmbeddings = embeddings != nullptr;
+    std::copy(detections, detections + count, slot.detections.begin());
+    if (embeddings) {
+        std::copy(embeddings, embeddings + (size_t)count * m_Config.embeddingDim, slot.embeddings.begin());
+    }
+    // m_Ready holds every slot, so this only fails once stop() closed it
+    if (!m_Ready.tryPush(index)) {
+        m_Free.tryPush(index);
+        m_FramesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_FramesIn.fetch_add(1, std::memory_order_relaxed);
+    m_DetectionsIn.fetch_add(count, std::memory_order_relaxed);
+    return true;
+}
+
+void AssociationService::process(const FrameSlot& slot)
+{
+    for (uint32_t i = 0; i < slot.count; ++i) {
+        const ServiceDetection& d = slot.detections[i];
+        if (d.localId >> 48) {
+            // The associator keys (camera, local id) pairs in 64 bits
+            m_ProtocolErrors.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        switch (d.event) {
+        case kServiceObserve: {
+            AssociationInput input;
+            input.camera = slot.camera;
+            input.localId = d.localId;
+            input.confidence = d.confidence;
+            input.box = d.box;
+            input.embedding = slot.hasEmbeddings ? &slot.embeddings[(size_t)i * m_Config.embeddingDim] : nullptr;
+            m_Associator.associate(input, slot.timestampUs);
+            break;
+        }
+        case kServiceLost:
+            m_Associator.suspendLocalTrack(slot.camera, d.localId, d.box, d.vx, d.vy, slot.timestampUs);
+            break;
+        case kServiceEnded:
+            m_Associator.endLocalTrack(slot.camera, d.localId);
+            break;
+        default:
+            m_ProtocolErrors.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+    // Expiry runs on stream time so replays behave like live sources
+    if (slot.timestampUs >= m_LastExpireUs + (uint64_t)(m_Config.expireIntervalS * 1e6)) {
+        m_Associator.expire(slot.timestampUs);
+        m_LastExpireUs = slot.timestampUs;
+    }
+}
+
+Task AssociationService::associateLoop()
+{
+    uint32_t index;
+    while (co_await m_Ready.pop(index)) {
+        co_await m_AssociatorLock.lock();
+        process(m_Slots[index]);
+        m_AssociatorLock.unlock();
+        m_FramesProcessed.fetch_add(1, std::memory_order_relaxed);
+        m_Free.tryPush(index);
+    }
+}
+
+bool AssociationService::writeSnapshotFile()
+{
+    std::string text;
+    m_Associator.writeSnapshot(text);
+    const std::string tmp = m_Config.snapshotPath + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        std::cerr << "ERROR: Cannot write " << tmp << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    const bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+    if (fclose(f) != 0 || !ok || rename(tmp.c_str(), m_Config.snapshotPath.c_str()) != 0) {
+        std::cerr << "ERROR: Cannot write " << m_Config.snapshotPath << ": " << strerror(errno) << std::endl;
+        unlink(tmp.c_str());
+        return false;
+    }
+    m_Snapshots.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+Task AssociationService::snapshotLoop()
+{
+    const std::chrono::microseconds interval((int64_t)(m_Config.snapshotIntervalS * 1e6));
+    while (co_await m_Loop.sleepFor(interval)) {
+        co_await m_AssociatorLock.lock();
+        writeSnapshotFile();
+        m_AssociatorLock.unlock();
+    }
+}
+
+bool AssociationService::track(int fd)
+{
+    std::lock_guard<std::mutex> lock(m_FdMutex);
+    if (m_Loop.stopping()) {
+        return false;
+    }
+    m_OpenFds.push_back(fd);
+    return true;
+}
+
+void AssociationService::untrack(int fd)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_FdMutex);
+        m_OpenFds.erase(std::remove(m_OpenFds.begin(), m_OpenFds.end(), fd), m_OpenFds.end());
+    }
+    close(fd);
+}
+
+Task AssociationService::acceptLoop(int listenFd, bool metrics)
+{
+    while (!m_Loop.stopping()) {
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // EINVAL once stop() shut the socket down
+                if (!m_Loop.stopping()) {
+                    std::cerr << "ERROR: accept failed: " << strerror(errno) << std::endl;
+                }
+                break;
+            }
+            const uint32_t events = co_await m_Loop.readable(listenFd);
+            if (events == 0) {
+                break;
+            }
+            continue;
+        }
+        if (!track(fd)) {
+            close(fd);
+            break;
+        }
+        m_Connections.fetch_add(1, std::memory_order_relaxed);
+        m_Loop.spawn(metrics ? metricsConnection(fd) : ingestConnection(fd));
+    }
+}
+
+Task AssociationService::ingestConnection(int fd)
+{
+    const uint32_t dim = m_Config.embeddingDim;
+    ServiceFrameHeader header;
+    while (co_await m_Loop.readAll(fd, &header, sizeof(header))) {
+        if (header.magic != ASSOCIATION_WIRE_MAGIC || header.count > m_Config.maxDetections ||
+            header.camera >= m_Config.maxCameras ||
+            (header.embeddingDim != 0 && header.embeddingDim != dim)) {
+            m_ProtocolErrors.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        // Waiting here stops reading the socket: back-pressure, not drops
+        uint32_t index;
+        if (!(co_await m_Free.pop(index))) {
+            break;
+        }
+        FrameSlot& slot = m_Slots[index];
+        slot.camera = header.camera;
+        slot.timestampUs = header.timestampUs;
+        slot.count = header.count;
+        slot.hasEmbeddings = header.embeddingDim != 0;
+        bool ok = co_await m_Loop.readAll(fd, slot.detections.data(), header.count * sizeof(ServiceDetection));
+        if (ok && slot.hasEmbeddings) {
+            ok = co_await m_Loop.readAll(fd, slot.embeddings.data(), (size_t)header.count * dim * sizeof(float));
+        }
+        if (!ok || !m_Ready.tryPush(index)) {
+            m_Free.tryPush(index);
+            break;
+        }
+        m_FramesIn.fetch_add(1, std::memory_order_relaxed);
+        m_DetectionsIn.fetch_add(header.count, std::memory_order_relaxed);
+    }
+    untrack(fd);
+}
+
+Task AssociationService::metricsConnection(int fd)
+{
+    char request[2048];
+    size_t used = 0;
+    bool complete = false;
+    while (!complete && used < sizeof(request) - 1) {
+        const ssize_t n = read(fd, request + used, sizeof(request) - 1 - used);
+        if (n > 0) {
+            used += (size_t)n;
+            request[used] = '\0';
+            complete = strstr(request, "\r\n\r\n") != nullptr;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            if ((co_await m_Loop.readable(fd)) == 0) {
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+
+    if (complete) {
+        std::string body;
+        const char* status = "404 Not Found";
+        if (strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0) {
+            status = "200 OK";
+            co_await m_AssociatorLock.lock();
+            writeMetrics(body);
+            m_AssociatorLock.unlock();
+        }
+        std::ostringstream os;
+        os << "HTTP/1.1 " << status << "\r\n"
+           << "Content-Type: text/plain; version=0.0.4\r\n"
+           << "Content-Length: " << body.size() << "\r\n"
+           << "Connection: close\r\n\r\n";
+        const std::string head = os.str();
+        if (co_await m_Loop.writeAll(fd, head.data(), head.size())) {
+            co_await m_Loop.writeAll(fd, body.data(), body.size());
+        }
+    }
+    untrack(fd);
+}
+
+void AssociationService::writeMetrics(std::string& out)
+{
+    m_Associator.writePrometheus(out);
+    std::ostringstream os;
+    os << "# TYPE deepstream_tracking_service_frames_received_total counter\n"
+       << "deepstream_tracking_service_frames_received_total " << m_FramesIn.load() << "\n"
+       << "# TYPE deepstream_tracking_service_frames_dropped_total counter\n"
+       << "deepstream_tracking_service_frames_dropped_total " << m_FramesDropped.load() << "\n"
+       << "# TYPE deepstream_tracking_service_frames_processed_total counter\n"
+       << "deepstream_tracking_service_frames_processed_total " << m_FramesProcessed.load() << "\n"
+       << "# TYPE deepstream_tracking_service_detections_received_total counter\n"
+       << "deepstream_tracking_service_detections_received_total " << m_DetectionsIn.load() << "\n"
+       << "# TYPE deepstream_tracking_service_queued_frames gauge\n"
+       << "deepstream_tracking_service_queued_frames " << m_Ready.size() << "\n"
+       << "# TYPE deepstream_tracking_service_connections_total counter\n"
+       << "deepstream_tracking_service_connections_total " << m_Connections.load() << "\n"
+       << "# TYPE deepstream_tracking_service_protocol_errors_total counter\n"
+       << "deepstream_tracking_service_protocol_errors_total " << m_ProtocolErrors.load() << "\n"
+       << "# TYPE deepstream_tracking_service_snapshots_total counter\n"
+       << "deepstream_tracking_service_snapshots_total " << m_Snapshots.load() << "\n";
+    out += os.str();
+}
+
+void AssociationService::run()
+{
+    m_Loop.spawn(associateLoop());
+    if (!m_Config.snapshotPath.empty()) {
+        m_Loop.spawn(snapshotLoop());
+    }
+    for (int fd : {m_UnixFd, m_TcpFd}) {
+        if (fd >= 0) {
+            m_Loop.spawn(acceptLoop(fd, false));
+        }
+    }
+    if (m_MetricsFd >= 0) {
+        m_Loop.spawn(acceptLoop(m_MetricsFd, true));
+    }
+    m_Loop.run(m_Config.threads);
+
+    // Every task has finished and the queue is drained
+    if (!m_Config.snapshotPath.empty()) {
+        writeSnapshotFile();
+    }
+}
+
+void AssociationService::stop()
+{
+    m_Loop.stop();
+    {
+        std::lock_guard<std::mutex> lock(m_FdMutex);
+        for (int fd : {m_UnixFd, m_TcpFd, m_MetricsFd}) {
+            if (fd >= 0) {
+                shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (int fd : m_OpenFds) {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+    m_Free.close();
+    m_Ready.close();
+}
@@ -0,0 +1,178 @@
+/*
+ * Native association service (C++20)
+ *
+ * Hosts the GlobalAssociator behind the coroutine runtime in
+ * event_loop.h instead of asyncio tasks created from GStreamer callbacks.
+ * Everything runs as a handful of cooperative tasks on a `threads`-sized
+ * pool:
+ *
+ *   ingest     submit() from pad probes, on any thread, copies a frame of
+ *              tracker output into a preallocated slot; socket clients
+ *              (Unix and/or TCP) stream the same frames in the wire format
+ *              below, one task per connection
+ *   associate  one task drains the frame queue into the associator, runs
+ *              re-stitching and expiry on stream time
+ *   snapshot   every snapshot-interval-s the live global tracks are written
+ *              to snapshot-path as JSON lines (temp file + rename)
+ *   metrics    Prometheus text on http://<host>:metrics-port/metrics
+ *
+ * Frames travel through a pool of queue-frames slots sized for
+ * max-detections detections of embedding-dim floats, so steady state does
+ * no allocation per frame or per detection. When every slot is taken,
+ * submit() drops the frame (a probe must never block the pipeline) and
+ * socket clients are paused until a slot frees up (back-pressure through
+ * TCP). The associator is only touched under an AsyncMutex, so the
+ * snapshot and metrics tasks never race the associate task.
+ *
+ * Wire format, little endian, per frame: ServiceFrameHeader, then `count`
+ * ServiceDetection, then `count` * embeddingDim floats (embeddingDim 0 =
+ * no embeddings, otherwise it must equal the service's embedding-dim).
+ * Frames from cameras at or above max-cameras and detections whose local id
+ * does not fit in 48 bits are protocol errors.
+ *
+ * Config (key file format, see configs/association_service.txt):
+ *
+ *   [service]
+ *   threads=2
+ *   embedding-dim=512
+ *   queue-frames=64
+ *   max-detections=256
+ *   max-cameras=256                                # at most 65536
+ *   unix-socket=/tmp/deepstream-association.sock   # empty = off
+ *   tcp-port=0                                     # 0 = off
+ *   metrics-port=9464                              # 0 = off
+ *   snapshot-path=/tmp/global_tracks.jsonl         # empty = off
+ *   snapshot-interval-s=10
+ *   expire-interval-s=1
+ */
+
+#ifndef __ASSOCIATION_SERVICE_H__
+#define __ASSOCIATION_SERVICE_H__
+
+#include "event_loop.h"
+#include "global_associator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define ASSOCIATION_WIRE_MAGIC 0x31565341u  // "ASV1"
+
+enum ServiceEvent : uint32_t
+{
+    kServiceObserve = 0,  // a matched detection of a confirmed track
+    kServiceLost = 1,     // the track went into shadow (re-stitch candidate)
+    kServiceEnded = 2,    // the tracker terminated the track
+};
+
+struct ServiceFrameHeader
+{
+    uint32_t magic;
+    uint32_t camera;
+    uint64_t timestampUs;
+    uint32_t count;
+    uint32_t embeddingDim;
+};
+
+struct ServiceDetection
+{
+    uint64_t localId;
+    uint32_t event;  // ServiceEvent
+    float confidence;
+    TrackBox box;
+    float vx, vy;  // pixels per second, for kServiceLost
+};
+
+struct ServiceConfig
+{
+    uint32_t threads = 2;
+    uint32_t embeddingDim = 512;
+    uint32_t queueFrames = 64;
+    uint32_t maxDetections = 256;
+    uint32_t maxCameras = 256;
+    std::string unixSocket = "/tmp/deepstream-association.sock";
+    uint32_t tcpPort = 0;
+    uint32_t metricsPort = 9464;
+    std::string snapshotPath = "/tmp/global_tracks.jsonl";
+    double snapshotIntervalS = 10.0;
+    double expireIntervalS = 1.0;
+
+    static bool load(const std::string& path, ServiceConfig& config);
+};
+
+class AssociationService
+{
+public:
+    // Binds the configured sockets; nullptr on failure
+    static std::unique_ptr<AssociationService> create(const ServiceConfig& config,
+                                                      const AssociatorConfig& associator);
+    ~AssociationService();
+
+    // Any thread, never blocks; false when the frame was dropped (no free
+    // slot, too many detections, camera out of range or stopping)
+    bool submit(uint32_t camera, uint64_t timestampUs, const ServiceDetection* detections, uint32_t count,
+                const float* embeddings);
+
+    // Runs every task until stop()
+    void run();
+    // Any thread
+    void stop();
+
+    uint16_t metricsPort() const { return m_MetricsPort; }
+    uint16_t tcpPort() const { return m_TcpPort; }
+
+private:
+    struct FrameSlot
+    {
+        uint32_t camera;
+        uint64_t timestampUs;
+        uint32_t count;
+        bool hasEmbeddings;
+        std::vector<ServiceDetection> detections;
+        std::vector<float> embeddings;
+    };
+
+    AssociationService(const ServiceConfig& config, const AssociatorConfig& associator);
+
+    Task associateLoop();
+    Task snapshotLoop();
+    Task acceptLoop(int listenFd, bool metrics);
+    Task ingestConnection(int fd);
+    Task metricsConnection(int fd);
+
+    void process(const FrameSlot& slot);
+    bool writeSnapshotFile();  // caller holds m_AssociatorLock or the loop is done
+    void writeMetrics(std::string& out);
+    bool track(int fd);
+    void untrack(int fd);
+
+    ServiceConfig m_Config;
+    EventLoop m_Loop;
+    GlobalAssociator m_Associator;
+    AsyncMutex m_AssociatorLock;
+    std::vector<FrameSlot> m_Slots;
+    AsyncQueue<uint32_t> m_Free;
+    AsyncQueue<uint32_t> m_Ready;
+    uint64_t m_LastExpireUs = 0;
+
+    int m_UnixFd = -1;
+    int m_TcpFd = -1;
+    int m_MetricsFd = -1;
+    uint16_t m_TcpPort = 0;
+    uint16_t m_MetricsPort = 0;
+    std::mutex m_FdMutex;
+    std::vector<int> m_OpenFds;  // sockets to shut down on stop()
+
+    std::atomic<uint64_t> m_FramesIn{0};
+    std::atomic<uint64_t> m_FramesDropped{0};
+    std::atomic<uint64_t> m_FramesProcessed{0};
+    std::atomic<uint64_t> m_DetectionsIn{0};
+    std::atomic<uint64_t> m_Connections{0};
+    std::atomic<uint64_t> m_ProtocolErrors{0};
+    std::atomic<uint64_t> m_Snapshots{0};
+};
+
+#endif
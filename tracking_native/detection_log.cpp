@@ -0,0 +1,261 @@
+/*
+ * Columnar detection log
+ */
+
+#include "detection_log.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::string NpyColumnWriter::header(uint64_t rows) const
+{
+    std::string shape = "(" + std::to_string(rows) + ",";
+    for (size_t i = 0; i < m_Trailing.size(); ++i) {
+        shape += (i ? ", " : " ") + std::to_string(m_Trailing[i]);
+    }
+    shape += ")";
+    std::string dict = "{'descr': '" + m_Descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+    // Fixed-size header so the row count can be rewritten in place; magic
+    // (6) + version (2) + length (2) + dict + padding + '\n' = 128 bytes
+    dict.resize(127 - 10, ' ');
+    dict += '\n';
+    std::string h("\x93NUMPY\x01\x00", 8);
+    h += (char)(dict.size() & 0xff);
+    h += (char)(dict.size() >> 8);
+    return h + dict;
+}
+
+bool NpyColumnWriter::open(const std::string& path, const std::string& descr, size_t elementSize,
+                           const std::vector<uint64_t>& trailing)
+{
+    close();
+    m_Descr = descr;
+    m_Trailing = trailing;
+    m_RowBytes = elementSize;
+    for (uint64_t d : trailing) {
+        m_RowBytes *= (size_t)d;
+    }
+    m_Rows = 0;
+    m_File = fopen(path.c_str(), "wb");
+    if (!m_File) {
+        std::cerr << "ERROR: Cannot create " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    const std::string h = header(0);
+    return fwrite(h.data(), 1, h.size(), m_File) == h.size();
+}
+
+bool NpyColumnWriter::append(const void* data, uint64_t rows)
+{
+    const size_t n = (size_t)rows * m_RowBytes;
+    if (!m_File || fwrite(data, 1, n, m_File) != n) {
+        return false;
+    }
+    m_Rows += rows;
+    return true;
+}
+
+bool NpyColumnWriter::close()
+{
+    if (!m_File) {
+        return true;
+    }
+    const std::string h = header(m_Rows);
+    bool ok = fseek(m_File, 0, SEEK_SET) == 0 && fwrite(h.data(), 1, h.size(), m_File) == h.size();
+    ok = fclose(m_File) == 0 && ok;
+    m_File = nullptr;
+    return ok;
+}
+
+bool DetectionLogWriter::open(const std::string& dir, uint32_t embeddingDim, bool withIdentity)
+{
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "ERROR: Cannot create " << dir << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    m_Dim = embeddingDim;
+    m_WithIdentity = withIdentity;
+    m_Rows = 0;
+    m_Zeros.assign(embeddingDim, 0.0f);
+    const std::string p = dir + "/";
+    bool ok = m_Timestamp.open(p + "timestamp_us.npy", "<i8", 8, {}) &&
+              m_Camera.open(p + "camera.npy", "<u4", 4, {}) && m_LocalId.open(p + "local_id.npy", "<u8", 8, {}) &&
+              m_Box.open(p + "box.npy", "<f4", 4, {4}) && m_Confidence.open(p + "confidence.npy", "<f4", 4, {}) &&
+              m_GlobalId.open(p + "global_id.npy", "<u8", 8, {}) &&
+              m_Embedding.open(p + "embedding.npy", "<f4", 4, {embeddingDim});
+    if (ok && withIdentity) {
+        ok = m_Identity.open(p + "identity.npy", "<u8", 8, {});
+    } else if (!withIdentity) {
+        unlink((p + "identity.npy").c_str());
+    }
+    return ok;
+}
+
+bool DetectionLogWriter::append(const DetectionLogRow& row, const float* embedding)
+{
+    const float box[4] = {row.box.left, row.box.top, row.box.width, row.box.height};
+    bool ok = m_Timestamp.append(&row.timestampUs, 1) && m_Camera.append(&row.camera, 1) &&
+              m_LocalId.append(&row.localId, 1) && m_Box.append(box, 1) && m_Confidence.append(&row.confidence, 1) &&
+              m_GlobalId.append(&row.globalId, 1) && m_Embedding.append(embedding ? embedding : m_Zeros.data(), 1);
+    if (ok && m_WithIdentity) {
+        ok = m_Identity.append(&row.identity, 1);
+    }
+    if (ok) {
+        m_Rows++;
+    }
+    return ok;
+}
+
+bool DetectionLogWriter::close()
+{
+    bool ok = m_Timestamp.close();
+    ok = m_Camera.close() && ok;
+    ok = m_LocalId.close() && ok;
+    ok = m_Box.close() && ok;
+    ok = m_Confidence.close() && ok;
+    ok = m_GlobalId.close() && ok;
+    ok = m_Embedding.close() && ok;
+    ok = m_Identity.close() && ok;
+    return ok;
+}
+
+DetectionLog::~DetectionLog()
+{
+    for (Mapped& c : m_Columns) {
+        if (c.base) {
+            munmap(c.base, c.length);
+        }
+    }
+}
+
+// Parses a version 1/2 .npy header: little-endian descr, C order
+bool DetectionLog::mapColumn(const std::string& path, const char* descr, Mapped& column)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 12) {
+        std::cerr << "ERROR: " << path << " is not a .npy file" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "ERROR: Could not map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    column.base = addr;
+    column.length = (size_t)st.st_size;
+
+    const unsigned char* p = (const unsigned char*)addr;
+    if (memcmp(p, "\x93NUMPY", 6) != 0 || (p[6] != 1 && p[6] != 2)) {
+        std::cerr << "ERROR: " << path << " is not a .npy file" << std::endl;
+        return false;
+    }
+    const size_t prefix = p[6] == 1 ? 10 : 12;
+    const size_t headerLen = p[6] == 1 ? (size_t)(p[8] | p[9] << 8)
+                                       : (size_t)(p[8] | p[9] << 8 | p[10] << 16 | (size_t)p[11] << 24);
+    if (prefix + headerLen > column.length) {
+        std::cerr << "ERROR: " << path << " has a truncated header" << std::endl;
+        return false;
+    }
+    const std::string dict((const char*)p + prefix, headerLen);
+    if (dict.find(std::string("'descr': '") + descr + "'") == std::string::npos ||
+        dict.find("'fortran_order': False") == std::string::npos) {
+        std::cerr << "ERROR: " << path << " must be a C-order " << descr << " array" << std::endl;
+        return false;
+    }
+    const size_t shapeBegin = dict.find("'shape': (");
+    const size_t shapeEnd = shapeBegin == std::string::npos ? shapeBegin : dict.find(')', shapeBegin);
+    if (shapeEnd == std::string::npos) {
+        std::cerr << "ERROR: " << path << " has no shape" << std::endl;
+        return false;
+    }
+    const std::string shape = dict.substr(shapeBegin + 10, shapeEnd - shapeBegin - 10);
+    size_t pos = 0;
+    while (pos < shape.size()) {
+        const size_t comma = shape.find(',', pos);
+        const std::string item = shape.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        if (item.find_first_of("0123456789") != std::string::npos) {
+            column.shape.push_back(strtoull(item.c_str(), nullptr, 10));
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    size_t bytes = (size_t)(descr[2] - '0');
+    for (uint64_t d : column.shape) {
+        bytes *= (size_t)d;
+    }
+    if (column.shape.empty() || prefix + headerLen + bytes > column.length) {
+        std::cerr << "ERROR: " << path << " is shorter than its shape" << std::endl;
+        return false;
+    }
+    column.data = p + prefix + headerLen;
+    return true;
+}
+
+std::unique_ptr<DetectionLog> DetectionLog::open(const std::string& dir)
+{
+    static const char* names[kNumColumns] = {"timestamp_us", "camera",    "local_id",  "box",
+                                             "confidence",   "global_id", "embedding", "identity"};
+    static const char* descrs[kNumColumns] = {"<i8", "<u4", "<u8", "<f4", "<f4", "<u8", "<f4", "<u8"};
+
+    std::unique_ptr<DetectionLog> log(new DetectionLog());
+    for (int c = 0; c < kNumColumns; ++c) {
+        const std::string path = dir + "/" + names[c] + ".npy";
+        if (c == kIdentity && access(path.c_str(), F_OK) != 0) {
+            continue;
+        }
+        if (!mapColumn(path, descrs[c], log->m_Columns[c])) {
+            return nullptr;
+        }
+    }
+
+    log->m_Rows = log->m_Columns[kTimestamp].shape[0];
+    for (int c = 0; c < kNumColumns; ++c) {
+        const Mapped& m = log->m_Columns[c];
+        if (m.data && m.shape[0] != log->m_Rows) {
+            std::cerr << "ERROR: " << dir << "/" << names[c] << ".npy has " << m.shape[0] << " rows, expected "
+                      << log->m_Rows << std::endl;
+            return nullptr;
+        }
+    }
+    if (log->m_Columns[kBox].shape.size() != 2 || log->m_Columns[kBox].shape[1] != 4 ||
+        log->m_Columns[kEmbedding].shape.size() != 2) {
+        std::cerr << "ERROR: " << dir << ": box must be [rows, 4] and embedding [rows, dim]" << std::endl;
+        return nullptr;
+    }
+    log->m_Dim = (uint32_t)log->m_Columns[kEmbedding].shape[1];
+    return log;
+}
+
+bool DetectionLog::writeColumn(const std::string& dir, const std::string& name, const std::vector<uint64_t>& values)
+{
+    const std::string path = dir + "/" + name + ".npy";
+    const std::string tmp = path + ".tmp";
+    NpyColumnWriter w;
+    if (!w.open(tmp, "<u8", 8, {}) || !w.append(values.data(), values.size()) || !w.close()) {
+        std::cerr << "ERROR: Cannot write " << tmp << std::endl;
+        unlink(tmp.c_str());
+        return false;
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "ERROR: Cannot replace " << path << ": " << strerror(errno) << std::endl;
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,137 @@
+/*
+ * Columnar detection log
+ *
+ * The associated detections of a recording, one row per detection in
+ * stream time order, stored as a directory of NumPy .npy files, one per
+ * column, so offline jobs and notebooks read only the columns they need
+ * (np.load(..., mmap_mode='r') works on every file):
+ *
+ *   timestamp_us.npy   <i8  [rows]      stream time
+ *   camera.npy         <u4  [rows]      source id
+ *   local_id.npy       <u8  [rows]      tracker-local track id
+ *   box.npy            <f4  [rows, 4]   left, top, width, height
+ *   confidence.npy     <f4  [rows]
+ *   global_id.npy      <u8  [rows]      online associator decision, 0 while provisional
+ *   embedding.npy      <f4  [rows, dim] ReID feature as produced
+ *   identity.npy       <u8  [rows]      optional ground truth (0 = unknown)
+ *
+ * Offline jobs add result columns of their own (for example offline_id.npy
+ * from the tracklet linker) with writeColumn(); a column is written to a
+ * temporary file and renamed into place, so readers never see half of it.
+ *
+ * The reader maps the files instead of loading them: a day of 512-d
+ * embeddings does not fit in memory, and the linker only touches the rows
+ * it summarises.
+ */
+
+#ifndef __DETECTION_LOG_H__
+#define __DETECTION_LOG_H__
+
+#include "iou_tracker.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct DetectionLogRow
+{
+    int64_t timestampUs;
+    uint32_t camera;
+    uint64_t localId;
+    TrackBox box;
+    float confidence;
+    uint64_t globalId;
+    uint64_t identity;
+};
+
+// Streams one .npy column; the row count in the header is patched on close
+class NpyColumnWriter
+{
+public:
+    NpyColumnWriter() : m_File(nullptr), m_RowBytes(0), m_Rows(0) {}
+    ~NpyColumnWriter() { close(); }
+
+    // descr is the NumPy type string ("<f4", "<u8", ...)
+    bool open(const std::string& path, const std::string& descr, size_t elementSize,
+              const std::vector<uint64_t>& trailing);
+    bool append(const void* data, uint64_t rows);
+    bool close();
+
+private:
+    std::string header(uint64_t rows) const;
+
+    FILE* m_File;
+    std::string m_Descr;
+    std::vector<uint64_t> m_Trailing;
+    size_t m_RowBytes;
+    uint64_t m_Rows;
+};
+
+class DetectionLogWriter
+{
+public:
+    // Creates the directory if needed and replaces any log in it
+    bool open(const std::string& dir, uint32_t embeddingDim, bool withIdentity);
+    // `embedding` is embeddingDim floats, or null for zeros
+    bool append(const DetectionLogRow& row, const float* embedding);
+    bool close();
+
+    uint64_t rows() const { return m_Rows; }
+
+private:
+    NpyColumnWriter m_Timestamp, m_Camera, m_LocalId, m_Box, m_Confidence, m_GlobalId, m_Embedding, m_Identity;
+    uint32_t m_Dim = 0;
+    bool m_WithIdentity = false;
+    uint64_t m_Rows = 0;
+    std::vector<float> m_Zeros;
+};
+
+class DetectionLog
+{
+public:
+    // Maps every column of the log in `dir`; nullptr when a required column
+    // is missing or the shapes disagree
+    static std::unique_ptr<DetectionLog> open(const std::string& dir);
+    ~DetectionLog();
+
+    uint64_t rows() const { return m_Rows; }
+    uint32_t embeddingDim() const { return m_Dim; }
+
+    const int64_t* timestampUs() const { return (const int64_t*)m_Columns[kTimestamp].data; }
+    const uint32_t* camera() const { return (const uint32_t*)m_Columns[kCamera].data; }
+    const uint64_t* localId() const { return (const uint64_t*)m_Columns[kLocalId].data; }
+    const float* box() const { return (const float*)m_Columns[kBox].data; }
+    const float* confidence() const { return (const float*)m_Columns[kConfidence].data; }
+    const uint64_t* globalId() const { return (const uint64_t*)m_Columns[kGlobalId].data; }
+    const float* embedding(uint64_t row) const
+    {
+        return (const float*)m_Columns[kEmbedding].data + (size_t)row * m_Dim;
+    }
+    // null when the log has no ground truth
+    const uint64_t* identity() const { return (const uint64_t*)m_Columns[kIdentity].data; }
+
+    // Writes (or replaces) <dir>/<name>.npy as a <u8 [rows] column
+    static bool writeColumn(const std::string& dir, const std::string& name, const std::vector<uint64_t>& values);
+
+private:
+    enum Column { kTimestamp, kCamera, kLocalId, kBox, kConfidence, kGlobalId, kEmbedding, kIdentity, kNumColumns };
+
+    struct Mapped
+    {
+        void* base = nullptr;
+        size_t length = 0;
+        const void* data = nullptr;
+        std::vector<uint64_t> shape;
+    };
+
+    DetectionLog() = default;
+    static bool mapColumn(const std::string& path, const char* descr, Mapped& column);
+
+    Mapped m_Columns[kNumColumns];
+    uint64_t m_Rows = 0;
+    uint32_t m_Dim = 0;
+};
+
+#endif
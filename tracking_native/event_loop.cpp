@@ -0,0 +1,224 @@
+/*
+ * Coroutine event loop for the native tracking services (C++20)
+ */
+
+#include "event_loop.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+void Task::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> h) noexcept
+{
+    EventLoop* loop = h.promise().loop;
+    h.destroy();
+    if (loop) {
+        loop->taskDone();
+    }
+}
+
+EventLoop::EventLoop()
+    : m_Epoll(epoll_create1(EPOLL_CLOEXEC)), m_WakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), m_Stopping(false),
+      m_Tasks(0), m_Idle(0)
+{
+    if (m_Epoll < 0 || m_WakeFd < 0) {
+        std::cerr << "ERROR: Cannot create event loop: " << strerror(errno) << std::endl;
+        return;
+    }
+    // Level-triggered, data.ptr null: wakes threads parked in epoll_wait
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_WakeFd, &ev) != 0) {
+        std::cerr << "ERROR: Cannot register event loop wake-up: " << strerror(errno) << std::endl;
+        close(m_WakeFd);
+        m_WakeFd = -1;
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    if (m_WakeFd >= 0) {
+        close(m_WakeFd);
+    }
+    if (m_Epoll >= 0) {
+        close(m_Epoll);
+    }
+}
+
+void EventLoop::spawn(Task task)
+{
+    std::coroutine_handle<Task::promise_type> h = task.m_Handle;
+    task.m_Handle = nullptr;
+    h.promise().loop = this;
+    m_Tasks.fetch_add(1);
+    post(h);
+}
+
+void EventLoop::post(std::coroutine_handle<> h)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Ready.push_back(h);
+    }
+    if (m_Idle.load() > 0) {
+        wake();
+    }
+}
+
+void EventLoop::wake()
+{
+    const uint64_t one = 1;
+    if (write(m_WakeFd, &one, sizeof(one)) < 0) {
+        // Already signalled (counter saturated) is as good as done
+    }
+}
+
+bool EventLoop::arm(IoWait* wait)
+{
+    // Nothing may touch `wait` once it is armed: another thread can resume
+    // the task before epoll_ctl returns
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = wait->events | EPOLLONESHOT | EPOLLRDHUP;
+    ev.data.ptr = wait;
+    const int fd = wait->fd;
+    if (epoll_ctl(m_Epoll, EPOLL_CTL_MOD, fd, &ev) == 0) {
+        return true;
+    }
+    if (errno == ENOENT && epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &ev) == 0) {
+        return true;
+    }
+    return false;
+}
+
+void EventLoop::addTimer(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> h)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Timers.push_back(Timer{deadline, h});
+        std::push_heap(m_Timers.begin(), m_Timers.end(), std::greater<Timer>());
+    }
+    // A thread parked with a later timeout has to recompute it
+    if (m_Idle.load() > 0) {
+        wake();
+    }
+}
+
+void EventLoop::stop()
+{
+    m_Stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const Timer& t : m_Timers) {
+            m_Ready.push_back(t.handle);
+        }
+        m_Timers.clear();
+    }
+    wake();
+}
+
+void EventLoop::taskDone()
+{
+    if (m_Tasks.fetch_sub(1) == 1 && stopping()) {
+        wake();
+    }
+}
+
+bool EventLoop::TransferAwaiter::complete()
+{
+    while (done < length) {
+        const ssize_t n = write ? send(fd, data + done, length - done, MSG_NOSIGNAL)
+                                : read(fd, data + done, length - done);
+        if (n > 0) {
+            done += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        error = true;  // EOF or a socket error
+        return true;
+    }
+    return true;
+}
+
+void EventLoop::worker()
+{
+    epoll_event events[64];
+    while (true) {
+        std::coroutine_handle<> h;
+        int timeoutMs = -1;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            while (!m_Timers.empty() && m_Timers.front().deadline <= now) {
+                std::pop_heap(m_Timers.begin(), m_Timers.end(), std::greater<Timer>());
+                m_Ready.push_back(m_Timers.back().handle);
+                m_Timers.pop_back();
+            }
+            if (!m_Ready.empty()) {
+                h = m_Ready.front();
+                m_Ready.pop_front();
+            } else if (stopping() && m_Tasks.load() == 0) {
+                break;
+            } else if (!m_Timers.empty()) {
+                const auto wait = m_Timers.front().deadline - now;
+                timeoutMs = (int)std::chrono::ceil<std::chrono::milliseconds>(wait).count();
+            }
+            if (!h) {
+                // Counted idle under the lock, so a post() after this sees it
+                m_Idle.fetch_add(1);
+            }
+        }
+        if (h) {
+            h.resume();
+            continue;
+        }
+
+        const int n = epoll_wait(m_Epoll, events, 64, timeoutMs);
+        m_Idle.fetch_sub(1);
+        for (int i = 0; i < n; ++i) {
+            IoWait* wait = (IoWait*)events[i].data.ptr;
+            if (!wait) {
+                // During shutdown the wake-up stays signalled for every thread
+                uint64_t count;
+                if (!stopping() && read(m_WakeFd, &count, sizeof(count)) < 0) {
+                    // Another thread drained it first
+                }
+                continue;
+            }
+            wait->revents = events[i].events;
+            if (!wait->complete()) {
+                if (arm(wait)) {
+                    continue;
+                }
+                wait->revents = EPOLLERR;
+            }
+            wait->handle.resume();
+        }
+    }
+}
+
+void EventLoop::run(uint32_t threads)
+{
+    std::vector<std::thread> pool;
+    for (uint32_t i = 1; i < std::max(1u, threads); ++i) {
+        pool.emplace_back([this]() { worker(); });
+    }
+    worker();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+}
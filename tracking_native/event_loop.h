@@ -0,0 +1,442 @@
+/*
+ * Coroutine event loop for the native tracking services (C++20)
+ *
+ * A small cooperative runtime: long-lived tasks written as C++20
+ * coroutines run on a pool of `threads` threads sharing one epoll set.
+ * A task suspends instead of blocking:
+ *
+ *   co_await loop.schedule();             hop onto a pool thread
+ *   co_await loop.sleepFor(interval);     false when woken by stop()
+ *   co_await loop.readable(fd);           wait for one readiness event
+ *   co_await loop.readAll(fd, buf, n);    false on EOF or error
+ *   co_await loop.writeAll(fd, buf, n);
+ *   co_await queue.pop(value);            AsyncQueue: false once closed
+ *   co_await mutex.lock();                AsyncMutex, unlock() by hand
+ *
+ * File descriptors must be non-blocking. Each wait is one-shot
+ * (EPOLLONESHOT), so exactly one thread resumes a task, and readAll /
+ * writeAll keep the task suspended until the whole buffer is done rather
+ * than waking it per chunk. Nothing here allocates per wait: awaiters
+ * live in the coroutine frame and queue waiters are linked through them.
+ * Only spawning a task allocates its frame, so tasks are meant to be per
+ * connection or per service loop, never per detection.
+ *
+ * Shutdown: stop() fires every timer early and, once the owner has
+ * closed its queues and shut down its sockets, run() returns as soon as
+ * the last task finishes.
+ */
+
+#ifndef __EVENT_LOOP_H__
+#define __EVENT_LOOP_H__
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include <sys/epoll.h>
+
+class EventLoop;
+
+// Fire-and-forget coroutine; start it with EventLoop::spawn()
+class Task
+{
+public:
+    struct promise_type
+    {
+        EventLoop* loop = nullptr;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept : m_Handle(other.m_Handle) { other.m_Handle = nullptr; }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (m_Handle) {
+            m_Handle.destroy();
+        }
+    }
+
+private:
+    friend class EventLoop;
+    explicit Task(std::coroutine_handle<promise_type> h) : m_Handle(h) {}
+
+    std::coroutine_handle<promise_type> m_Handle;
+};
+
+// An fd wait registered with the loop. complete() runs on readiness and
+// returns false to be re-armed (partial reads and writes).
+struct IoWait
+{
+    int fd = -1;
+    uint32_t events = 0;
+    uint32_t revents = 0;
+    std::coroutine_handle<> handle;
+    virtual bool complete() { return true; }
+
+protected:
+    ~IoWait() = default;
+};
+
+class EventLoop
+{
+public:
+    EventLoop();
+    ~EventLoop();
+
+    bool valid() const { return m_Epoll >= 0 && m_WakeFd >= 0; }
+
+    // Runs tasks on the calling thread plus threads - 1 more until stop()
+    // has been called and every task has finished
+    void run(uint32_t threads);
+    void stop();
+    bool stopping() const { return m_Stopping.load(std::memory_order_acquire); }
+
+    void spawn(Task task);
+    // Resumes `h` on a pool thread; any thread
+    void post(std::coroutine_handle<> h);
+
+    struct ScheduleAwaiter
+    {
+        EventLoop* loop;
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop->post(h); }
+        void await_resume() {}
+    };
+    ScheduleAwaiter schedule() { return ScheduleAwaiter{this}; }
+
+    struct SleepAwaiter
+    {
+        EventLoop* loop;
+        std::chrono::steady_clock::time_point deadline;
+        bool await_ready() { return loop->stopping(); }
+        void await_suspend(std::coroutine_handle<> h) { loop->addTimer(deadline, h); }
+        bool await_resume() { return !loop->stopping(); }
+    };
+    SleepAwaiter sleepFor(std::chrono::microseconds d)
+    {
+        return SleepAwaiter{this, std::chrono::steady_clock::now() + d};
+    }
+
+    struct FdAwaiter : IoWait
+    {
+        EventLoop* loop;
+        bool failed = false;
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            // Once armed, another thread may resume (and free) the frame
+            if (!loop->arm(this)) {
+                failed = true;
+                return false;
+            }
+            return true;
+        }
+        // EPOLLIN/EPOLLOUT/EPOLLHUP/EPOLLERR bits, 0 if the wait failed
+        uint32_t await_resume() { return failed ? 0 : revents; }
+    };
+    FdAwaiter readable(int fd) { return makeFdAwaiter(fd, EPOLLIN); }
+    FdAwaiter writable(int fd) { return makeFdAwaiter(fd, EPOLLOUT); }
+
+    struct TransferAwaiter : IoWait
+    {
+        EventLoop* loop;
+        char* data;
+        size_t length;
+        size_t done = 0;
+        bool write;
+        bool error = false;
+
+        bool complete() override;
+        bool await_ready() { return complete(); }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            return loop->arm(this) ? true : (error = true, false);
+        }
+        bool await_resume() { return !error && done == length; }
+    };
+    TransferAwaiter readAll(int fd, void* data, size_t length) { return makeTransfer(fd, data, length, false); }
+    TransferAwaiter writeAll(int fd, const void* data, size_t length)
+    {
+        return makeTransfer(fd, const_cast<void*>(data), length, true);
+    }
+
+private:
+    friend struct Task::promise_type::FinalAwaiter;
+
+    struct Timer
+    {
+        std::chrono::steady_clock::time_point deadline;
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& o) const { return deadline > o.deadline; }
+    };
+
+    FdAwaiter makeFdAwaiter(int fd, uint32_t events)
+    {
+        FdAwaiter a;
+        a.fd = fd;
+        a.events = events;
+        a.loop = this;
+        return a;
+    }
+    TransferAwaiter makeTransfer(int fd, void* data, size_t length, bool write)
+    {
+        TransferAwaiter a;
+        a.fd = fd;
+        a.events = write ? EPOLLOUT : EPOLLIN;
+        a.loop = this;
+        a.data = (char*)data;
+        a.length = length;
+        a.write = write;
+        return a;
+    }
+
+    bool arm(IoWait* wait);
+    void addTimer(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> h);
+    void taskDone();
+    void wake();
+    void worker();
+
+    int m_Epoll;
+    int m_WakeFd;
+    std::mutex m_Mutex;
+    std::deque<std::coroutine_handle<>> m_Ready;
+    std::vector<Timer> m_Timers;  // min-heap on deadline
+    std::atomic<bool> m_Stopping;
+    std::atomic<uint32_t> m_Tasks;
+    std::atomic<uint32_t> m_Idle;  // threads in epoll_wait
+};
+
+// Bounded MPMC queue whose pop and push can be awaited. tryPush/tryPop
+// never wait, for callers outside the loop (e.g. a pad probe).
+template <typename T>
+class AsyncQueue
+{
+public:
+    AsyncQueue(EventLoop& loop, size_t capacity) : m_Loop(loop), m_Ring(capacity) {}
+
+    bool tryPush(const T& value)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        return !m_Closed && putLocked(value, lock);
+    }
+
+    bool tryPop(T& value)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        return takeLocked(value, lock);
+    }
+
+    struct PopAwaiter
+    {
+        AsyncQueue* queue;
+        T* out;
+        bool ok = false;
+        std::coroutine_handle<> handle = nullptr;
+        PopAwaiter* next = nullptr;
+
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            std::unique_lock<std::mutex> lock(queue->m_Mutex);
+            if (queue->takeLocked(*out, lock)) {
+                ok = true;
+                return false;
+            }
+            if (queue->m_Closed) {
+                return false;
+            }
+            handle = h;
+            PopAwaiter** tail = &queue->m_Poppers;
+            while (*tail) {
+                tail = &(*tail)->next;
+            }
+            *tail = this;
+            return true;
+        }
+        bool await_resume() { return ok; }
+    };
+    // co_await pop(v): false once the queue is closed and empty
+    PopAwaiter pop(T& value) { return PopAwaiter{this, &value}; }
+
+    struct PushAwaiter
+    {
+        AsyncQueue* queue;
+        T value;
+        bool ok = false;
+        std::coroutine_handle<> handle = nullptr;
+        PushAwaiter* next = nullptr;
+
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            std::unique_lock<std::mutex> lock(queue->m_Mutex);
+            if (queue->m_Closed) {
+                return false;
+            }
+            if (queue->putLocked(value, lock)) {
+                ok = true;
+                return false;
+            }
+            handle = h;
+            PushAwaiter** tail = &queue->m_Pushers;
+            while (*tail) {
+                tail = &(*tail)->next;
+            }
+            *tail = this;
+            return true;
+        }
+        bool await_resume() { return ok; }
+    };
+    // co_await push(v): waits for room; false once the queue is closed
+    PushAwaiter push(const T& value) { return PushAwaiter{this, value}; }
+
+    // Wakes every waiter; pops drain what is left, pushes fail
+    void close()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Closed = true;
+        PopAwaiter* poppers = m_Poppers;
+        PushAwaiter* pushers = m_Pushers;
+        m_Poppers = nullptr;
+        m_Pushers = nullptr;
+        lock.unlock();
+        while (poppers) {
+            PopAwaiter* next = poppers->next;
+            m_Loop.post(poppers->handle);
+            poppers = next;
+        }
+        while (pushers) {
+            PushAwaiter* next = pushers->next;
+            m_Loop.post(pushers->handle);
+            pushers = next;
+        }
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Size;
+    }
+
+private:
+    // Hands the value to a waiting pop, or queues it if there is room
+    bool putLocked(const T& value, std::unique_lock<std::mutex>& lock)
+    {
+        if (PopAwaiter* w = m_Poppers) {
+            m_Poppers = w->next;
+            *w->out = value;
+            w->ok = true;
+            lock.unlock();
+            m_Loop.post(w->handle);
+            return true;
+        }
+        if (m_Size == m_Ring.size()) {
+            return false;
+        }
+        m_Ring[(m_Head + m_Size++) % m_Ring.size()] = value;
+        return true;
+    }
+
+    bool takeLocked(T& value, std::unique_lock<std::mutex>& lock)
+    {
+        if (m_Size == 0) {
+            return false;
+        }
+        value = m_Ring[m_Head];
+        m_Head = (m_Head + 1) % m_Ring.size();
+        m_Size--;
+        // A waiting pusher takes the freed place
+        if (PushAwaiter* w = m_Pushers) {
+            m_Pushers = w->next;
+            m_Ring[(m_Head + m_Size++) % m_Ring.size()] = w->value;
+            w->ok = true;
+            lock.unlock();
+            m_Loop.post(w->handle);
+        }
+        return true;
+    }
+
+    EventLoop& m_Loop;
+    std::mutex m_Mutex;
+    std::vector<T> m_Ring;
+    size_t m_Head = 0;
+    size_t m_Size = 0;
+    bool m_Closed = false;
+    PopAwaiter* m_Poppers = nullptr;
+    PushAwaiter* m_Pushers = nullptr;
+};
+
+// Mutual exclusion between tasks without blocking a pool thread
+class AsyncMutex
+{
+public:
+    explicit AsyncMutex(EventLoop& loop) : m_Loop(loop) {}
+
+    struct LockAwaiter
+    {
+        AsyncMutex* mutex;
+        std::coroutine_handle<> handle = nullptr;
+        LockAwaiter* next = nullptr;
+
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            std::lock_guard<std::mutex> lock(mutex->m_Mutex);
+            if (!mutex->m_Locked) {
+                mutex->m_Locked = true;
+                return false;
+            }
+            handle = h;
+            LockAwaiter** tail = &mutex->m_Waiters;
+            while (*tail) {
+                tail = &(*tail)->next;
+            }
+            *tail = this;
+            return true;
+        }
+        void await_resume() {}
+    };
+    LockAwaiter lock() { return LockAwaiter{this}; }
+
+    // Hands the lock to the next waiter, if any
+    void unlock()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        LockAwaiter* w = m_Waiters;
+        if (!w) {
+            m_Locked = false;
+            return;
+        }
+        m_Waiters = w->next;
+        lock.unlock();
+        m_Loop.post(w->handle);
+    }
+
+private:
+    EventLoop& m_Loop;
+    std::mutex m_Mutex;
+    bool m_Locked = false;
+    LockAwaiter* m_Waiters = nullptr;
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Open-addressing hash map with 64-bit keys for the native tracking engine
+ *
+ * Keys and values sit together in one power-of-two array. Lookups probe
+ * linearly from the key's hash, and the table grows before it is half
+ * full, so a lookup is one hash and usually one cache line. Erasure
+ * shifts the rest of the probe run back instead of leaving tombstones,
+ * so long-running maps with heavy churn (local track ids come and go all
+ * day) never degrade.
+ *
+ * UINT64_MAX marks an empty slot and cannot be used as a key. Pointers to
+ * values are invalidated by any insertion or erasure.
+ */
+
+#ifndef __FLAT_MAP_H__
+#define __FLAT_MAP_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename Value>
+class FlatMap
+{
+public:
+    static const uint64_t kEmptyKey = UINT64_MAX;
+
+    FlatMap() : m_Slots(16), m_Mask(15), m_Size(0) {}
+
+    Value* find(uint64_t key)
+    {
+        for (size_t i = hash(key) & m_Mask;; i = (i + 1) & m_Mask) {
+            if (m_Slots[i].key == key) {
+                return &m_Slots[i].value;
+            }
+            if (m_Slots[i].key == kEmptyKey) {
+                return nullptr;
+            }
+        }
+    }
+
+    const Value* find(uint64_t key) const { return const_cast<FlatMap*>(this)->find(key); }
+
+    // Inserts a value-initialised entry when the key is absent
+    Value& operator[](uint64_t key)
+    {
+        if (2 * (m_Size + 1) > m_Slots.size()) {
+            rehash(2 * m_Slots.size());
+        }
+        size_t i = hash(key) & m_Mask;
+        while (m_Slots[i].key != key && m_Slots[i].key != kEmptyKey) {
+            i = (i + 1) & m_Mask;
+        }
+        if (m_Slots[i].key == kEmptyKey) {
+            m_Slots[i].key = key;
+            m_Slots[i].value = Value();
+            m_Size++;
+        }
+        return m_Slots[i].value;
+    }
+
+    bool erase(uint64_t key)
+    {
+        for (size_t i = hash(key) & m_Mask;; i = (i + 1) & m_Mask) {
+            if (m_Slots[i].key == key) {
+                eraseSlot(i);
+                return true;
+            }
+            if (m_Slots[i].key == kEmptyKey) {
+                return false;
+            }
+        }
+    }
+
+    // Erases every entry for which pred(key, value) is true; returns how many
+    template <typename Pred>
+    size_t eraseIf(Pred pred)
+    {
+        size_t erased = 0;
+        for (size_t i = 0; i < m_Slots.size();) {
+            // A shift may move a later entry into slot i, so look at it again
+            if (m_Slots[i].key != kEmptyKey && pred(m_Slots[i].key, m_Slots[i].value)) {
+                eraseSlot(i);
+                erased++;
+            } else {
+                ++i;
+            }
+        }
+        return erased;
+    }
+
+    // f(key, value) for every entry; f may change values, not the map
+    template <typename F>
+    void forEach(F f)
+    {
+        for (Slot& s : m_Slots) {
+            if (s.key != kEmptyKey) {
+                f(s.key, s.value);
+            }
+        }
+    }
+
+    // Keeps the capacity
+    void clear()
+    {
+        for (Slot& s : m_Slots) {
+            s.key = kEmptyKey;
+        }
+        m_Size = 0;
+    }
+
+    size_t size() const { return m_Size; }
+    bool empty() const { return m_Size == 0; }
+    size_t memoryBytes() const { return m_Slots.capacity() * sizeof(Slot); }
+
+private:
+    struct Slot
+    {
+        uint64_t key = kEmptyKey;
+        Value value = Value();
+    };
+
+    // splitmix64 finaliser: local keys differ mostly in their low bits
+    static size_t hash(uint64_t key)
+    {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ull;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebull;
+        key ^= key >> 31;
+        return (size_t)key;
+    }
+
+    void eraseSlot(size_t hole)
+    {
+        // Pull back each later entry of the run whose home is not between
+        // the hole and its current slot, so every probe still reaches it
+        for (size_t i = (hole + 1) & m_Mask; m_Slots[i].key != kEmptyKey; i = (i + 1) & m_Mask) {
+            const size_t home = hash(m_Slots[i].key) & m_Mask;
+            if (((i - home) & m_Mask) >= ((i - hole) & m_Mask)) {
+                m_Slots[hole] = m_Slots[i];
+                hole = i;
+            }
+        }
+        m_Slots[hole].key = kEmptyKey;
+        m_Size--;
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<Slot> old(capacity);
+        old.swap(m_Slots);
+        m_Mask = capacity - 1;
+        for (const Slot& s : old) {
+            if (s.key != kEmptyKey) {
+                size_t i = hash(s.key) & m_Mask;
+                while (m_Slots[i].key != kEmptyKey) {
+                    i = (i + 1) & m_Mask;
+                }
+                m_Slots[i] = s;
+            }
+        }
+    }
+
+    std::vector<Slot> m_Slots;
+    size_t m_Mask;
+    size_t m_Size;
+};
+
+#endif
@@ -0,0 +1,523 @@
+/*
+ * Cross-camera global track associator for the native tracking engine
+ */
+
+#include "global_associator.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+bool AssociatorConfig::load(const std::string& path, AssociatorConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "associator";
+    AssociatorConfig c;
+    c.reidThreshold = (float)kf.getDouble(g, "reid-threshold", c.reidThreshold);
+    c.maxHistory = (uint32_t)kf.getInt(g, "max-history", (int)c.maxHistory);
+    c.matchHistory = (uint32_t)kf.getInt(g, "match-history", (int)c.matchHistory);
+    c.trackTimeoutS = kf.getDouble(g, "track-timeout-s", c.trackTimeoutS);
+    c.minConfidence = (float)kf.getDouble(g, "min-confidence", c.minConfidence);
+    c.decisionWindowMs = (uint32_t)std::max(0, kf.getInt(g, "decision-window-ms", (int)c.decisionWindowMs));
+    c.decisionTickMs = (uint32_t)std::max(0, kf.getInt(g, "decision-tick-ms", (int)c.decisionTickMs));
+    if (c.maxHistory == 0 || c.matchHistory == 0 || c.matchHistory > c.maxHistory || c.trackTimeoutS <= 0.0) {
+        std::cerr << "ERROR: " << path << ": need 0 < match-history <= max-history and a positive track-timeout-s"
+                  << std::endl;
+        return false;
+    }
+    if (c.decisionWindowMs > 0 && (c.decisionTickMs == 0 || c.decisionTickMs > c.decisionWindowMs)) {
+        std::cerr << "ERROR: " << path << ": need 0 < decision-tick-ms <= decision-window-ms" << std::endl;
+        return false;
+    }
+    if (!StitchConfig::load(kf, path, c.stitching) || !RerankConfig::load(kf, path, c.rerank)) {
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+GlobalAssociator::GlobalAssociator(const AssociatorConfig& config, uint32_t embeddingDim)
+    : m_Config(config), m_Dim(embeddingDim), m_NextId(1),
+      m_TimeoutUs((uint64_t)(config.trackTimeoutS * 1e6)), m_WindowUs(config.decisionWindowMs * 1000ull),
+      m_TickUs(config.decisionTickMs * 1000ull), m_NextDecisionUs(0), m_Query(embeddingDim), m_Mean(embeddingDim),
+      m_Reranker(config.rerank, embeddingDim), m_Stitcher(config.stitching, embeddingDim)
+{
+}
+
+std::string GlobalAssociator::formatId(uint64_t globalId)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "GT_%06llu", (unsigned long long)globalId);
+    return buf;
+}
+
+void GlobalAssociator::normalize(const float* in, float* out) const
+{
+    double norm = 0.0;
+    for (uint32_t k = 0; k < m_Dim; ++k) {
+        norm += (double)in[k] * in[k];
+    }
+    const float inv = (float)(1.0 / (std::sqrt(norm) + 1e-8));
+    for (uint32_t k = 0; k < m_Dim; ++k) {
+        out[k] = in[k] * inv;
+    }
+}
+
+float GlobalAssociator::matchScore(const GlobalTrack& track, const float* embedding)
+{
+    const uint32_t n = std::min(track.featureCount, m_Config.matchHistory);
+    if (n == 0) {
+        return 0.0f;
+    }
+    float best = 0.0f;
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t slot = (track.featureHead + m_Config.maxHistory - 1 - i) % m_Config.maxHistory;
+        const float* f = &track.features[(size_t)slot * m_Dim];
+        float dot = 0.0f;
+        for (uint32_t k = 0; k < m_Dim; ++k) {
+            dot += f[k] * embedding[k];
+        }
+        dot = std::max(0.0f, dot);
+        best = std::max(best, dot);
+        sum += dot;
+    }
+    m_Stats.comparisons += n;
+    return 0.7f * best + 0.3f * sum / n;
+}
+
+GlobalAssociator::Handle GlobalAssociator::collectCandidates(uint32_t camera, const float* query, uint64_t nowUs)
+{
+    const bool rerank = m_Config.rerank.enable;
+    m_Candidates.clear();
+    m_Tracks.forEach([&](Handle h, GlobalTrack& t) {
+        // Within-camera continuity is the local tracker's job
+        if (t.provisional || nowUs > t.lastSeenUs + m_TimeoutUs ||
+            std::find(t.cameras.begin(), t.cameras.end(), camera) != t.cameras.end()) {
+            return;
+        }
+        const float score = matchScore(t, query);
+        // Re-ranking also needs the candidates below the threshold: they
+        // are the query's neighbourhood
+        if (score > m_Config.reidThreshold || (rerank && score > 0.0f)) {
+            m_Candidates.push_back(RerankCandidate{h, score, score, true});
+        }
+    });
+    if (m_Candidates.empty()) {
+        return 0;
+    }
+    auto higherScore = [](const RerankCandidate& a, const RerankCandidate& b) { return a.score > b.score; };
+    auto byRank = [](const RerankCandidate& a, const RerankCandidate& b) { return a.reranked < b.reranked; };
+    if (!rerank) {
+        return std::max_element(m_Candidates.begin(), m_Candidates.end(), byRank)->id;
+    }
+
+    const uint32_t k = m_Config.rerank.k;
+    if (m_Candidates.size() > k) {
+        std::nth_element(m_Candidates.begin(), m_Candidates.begin() + (k - 1), m_Candidates.end(), higherScore);
+        m_Candidates.resize(k);
+    }
+    // What the score alone would link
+    const RerankCandidate top = *std::min_element(m_Candidates.begin(), m_Candidates.end(), higherScore);
+    m_Reranker.rerank(query, m_Candidates);
+    m_Candidates.erase(std::remove_if(m_Candidates.begin(), m_Candidates.end(),
+                                      [this](const RerankCandidate& c) {
+                                          return !c.reciprocal || c.score <= m_Config.reidThreshold;
+                                      }),
+                       m_Candidates.end());
+    if (top.score <= m_Config.reidThreshold) {
+        return 0;
+    }
+    if (m_Candidates.empty()) {
+        m_Stats.rerankRejected++;
+        return 0;
+    }
+    const Handle best = std::max_element(m_Candidates.begin(), m_Candidates.end(), byRank)->id;
+    if (best != top.id) {
+        m_Stats.rerankReordered++;
+    }
+    return best;
+}
+
+void GlobalAssociator::refreshGallery(Handle handle, const GlobalTrack& track)
+{
+    if (m_Config.rerank.enable && !track.provisional && recentMean(track, m_Config.matchHistory)) {
+        m_Reranker.update(handle, m_Mean.data());
+    }
+}
+
+GlobalAssociator::Handle GlobalAssociator::createTrack(const AssociationInput& input, uint64_t timestampUs,
+                                                      bool provisional)
+{
+    const Handle handle = m_Tracks.acquire();
+    GlobalTrack& t = *m_Tracks.get(handle);
+    t.id = provisional ? 0 : m_NextId++;
+    t.cameras.assign(1, input.camera);
+    t.firstSeenUs = timestampUs;
+    t.lastSeenUs = timestampUs;
+    t.featureHead = 0;
+    t.featureCount = 0;
+    t.totalDetections = 0;
+    t.confidenceSum = 0.0;
+    t.provisional = provisional;
+    update(t, input, timestampUs);
+    if (provisional) {
+        m_Provisional.push_back(handle);
+    } else {
+        m_Stats.newTracks++;
+        refreshGallery(handle, t);
+    }
+    return handle;
+}
+
+void GlobalAssociator::update(GlobalTrack& track, const AssociationInput& input, uint64_t timestampUs)
+{
+    if (std::find(track.cameras.begin(), track.cameras.end(), input.camera) == track.cameras.end()) {
+        track.cameras.push_back(input.camera);
+    }
+    track.lastSeenUs = std::max(track.lastSeenUs, timestampUs);
+    track.totalDetections++;
+    track.confidenceSum += input.confidence;
+    if (input.embedding) {
+        normalize(input.embedding, nextFeature(track));
+    }
+}
+
+float* GlobalAssociator::nextFeature(GlobalTrack& track)
+{
+    if (track.features.empty()) {
+        track.features.resize((size_t)m_Config.maxHistory * m_Dim);
+    }
+    float* f = &track.features[(size_t)track.featureHead * m_Dim];
+    track.featureHead = (track.featureHead + 1) % m_Config.maxHistory;
+    track.featureCount = std::min(track.featureCount + 1, m_Config.maxHistory);
+    return f;
+}
+
+bool GlobalAssociator::recentMean(const GlobalTrack& track, uint32_t n)
+{
+    n = std::min(track.featureCount, n);
+    if (n == 0) {
+        return false;
+    }
+    std::fill(m_Mean.begin(), m_Mean.end(), 0.0f);
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t slot = (track.featureHead + m_Config.maxHistory - 1 - i) % m_Config.maxHistory;
+        const float* f = &track.features[(size_t)slot * m_Dim];
+        for (uint32_t k = 0; k < m_Dim; ++k) {
+            m_Mean[k] += f[k];
+        }
+    }
+    normalize(m_Mean.data(), m_Mean.data());
+    return true;
+}
+
+void GlobalAssociator::merge(GlobalTrack& into, const GlobalTrack& from)
+{
+    for (uint32_t camera : from.cameras) {
+        if (std::find(into.cameras.begin(), into.cameras.end(), camera) == into.cameras.end()) {
+            into.cameras.push_back(camera);
+        }
+    }
+    into.firstSeenUs = std::min(into.firstSeenUs, from.firstSeenUs);
+    into.lastSeenUs = std::max(into.lastSeenUs, from.lastSeenUs);
+    into.totalDetections += from.totalDetections;
+    into.confidenceSum += from.confidenceSum;
+    // Oldest first, so the newest stay newest
+    for (uint32_t i = from.featureCount; i > 0; --i) {
+        const uint32_t slot = (from.featureHead + m_Config.maxHistory - i) % m_Config.maxHistory;
+        const float* f = &from.features[(size_t)slot * m_Dim];
+        std::copy(f, f + m_Dim, nextFeature(into));
+    }
+}
+
+GlobalAssociator::Handle GlobalAssociator::stitch(const AssociationInput& input, const float* query,
+                                                  uint64_t timestampUs)
+{
+    Handle handle = 0;
+    uint64_t oldLocalId = 0;
+    if (!m_Stitcher.match(input.camera, input.box, query, timestampUs, handle, oldLocalId)) {
+        return 0;
+    }
+    GlobalTrack* track = m_Tracks.get(handle);
+    if (!track) {
+        return 0;
+    }
+    // The old local id may still be in shadow; it no longer owns the track
+    const uint64_t oldKey = localKey(input.camera, oldLocalId);
+    const LocalLink* old = m_LocalToGlobal.find(oldKey);
+    if (old && old->track == handle) {
+        m_LocalToGlobal.erase(oldKey);
+    }
+    update(*track, input, timestampUs);
+    m_Stats.stitched++;
+    return handle;
+}
+
+uint64_t GlobalAssociator::associate(const AssociationInput& input, uint64_t timestampUs)
+{
+    m_Stats.detections++;
+    decide(timestampUs);
+    const uint64_t key = localKey(input.camera, input.localId);
+    LocalLink* mapped = m_LocalToGlobal.find(key);
+    if (mapped) {
+        GlobalTrack* track = m_Tracks.get(mapped->track);
+        if (track) {
+            if (mapped->suspended) {
+                m_Stitcher.remove(input.camera, input.localId);
+                mapped->suspended = false;
+            }
+            const uint32_t features = track->featureCount;
+            update(*track, input, timestampUs);
+            // It entered the gallery on its first embedding
+            if (features < m_Config.matchHistory && track->featureCount == m_Config.matchHistory) {
+                refreshGallery(mapped->track, *track);
+            }
+            return track->id;
+        }
+        // Its global track timed out while the local track lived on
+        m_LocalToGlobal.erase(key);
+    }
+
+    if (input.embedding) {
+        normalize(input.embedding, m_Query.data());
+    }
+    Handle handle = 0;
+    if (m_Config.stitching.enable && m_Stitcher.size() > 0) {
+        handle = stitch(input, input.embedding ? m_Query.data() : nullptr, timestampUs);
+    }
+    if (handle == 0 && m_WindowUs > 0) {
+        m_LocalToGlobal[key] = LocalLink{createTrack(input, timestampUs, true), false};
+        return 0;
+    }
+    if (handle == 0 && input.embedding && input.confidence >= m_Config.minConfidence) {
+        const Handle best = collectCandidates(input.camera, m_Query.data(), timestampUs);
+        if (best) {
+            GlobalTrack& track = *m_Tracks.get(best);
+            update(track, input, timestampUs);
+            refreshGallery(best, track);
+            handle = best;
+            m_Stats.crossCameraAssociations++;
+        }
+    }
+    if (handle == 0) {
+        handle = createTrack(input, timestampUs, false);
+    }
+    m_LocalToGlobal[key] = LocalLink{handle, false};
+    return m_Tracks.get(handle)->id;
+}
+
+void GlobalAssociator::suspendLocalTrack(uint32_t camera, uint64_t localId, const TrackBox& lastBox, float vx,
+                                         float vy, uint64_t lastSeenUs)
+{
+    if (!m_Config.stitching.enable) {
+        return;
+    }
+    LocalLink* mapped = m_LocalToGlobal.find(localKey(camera, localId));
+    if (!mapped) {
+        return;
+    }
+    const GlobalTrack* found = m_Tracks.get(mapped->track);
+    if (!found) {
+        return;
+    }
+
+    // Mean of the newest features: the track's look just before it was lost
+    const bool hasMean = recentMean(*found, m_Config.stitching.embeddingHistory);
+    // The stitcher hands the handle back as the candidate's global id; if
+    // the track times out first, it no longer resolves in stitch()
+    m_Stitcher.add(camera, localId, mapped->track, lastBox, vx, vy, lastSeenUs, hasMean ? m_Mean.data() : nullptr);
+    mapped->suspended = true;
+}
+
+void GlobalAssociator::endLocalTrack(uint32_t camera, uint64_t localId)
+{
+    m_LocalToGlobal.erase(localKey(camera, localId));
+}
+
+void GlobalAssociator::decide(uint64_t nowUs)
+{
+    if (m_WindowUs == 0 || nowUs < m_NextDecisionUs) {
+        return;
+    }
+    m_NextDecisionUs = nowUs + m_TickUs;
+
+    // Due: past its window by the next tick
+    m_Due.clear();
+    size_t kept = 0;
+    for (Handle h : m_Provisional) {
+        const GlobalTrack* t = m_Tracks.get(h);
+        if (!t) {
+            continue;
+        }
+        if (t->firstSeenUs + m_WindowUs <= nowUs + m_TickUs) {
+            m_Due.push_back(h);
+        } else {
+            m_Provisional[kept++] = h;
+        }
+    }
+    m_Provisional.resize(kept);
+    if (m_Due.empty()) {
+        return;
+    }
+    m_Stats.batches++;
+
+    // Rows are due tracks, columns (global track, camera) pairs: one global
+    // track can take a new local track on each camera
+    m_Edges.clear();
+    m_Columns.clear();
+    m_ColumnOf.clear();
+    for (uint32_t row = 0; row < m_Due.size(); ++row) {
+        const GlobalTrack& p = *m_Tracks.get(m_Due[row]);
+        const uint32_t camera = p.cameras[0];
+        if (p.confidenceSum < m_Config.minConfidence * p.totalDetections ||
+            !recentMean(p, m_Config.maxHistory)) {
+            continue;
+        }
+        collectCandidates(camera, m_Mean.data(), nowUs);
+        for (const RerankCandidate& c : m_Candidates) {
+            uint32_t& column = m_ColumnOf[(uint64_t)(uint32_t)c.id << 32 | camera];
+            if (column == 0) {
+                m_Columns.push_back(c.id);
+                column = (uint32_t)m_Columns.size();
+            }
+            // Every candidate is worth linking; re-ranked ones by their rank
+            const float cost = m_Config.rerank.enable ? -c.reranked : m_Config.reidThreshold - c.score;
+            m_Edges.push_back(AssignmentEdge{row, column - 1, cost});
+        }
+    }
+    m_Solver.solve((uint32_t)m_Due.size(), (uint32_t)m_Columns.size(), m_Edges, 0.0f, m_Assigned);
+
+    m_Merged.clear();
+    for (uint32_t row = 0; row < m_Due.size(); ++row) {
+        const Handle h = m_Due[row];
+        GlobalTrack& p = *m_Tracks.get(h);
+        const uint64_t latencyUs = nowUs > p.firstSeenUs ? nowUs - p.firstSeenUs : 0;
+        m_Stats.decisions++;
+        m_Stats.decisionLatencySumUs += latencyUs;
+        m_Stats.maxDecisionLatencyUs = std::max(m_Stats.maxDecisionLatencyUs, latencyUs);
+        if (latencyUs > m_WindowUs) {
+            m_Stats.lateDecisions++;
+        }
+        if (m_Assigned[row] < 0) {
+            p.provisional = false;
+            p.id = m_NextId++;
+            m_Stats.newTracks++;
+            refreshGallery(h, p);
+            continue;
+        }
+        const Handle into = m_Columns[m_Assigned[row]];
+        GlobalTrack& target = *m_Tracks.get(into);
+        merge(target, p);
+        refreshGallery(into, target);
+        m_Stitcher.retarget(h, into);
+        m_Merged[h] = into;
+        m_Tracks.release(h);
+        m_Stats.crossCameraAssociations++;
+    }
+    if (!m_Merged.empty()) {
+        m_LocalToGlobal.forEach([this](uint64_t, LocalLink& link) {
+            const Handle* into = m_Merged.find(link.track);
+            if (into) {
+                link.track = *into;
+            }
+        });
+    }
+}
+
+void GlobalAssociator::expire(uint64_t nowUs)
+{
+    decide(nowUs);
+    m_Tracks.forEach([&](Handle h, GlobalTrack& t) {
+        if (nowUs > t.lastSeenUs + m_TimeoutUs) {
+            m_Reranker.remove(h);
+            m_Tracks.release(h);
+            m_Stats.timeouts++;
+        }
+    });
+    m_LocalToGlobal.eraseIf([this](uint64_t, const LocalLink& link) { return !m_Tracks.get(link.track); });
+    m_Stitcher.expire(nowUs);
+}
+
+size_t GlobalAssociator::memoryBytes() const
+{
+    size_t bytes = (m_Query.capacity() + m_Mean.capacity()) * sizeof(float) + m_Stitcher.memoryBytes();
+    bytes += m_Tracks.memoryBytes() + m_LocalToGlobal.memoryBytes() + m_Reranker.memoryBytes();
+    m_Tracks.forEach([&bytes](Handle, const GlobalTrack& t) {
+        bytes += t.features.capacity() * sizeof(float) + t.cameras.capacity() * sizeof(uint32_t);
+    });
+    return bytes;
+}
+
+void GlobalAssociator::writePrometheus(std::string& out) const
+{
+    std::ostringstream os;
+    os << "# TYPE deepstream_tracking_global_tracks gauge\n"
+       << "deepstream_tracking_global_tracks " << m_Tracks.size() << "\n"
+       << "# TYPE deepstream_tracking_local_mappings gauge\n"
+       << "deepstream_tracking_local_mappings " << m_LocalToGlobal.size() << "\n"
+       << "# TYPE deepstream_tracking_associator_memory_bytes gauge\n"
+       << "deepstream_tracking_associator_memory_bytes " << memoryBytes() << "\n"
+       << "# TYPE deepstream_tracking_detections_total counter\n"
+       << "deepstream_tracking_detections_total " << m_Stats.detections << "\n"
+       << "# TYPE deepstream_tracking_global_tracks_created_total counter\n"
+       << "deepstream_tracking_global_tracks_created_total " << m_Stats.newTracks << "\n"
+       << "# TYPE deepstream_tracking_cross_camera_associations_total counter\n"
+       << "deepstream_tracking_cross_camera_associations_total " << m_Stats.crossCameraAssociations << "\n"
+       << "# TYPE deepstream_tracking_stitched_tracks_total counter\n"
+       << "deepstream_tracking_stitched_tracks_total " << m_Stats.stitched << "\n"
+       << "# TYPE deepstream_tracking_stitch_candidates gauge\n"
+       << "deepstream_tracking_stitch_candidates " << m_Stitcher.size() << "\n"
+       << "# TYPE deepstream_tracking_global_track_timeouts_total counter\n"
+       << "deepstream_tracking_global_track_timeouts_total " << m_Stats.timeouts << "\n"
+       << "# TYPE deepstream_tracking_embedding_comparisons_total counter\n"
+       << "deepstream_tracking_embedding_comparisons_total " << m_Stats.comparisons << "\n";
+    if (m_WindowUs > 0) {
+        os << "# TYPE deepstream_tracking_provisional_tracks gauge\n"
+           << "deepstream_tracking_provisional_tracks " << m_Provisional.size() << "\n"
+           << "# TYPE deepstream_tracking_association_batches_total counter\n"
+           << "deepstream_tracking_association_batches_total " << m_Stats.batches << "\n"
+           << "# TYPE deepstream_tracking_decision_latency_seconds summary\n"
+           << "deepstream_tracking_decision_latency_seconds_sum " << m_Stats.decisionLatencySumUs / 1e6 << "\n"
+           << "deepstream_tracking_decision_latency_seconds_count " << m_Stats.decisions << "\n"
+           << "# TYPE deepstream_tracking_decision_latency_max_seconds gauge\n"
+           << "deepstream_tracking_decision_latency_max_seconds " << m_Stats.maxDecisionLatencyUs / 1e6 << "\n"
+           << "# TYPE deepstream_tracking_late_decisions_total counter\n"
+           << "deepstream_tracking_late_decisions_total " << m_Stats.lateDecisions << "\n";
+    }
+    if (m_Config.rerank.enable) {
+        os << "# TYPE deepstream_tracking_rerank_gallery_tracks gauge\n"
+           << "deepstream_tracking_rerank_gallery_tracks " << m_Reranker.size() << "\n"
+           << "# TYPE deepstream_tracking_rerank_rejected_total counter\n"
+           << "deepstream_tracking_rerank_rejected_total " << m_Stats.rerankRejected << "\n"
+           << "# TYPE deepstream_tracking_rerank_reordered_total counter\n"
+           << "deepstream_tracking_rerank_reordered_total " << m_Stats.rerankReordered << "\n"
+           << "# TYPE deepstream_tracking_rerank_comparisons_total counter\n"
+           << "deepstream_tracking_rerank_comparisons_total " << m_Reranker.stats().comparisons << "\n";
+    }
+    out += os.str();
+}
+
+void GlobalAssociator::writeSnapshot(std::string& out) const
+{
+    std::ostringstream os;
+    m_Tracks.forEach([&os](Handle, const GlobalTrack& t) {
+        if (t.provisional) {
+            return;
+        }
+        os << "{\"id\":\"" << formatId(t.id) << "\",\"cameras\":[";
+        for (size_t i = 0; i < t.cameras.size(); ++i) {
+            os << (i ? "," : "") << t.cameras[i];
+        }
+        os << "],\"first_seen_us\":" << t.firstSeenUs << ",\"last_seen_us\":" << t.lastSeenUs
+           << ",\"detections\":" << t.totalDetections << ",\"mean_confidence\":"
+           << (t.totalDetections ? t.confidenceSum / t.totalDetections : 0.0) << "}\n";
+    });
+    out += os.str();
+}
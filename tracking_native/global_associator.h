@@ -0,0 +1,250 @@
+/*
+ * Cross-camera global track associator for the native tracking engine
+ *
+ * Native port of src/tracking/global_track_manager.py with the same
+ * decision rule, so benchmarks measure the algorithm we actually run:
+ *
+ *   - the first time a (camera, local track id) pair is seen, its embedding
+ *     is compared with the recent features (match-history) of every global
+ *     track that is still live and has not been seen on that camera;
+ *     score = 0.7 * max + 0.3 * mean cosine similarity, and the best score
+ *     above reid-threshold links it, otherwise a new global track starts
+ *   - later sightings of the pair update the linked track and append the
+ *     embedding to its history (capped at max-history)
+ *   - global tracks not seen for track-timeout-s are dropped
+ *
+ * With decision-window-ms set, a new local track is not linked on its
+ * first sighting. It stays provisional: its detections build up a
+ * private track whose id associate() reports as 0. Every decision-tick-ms,
+ * all provisional tracks from all cameras whose window would run out
+ * before the next tick are decided in one batch. The batch is a sparse
+ * minimum-cost assignment (sparse_assignment.h) of those tracks to live
+ * global tracks. The score is the same, but the query is the normalised
+ * mean of everything seen in the window. A (global track, camera) pair
+ * takes at most one new local track per batch. A matched provisional
+ * track is merged into its global track; the rest become new global
+ * tracks. No decision comes later than the window as long as
+ * associate() or decide() is called at least once a tick. Decisions that
+ * are late anyway are counted in the stats.
+ *
+ * With [rerank] enabled, the top rerank k candidates of a query (the
+ * embedding, or the window mean) are re-ranked k-reciprocally against
+ * neighbour lists kept in the gallery (reciprocal_reranker.h). Only
+ * candidates above reid-threshold that are k-reciprocal with the query may
+ * link, and the reranked score picks among them. A gallery track's
+ * representative is the mean of its recent features. It is refreshed when
+ * the track is created or decided, when its match history first fills,
+ * and when it links or merges another local track, so the lists cost one
+ * dot product per gallery track a few times per local track.
+ *
+ * Fragments of one person on one camera (a local track lost in an
+ * occlusion and reborn under a new id) are re-stitched to the old global
+ * id by a TrackletStitcher before the gallery is searched; the caller
+ * reports lost tracks with suspendLocalTrack(). See tracklet_stitcher.h.
+ *
+ * Unlike the Python version, the per-detection trajectory list is not
+ * kept, decisions are made once per local track instead of per detection,
+ * and timestamps are the caller's (stream time), not the wall clock.
+ * Embeddings are L2-normalised on insert, so a similarity is a dot product.
+ *
+ * Where the Python manager keys dicts by "GT_000042" strings, global
+ * tracks here live in a Slab (slab.h) named by generational handles, and
+ * (camera, local id) pairs map to handles in a FlatMap (flat_map.h). A
+ * detection of a known local track costs one probe and one slot check;
+ * a handle whose track timed out stops resolving instead of aliasing the
+ * track that reuses its slot. Ids are sequential integers and are only
+ * formatted as strings for export (formatId, writeSnapshot).
+ *
+ * Not thread-safe: one owner thread calls everything.
+ *
+ * Config (key file format, see configs/tracking_native.txt):
+ *
+ *   [associator]
+ *   reid-threshold=0.75
+ *   max-history=100
+ *   match-history=10
+ *   track-timeout-s=30
+ *   min-confidence=0.5       # lower first sightings always start a new track
+ *   decision-window-ms=0     # 0 = link on the first sighting
+ *   decision-tick-ms=100     # batch period, at most decision-window-ms
+ *
+ *   [stitching]              # see tracklet_stitcher.h
+ *   [rerank]                 # see reciprocal_reranker.h
+ */
+
+#ifndef __GLOBAL_ASSOCIATOR_H__
+#define __GLOBAL_ASSOCIATOR_H__
+
+#include "flat_map.h"
+#include "iou_tracker.h"
+#include "reciprocal_reranker.h"
+#include "slab.h"
+#include "sparse_assignment.h"
+#include "tracklet_stitcher.h"
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AssociatorConfig
+{
+    float reidThreshold = 0.75f;
+    uint32_t maxHistory = 100;
+    uint32_t matchHistory = 10;
+    double trackTimeoutS = 30.0;
+    float minConfidence = 0.5f;
+    uint32_t decisionWindowMs = 0;
+    uint32_t decisionTickMs = 100;
+    StitchConfig stitching;
+    RerankConfig rerank;
+
+    static bool load(const std::string& path, AssociatorConfig& config);
+};
+
+struct AssociationInput
+{
+    uint32_t camera;
+    uint64_t localId;
+    float confidence;
+    TrackBox box;
+    const float* embedding;  // embeddingDim floats, may be null
+};
+
+struct AssociatorStats
+{
+    uint64_t detections = 0;
+    uint64_t newTracks = 0;
+    uint64_t crossCameraAssociations = 0;
+    uint64_t stitched = 0;  // new local tracks re-stitched to a lost one
+    uint64_t timeouts = 0;
+    uint64_t comparisons = 0;  // embedding dot products
+    // decision-window-ms
+    uint64_t batches = 0;
+    uint64_t decisions = 0;      // provisional tracks decided
+    uint64_t lateDecisions = 0;  // after their window
+    uint64_t decisionLatencySumUs = 0;
+    uint64_t maxDecisionLatencyUs = 0;
+    // [rerank]
+    uint64_t rerankRejected = 0;   // queries above reid-threshold left with no candidate
+    uint64_t rerankReordered = 0;  // queries whose best candidate is not their best score
+};
+
+class GlobalAssociator
+{
+public:
+    // Camera ids must stay below this, and local ids below 2^48
+    static const uint32_t kMaxCameras = 65536;
+
+    GlobalAssociator(const AssociatorConfig& config, uint32_t embeddingDim);
+
+    // Global id of the detection's local track, 1-based, or 0 while the
+    // local track is provisional
+    uint64_t associate(const AssociationInput& input, uint64_t timestampUs);
+
+    // Decides the provisional tracks due by the next tick after nowUs.
+    // associate() and expire() call this; callers with gaps between
+    // detections longer than decision-tick-ms call it from a timer.
+    void decide(uint64_t nowUs);
+
+    // The local tracker lost sight of this track at lastSeenUs (velocity in
+    // pixels per second); a new track on the same camera may take over its
+    // global id. Associating the pair again cancels this.
+    void suspendLocalTrack(uint32_t camera, uint64_t localId, const TrackBox& lastBox, float vx, float vy,
+                           uint64_t lastSeenUs);
+
+    // The local tracker ended this track; its global track stays in the
+    // gallery until it times out
+    void endLocalTrack(uint32_t camera, uint64_t localId);
+
+    // Drops global tracks last seen more than track-timeout-s before nowUs
+    void expire(uint64_t nowUs);
+
+    // Provisional tracks included
+    size_t globalTracks() const { return m_Tracks.size(); }
+    size_t provisionalTracks() const { return m_Provisional.size(); }
+    size_t localMappings() const { return m_LocalToGlobal.size(); }
+    // Approximate heap bytes held by tracks, features and maps
+    size_t memoryBytes() const;
+    size_t stitchCandidates() const { return m_Stitcher.size(); }
+    const AssociatorStats& stats() const { return m_Stats; }
+
+    // "GT_000042", the Python manager's id format
+    static std::string formatId(uint64_t globalId);
+
+    void writePrometheus(std::string& out) const;
+
+    // One JSON object per live, decided global track (JSON lines): id, cameras,
+    // first/last seen, detections and mean confidence
+    void writeSnapshot(std::string& out) const;
+
+private:
+    struct GlobalTrack
+    {
+        uint64_t id;  // 0 while provisional
+        std::vector<uint32_t> cameras;
+        uint64_t firstSeenUs;
+        uint64_t lastSeenUs;
+        std::vector<float> features;  // ring of maxHistory * dim, newest at head - 1
+        uint32_t featureHead;
+        uint32_t featureCount;
+        uint64_t totalDetections;
+        double confidenceSum;
+        bool provisional;
+    };
+
+    typedef Slab<GlobalTrack>::Handle Handle;
+
+    struct LocalLink
+    {
+        Handle track;
+        bool suspended;
+    };
+
+    // Cameras below kMaxCameras and local ids below 2^48 get distinct keys
+    static uint64_t localKey(uint32_t camera, uint64_t localId)
+    {
+        assert(camera < kMaxCameras && localId >> 48 == 0);
+        return (uint64_t)camera << 48 | localId;
+    }
+
+    Handle createTrack(const AssociationInput& input, uint64_t timestampUs, bool provisional);
+    Handle stitch(const AssociationInput& input, const float* query, uint64_t timestampUs);
+    void update(GlobalTrack& track, const AssociationInput& input, uint64_t timestampUs);
+    float* nextFeature(GlobalTrack& track);
+    bool recentMean(const GlobalTrack& track, uint32_t n);
+    void merge(GlobalTrack& into, const GlobalTrack& from);
+    float matchScore(const GlobalTrack& track, const float* embedding);
+    Handle collectCandidates(uint32_t camera, const float* query, uint64_t nowUs);
+    void refreshGallery(Handle handle, const GlobalTrack& track);
+    void normalize(const float* in, float* out) const;
+
+    AssociatorConfig m_Config;
+    uint32_t m_Dim;
+    uint64_t m_NextId;
+    uint64_t m_TimeoutUs;
+    uint64_t m_WindowUs;
+    uint64_t m_TickUs;
+    uint64_t m_NextDecisionUs;
+    Slab<GlobalTrack> m_Tracks;
+    FlatMap<LocalLink> m_LocalToGlobal;  // localKey -> track handle
+    std::vector<float> m_Query;  // normalised input embedding
+    std::vector<float> m_Mean;   // recent appearance: for the stitcher, or a batch query
+    std::vector<Handle> m_Provisional;
+    // Batch scratch
+    std::vector<Handle> m_Due;
+    std::vector<Handle> m_Columns;   // global track of each assignment column
+    FlatMap<uint32_t> m_ColumnOf;    // handle index << 32 | camera -> column + 1
+    FlatMap<Handle> m_Merged;        // provisional -> global track
+    std::vector<AssignmentEdge> m_Edges;
+    std::vector<int32_t> m_Assigned;
+    SparseAssignment m_Solver;
+    // Tracks a query may link, ranked by `reranked` (the score itself
+    // when re-ranking is off)
+    std::vector<RerankCandidate> m_Candidates;
+    ReciprocalReranker m_Reranker;
+    TrackletStitcher m_Stitcher;
+    AssociatorStats m_Stats;
+};
+
+#endif
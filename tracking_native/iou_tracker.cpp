@@ -0,0 +1,172 @@
+/*
+ * Per-camera IoU tracker for the native tracking engine
+ */
+
+#include "iou_tracker.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <iostream>
+
+float trackBoxIou(const TrackBox& a, const TrackBox& b)
+{
+    const float iw = std::min(a.left + a.width, b.left + b.width) - std::max(a.left, b.left);
+    const float ih = std::min(a.top + a.height, b.top + b.height) - std::max(a.top, b.top);
+    if (iw <= 0.0f || ih <= 0.0f) {
+        return 0.0f;
+    }
+    const float inter = iw * ih;
+    return inter / (a.width * a.height + b.width * b.height - inter);
+}
+
+bool IouTrackerConfig::load(const std::string& path, IouTrackerConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "tracker";
+    IouTrackerConfig c;
+    c.minIou = (float)kf.getDouble(g, "min-iou", c.minIou);
+    c.probationAge = (uint32_t)kf.getInt(g, "probation-age", (int)c.probationAge);
+    c.maxShadowAge = (uint32_t)kf.getInt(g, "max-shadow-age", (int)c.maxShadowAge);
+    c.maxTargets = (uint32_t)kf.getInt(g, "max-targets", (int)c.maxTargets);
+    c.minConfidence = (float)kf.getDouble(g, "min-confidence", c.minConfidence);
+    c.velocitySmoothing = (float)kf.getDouble(g, "velocity-smoothing", c.velocitySmoothing);
+    if (c.minIou <= 0.0f || c.minIou > 1.0f || c.velocitySmoothing < 0.0f || c.velocitySmoothing > 1.0f) {
+        std::cerr << "ERROR: " << path << ": min-iou must be within (0, 1], velocity-smoothing within [0, 1]"
+                  << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+IouTracker::IouTracker(const IouTrackerConfig& config) : m_Config(config), m_NextId(1), m_Frame(0)
+{
+}
+
+TrackBox IouTracker::predict(const Track& t) const
+{
+    const float steps = (float)(m_Frame - t.lastFrame);
+    TrackBox b = t.box;
+    b.left += t.vx * steps;
+    b.top += t.vy * steps;
+    return b;
+}
+
+void IouTracker::update(const std::vector<TrackerDetection>& detections, std::vector<TrackedObject>& active,
+                        std::vector<TerminatedTrack>& terminated)
+{
+    m_Frame++;
+    active.clear();
+    terminated.clear();
+
+    const uint32_t numTracks = (uint32_t)m_Tracks.size();
+    const uint32_t numDets = (uint32_t)detections.size();
+    m_Predicted.resize(numTracks);
+    for (uint32_t t = 0; t < numTracks; ++t) {
+        m_Predicted[t] = predict(m_Tracks[t]);
+    }
+
+    // Greedy matching on descending IoU
+    m_Candidates.clear();
+    for (uint32_t t = 0; t < numTracks; ++t) {
+        for (uint32_t d = 0; d < numDets; ++d) {
+            if (detections[d].classId != m_Tracks[t].classId) {
+                continue;
+            }
+            const float iou = trackBoxIou(m_Predicted[t], detections[d].box);
+            if (iou >= m_Config.minIou) {
+                m_Candidates.push_back(Candidate{iou, t, d});
+            }
+        }
+    }
+    std::sort(m_Candidates.begin(), m_Candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.iou > b.iou; });
+
+    m_TrackMatch.assign(numTracks, -1);
+    m_DetectionUsed.assign(numDets, false);
+    for (const Candidate& c : m_Candidates) {
+        if (m_TrackMatch[c.track] < 0 && !m_DetectionUsed[c.detection]) {
+            m_TrackMatch[c.track] = (int)c.detection;
+            m_DetectionUsed[c.detection] = true;
+        }
+    }
+
+    const float alpha = m_Config.velocitySmoothing;
+    size_t keep = 0;
+    for (uint32_t t = 0; t < numTracks; ++t) {
+        Track& tr = m_Tracks[t];
+        tr.age++;
+        const int d = m_TrackMatch[t];
+        if (d >= 0) {
+            const TrackBox& nb = detections[d].box;
+            const float steps = (float)(m_Frame - tr.lastFrame);
+            const float dx = (nb.left + nb.width * 0.5f - tr.box.left - tr.box.width * 0.5f) / steps;
+            const float dy = (nb.top + nb.height * 0.5f - tr.box.top - tr.box.height * 0.5f) / steps;
+            tr.vx = alpha * tr.vx + (1.0f - alpha) * dx;
+            tr.vy = alpha * tr.vy + (1.0f - alpha) * dy;
+            tr.box = nb;
+            tr.confidence = detections[d].confidence;
+            tr.hits++;
+            tr.missed = 0;
+            tr.lastFrame = m_Frame;
+        } else {
+            tr.missed++;
+        }
+
+        const bool confirmed = tr.hits >= m_Config.probationAge;
+        // Tentative tracks die on their first miss (earlyTerminationAge 1)
+        if (tr.missed > m_Config.maxShadowAge || (!confirmed && tr.missed > 0)) {
+            terminated.push_back(TerminatedTrack{tr.id, tr.box, tr.vx, tr.vy, tr.lastFrame, tr.age, confirmed});
+            continue;
+        }
+
+        TrackedObject o;
+        o.trackId = tr.id;
+        o.box = d >= 0 ? tr.box : m_Predicted[t];
+        o.vx = tr.vx;
+        o.vy = tr.vy;
+        o.confidence = tr.confidence;
+        o.classId = tr.classId;
+        o.detection = d >= 0 ? (uint32_t)d : TrackedObject::kNoDetection;
+        o.age = tr.age;
+        o.missed = tr.missed;
+        o.confirmed = confirmed;
+        active.push_back(o);
+        m_Tracks[keep++] = tr;
+    }
+    m_Tracks.resize(keep);
+
+    for (uint32_t d = 0; d < numDets && m_Tracks.size() < m_Config.maxTargets; ++d) {
+        if (m_DetectionUsed[d] || detections[d].confidence < m_Config.minConfidence) {
+            continue;
+        }
+        Track tr;
+        tr.id = m_NextId++;
+        tr.box = detections[d].box;
+        tr.vx = 0.0f;
+        tr.vy = 0.0f;
+        tr.confidence = detections[d].confidence;
+        tr.classId = detections[d].classId;
+        tr.age = 1;
+        tr.hits = 1;
+        tr.missed = 0;
+        tr.lastFrame = m_Frame;
+        m_Tracks.push_back(tr);
+
+        TrackedObject o;
+        o.trackId = tr.id;
+        o.box = tr.box;
+        o.vx = 0.0f;
+        o.vy = 0.0f;
+        o.confidence = tr.confidence;
+        o.classId = tr.classId;
+        o.detection = d;
+        o.age = 1;
+        o.missed = 0;
+        o.confirmed = tr.hits >= m_Config.probationAge;
+        active.push_back(o);
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * Per-camera IoU tracker for the native tracking engine
+ *
+ * A CPU stand-in for the NvDCF low-level tracker, good enough to drive the
+ * cross-camera associator from host-side tools and benchmarks: each track
+ * predicts its box one frame ahead with a smoothed velocity, detections are
+ * matched to predictions greedily by descending IoU (NvDCF's
+ * associationMatcherType 0), unmatched detections above min-confidence open
+ * tentative tracks, and tracks missing for more than max-shadow-age frames
+ * are terminated. Parameter names follow trackers/tracker_config*.yml.
+ *
+ * Config (key file format, see configs/tracking_native.txt):
+ *
+ *   [tracker]
+ *   min-iou=0.3
+ *   probation-age=3          # matched frames before a track is reported
+ *   max-shadow-age=90        # frames a track survives without a match
+ *   max-targets=150
+ *   min-confidence=0.3       # to open a track
+ *   velocity-smoothing=0.5
+ */
+
+#ifndef __IOU_TRACKER_H__
+#define __IOU_TRACKER_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TrackBox
+{
+    float left, top, width, height;
+};
+
+float trackBoxIou(const TrackBox& a, const TrackBox& b);
+
+struct IouTrackerConfig
+{
+    float minIou = 0.3f;
+    uint32_t probationAge = 3;
+    uint32_t maxShadowAge = 90;
+    uint32_t maxTargets = 150;
+    float minConfidence = 0.3f;
+    float velocitySmoothing = 0.5f;
+
+    static bool load(const std::string& path, IouTrackerConfig& config);
+};
+
+struct TrackerDetection
+{
+    TrackBox box;
+    float confidence;
+    int classId;
+};
+
+struct TrackedObject
+{
+    uint64_t trackId;  // unique per tracker, never reused
+    TrackBox box;      // matched detection, or the prediction while in shadow
+    float vx, vy;      // centre velocity, pixels per frame
+    float confidence;
+    int classId;
+    uint32_t detection;  // index into this frame's detections, kNoDetection in shadow
+    uint32_t age;        // frames since birth
+    uint32_t missed;     // consecutive frames without a match
+    bool confirmed;      // passed probation
+
+    static const uint32_t kNoDetection = 0xffffffffu;
+};
+
+// A track that ended this frame: its last matched box, the velocity it was
+// moving with and when it was last seen, for re-stitching and cleanup
+struct TerminatedTrack
+{
+    uint64_t trackId;
+    TrackBox lastBox;
+    float vx, vy;  // pixels per frame
+    uint64_t lastFrame;
+    uint32_t age;
+    bool confirmed;
+};
+
+class IouTracker
+{
+public:
+    explicit IouTracker(const IouTrackerConfig& config);
+
+    // Advances one frame. `active` gets every live track (tentative ones
+    // included, check `confirmed`), `terminated` the tracks that ended.
+    void update(const std::vector<TrackerDetection>& detections, std::vector<TrackedObject>& active,
+                std::vector<TerminatedTrack>& terminated);
+
+    size_t size() const { return m_Tracks.size(); }
+    uint64_t frame() const { return m_Frame; }
+    uint64_t tracksCreated() const { return m_NextId - 1; }
+
+private:
+    struct Track
+    {
+        uint64_t id;
+        TrackBox box;  // last matched
+        float vx, vy;  // centre velocity, pixels per frame
+        float confidence;
+        int classId;
+        uint32_t age;
+        uint32_t hits;
+        uint32_t missed;
+        uint64_t lastFrame;
+    };
+
+    struct Candidate
+    {
+        float iou;
+        uint32_t track;
+        uint32_t detection;
+    };
+
+    TrackBox predict(const Track& t) const;
+
+    IouTrackerConfig m_Config;
+    std::vector<Track> m_Tracks;
+    uint64_t m_NextId;
+    uint64_t m_Frame;
+    // Scratch reused across frames
+    std::vector<Candidate> m_Candidates;
+    std::vector<TrackBox> m_Predicted;
+    std::vector<int> m_TrackMatch;
+    std::vector<bool> m_DetectionUsed;
+};
+
+#endif
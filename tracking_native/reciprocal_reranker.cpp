@@ -0,0 +1,199 @@
+/*
+ * k-reciprocal re-ranking of cross-camera ReID candidates
+ */
+
+#include "reciprocal_reranker.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <iostream>
+
+bool RerankConfig::load(const KeyFile& kf, const std::string& path, RerankConfig& config)
+{
+    const std::string g = "rerank";
+    RerankConfig c;
+    c.enable = kf.getBool(g, "enable", c.enable);
+    c.k = (uint32_t)std::max(0, kf.getInt(g, "k", (int)c.k));
+    c.lambda = (float)kf.getDouble(g, "lambda", c.lambda);
+    if (c.k == 0 || c.lambda < 0.0f || c.lambda > 1.0f) {
+        std::cerr << "ERROR: " << path << ": [rerank] needs a positive k and 0 <= lambda <= 1" << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+ReciprocalReranker::ReciprocalReranker(const RerankConfig& config, uint32_t embeddingDim)
+    : m_Config(config), m_Dim(embeddingDim)
+{
+}
+
+float ReciprocalReranker::dot(const float* a, const float* b) const
+{
+    float d = 0.0f;
+    for (uint32_t k = 0; k < m_Dim; ++k) {
+        d += a[k] * b[k];
+    }
+    // Weights below are similarities, so keep them non-negative like matchScore
+    return std::max(0.0f, d);
+}
+
+uint32_t ReciprocalReranker::indexOf(uint64_t id) const
+{
+    const uint32_t* at = m_IndexOf.find(id);
+    return at ? *at : 0;
+}
+
+bool ReciprocalReranker::enters(uint32_t index, float similarity) const
+{
+    const std::vector<Neighbour>& list = m_Neighbours[index];
+    return list.size() < m_Config.k || similarity >= list.back().similarity;
+}
+
+void ReciprocalReranker::offer(std::vector<Neighbour>& list, uint32_t index, float similarity)
+{
+    if (list.size() >= m_Config.k && similarity <= list.back().similarity) {
+        return;
+    }
+    auto at = std::upper_bound(list.begin(), list.end(), similarity,
+                               [](float s, const Neighbour& n) { return s > n.similarity; });
+    list.insert(at, Neighbour{index, similarity});
+    if (list.size() > m_Config.k) {
+        list.pop_back();
+    }
+}
+
+void ReciprocalReranker::drop(std::vector<Neighbour>& list, uint32_t index)
+{
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (list[i].index == index) {
+            list.erase(list.begin() + i);
+            return;
+        }
+    }
+}
+
+void ReciprocalReranker::update(uint64_t id, const float* embedding)
+{
+    uint32_t at = indexOf(id);
+    if (at == 0) {
+        m_Ids.push_back(id);
+        m_Embeddings.insert(m_Embeddings.end(), embedding, embedding + m_Dim);
+        m_Neighbours.emplace_back();
+        at = (uint32_t)m_Ids.size();
+        m_IndexOf[id] = at;
+    } else {
+        std::copy(embedding, embedding + m_Dim, &m_Embeddings[(size_t)(at - 1) * m_Dim]);
+    }
+    const uint32_t self = at - 1;
+    m_Stats.updates++;
+
+    // A list that loses this track here is one short until its own track
+    // updates, which only makes reciprocity easier to reach for it
+    m_Neighbours[self].clear();
+    for (uint32_t j = 0; j < m_Ids.size(); ++j) {
+        if (j == self) {
+            continue;
+        }
+        const float s = dot(&m_Embeddings[(size_t)j * m_Dim], embedding);
+        drop(m_Neighbours[j], self);
+        offer(m_Neighbours[j], self, s);
+        offer(m_Neighbours[self], j, s);
+    }
+    m_Stats.comparisons += m_Ids.size() - 1;
+}
+
+void ReciprocalReranker::remove(uint64_t id)
+{
+    const uint32_t at = indexOf(id);
+    if (at == 0) {
+        return;
+    }
+    const uint32_t self = at - 1;
+    const uint32_t last = (uint32_t)m_Ids.size() - 1;
+    m_Stats.removals++;
+
+    for (std::vector<Neighbour>& list : m_Neighbours) {
+        drop(list, self);
+        for (Neighbour& n : list) {
+            if (n.index == last) {
+                n.index = self;
+            }
+        }
+    }
+    if (self != last) {
+        m_Ids[self] = m_Ids[last];
+        std::copy(&m_Embeddings[(size_t)last * m_Dim], &m_Embeddings[(size_t)last * m_Dim] + m_Dim,
+                  &m_Embeddings[(size_t)self * m_Dim]);
+        m_Neighbours[self].swap(m_Neighbours[last]);
+        m_IndexOf[m_Ids[self]] = at;
+    }
+    m_Ids.pop_back();
+    m_Embeddings.resize((size_t)last * m_Dim);
+    m_Neighbours.pop_back();
+    m_IndexOf.erase(id);
+}
+
+void ReciprocalReranker::rerank(const float* query, std::vector<RerankCandidate>& candidates)
+{
+    m_Stats.queries++;
+    const size_t n = candidates.size();
+    m_CandidateIndex.resize(n);
+    m_QuerySimilarity.resize(n);
+    m_Reciprocal.clear();
+
+    // R(q) and the weight of {q} + R(q)
+    float querySum = 1.0f;
+    for (size_t i = 0; i < n; ++i) {
+        RerankCandidate& c = candidates[i];
+        const uint32_t at = indexOf(c.id);
+        m_CandidateIndex[i] = at;
+        m_QuerySimilarity[i] = at ? dot(query, &m_Embeddings[(size_t)(at - 1) * m_Dim]) : 0.0f;
+        c.reciprocal = at && enters(at - 1, m_QuerySimilarity[i]);
+        if (c.reciprocal) {
+            m_Reciprocal.push_back((uint32_t)i);
+            querySum += m_QuerySimilarity[i];
+        }
+        m_Stats.comparisons += at ? 1 : 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        RerankCandidate& c = candidates[i];
+        float jaccard = 0.0f;
+        if (m_CandidateIndex[i]) {
+            // {g} + R(g), plus q when the two are reciprocal: then q and g
+            // each sit in both sets, weighted s(q, g) on one side and 1 on
+            // the other
+            const uint32_t g = m_CandidateIndex[i] - 1;
+            float shared = 0.0f;
+            float candidateSum = 1.0f;
+            if (c.reciprocal) {
+                shared += 2.0f * m_QuerySimilarity[i];
+                candidateSum += m_QuerySimilarity[i];
+            }
+            for (const Neighbour& h : m_Neighbours[g]) {
+                if (!enters(h.index, h.similarity)) {
+                    continue;
+                }
+                candidateSum += h.similarity;
+                for (uint32_t r : m_Reciprocal) {
+                    if (m_CandidateIndex[r] == h.index + 1) {
+                        shared += std::min(m_QuerySimilarity[r], h.similarity);
+                    }
+                }
+            }
+            jaccard = shared / (querySum + candidateSum - shared);
+        }
+        c.reranked = (1.0f - m_Config.lambda) * jaccard + m_Config.lambda * c.score;
+    }
+}
+
+size_t ReciprocalReranker::memoryBytes() const
+{
+    size_t bytes = m_Ids.capacity() * sizeof(uint64_t) + m_Embeddings.capacity() * sizeof(float) +
+                   m_Neighbours.capacity() * sizeof(std::vector<Neighbour>) + m_IndexOf.memoryBytes();
+    for (const std::vector<Neighbour>& list : m_Neighbours) {
+        bytes += list.capacity() * sizeof(Neighbour);
+    }
+    return bytes;
+}
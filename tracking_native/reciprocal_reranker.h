@@ -0,0 +1,143 @@
+/*
+ * k-reciprocal re-ranking of cross-camera ReID candidates
+ *
+ * The gallery search scores a new local track against each global track on
+ * its own. A track that looks like many people (a "hub": dark clothes, a
+ * back view) wins wherever the right person is missing from the gallery,
+ * and this causes most false merges. k-reciprocal re-ranking (Zhong et al.,
+ * CVPR 2017) also asks the reverse question: would the query rank among
+ * the candidate's own k nearest gallery tracks? Two people who merely look
+ * alike often fail that test, while two views of one person usually pass.
+ *
+ * Re-ranking runs only on the query's top-k candidates. The reverse
+ * neighbourhoods come from neighbour lists that the reranker keeps for
+ * every gallery track: its k most similar other tracks, by the cosine
+ * similarity of their representative embeddings (the normalised mean of
+ * recent features). The lists are maintained incrementally, not
+ * recomputed per query:
+ *
+ *   update    a track's representative changed: one dot product per
+ *             gallery track, rebuilding its own list and entering it into
+ *             (or dropping it from) the lists of the others
+ *   remove    one pass over the lists
+ *
+ * Each candidate then costs O(k) for the reciprocity test and O(k^2) for
+ * the Jaccard term, whatever the gallery size. For candidate g of query q,
+ * with s(a, b) the similarity:
+ *
+ *   reciprocal  q would enter g's list: it is short of k, or s(q, g) beats
+ *               its k-th entry
+ *   R(q)        reciprocal candidates of q; R(g) the entries h of g's list
+ *               for which g would enter h's list
+ *   jaccard     weighted Jaccard similarity of {q} + R(q) and {g} + R(g),
+ *               weights s(q, .) and s(g, .), self 1, and q in R(g) when g
+ *               is in R(q)
+ *   reranked    (1 - lambda) * jaccard + lambda * score, where score is
+ *               the caller's original score
+ *
+ * The Jaccard term does not share the original score's scale, so the
+ * reranked value orders candidates and is not compared with
+ * reid-threshold.
+ *
+ * Tracks are named by the owner's 64-bit ids (the associator's slab
+ * handles). Not thread-safe.
+ *
+ * Config (key file format, see configs/tracking_native.txt):
+ *
+ *   [rerank]
+ *   enable=0
+ *   k=10          # candidates re-ranked, and neighbours kept per track
+ *   lambda=0.3
+ */
+
+#ifndef __RECIPROCAL_RERANKER_H__
+#define __RECIPROCAL_RERANKER_H__
+
+#include "flat_map.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class KeyFile;
+
+struct RerankConfig
+{
+    bool enable = false;
+    uint32_t k = 10;
+    float lambda = 0.3f;
+
+    // Reads the [rerank] group; false on invalid values
+    static bool load(const KeyFile& kf, const std::string& path, RerankConfig& config);
+};
+
+struct RerankCandidate
+{
+    uint64_t id;
+    float score;     // the caller's, in
+    float reranked;  // out
+    bool reciprocal; // out
+};
+
+struct RerankStats
+{
+    uint64_t updates = 0;
+    uint64_t removals = 0;
+    uint64_t queries = 0;
+    uint64_t comparisons = 0;  // embedding dot products
+};
+
+class ReciprocalReranker
+{
+public:
+    ReciprocalReranker(const RerankConfig& config, uint32_t embeddingDim);
+
+    // Adds track `id` or replaces its representative; `embedding` is
+    // normalised
+    void update(uint64_t id, const float* embedding);
+
+    void remove(uint64_t id);
+
+    // Fills in reranked and reciprocal for the query's candidates, at most
+    // k of them; `query` is normalised. Candidates not in the gallery are
+    // never reciprocal.
+    void rerank(const float* query, std::vector<RerankCandidate>& candidates);
+
+    const RerankConfig& config() const { return m_Config; }
+    size_t size() const { return m_Ids.size(); }
+    size_t memoryBytes() const;
+    const RerankStats& stats() const { return m_Stats; }
+
+private:
+    struct Neighbour
+    {
+        uint32_t index;
+        float similarity;
+    };
+
+    float dot(const float* a, const float* b) const;
+    // Index + 1, or 0
+    uint32_t indexOf(uint64_t id) const;
+    // `similarity` would make the list of track `index` (entries sorted by
+    // descending similarity)
+    bool enters(uint32_t index, float similarity) const;
+    void offer(std::vector<Neighbour>& list, uint32_t index, float similarity);
+    void drop(std::vector<Neighbour>& list, uint32_t index);
+
+    RerankConfig m_Config;
+    uint32_t m_Dim;
+    // Tracks sit densely by index, so update() is one sweep over
+    // m_Embeddings; remove() moves the last track into the hole
+    std::vector<uint64_t> m_Ids;
+    std::vector<float> m_Embeddings;  // size() * dim
+    std::vector<std::vector<Neighbour>> m_Neighbours;
+    FlatMap<uint32_t> m_IndexOf;  // id -> index + 1
+    // Query scratch
+    std::vector<uint32_t> m_CandidateIndex;  // per candidate, index + 1 or 0
+    std::vector<float> m_QuerySimilarity;
+    std::vector<uint32_t> m_Reciprocal;  // candidate positions in R(q)
+    RerankStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ * In-process ReID embedder on the ONNX Runtime CPU execution provider
+ */
+
+#include "reid_embedder.h"
+#include "key_file.h"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+typedef std::chrono::steady_clock Clock;
+
+static uint64_t elapsedUs(Clock::time_point since)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count();
+}
+
+bool ReidEmbedderConfig::load(const std::string& path, ReidEmbedderConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "reid-cpu";
+    ReidEmbedderConfig c;
+    c.model = kf.getString(g, "model", c.model);
+    c.inputName = kf.getString(g, "input-name", c.inputName);
+    c.outputName = kf.getString(g, "output-name", c.outputName);
+    c.maxBatch = (uint32_t)std::max(0, kf.getInt(g, "max-batch", (int)c.maxBatch));
+    const int threads = kf.getInt(g, "intra-op-threads", (int)c.intraOpThreads);
+    if (threads < 0 || threads > (int)kMaxIntraOpThreads) {
+        std::cerr << "ERROR: " << path << ": intra-op-threads must be within 0.." << kMaxIntraOpThreads << std::endl;
+        return false;
+    }
+    c.intraOpThreads = (uint32_t)threads;
+    c.cpus = kf.getIntList(g, "cpus");
+    c.allowSpinning = kf.getBool(g, "allow-spinning", c.allowSpinning);
+    c.optimization = kf.getString(g, "optimization", c.optimization);
+    if (kf.hasKey(g, "mean")) {
+        const std::vector<double> v = kf.getDoubleList(g, "mean");
+        if (v.size() != 3) {
+            std::cerr << "ERROR: " << path << ": mean needs 3 values (R;G;B)" << std::endl;
+            return false;
+        }
+        for (int i = 0; i < 3; ++i) {
+            c.mean[i] = (float)v[i];
+        }
+    }
+    if (kf.hasKey(g, "std")) {
+        const std::vector<double> v = kf.getDoubleList(g, "std");
+        if (v.size() != 3 || v[0] <= 0.0 || v[1] <= 0.0 || v[2] <= 0.0) {
+            std::cerr << "ERROR: " << path << ": std needs 3 positive values (R;G;B)" << std::endl;
+            return false;
+        }
+        for (int i = 0; i < 3; ++i) {
+            c.stddev[i] = (float)v[i];
+        }
+    }
+    if (c.model.empty() || c.maxBatch == 0 || c.maxBatch > kMaxBatch) {
+        std::cerr << "ERROR: " << path << ": need a model and max-batch within 1.." << kMaxBatch << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+struct ReidEmbedder::Runtime
+{
+    Ort::Env env{ORT_LOGGING_LEVEL_WARNING, "reid-cpu"};
+    Ort::Session session{nullptr};
+    Ort::RunOptions run;
+    // Views of m_Input/m_Output and their binding, index = batch size - 1
+    std::vector<Ort::Value> inputs;
+    std::vector<Ort::Value> outputs;
+    std::vector<Ort::IoBinding> bindings;
+};
+
+ReidEmbedder::ReidEmbedder(const ReidEmbedderConfig& config) : m_Config(config)
+{
+}
+
+ReidEmbedder::~ReidEmbedder() = default;
+
+std::unique_ptr<ReidEmbedder> ReidEmbedder::create(const ReidEmbedderConfig& config)
+{
+    std::unique_ptr<ReidEmbedder> embedder(new ReidEmbedder(config));
+    if (!embedder->init()) {
+        return nullptr;
+    }
+    return embedder;
+}
+
+static bool parseOptimization(const std::string& name, GraphOptimizationLevel& level)
+{
+    if (name == "none") {
+        level = ORT_DISABLE_ALL;
+    } else if (name == "basic") {
+        level = ORT_ENABLE_BASIC;
+    } else if (name == "extended") {
+        level = ORT_ENABLE_EXTENDED;
+    } else if (name == "all") {
+        level = ORT_ENABLE_ALL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Shape of the named input or output, empty when the model has none or it
+// is not an FP32 tensor
+static std::vector<int64_t> tensorShape(Ort::Session& session, const std::string& name, bool input)
+{
+    Ort::AllocatorWithDefaultOptions allocator;
+    const size_t count = input ? session.GetInputCount() : session.GetOutputCount();
+    for (size_t i = 0; i < count; ++i) {
+        Ort::AllocatedStringPtr n =
+            input ? session.GetInputNameAllocated(i, allocator) : session.GetOutputNameAllocated(i, allocator);
+        if (name != n.get()) {
+            continue;
+        }
+        Ort::TypeInfo type = input ? session.GetInputTypeInfo(i) : session.GetOutputTypeInfo(i);
+        auto tensor = type.GetTensorTypeAndShapeInfo();
+        if (tensor.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+            return {};
+        }
+        return tensor.GetShape();
+    }
+    return {};
+}
+
+bool ReidEmbedder::init()
+{
+    const ReidEmbedderConfig& c = m_Config;
+    GraphOptimizationLevel level;
+    if (!parseOptimization(c.optimization, level)) {
+        std::cerr << "ERROR: Unknown ReID optimization level " << c.optimization << std::endl;
+        return false;
+    }
+    // Configs built in code skip load(); tensors are sized by max-batch
+    if (c.maxBatch == 0 || c.maxBatch > ReidEmbedderConfig::kMaxBatch ||
+        c.intraOpThreads > ReidEmbedderConfig::kMaxIntraOpThreads) {
+        std::cerr << "ERROR: ReID embedder needs max-batch within 1.." << ReidEmbedderConfig::kMaxBatch
+                  << " and at most " << ReidEmbedderConfig::kMaxIntraOpThreads << " intra-op threads" << std::endl;
+        return false;
+    }
+    m_Threads = c.intraOpThreads ? c.intraOpThreads : std::max<uint32_t>(1, (uint32_t)c.cpus.size());
+    if (!c.cpus.empty() && c.cpus.size() < m_Threads) {
+        std::cerr << "ERROR: ReID embedder has " << m_Threads << " intra-op threads but only " << c.cpus.size()
+                  << " cpus" << std::endl;
+        return false;
+    }
+
+    try {
+        m_Runtime.reset(new Runtime());
+        Ort::SessionOptions options;
+        options.SetExecutionMode(ORT_SEQUENTIAL);
+        options.SetGraphOptimizationLevel(level);
+        options.SetIntraOpNumThreads((int)m_Threads);
+        options.SetInterOpNumThreads(1);
+        options.AddConfigEntry("session.intra_op.allow_spinning", c.allowSpinning ? "1" : "0");
+        // Denormals in late ResNet layers cost more than the precision
+        options.AddConfigEntry("session.set_denormal_as_zero", "1");
+        if (!c.cpus.empty() && m_Threads > 1) {
+            // One entry per pool thread (not the caller), 1-based processor ids
+            std::ostringstream affinities;
+            for (uint32_t t = 1; t < m_Threads; ++t) {
+                affinities << (t > 1 ? ";" : "") << c.cpus[t] + 1;
+            }
+            options.AddConfigEntry("session.intra_op_thread_affinities", affinities.str().c_str());
+        }
+        m_Runtime->session = Ort::Session(m_Runtime->env, c.model.c_str(), options);
+
+        const std::vector<int64_t> in = tensorShape(m_Runtime->session, c.inputName, true);
+        const std::vector<int64_t> out = tensorShape(m_Runtime->session, c.outputName, false);
+        if (in.size() != 4 || in[1] != 3 || in[2] <= 0 || in[3] <= 0 || in[0] > 0 || out.size() != 2 ||
+            out[1] <= 0 || out[0] > 0) {
+            std::cerr << "ERROR: " << c.model << ": need FP32 input " << c.inputName
+                      << " [N,3,H,W] and output " << c.outputName << " [N,D] with a dynamic batch" << std::endl;
+            return false;
+        }
+        m_Height = (uint32_t)in[2];
+        m_Width = (uint32_t)in[3];
+        m_Dim = (uint32_t)out[1];
+
+        const size_t crop = (size_t)3 * m_Height * m_Width;
+        m_Input.assign(crop * c.maxBatch, 0.0f);
+        m_Output.assign((size_t)m_Dim * c.maxBatch, 0.0f);
+        m_X0.resize(m_Width);
+        m_X1.resize(m_Width);
+        m_Fx.resize(m_Width);
+
+        Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        for (uint32_t n = 1; n <= c.maxBatch; ++n) {
+            const int64_t inShape[4] = {(int64_t)n, 3, (int64_t)m_Height, (int64_t)m_Width};
+            const int64_t outShape[2] = {(int64_t)n, (int64_t)m_Dim};
+            m_Runtime->inputs.push_back(Ort::Value::CreateTensor<float>(memory, m_Input.data(), crop * n, inShape, 4));
+            m_Runtime->outputs.push_back(
+                Ort::Value::CreateTensor<float>(memory, m_Output.data(), (size_t)m_Dim * n, outShape, 2));
+            Ort::IoBinding binding(m_Runtime->session);
+            binding.BindInput(c.inputName.c_str(), m_Runtime->inputs.back());
+            binding.BindOutput(c.outputName.c_str(), m_Runtime->outputs.back());
+            m_Runtime->bindings.push_back(std::move(binding));
+        }
+
+        // ONNX Runtime plans its allocations on the first run per shape
+        for (uint32_t n : {1u, c.maxBatch}) {
+            m_Runtime->session.Run(m_Runtime->run, m_Runtime->bindings[n - 1]);
+        }
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ERROR: Cannot load ReID model " << c.model << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ReidEmbedder::preprocess(const ReidCrop& crop, float* dst)
+{
+    const size_t plane = (size_t)m_Width * m_Height;
+    const float left = std::max(0.0f, crop.box.left);
+    const float top = std::max(0.0f, crop.box.top);
+    const float right = std::min((float)crop.width, crop.box.left + crop.box.width);
+    const float bottom = std::min((float)crop.height, crop.box.top + crop.box.height);
+    if (right - left < 1.0f || bottom - top < 1.0f) {
+        // Nothing left of the box: the normalised mean, i.e. zeros
+        std::fill(dst, dst + 3 * plane, 0.0f);
+        return;
+    }
+
+    const uint32_t bpp = (crop.format == kReidRgba || crop.format == kReidBgra) ? 4 : 3;
+    const bool bgr = crop.format == kReidBgr || crop.format == kReidBgra;
+    const uint32_t channel[3] = {bgr ? 2u : 0u, 1u, bgr ? 0u : 2u};  // byte offset of R, G, B
+    float scale[3], bias[3];
+    for (int ch = 0; ch < 3; ++ch) {
+        scale[ch] = 1.0f / (255.0f * m_Config.stddev[ch]);
+        bias[ch] = -m_Config.mean[ch] / m_Config.stddev[ch];
+    }
+
+    // Bilinear taps with pixel centres aligned, clamped to the box
+    const float sx = (right - left) / m_Width;
+    const float sy = (bottom - top) / m_Height;
+    const int32_t maxX = (int32_t)std::ceil(right) - 1;
+    const int32_t maxY = (int32_t)std::ceil(bottom) - 1;
+    for (uint32_t x = 0; x < m_Width; ++x) {
+        const float fx = std::max(left, left + (x + 0.5f) * sx - 0.5f);
+        const int32_t x0 = std::min((int32_t)fx, maxX);
+        m_X0[x] = x0 * (int32_t)bpp;
+        m_X1[x] = std::min(x0 + 1, maxX) * (int32_t)bpp;
+        m_Fx[x] = fx - x0;
+    }
+
+    for (uint32_t y = 0; y < m_Height; ++y) {
+        const float fy = std::max(top, top + (y + 0.5f) * sy - 0.5f);
+        const int32_t y0 = std::min((int32_t)fy, maxY);
+        const int32_t y1 = std::min(y0 + 1, maxY);
+        const float wy = fy - y0;
+        const uint8_t* row0 = crop.pixels + (size_t)y0 * crop.stride;
+        const uint8_t* row1 = crop.pixels + (size_t)y1 * crop.stride;
+        for (int ch = 0; ch < 3; ++ch) {
+            float* out = dst + ch * plane + (size_t)y * m_Width;
+            const uint32_t o = channel[ch];
+            for (uint32_t x = 0; x < m_Width; ++x) {
+                const float wx = m_Fx[x];
+                const float a = row0[m_X0[x] + o] + wx * (row0[m_X1[x] + o] - row0[m_X0[x] + o]);
+                const float b = row1[m_X0[x] + o] + wx * (row1[m_X1[x] + o] - row1[m_X0[x] + o]);
+                out[x] = (a + wy * (b - a)) * scale[ch] + bias[ch];
+            }
+        }
+    }
+}
+
+bool ReidEmbedder::embed(const ReidCrop* crops, uint32_t count, float* embeddings)
+{
+    const size_t crop = (size_t)3 * m_Height * m_Width;
+    for (uint32_t done = 0; done < count;) {
+        const uint32_t n = std::min(count - done, m_Config.maxBatch);
+        Clock::time_point start = Clock::now();
+        for (uint32_t i = 0; i < n; ++i) {
+            preprocess(crops[done + i], &m_Input[i * crop]);
+        }
+        m_Stats.preprocessUs += elapsedUs(start);
+
+        start = Clock::now();
+        try {
+            m_Runtime->session.Run(m_Runtime->run, m_Runtime->bindings[n - 1]);
+        } catch (const Ort::Exception& e) {
+            std::cerr << "ERROR: ReID inference failed: " << e.what() << std::endl;
+            return false;
+        }
+        m_Stats.inferenceUs += elapsedUs(start);
+
+        memcpy(embeddings + (size_t)done * m_Dim, m_Output.data(), (size_t)n * m_Dim * sizeof(float));
+        m_Stats.crops += n;
+        m_Stats.batches += 1;
+        done += n;
+    }
+    return true;
+}
+
+void ReidEmbedder::writePrometheus(std::string& out) const
+{
+    std::ostringstream os;
+    os << "# TYPE deepstream_tracking_reid_crops_total counter\n"
+       << "deepstream_tracking_reid_crops_total " << m_Stats.crops << "\n"
+       << "# TYPE deepstream_tracking_reid_batches_total counter\n"
+       << "deepstream_tracking_reid_batches_total " << m_Stats.batches << "\n"
+       << "# TYPE deepstream_tracking_reid_preprocess_seconds_total counter\n"
+       << "deepstream_tracking_reid_preprocess_seconds_total " << m_Stats.preprocessUs / 1e6 << "\n"
+       << "# TYPE deepstream_tracking_reid_inference_seconds_total counter\n"
+       << "deepstream_tracking_reid_inference_seconds_total " << m_Stats.inferenceUs / 1e6 << "\n";
+    out += os.str();
+}
@@ -0,0 +1,140 @@
+/*
+ * In-process ReID embedder on the ONNX Runtime CPU execution provider
+ *
+ * Runs models/reid_resnet50 (input "input" [N,3,256,128] FP32 NCHW,
+ * output "output" [N,512]) inside the process instead of through Triton,
+ * without a GPU or a network round trip per call. Only tools/bench_reid_cpu
+ * runs it so far; no pipeline config (configs/reid/deepstream_reid_cpu.txt
+ * included) has a probe that feeds it crops.
+ *
+ *   - crops are cut from packed 8-bit frames (RGB, BGR, RGBA or BGRA with
+ *     a row stride, as a mapped NvBufSurface on the CPU path), resized
+ *     bilinearly to the model input and normalised with the ImageNet
+ *     mean/std straight into the input tensor
+ *   - embed() splits its crops into batches of at most max-batch (the
+ *     model's max_batch_size, 16) and runs one session call per batch
+ *   - the input and output tensors are allocated once for max-batch; an
+ *     IoBinding per batch size 1..max-batch binds views of those buffers,
+ *     so a call allocates nothing and ONNX Runtime writes the embeddings
+ *     into memory we own
+ *   - the session has its own intra-op pool of intra-op-threads threads.
+ *     ONNX Runtime counts the calling thread as the first of them, so with
+ *     `cpus` set the pool threads are pinned to cpus[1..] and cpus[0] is
+ *     left for the caller (which should pin itself there)
+ *
+ * Not thread-safe: one owner thread calls embed(). Run one embedder per
+ * thread to use more cores with smaller intra-op pools.
+ *
+ * Config (key file format, see configs/reid/reid_cpu_embedder.txt):
+ *
+ *   [reid-cpu]
+ *   model=/workspace/models/reid_resnet50/1/model.onnx
+ *   input-name=input
+ *   output-name=output
+ *   max-batch=16              # 1..16, the model's max_batch_size
+ *   intra-op-threads=0        # 0 = size of cpus, or 1 when cpus is empty
+ *   cpus=                     # ';'-separated CPU ids, first one for the caller
+ *   allow-spinning=0          # 1 = pool threads spin between batches
+ *   optimization=all          # none | basic | extended | all
+ *   mean=0.485;0.456;0.406    # RGB, on pixels scaled to [0, 1]
+ *   std=0.229;0.224;0.225
+ */
+
+#ifndef __REID_EMBEDDER_H__
+#define __REID_EMBEDDER_H__
+
+#include "iou_tracker.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ReidEmbedderConfig
+{
+    // The model's max_batch_size
+    static const uint32_t kMaxBatch = 16;
+    // Far past any CPU set the embedder would be given
+    static const uint32_t kMaxIntraOpThreads = 256;
+
+    std::string model = "/workspace/models/reid_resnet50/1/model.onnx";
+    std::string inputName = "input";
+    std::string outputName = "output";
+    uint32_t maxBatch = 16;
+    uint32_t intraOpThreads = 0;
+    std::vector<int> cpus;
+    bool allowSpinning = false;
+    std::string optimization = "all";
+    float mean[3] = {0.485f, 0.456f, 0.406f};
+    float stddev[3] = {0.229f, 0.224f, 0.225f};
+
+    static bool load(const std::string& path, ReidEmbedderConfig& config);
+};
+
+enum ReidPixelFormat : uint32_t
+{
+    kReidRgb = 0,
+    kReidBgr = 1,
+    kReidRgba = 2,
+    kReidBgra = 3,
+};
+
+struct ReidCrop
+{
+    const uint8_t* pixels;  // top-left of the frame
+    uint32_t width, height;  // frame size
+    uint32_t stride;         // bytes per row
+    ReidPixelFormat format;
+    TrackBox box;  // frame pixels, clipped to the frame
+};
+
+struct ReidEmbedderStats
+{
+    uint64_t crops = 0;
+    uint64_t batches = 0;
+    uint64_t preprocessUs = 0;
+    uint64_t inferenceUs = 0;
+};
+
+class ReidEmbedder
+{
+public:
+    // Loads the model and checks its input/output shapes; nullptr on failure
+    static std::unique_ptr<ReidEmbedder> create(const ReidEmbedderConfig& config);
+    ~ReidEmbedder();
+
+    // Writes count * embeddingDim() floats (not normalised); false when
+    // ONNX Runtime failed
+    bool embed(const ReidCrop* crops, uint32_t count, float* embeddings);
+
+    uint32_t embeddingDim() const { return m_Dim; }
+    uint32_t inputWidth() const { return m_Width; }
+    uint32_t inputHeight() const { return m_Height; }
+    uint32_t maxBatch() const { return m_Config.maxBatch; }
+    uint32_t intraOpThreads() const { return m_Threads; }
+    const ReidEmbedderStats& stats() const { return m_Stats; }
+
+    void writePrometheus(std::string& out) const;
+
+private:
+    struct Runtime;  // ONNX Runtime objects, kept out of this header
+
+    explicit ReidEmbedder(const ReidEmbedderConfig& config);
+
+    bool init();
+    void preprocess(const ReidCrop& crop, float* dst);
+
+    ReidEmbedderConfig m_Config;
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+    uint32_t m_Dim = 0;
+    uint32_t m_Threads = 1;
+    std::vector<float> m_Input;   // maxBatch * 3 * height * width
+    std::vector<float> m_Output;  // maxBatch * dim
+    std::vector<int32_t> m_X0, m_X1;  // bilinear taps per output column,
+    std::vector<float> m_Fx;          // rebuilt per crop
+    std::unique_ptr<Runtime> m_Runtime;
+    ReidEmbedderStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Slab storage with generational handles for the native tracking engine
+ *
+ * Objects live in one vector of slots and are named by a 64-bit handle:
+ * the slot index in the low 32 bits and the slot's generation in the high
+ * 32. Releasing a slot bumps its generation and puts it on a free list, so
+ * a handle kept after its object was released resolves to null instead of
+ * to whatever reuses the slot. Generations start at 1, so 0 is never a
+ * valid handle and can mean "none".
+ *
+ * Releasing a slot resets its value to T(), freeing what it owns; the
+ * caller of acquire() fills in every field. Pointers into the slab are
+ * invalidated by acquire(); handles never are.
+ */
+
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename T>
+class Slab
+{
+public:
+    typedef uint64_t Handle;
+
+    Handle acquire()
+    {
+        uint32_t index;
+        if (!m_Free.empty()) {
+            index = m_Free.back();
+            m_Free.pop_back();
+        } else {
+            index = (uint32_t)m_Slots.size();
+            m_Slots.emplace_back();
+            m_Slots.back().generation = 1;
+        }
+        m_Slots[index].live = true;
+        m_Live++;
+        return (Handle)m_Slots[index].generation << 32 | index;
+    }
+
+    // Null for a released or never issued handle
+    T* get(Handle handle)
+    {
+        const uint32_t index = (uint32_t)handle;
+        if (index >= m_Slots.size()) {
+            return nullptr;
+        }
+        Slot& s = m_Slots[index];
+        return s.live && s.generation == (uint32_t)(handle >> 32) ? &s.value : nullptr;
+    }
+
+    const T* get(Handle handle) const { return const_cast<Slab*>(this)->get(handle); }
+
+    void release(Handle handle)
+    {
+        if (!get(handle)) {
+            return;
+        }
+        Slot& s = m_Slots[(uint32_t)handle];
+        s.value = T();
+        s.live = false;
+        // Skip 0 on wrap-around so it stays an invalid handle
+        s.generation = s.generation == UINT32_MAX ? 1 : s.generation + 1;
+        m_Free.push_back((uint32_t)handle);
+        m_Live--;
+    }
+
+    // f(handle, value) for every live object, in slot order
+    template <typename F>
+    void forEach(F f)
+    {
+        for (size_t i = 0; i < m_Slots.size(); ++i) {
+            if (m_Slots[i].live) {
+                f((Handle)m_Slots[i].generation << 32 | i, m_Slots[i].value);
+            }
+        }
+    }
+
+    template <typename F>
+    void forEach(F f) const
+    {
+        for (size_t i = 0; i < m_Slots.size(); ++i) {
+            if (m_Slots[i].live) {
+                f((Handle)m_Slots[i].generation << 32 | i, m_Slots[i].value);
+            }
+        }
+    }
+
+    size_t size() const { return m_Live; }
+
+    // Slots and free list, not the heap memory the values own
+    size_t memoryBytes() const { return m_Slots.capacity() * sizeof(Slot) + m_Free.capacity() * sizeof(uint32_t); }
+
+private:
+    struct Slot
+    {
+        T value;
+        uint32_t generation;
+        bool live;
+    };
+
+    std::vector<Slot> m_Slots;
+    std::vector<uint32_t> m_Free;  // released slot indices, reused last in first out
+    size_t m_Live = 0;
+};
+
+#endif
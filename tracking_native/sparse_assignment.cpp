@@ -0,0 +1,170 @@
+/*
+ * Sparse linear assignment for gated association
+ */
+
+#include "sparse_assignment.h"
+
+#include <algorithm>
+#include <functional>
+
+static const uint32_t kUnplaced = UINT32_MAX;
+
+void SparseAssignment::buildRows(uint32_t rows, const std::vector<AssignmentEdge>& edges)
+{
+    // Counting sort by row; edges never worth taking are dropped here
+    m_RowStart.assign(rows + 1, 0);
+    for (const AssignmentEdge& e : edges) {
+        if (e.row < rows && e.col < m_Cols && e.cost < m_Unassigned) {
+            m_RowStart[e.row + 1]++;
+        }
+    }
+    for (uint32_t r = 0; r < rows; ++r) {
+        m_RowStart[r + 1] += m_RowStart[r];
+    }
+    const uint32_t n = m_RowStart[rows];
+    m_EdgeCol.resize(n);
+    m_EdgeCost.resize(n);
+    // m_Scanned is idle until the searches; here it is each row's next slot
+    m_Scanned.assign(m_RowStart.begin(), m_RowStart.end() - 1);
+    for (const AssignmentEdge& e : edges) {
+        if (e.row < rows && e.col < m_Cols && e.cost < m_Unassigned) {
+            const uint32_t at = m_Scanned[e.row]++;
+            m_EdgeCol[at] = e.col;
+            m_EdgeCost[at] = e.cost;
+        }
+    }
+    m_Stats.edges = n;
+}
+
+void SparseAssignment::greedy(uint32_t rows)
+{
+    // With zero potentials, a row holding its cheapest candidate already
+    // satisfies the search's invariant, so this only saves searches
+    for (uint32_t r = 0; r < rows; ++r) {
+        uint32_t best = m_Cols + r;
+        double bestCost = m_Unassigned;
+        for (uint32_t e = m_RowStart[r]; e < m_RowStart[r + 1]; ++e) {
+            if (m_EdgeCost[e] < bestCost) {
+                bestCost = m_EdgeCost[e];
+                best = m_EdgeCol[e];
+            }
+        }
+        if (m_RowOfCol[best] < 0) {
+            m_RowOfCol[best] = (int32_t)r;
+            m_ColOfRow[r] = best;
+            m_MatchCost[r] = bestCost;
+            m_Stats.greedy++;
+        }
+    }
+}
+
+void SparseAssignment::relax(uint32_t row, double base)
+{
+    const uint32_t end = m_RowStart[row + 1];
+    for (uint32_t e = m_RowStart[row]; e <= end; ++e) {
+        // One past the row's edges is its unassigned column
+        const uint32_t col = e < end ? m_EdgeCol[e] : m_Cols + row;
+        const double cost = e < end ? m_EdgeCost[e] : m_Unassigned;
+        if (m_Settled[col] == m_Search) {
+            continue;
+        }
+        const double d = base + cost - m_Potential[col];
+        if (m_Reached[col] != m_Search || d < m_Dist[col]) {
+            m_Reached[col] = m_Search;
+            m_Dist[col] = d;
+            m_Via[col] = row;
+            m_ViaCost[col] = cost;
+            m_Heap.push_back(HeapItem(d, col));
+            std::push_heap(m_Heap.begin(), m_Heap.end(), std::greater<HeapItem>());
+        }
+    }
+    m_Stats.relaxations += end - m_RowStart[row] + 1;
+}
+
+void SparseAssignment::augment(uint32_t row)
+{
+    if (++m_Search == 0) {
+        std::fill(m_Reached.begin(), m_Reached.end(), 0);
+        std::fill(m_Settled.begin(), m_Settled.end(), 0);
+        m_Search = 1;
+    }
+    m_Stats.searches++;
+    m_Heap.clear();
+    m_Scanned.clear();
+
+    // Dijkstra over reduced costs cost - u(row) - v(col), where a placed
+    // row's u is what its own column costs it. The row's unassigned column
+    // is free, so the search always ends.
+    relax(row, 0.0);
+    uint32_t freeCol = 0;
+    double shortest = 0.0;
+    while (true) {
+        std::pop_heap(m_Heap.begin(), m_Heap.end(), std::greater<HeapItem>());
+        const HeapItem top = m_Heap.back();
+        m_Heap.pop_back();
+        const uint32_t col = top.second;
+        if (m_Settled[col] == m_Search || top.first > m_Dist[col]) {
+            continue;
+        }
+        m_Settled[col] = m_Search;
+        m_Scanned.push_back(col);
+        if (m_RowOfCol[col] < 0) {
+            freeCol = col;
+            shortest = top.first;
+            break;
+        }
+        const uint32_t next = (uint32_t)m_RowOfCol[col];
+        relax(next, top.first - (m_MatchCost[next] - m_Potential[col]));
+    }
+
+    // Keeps every reduced cost non-negative and those of the new matching 0
+    for (uint32_t col : m_Scanned) {
+        m_Potential[col] += m_Dist[col] - shortest;
+    }
+    for (uint32_t col = freeCol;;) {
+        const uint32_t r = m_Via[col];
+        const uint32_t previous = m_ColOfRow[r];
+        m_RowOfCol[col] = (int32_t)r;
+        m_ColOfRow[r] = col;
+        m_MatchCost[r] = m_ViaCost[col];
+        if (r == row) {
+            break;
+        }
+        col = previous;
+    }
+}
+
+double SparseAssignment::solve(uint32_t rows, uint32_t cols, const std::vector<AssignmentEdge>& edges,
+                               float unassignedCost, std::vector<int32_t>& colOfRow)
+{
+    m_Stats = AssignmentStats();
+    m_Cols = cols;
+    m_Unassigned = unassignedCost;
+    buildRows(rows, edges);
+
+    const size_t columns = (size_t)cols + rows;
+    m_Potential.assign(columns, 0.0);
+    m_RowOfCol.assign(columns, -1);
+    m_ColOfRow.assign(rows, kUnplaced);
+    m_MatchCost.assign(rows, 0.0);
+    m_Dist.resize(columns);
+    m_Via.resize(columns);
+    m_ViaCost.resize(columns);
+    m_Reached.resize(columns, 0);
+    m_Settled.resize(columns, 0);
+
+    greedy(rows);
+    for (uint32_t r = 0; r < rows; ++r) {
+        if (m_ColOfRow[r] == kUnplaced) {
+            augment(r);
+        }
+    }
+
+    double total = 0.0;
+    colOfRow.resize(rows);
+    for (uint32_t r = 0; r < rows; ++r) {
+        colOfRow[r] = m_ColOfRow[r] < cols ? (int32_t)m_ColOfRow[r] : -1;
+        total += m_MatchCost[r];
+    }
+    return total;
+}
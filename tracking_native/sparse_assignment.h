@@ -0,0 +1,100 @@
+/*
+ * Sparse linear assignment for gated association
+ *
+ * At a large site one association round can pair 1000+ detections or
+ * tracklets (rows) with 5000+ live tracks (columns), but gating by camera
+ * topology, transit time and appearance leaves each row a handful of
+ * candidates. A dense solver pays for the full rows x columns matrix; this
+ * one only ever reads the surviving edges.
+ *
+ * It finds the assignment of minimum total cost where every row takes at
+ * most one column and every column at most one row, and a row left
+ * unassigned costs unassignedCost. So an edge costing unassignedCost or
+ * more is never worth taking, and with unassignedCost 0 and negative edge
+ * costs it is a maximum-weight matching that links only where it pays.
+ *
+ * Method: shortest augmenting paths with column potentials (Jonker and
+ * Volgenant; the rectangular form of Crouse, 2016) on the sparse graph.
+ * Each row gets a private "unassigned" column, so every row can always be
+ * placed. A greedy pass first gives each row its cheapest free candidate.
+ * Then one Dijkstra search per remaining row runs over reduced costs
+ * until it reaches a free column. The search is bounded by the row's own
+ * unassigned cost and only touches columns reachable through gated
+ * edges. In practice a round costs a small multiple of the edge count,
+ * not rows x columns.
+ *
+ * Not thread-safe; keep one solver per thread. Its scratch is reused
+ * between calls.
+ */
+
+#ifndef __SPARSE_ASSIGNMENT_H__
+#define __SPARSE_ASSIGNMENT_H__
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct AssignmentEdge
+{
+    uint32_t row;
+    uint32_t col;
+    float cost;
+};
+
+struct AssignmentStats
+{
+    uint64_t edges = 0;       // taken from the input, after dropping those never worth taking
+    uint64_t greedy = 0;      // rows placed by the greedy pass
+    uint64_t searches = 0;    // shortest-path searches
+    uint64_t relaxations = 0; // edges scanned by the searches
+};
+
+class SparseAssignment
+{
+public:
+    // Solves for `rows` x `cols` over `edges`, given in any order; of
+    // duplicate (row, col) edges the cheapest counts. colOfRow[r] becomes
+    // the column of row r, or -1. Returns the total cost, unassigned rows
+    // included.
+    double solve(uint32_t rows, uint32_t cols, const std::vector<AssignmentEdge>& edges, float unassignedCost,
+                 std::vector<int32_t>& colOfRow);
+
+    // What row r pays in the last solve(): its edge, or unassignedCost
+    double rowCost(uint32_t row) const { return m_MatchCost[row]; }
+
+    // Of the last solve()
+    const AssignmentStats& stats() const { return m_Stats; }
+
+private:
+    typedef std::pair<double, uint32_t> HeapItem;
+
+    void buildRows(uint32_t rows, const std::vector<AssignmentEdge>& edges);
+    void greedy(uint32_t rows);
+    void relax(uint32_t row, double base);
+    void augment(uint32_t row);
+
+    uint32_t m_Cols = 0;  // real columns; m_Cols + r is row r's unassigned column
+    double m_Unassigned = 0.0;
+    // Candidates of each row in CSR form, unassigned column excluded
+    std::vector<uint32_t> m_RowStart;
+    std::vector<uint32_t> m_EdgeCol;
+    std::vector<double> m_EdgeCost;
+    std::vector<double> m_Potential;  // per column, real then unassigned
+    std::vector<int32_t> m_RowOfCol;
+    std::vector<uint32_t> m_ColOfRow;  // UINT32_MAX until placed
+    std::vector<double> m_MatchCost;   // cost of the row's current column
+    // Search scratch, per column. m_Dist, m_Via and m_ViaCost are valid
+    // while m_Reached holds the current search's number, and the column is
+    // settled while m_Settled does.
+    std::vector<double> m_Dist;
+    std::vector<uint32_t> m_Via;  // row the path reached the column from
+    std::vector<double> m_ViaCost;
+    std::vector<uint32_t> m_Reached;
+    std::vector<uint32_t> m_Settled;
+    std::vector<uint32_t> m_Scanned;  // settled columns of this search
+    std::vector<HeapItem> m_Heap;
+    uint32_t m_Search = 0;
+    AssignmentStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,426 @@
+/*
+ * Offline tracklet linking by min-cost assignment
+ */
+
+#include "tracklet_linker.h"
+#include "detection_log.h"
+#include "key_file.h"
+#include "sparse_assignment.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+bool LinkerConfig::load(const std::string& path, LinkerConfig& config)
+{
+    KeyFile kf;
+    if (!kf.loadFromFile(path)) {
+        return false;
+    }
+    const std::string g = "linker";
+    LinkerConfig c;
+    c.windowS = kf.getDouble(g, "window-s", c.windowS);
+    c.threads = (uint32_t)std::max(0, kf.getInt(g, "threads", (int)c.threads));
+    c.minSimilarity = (float)kf.getDouble(g, "min-similarity", c.minSimilarity);
+    c.sameCameraMaxGapS = kf.getDouble(g, "same-camera-max-gap-s", c.sameCameraMaxGapS);
+    c.minTransitS = kf.getDouble(g, "min-transit-s", c.minTransitS);
+    c.maxTransitS = kf.getDouble(g, "max-transit-s", c.maxTransitS);
+    c.gapPenalty = (float)kf.getDouble(g, "gap-penalty", c.gapPenalty);
+    c.summaryFeatures = (uint32_t)kf.getInt(g, "summary-features", (int)c.summaryFeatures);
+    c.splitSimilarity = (float)kf.getDouble(g, "split-similarity", c.splitSimilarity);
+    c.splitFrames = (uint32_t)std::max(1, kf.getInt(g, "split-frames", (int)c.splitFrames));
+    c.minDetections = (uint32_t)kf.getInt(g, "min-detections", (int)c.minDetections);
+    if (c.windowS <= 0.0 || c.summaryFeatures == 0 || c.sameCameraMaxGapS < 0.0 || c.maxTransitS < c.minTransitS) {
+        std::cerr << "ERROR: " << path << ": [linker] needs positive window-s and summary-features, "
+                  << "and min-transit-s <= max-transit-s" << std::endl;
+        return false;
+    }
+
+    for (const std::string& group : kf.groups()) {
+        unsigned from = 0, to = 0;
+        char extra = 0;
+        if (group.compare(0, 8, "transit-") != 0) {
+            continue;
+        }
+        if (sscanf(group.c_str(), "transit-%u-%u%c", &from, &to, &extra) != 2) {
+            std::cerr << "ERROR: " << path << ": [" << group << "] must be [transit-<from>-<to>]" << std::endl;
+            return false;
+        }
+        TransitGate t;
+        t.from = from;
+        t.to = to;
+        t.minS = kf.getDouble(group, "min-s", 0.0);
+        t.maxS = kf.getDouble(group, "max-s", -1.0);
+        if (t.maxS < t.minS || t.maxS <= 0.0) {
+            std::cerr << "ERROR: " << path << ": [" << group << "] needs 0 <= min-s <= max-s" << std::endl;
+            return false;
+        }
+        c.transits.push_back(t);
+        if (kf.getBool(group, "bidirectional", false)) {
+            std::swap(t.from, t.to);
+            c.transits.push_back(t);
+        }
+    }
+    config = c;
+    return true;
+}
+
+bool LinkerConfig::gate(uint32_t from, uint32_t to, double& minS, double& maxS) const
+{
+    if (from == to) {
+        minS = 0.0;
+        maxS = sameCameraMaxGapS;
+        return maxS > 0.0;
+    }
+    if (transits.empty()) {
+        minS = minTransitS;
+        maxS = maxTransitS;
+        return maxS > 0.0;
+    }
+    for (const TransitGate& t : transits) {
+        if (t.from == from && t.to == to) {
+            minS = t.minS;
+            maxS = t.maxS;
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+double elapsedMs(Clock::time_point from)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+}
+
+void normalize(std::vector<float>& v)
+{
+    double norm = 0.0;
+    for (float x : v) {
+        norm += (double)x * x;
+    }
+    const float inv = (float)(1.0 / (std::sqrt(norm) + 1e-8));
+    for (float& x : v) {
+        x *= inv;
+    }
+}
+
+} // namespace
+
+TrackletLinker::TrackletLinker(const LinkerConfig& config) : m_Config(config), m_Dim(0)
+{
+    m_MaxGapS = config.sameCameraMaxGapS;
+    if (config.transits.empty()) {
+        m_MaxGapS = std::max(m_MaxGapS, config.maxTransitS);
+    }
+    for (const TransitGate& t : config.transits) {
+        m_MaxGapS = std::max(m_MaxGapS, t.maxS);
+    }
+}
+
+void TrackletLinker::build(const DetectionLog& log)
+{
+    const Clock::time_point t0 = Clock::now();
+    const uint32_t k = m_Config.summaryFeatures;
+    const float emaWeight = 0.1f;
+    m_Dim = log.embeddingDim();
+    m_Tracklets.clear();
+    m_Index.clear();
+    m_Stats = LinkerStats();
+
+    // Per tracklet while reading: rows of its last k embeddings (a ring),
+    // the running mean appearance and the rows that disagree with it
+    struct Building
+    {
+        std::vector<uint64_t> tailRows;
+        std::vector<float> mean;
+        std::vector<uint64_t> pending;
+    };
+    std::vector<Building> building;
+    std::unordered_map<uint64_t, uint32_t> current;  // key -> tracklet being extended
+
+    const int64_t* ts = log.timestampUs();
+    auto create = [&](uint64_t row) {
+        Tracklet t;
+        t.camera = log.camera()[row];
+        t.localId = log.localId()[row];
+        t.startUs = ts[row];
+        t.endUs = ts[row];
+        t.detections = 0;
+        t.head.assign(m_Dim, 0.0f);
+        t.next = -1;
+        m_Tracklets.push_back(std::move(t));
+        building.emplace_back();
+        return (uint32_t)(m_Tracklets.size() - 1);
+    };
+    auto add = [&](uint32_t i, uint64_t row) {
+        Tracklet& t = m_Tracklets[i];
+        Building& b = building[i];
+        const float* f = log.embedding(row);
+        t.endUs = std::max(t.endUs, ts[row]);
+        if (t.detections < k) {
+            for (uint32_t d = 0; d < m_Dim; ++d) {
+                t.head[d] += f[d];
+            }
+            b.tailRows.push_back(row);
+        } else {
+            b.tailRows[t.detections % k] = row;
+        }
+        if (b.mean.empty()) {
+            b.mean.assign(f, f + m_Dim);
+        } else {
+            for (uint32_t d = 0; d < m_Dim; ++d) {
+                b.mean[d] = (1.0f - emaWeight) * b.mean[d] + emaWeight * f[d];
+            }
+        }
+        t.detections++;
+    };
+
+    for (uint64_t row = 0; row < log.rows(); ++row) {
+        const uint64_t id = key(log.camera()[row], log.localId()[row]);
+        auto found = current.find(id);
+        if (found == current.end()) {
+            const uint32_t i = create(row);
+            m_Index.emplace(id, i);
+            current.emplace(id, i);
+            add(i, row);
+            continue;
+        }
+        const uint32_t i = found->second;
+        Building& b = building[i];
+        if (m_Config.splitSimilarity <= 0.0f) {
+            add(i, row);
+            continue;
+        }
+
+        const float* f = log.embedding(row);
+        double dot = 0.0, norm = 0.0;
+        for (uint32_t d = 0; d < m_Dim; ++d) {
+            dot += (double)f[d] * b.mean[d];
+            norm += (double)b.mean[d] * b.mean[d];
+        }
+        const float similarity = (float)(dot / (std::sqrt(norm) + 1e-8));
+        if (similarity >= m_Config.splitSimilarity) {
+            // A brief outlier (occlusion) is kept
+            for (uint64_t p : b.pending) {
+                add(i, p);
+            }
+            b.pending.clear();
+            add(i, row);
+            continue;
+        }
+        b.pending.push_back(row);
+        if (b.pending.size() < m_Config.splitFrames) {
+            continue;
+        }
+        // Someone else has carried this local id for split-frames rows
+        const std::vector<uint64_t> moved = std::move(b.pending);
+        b.pending.clear();
+        const uint32_t j = create(moved[0]);
+        m_Tracklets[i].next = j;
+        found->second = j;
+        for (uint64_t p : moved) {
+            add(j, p);
+        }
+        m_Stats.splits++;
+    }
+
+    for (size_t i = 0; i < m_Tracklets.size(); ++i) {
+        Tracklet& t = m_Tracklets[i];
+        for (uint64_t p : building[i].pending) {
+            add((uint32_t)i, p);
+        }
+        normalize(t.head);
+        t.tail.assign(m_Dim, 0.0f);
+        for (uint64_t row : building[i].tailRows) {
+            const float* f = log.embedding(row);
+            for (uint32_t d = 0; d < m_Dim; ++d) {
+                t.tail[d] += f[d];
+            }
+        }
+        normalize(t.tail);
+        std::vector<uint64_t>().swap(building[i].tailRows);
+        std::vector<float>().swap(building[i].mean);
+    }
+
+    m_ByStart.resize(m_Tracklets.size());
+    for (uint32_t i = 0; i < m_ByStart.size(); ++i) {
+        m_ByStart[i] = i;
+    }
+    std::sort(m_ByStart.begin(), m_ByStart.end(),
+              [this](uint32_t a, uint32_t b) { return m_Tracklets[a].startUs < m_Tracklets[b].startUs; });
+
+    m_Stats.rows = log.rows();
+    m_Stats.tracklets = m_Tracklets.size();
+    m_Stats.buildMs = elapsedMs(t0);
+}
+
+void TrackletLinker::solveWindow(const std::vector<uint32_t>& left, std::vector<Link>& links, uint64_t& edges) const
+{
+    std::vector<AssignmentEdge> local;
+    std::unordered_map<uint32_t, uint32_t> rightIndex;
+    std::vector<uint32_t> right;
+    const int64_t maxGapUs = (int64_t)(m_MaxGapS * 1e6);
+
+    for (uint32_t li = 0; li < left.size(); ++li) {
+        const Tracklet& a = m_Tracklets[left[li]];
+        if (a.detections < m_Config.minDetections) {
+            continue;
+        }
+        auto it = std::upper_bound(m_ByStart.begin(), m_ByStart.end(), a.endUs,
+                                   [this](int64_t t, uint32_t j) { return t < m_Tracklets[j].startUs; });
+        for (; it != m_ByStart.end() && m_Tracklets[*it].startUs - a.endUs <= maxGapUs; ++it) {
+            const Tracklet& b = m_Tracklets[*it];
+            double minS = 0.0, maxS = 0.0;
+            if (b.detections < m_Config.minDetections || !m_Config.gate(a.camera, b.camera, minS, maxS)) {
+                continue;
+            }
+            const double gap = (b.startUs - a.endUs) / 1e6;
+            if (gap < minS || gap > maxS) {
+                continue;
+            }
+            float similarity = 0.0f;
+            for (uint32_t d = 0; d < m_Dim; ++d) {
+                similarity += a.tail[d] * b.head[d];
+            }
+            if (similarity < m_Config.minSimilarity) {
+                continue;
+            }
+            const double cost = -(similarity - m_Config.minSimilarity) + m_Config.gapPenalty * gap / maxS;
+            if (cost >= 0.0) {
+                continue;
+            }
+            auto ins = rightIndex.emplace(*it, (uint32_t)right.size());
+            if (ins.second) {
+                right.push_back(*it);
+            }
+            local.push_back(AssignmentEdge{li, ins.first->second, (float)cost});
+        }
+    }
+
+    edges = local.size();
+    links.clear();
+
+    // Every tracklet has at most one successor and one predecessor, and a
+    // link is taken only where it lowers the total cost
+    SparseAssignment solver;
+    std::vector<int32_t> successor;
+    solver.solve((uint32_t)left.size(), (uint32_t)right.size(), local, 0.0f, successor);
+    for (uint32_t li = 0; li < successor.size(); ++li) {
+        if (successor[li] >= 0) {
+            links.push_back(Link{left[li], right[successor[li]], (float)solver.rowCost(li)});
+        }
+    }
+}
+
+void TrackletLinker::solve()
+{
+    const Clock::time_point t0 = Clock::now();
+    const size_t n = m_Tracklets.size();
+    m_Successor.assign(n, -1);
+    m_Identity.assign(n, 0);
+    if (n == 0) {
+        return;
+    }
+
+    // Windows by end time
+    int64_t firstUs = m_Tracklets[0].endUs;
+    for (const Tracklet& t : m_Tracklets) {
+        firstUs = std::min(firstUs, t.endUs);
+    }
+    const int64_t windowUs = std::max<int64_t>(1, (int64_t)(m_Config.windowS * 1e6));
+    std::vector<std::vector<uint32_t>> windows;
+    for (uint32_t i = 0; i < n; ++i) {
+        const size_t w = (size_t)((m_Tracklets[i].endUs - firstUs) / windowUs);
+        if (w >= windows.size()) {
+            windows.resize(w + 1);
+        }
+        windows[w].push_back(i);
+    }
+
+    std::vector<std::vector<Link>> links(windows.size());
+    std::vector<uint64_t> edges(windows.size(), 0);
+    std::atomic<size_t> next{0};
+    uint32_t threads = m_Config.threads ? m_Config.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = (uint32_t)std::min<size_t>(threads, windows.size());
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < windows.size(); i = next++) {
+                solveWindow(windows[i], links[i], edges[i]);
+            }
+        });
+    }
+    for (std::thread& t : workers) {
+        t.join();
+    }
+
+    // Predecessors are unique per window; a successor claimed across a
+    // boundary goes to the cheaper link
+    std::vector<Link> all;
+    for (size_t w = 0; w < windows.size(); ++w) {
+        all.insert(all.end(), links[w].begin(), links[w].end());
+        m_Stats.edges += edges[w];
+    }
+    std::sort(all.begin(), all.end(), [](const Link& a, const Link& b) { return a.cost < b.cost; });
+    std::vector<bool> hasPredecessor(n, false);
+    for (const Link& l : all) {
+        if (hasPredecessor[l.to] || m_Successor[l.from] >= 0) {
+            m_Stats.conflicts++;
+            continue;
+        }
+        m_Successor[l.from] = l.to;
+        hasPredecessor[l.to] = true;
+        m_Stats.links++;
+    }
+
+    uint64_t identities = 0;
+    for (uint32_t i : m_ByStart) {
+        if (hasPredecessor[i]) {
+            continue;
+        }
+        ++identities;
+        for (int64_t j = i; j >= 0; j = m_Successor[j]) {
+            m_Identity[j] = identities;
+        }
+    }
+    m_Stats.windows = windows.size();
+    m_Stats.identities = identities;
+    m_Stats.solveMs = elapsedMs(t0);
+}
+
+std::vector<uint64_t> TrackletLinker::rowIdentities(const DetectionLog& log) const
+{
+    std::vector<uint64_t> ids(log.rows(), 0);
+    const int64_t* ts = log.timestampUs();
+    const uint32_t* camera = log.camera();
+    const uint64_t* localId = log.localId();
+    // Rows are in time order, so a local track moves on to the next
+    // tracklet of a split once the row reaches that tracklet's start
+    std::unordered_map<uint64_t, uint32_t> current;
+    for (uint64_t row = 0; row < log.rows(); ++row) {
+        const uint64_t id = key(camera[row], localId[row]);
+        auto it = current.find(id);
+        if (it == current.end()) {
+            auto first = m_Index.find(id);
+            if (first == m_Index.end()) {
+                continue;
+            }
+            it = current.emplace(id, first->second).first;
+        }
+        while (m_Tracklets[it->second].next >= 0 && m_Tracklets[m_Tracklets[it->second].next].startUs <= ts[row]) {
+            it->second = (uint32_t)m_Tracklets[it->second].next;
+        }
+        if (it->second < m_Identity.size()) {
+            ids[row] = m_Identity[it->second];
+        }
+    }
+    return ids;
+}
@@ -0,0 +1,164 @@
+/*
+ * Offline tracklet linking by min-cost assignment
+ *
+ * The online associator decides once per local track, the moment it is
+ * confirmed, and never revisits that choice. For forensic queries over a
+ * recorded day the whole log is available, so identities are solved
+ * globally instead:
+ *
+ *   1. build   every (camera, local id) in a DetectionLog becomes a
+ *              tracklet: first/last time, detection count and the mean of
+ *              its first and of its last summary-features embeddings. A
+ *              local track whose embeddings stay below split-similarity
+ *              to its running mean for split-frames rows has switched
+ *              people and is cut there into two tracklets.
+ *   2. gate    tracklet i may continue as j only if j starts after i ends
+ *              and the gap fits the camera pair: same-camera-max-gap-s on
+ *              one camera, a [transit-A-B] window between cameras (or the
+ *              default min/max-transit-s when no topology is given), and
+ *              the similarity of i's tail and j's head is at least
+ *              min-similarity
+ *   3. solve   each surviving edge costs
+ *                  -(similarity - min-similarity) + gap-penalty * gap / max gap
+ *              and every tracklet has at most one successor and one
+ *              predecessor: a minimum-cost assignment of "i ends" rows to
+ *              "j starts" columns over the surviving edges only, where
+ *              leaving a tracklet without a successor costs 0
+ *              (SparseAssignment, see sparse_assignment.h)
+ *   4. label   chains of links become identities, numbered in start order
+ *
+ * The day is cut into windows of window-s by tracklet end time; windows
+ * are independent problems solved on `threads` threads. A tracklet
+ * starting near a boundary can be chosen as successor by two windows; the
+ * merge keeps the cheaper link, so a window boundary can cost at most that
+ * one link, never a wrong one.
+ *
+ * Config (key file format, see configs/tracklet_linking.txt):
+ *
+ *   [linker]
+ *   window-s=600
+ *   threads=0                 # 0 = one per core
+ *   min-similarity=0.65
+ *   same-camera-max-gap-s=20
+ *   min-transit-s=0           # camera pairs without a [transit-*] group,
+ *   max-transit-s=15          # when no [transit-*] group exists at all
+ *   gap-penalty=0.1
+ *   summary-features=10
+ *   split-similarity=0.4      # 0 = never split a local track
+ *   split-frames=3
+ *   min-detections=3          # shorter tracklets keep an identity of their own
+ *
+ *   [transit-0-1]             # camera 0 -> camera 1; once any transit group
+ *   min-s=2                   # exists, unlisted pairs are never linked
+ *   max-s=20
+ *   bidirectional=1
+ */
+
+#ifndef __TRACKLET_LINKER_H__
+#define __TRACKLET_LINKER_H__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class DetectionLog;
+
+struct TransitGate
+{
+    uint32_t from;
+    uint32_t to;
+    double minS;
+    double maxS;
+};
+
+struct LinkerConfig
+{
+    double windowS = 600.0;
+    uint32_t threads = 0;
+    float minSimilarity = 0.65f;
+    double sameCameraMaxGapS = 20.0;
+    double minTransitS = 0.0;
+    double maxTransitS = 15.0;
+    float gapPenalty = 0.1f;
+    uint32_t summaryFeatures = 10;
+    float splitSimilarity = 0.4f;
+    uint32_t splitFrames = 3;
+    uint32_t minDetections = 3;
+    std::vector<TransitGate> transits;
+
+    static bool load(const std::string& path, LinkerConfig& config);
+
+    // Allowed gap between cameras `from` and `to`; false if never linked
+    bool gate(uint32_t from, uint32_t to, double& minS, double& maxS) const;
+};
+
+struct Tracklet
+{
+    uint32_t camera;
+    uint64_t localId;
+    int64_t startUs;
+    int64_t endUs;
+    uint64_t detections;
+    std::vector<float> head;  // normalised mean of the first embeddings
+    std::vector<float> tail;  // normalised mean of the last embeddings
+    int64_t next;             // tracklet the same local track continues as after a split, -1 for none
+};
+
+struct LinkerStats
+{
+    uint64_t rows = 0;
+    uint64_t tracklets = 0;
+    uint64_t splits = 0;  // local tracks cut at an identity switch
+    uint64_t windows = 0;
+    uint64_t edges = 0;      // after gating
+    uint64_t links = 0;      // chosen
+    uint64_t conflicts = 0;  // links dropped at window boundaries
+    uint64_t identities = 0;
+    double buildMs = 0.0;
+    double solveMs = 0.0;
+};
+
+class TrackletLinker
+{
+public:
+    explicit TrackletLinker(const LinkerConfig& config);
+
+    // Summarises the log into tracklets
+    void build(const DetectionLog& log);
+
+    // Links tracklets and numbers the identities
+    void solve();
+
+    // 1-based identity of every row of `log` (the one build() read)
+    std::vector<uint64_t> rowIdentities(const DetectionLog& log) const;
+
+    const std::vector<Tracklet>& tracklets() const { return m_Tracklets; }
+    // Successor of each tracklet, -1 for none
+    const std::vector<int64_t>& successors() const { return m_Successor; }
+    const LinkerStats& stats() const { return m_Stats; }
+
+private:
+    struct Link
+    {
+        uint32_t from;
+        uint32_t to;
+        float cost;
+    };
+
+    static uint64_t key(uint32_t camera, uint64_t localId) { return (uint64_t)camera << 48 | localId; }
+
+    void solveWindow(const std::vector<uint32_t>& left, std::vector<Link>& links, uint64_t& edges) const;
+
+    LinkerConfig m_Config;
+    double m_MaxGapS;
+    uint32_t m_Dim;
+    std::vector<Tracklet> m_Tracklets;
+    std::unordered_map<uint64_t, uint32_t> m_Index;  // key -> first tracklet
+    std::vector<uint32_t> m_ByStart;                 // tracklets by start time
+    std::vector<int64_t> m_Successor;
+    std::vector<uint64_t> m_Identity;  // per tracklet, 1-based
+    LinkerStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Within-camera tracklet re-stitching
+ */
+
+#include "tracklet_stitcher.h"
+#include "key_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+bool StitchConfig::load(const KeyFile& kf, const std::string& path, StitchConfig& config)
+{
+    const std::string g = "stitching";
+    StitchConfig c;
+    c.enable = kf.getBool(g, "enable", c.enable);
+    c.lostAfterFrames = (uint32_t)std::max(0, kf.getInt(g, "lost-after-frames", (int)c.lostAfterFrames));
+    c.maxGapS = kf.getDouble(g, "max-gap-s", c.maxGapS);
+    c.maxCandidates = (uint32_t)std::max(0, kf.getInt(g, "max-candidates", (int)c.maxCandidates));
+    c.minSimilarity = (float)kf.getDouble(g, "min-similarity", c.minSimilarity);
+    c.gateBase = (float)kf.getDouble(g, "gate-base", c.gateBase);
+    c.gateGrowth = (float)kf.getDouble(g, "gate-growth", c.gateGrowth);
+    c.maxSizeRatio = (float)kf.getDouble(g, "max-size-ratio", c.maxSizeRatio);
+    c.motionWeight = (float)kf.getDouble(g, "motion-weight", c.motionWeight);
+    c.embeddingHistory = (uint32_t)std::max(0, kf.getInt(g, "embedding-history", (int)c.embeddingHistory));
+    if (c.maxGapS <= 0.0 || c.maxCandidates == 0 || c.gateBase <= 0.0f || c.maxSizeRatio < 1.0f ||
+        c.embeddingHistory == 0 || c.lostAfterFrames == 0) {
+        std::cerr << "ERROR: " << path << ": [stitching] needs positive max-gap-s, max-candidates, gate-base, "
+                  << "embedding-history and lost-after-frames, and max-size-ratio >= 1" << std::endl;
+        return false;
+    }
+    config = c;
+    return true;
+}
+
+TrackletStitcher::TrackletStitcher(const StitchConfig& config, uint32_t embeddingDim)
+    : m_Config(config), m_Dim(embeddingDim), m_MaxGapUs((uint64_t)(config.maxGapS * 1e6))
+{
+}
+
+void TrackletStitcher::add(uint32_t camera, uint64_t localId, uint64_t globalId, const TrackBox& box, float vx,
+                           float vy, uint64_t lastSeenUs, const float* embedding)
+{
+    if (camera >= m_Cameras.size()) {
+        m_Cameras.resize(camera + 1);
+    }
+    std::vector<Candidate>& list = m_Cameras[camera];
+    remove(camera, localId);
+    if (list.size() >= m_Config.maxCandidates) {
+        list.erase(list.begin());
+    }
+    Candidate c;
+    c.localId = localId;
+    c.globalId = globalId;
+    c.box = box;
+    c.vx = vx;
+    c.vy = vy;
+    c.lastSeenUs = lastSeenUs;
+    c.hasEmbedding = embedding != nullptr;
+    if (embedding) {
+        c.embedding.assign(embedding, embedding + m_Dim);
+    }
+    list.push_back(std::move(c));
+}
+
+void TrackletStitcher::remove(uint32_t camera, uint64_t localId)
+{
+    if (camera >= m_Cameras.size()) {
+        return;
+    }
+    std::vector<Candidate>& list = m_Cameras[camera];
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (list[i].localId == localId) {
+            list.erase(list.begin() + i);
+            return;
+        }
+    }
+}
+
+bool TrackletStitcher::match(uint32_t camera, const TrackBox& box, const float* embedding, uint64_t nowUs,
+                             uint64_t& globalId, uint64_t& oldLocalId)
+{
+    // Size ratio and distance are relative to box height
+    if (!m_Config.enable || camera >= m_Cameras.size() || box.height <= 0.0f) {
+        return false;
+    }
+    std::vector<Candidate>& list = m_Cameras[camera];
+    const float cx = box.left + box.width * 0.5f, cy = box.top + box.height * 0.5f;
+
+    int best = -1;
+    float bestScore = -1e30f;
+    for (size_t i = 0; i < list.size(); ++i) {
+        const Candidate& c = list[i];
+        if (nowUs <= c.lastSeenUs || nowUs - c.lastSeenUs > m_MaxGapUs || c.box.height <= 0.0f) {
+            continue;
+        }
+        const float gap = (float)((nowUs - c.lastSeenUs) / 1e6);
+        const float ratio = box.height / c.box.height;
+        if (ratio > m_Config.maxSizeRatio || ratio * m_Config.maxSizeRatio < 1.0f) {
+            continue;
+        }
+
+        const float px = c.box.left + c.box.width * 0.5f + c.vx * gap;
+        const float py = c.box.top + c.box.height * 0.5f + c.vy * gap;
+        const float dist = std::sqrt((cx - px) * (cx - px) + (cy - py) * (cy - py)) / c.box.height;
+        const bool appearance = embedding && c.hasEmbedding;
+        float gate = m_Config.gateBase + m_Config.gateGrowth * gap;
+        if (!appearance) {
+            gate *= 0.5f;
+        }
+        if (dist > gate) {
+            continue;
+        }
+
+        float similarity = m_Config.minSimilarity;
+        if (appearance) {
+            float dot = 0.0f;
+            for (uint32_t k = 0; k < m_Dim; ++k) {
+                dot += embedding[k] * c.embedding[k];
+            }
+            if (dot < m_Config.minSimilarity) {
+                continue;
+            }
+            similarity = dot;
+        }
+        const float score = similarity - m_Config.motionWeight * dist / gate;
+        if (score > bestScore) {
+            bestScore = score;
+            best = (int)i;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    globalId = list[best].globalId;
+    oldLocalId = list[best].localId;
+    list.erase(list.begin() + best);
+    return true;
+}
+
+void TrackletStitcher::expire(uint64_t nowUs)
+{
+    for (std::vector<Candidate>& list : m_Cameras) {
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [&](const Candidate& c) { return nowUs > c.lastSeenUs + m_MaxGapUs; }),
+                   list.end());
+    }
+}
+
+void TrackletStitcher::retarget(uint64_t from, uint64_t to)
+{
+    for (std::vector<Candidate>& list : m_Cameras) {
+        for (Candidate& c : list) {
+            if (c.globalId == from) {
+                c.globalId = to;
+            }
+        }
+    }
+}
+
+size_t TrackletStitcher::size() const
+{
+    size_t n = 0;
+    for (const std::vector<Candidate>& list : m_Cameras) {
+        n += list.size();
+    }
+    return n;
+}
+
+size_t TrackletStitcher::memoryBytes() const
+{
+    size_t bytes = m_Cameras.capacity() * sizeof(std::vector<Candidate>);
+    for (const std::vector<Candidate>& list : m_Cameras) {
+        bytes += list.capacity() * sizeof(Candidate);
+        for (const Candidate& c : list) {
+            bytes += c.embedding.capacity() * sizeof(float);
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,117 @@
+/*
+ * Within-camera tracklet re-stitching
+ *
+ * A long occlusion breaks a local track: the tracker gives up on the old
+ * id and the person comes back under a new one. The associator only looks
+ * across cameras, so every such fragment used to start a new global track
+ * with its own embedding history. The stitcher keeps a small per-camera
+ * list of tracks the local tracker has lost (in shadow for lost-after-frames
+ * or terminated) together with their last box, velocity and a cached mean
+ * of their latest embeddings. A new track on the same camera is checked
+ * against that list before the cross-camera gallery:
+ *
+ *   gap       0 < now - last seen <= max-gap-s
+ *   motion    the new box centre lies within gate-base + gate-growth * gap
+ *             box heights of the old box moved on at its last velocity
+ *   size      heights within max-size-ratio of each other
+ *   look      cosine similarity of the embeddings >= min-similarity
+ *
+ * and the best candidate by similarity - motion-weight * (distance / gate)
+ * hands its global id to the new track. Without embeddings only the motion
+ * gate decides, at half its width.
+ *
+ * The list holds at most max-candidates per camera (oldest evicted first),
+ * so a lookup is a short linear scan with the cheap geometric gates ahead
+ * of the dot product.
+ *
+ * Config (key file format, see configs/tracking_native.txt):
+ *
+ *   [stitching]
+ *   enable=1
+ *   lost-after-frames=5
+ *   max-gap-s=8
+ *   max-candidates=32
+ *   min-similarity=0.6
+ *   gate-base=0.75
+ *   gate-growth=0.5
+ *   max-size-ratio=1.5
+ *   motion-weight=0.3
+ *   embedding-history=5
+ */
+
+#ifndef __TRACKLET_STITCHER_H__
+#define __TRACKLET_STITCHER_H__
+
+#include "iou_tracker.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class KeyFile;
+
+struct StitchConfig
+{
+    bool enable = true;
+    uint32_t lostAfterFrames = 5;  // for callers: when to report a shadow track as lost
+    double maxGapS = 8.0;
+    uint32_t maxCandidates = 32;
+    float minSimilarity = 0.6f;
+    float gateBase = 0.75f;   // box heights
+    float gateGrowth = 0.5f;  // box heights per second of gap
+    float maxSizeRatio = 1.5f;
+    float motionWeight = 0.3f;
+    uint32_t embeddingHistory = 5;
+
+    // Reads the [stitching] group; false on invalid values
+    static bool load(const KeyFile& kf, const std::string& path, StitchConfig& config);
+};
+
+class TrackletStitcher
+{
+public:
+    TrackletStitcher(const StitchConfig& config, uint32_t embeddingDim);
+
+    // A lost track of `camera` becomes a candidate. `embedding` is its
+    // normalised mean appearance, or null. Velocity is in pixels per second.
+    void add(uint32_t camera, uint64_t localId, uint64_t globalId, const TrackBox& box, float vx, float vy,
+             uint64_t lastSeenUs, const float* embedding);
+
+    // The local tracker found the track again
+    void remove(uint32_t camera, uint64_t localId);
+
+    // Best candidate for a track new on `camera`; the candidate is consumed.
+    // `embedding` is normalised, or null.
+    bool match(uint32_t camera, const TrackBox& box, const float* embedding, uint64_t nowUs, uint64_t& globalId,
+               uint64_t& oldLocalId);
+
+    // Candidates carrying global id `from` carry `to` from now on (the
+    // owner merged the two tracks)
+    void retarget(uint64_t from, uint64_t to);
+
+    // Drops candidates older than max-gap-s
+    void expire(uint64_t nowUs);
+
+    const StitchConfig& config() const { return m_Config; }
+    size_t size() const;
+    size_t memoryBytes() const;
+
+private:
+    struct Candidate
+    {
+        uint64_t localId;
+        uint64_t globalId;
+        TrackBox box;
+        float vx, vy;
+        uint64_t lastSeenUs;
+        bool hasEmbedding;
+        std::vector<float> embedding;
+    };
+
+    StitchConfig m_Config;
+    uint32_t m_Dim;
+    uint64_t m_MaxGapUs;
+    std::vector<std::vector<Candidate>> m_Cameras;  // by camera id, oldest first
+};
+
+#endif